@@ -0,0 +1,180 @@
+/**
+ * @file balancer_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Balancing benchmark of the strategies of "Balancer" under a skewed
+ * workload: every "io_threads"-th client pushes data as fast as it can, the
+ * others stay idle, so counting connections (or going round) piles the heavy
+ * ones up in the same I/O thread.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/balancer.h"
+#include "../src/event_manager.h"
+#include "../src/logger.h"
+#include "../src/server.h"
+
+namespace {
+
+struct StrategyName {
+  const char* name;
+  int strategy;
+};
+
+constexpr StrategyName kStrategyNames[] = {
+    {"rr", taotu::BalancerStrategy::kRoundRobin},
+    {"min-events", taotu::BalancerStrategy::kMinEvents},
+    {"p2c", taotu::BalancerStrategy::kPowerOfTwoChoices},
+    {"latency", taotu::BalancerStrategy::kLeastLatency},
+    {"bytes", taotu::BalancerStrategy::kLeastBytesPerSecond},
+    {"weighted", taotu::BalancerStrategy::kWeighted},
+};
+
+std::atomic_bool is_stopped{false};
+
+int Connect(uint16_t port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_in address {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                sizeof(address)) < 0) {
+    ::perror("connect");
+    ::exit(1);
+  }
+  return fd;
+}
+
+void RunClient(uint16_t port, bool is_heavy) {
+  int fd = Connect(port);
+  std::string block(64 * 1024, 'x');
+  while (!is_stopped.load(std::memory_order_relaxed)) {
+    if (!is_heavy) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } else if (::write(fd, block.data(), block.size()) <= 0) {
+      break;
+    }
+  }
+  ::close(fd);
+}
+
+}  // namespace
+
+// Call it by:
+// './balancer_bench strategy(rr|min-events|p2c|latency|bytes|weighted) port
+// amount-of-I/O-threads amount-of-connections time-for-waiting'
+int main(int argc, char* argv[]) {
+  if (argc != 6) {
+    ::fprintf(stderr,
+              "Usage: balancer_bench "
+              "<rr|min-events|p2c|latency|bytes|weighted> <port> <io_threads> "
+              "<connections> <time>\n");
+    return 0;
+  }
+  int strategy = -1;
+  for (const auto& strategy_name : kStrategyNames) {
+    if (::strcmp(argv[1], strategy_name.name) == 0) {
+      strategy = strategy_name.strategy;
+    }
+  }
+  if (strategy < 0) {
+    ::fprintf(stderr, "Unknown strategy: %s\n", argv[1]);
+    return 0;
+  }
+  auto port = static_cast<uint16_t>(::atoi(argv[2]));
+  auto io_thread_amount = static_cast<size_t>(::atoi(argv[3]));
+  auto connection_amount = static_cast<size_t>(::atoi(argv[4]));
+  int timeout = ::atoi(argv[5]);
+  taotu::START_LOG("balancer_bench_log.txt");
+
+  // The first one only accepts
+  std::vector<taotu::EventManager*> event_managers;
+  for (size_t i = 0; i <= io_thread_amount; ++i) {
+    event_managers.push_back(new taotu::EventManager);
+  }
+  auto server = std::make_unique<taotu::Server>(
+      &event_managers, taotu::NetAddress{port}, false);
+  server->SetMessageCallback(
+      [](taotu::Connecting&, taotu::IoBuffer* io_buffer, taotu::TimePoint) {
+        io_buffer->RefreshRW();
+      });
+  server->SetBalancerStrategy(strategy);
+  std::thread server_thread([&server]() { server->Start(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Connections arrive one by one, so load-aware strategies can see the load
+  // of the connections before
+  std::vector<std::thread> clients;
+  for (size_t i = 0; i < connection_amount; ++i) {
+    clients.emplace_back(RunClient, port, i % io_thread_amount == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  // Sample the published load of each I/O thread
+  std::vector<double> bytes_per_second(io_thread_amount + 1, 0.0);
+  std::vector<double> busy_permille(io_thread_amount + 1, 0.0);
+  int sample_amount = timeout * 10;
+  for (int i = 0; i < sample_amount; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (size_t j = 1; j <= io_thread_amount; ++j) {
+      const auto& loop_metrics = event_managers[j]->GetLoopMetrics();
+      bytes_per_second[j] +=
+          static_cast<double>(loop_metrics.GetBytesPerSecond()) /
+          sample_amount;
+      busy_permille[j] +=
+          static_cast<double>(loop_metrics.GetBusyPermille()) / sample_amount;
+    }
+  }
+  is_stopped.store(true);
+
+  double total = 0.0;
+  double max = 0.0;
+  ::printf("%-8s%-14s%-10s%-12s\n", "thread", "connections", "busy(%)",
+           "MiB/s");
+  for (size_t j = 1; j <= io_thread_amount; ++j) {
+    double mib_per_second = bytes_per_second[j] / (1024 * 1024);
+    total += mib_per_second;
+    max = std::max(max, mib_per_second);
+    ::printf("%-8zu%-14u%-10.1lf%-12.1lf\n", j,
+             event_managers[j]->GetLoopMetrics().GetActiveConnections(),
+             busy_permille[j] / 10, mib_per_second);
+  }
+  double mean = total / static_cast<double>(io_thread_amount);
+  ::printf(
+      "Strategy %s: the throughput is %lfMiB/s,\nand the imbalance (max / "
+      "mean) is %lf.\n",
+      argv[1], total, mean > 0.0 ? max / mean : 0.0);
+  ::fflush(stdout);
+
+  for (auto& client : clients) {
+    client.join();
+  }
+  event_managers[0]->Quit();
+  server_thread.join();
+  server.reset();
+  for (size_t i = event_managers.size(); i > 0; --i) {
+    delete event_managers[i - 1];
+  }
+  taotu::END_LOG();
+  return 0;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file core_bench_main.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief The entrance of the microbenchmarks of the core data structures (run
+ * with "--benchmark_out=<file> --benchmark_out_format=json" to keep results).
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../src/logger.h"
+
+int main(int argc, char* argv[]) {
+  // The logger is shared by all cases (and started only once)
+  taotu::START_LOG("core_bench_log.txt");
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    taotu::END_LOG();
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+  ::benchmark::Shutdown();
+  taotu::END_LOG();
+  return 0;
+}
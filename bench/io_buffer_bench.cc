@@ -0,0 +1,66 @@
+/**
+ * @file io_buffer_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of appending, retrieving, finding and growing of
+ * "IoBuffer".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "../src/io_buffer.h"
+
+namespace {
+
+void BM_IoBufferAppendRetrieve(benchmark::State& state) {
+  std::string message(state.range(0), 'x');
+  taotu::IoBuffer io_buffer;
+  for (auto _ : state) {
+    io_buffer.Append(message.data(), message.size());
+    benchmark::DoNotOptimize(io_buffer.RetrieveAllAsString());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+// Lines appended and taken one by one, as line-based protocols do
+void BM_IoBufferFindCrlf(benchmark::State& state) {
+  std::string line(state.range(0) - 2, 'a');
+  line += "\r\n";
+  taotu::IoBuffer io_buffer;
+  for (auto _ : state) {
+    io_buffer.Append(line.data(), line.size());
+    const char* crlf = io_buffer.FindCrlf();
+    benchmark::DoNotOptimize(crlf);
+    io_buffer.Refresh(crlf + 2 - io_buffer.GetReadablePosition());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+// Filling a new buffer in 512-byte pieces up to the size
+void BM_IoBufferGrow(benchmark::State& state) {
+  constexpr size_t kPieceSize = 512;
+  std::string piece(kPieceSize, 'x');
+  auto total_size = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    taotu::IoBuffer io_buffer;
+    for (size_t size = 0; size < total_size; size += kPieceSize) {
+      io_buffer.Append(piece.data(), piece.size());
+    }
+    benchmark::DoNotOptimize(io_buffer.GetReadablePosition());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_IoBufferAppendRetrieve)->Range(16, 64 * 1024);
+BENCHMARK(BM_IoBufferFindCrlf)->Range(16, 16 * 1024);
+BENCHMARK(BM_IoBufferGrow)->Range(4 * 1024, 4 * 1024 * 1024);
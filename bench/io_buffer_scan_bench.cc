@@ -0,0 +1,168 @@
+/**
+ * @file io_buffer_scan_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of delimiter scanning of "IoBuffer" against the former
+ * "memmem()" / "memchr()" based searching.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include <string>
+#include <string_view>
+
+#include "../src/byte_scanner.h"
+#include "../src/io_buffer.h"
+
+namespace {
+
+// Header lines of "len" bytes in total, followed by the terminating CRLF
+std::string MakeHeaders(size_t len) {
+  std::string headers;
+  while (headers.size() + 32 < len) {
+    headers += "X-Taotu-Field: some-value-0711\r\n";
+  }
+  headers.append(len - headers.size() - 4, 'v');
+  headers += "\r\n\r\n";
+  return headers;
+}
+
+// One line without CRLF until the end
+std::string MakeLine(size_t len) {
+  std::string line(len - 2, 'a');
+  line += "\r\n";
+  return line;
+}
+
+const char* MemmemFind(const std::string& text, const char* pattern,
+                       size_t pattern_len) {
+  return static_cast<const char*>(
+      ::memmem(text.data(), text.size(), pattern, pattern_len));
+}
+
+void SetUp(benchmark::State& state, size_t len) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * len);
+}
+
+void BM_FindCrlfMemmem(benchmark::State& state) {
+  std::string line = MakeLine(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(MemmemFind(line, "\r\n", 2));
+  }
+  SetUp(state, line.size());
+}
+
+void BM_FindCrlf(benchmark::State& state) {
+  taotu::byte_scanner::SetScanLevel(
+      static_cast<taotu::ScanLevel>(state.range(1)));
+  std::string line = MakeLine(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(taotu::byte_scanner::FindCrlf(
+        line.data(), line.data() + line.size()));
+  }
+  SetUp(state, line.size());
+}
+
+void BM_FindDoubleCrlfMemmem(benchmark::State& state) {
+  std::string headers = MakeHeaders(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(MemmemFind(headers, "\r\n\r\n", 4));
+  }
+  SetUp(state, headers.size());
+}
+
+void BM_FindDoubleCrlf(benchmark::State& state) {
+  taotu::byte_scanner::SetScanLevel(
+      static_cast<taotu::ScanLevel>(state.range(1)));
+  std::string headers = MakeHeaders(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(taotu::byte_scanner::FindDoubleCrlf(
+        headers.data(), headers.data() + headers.size()));
+  }
+  SetUp(state, headers.size());
+}
+
+void BM_FindAnyOfStringView(benchmark::State& state) {
+  std::string text(state.range(0), 'a');
+  text.back() = '$';
+  std::string_view text_view(text);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(text_view.find_first_of("\r\n$*"));
+  }
+  SetUp(state, text.size());
+}
+
+void BM_FindAnyOf(benchmark::State& state) {
+  taotu::byte_scanner::SetScanLevel(
+      static_cast<taotu::ScanLevel>(state.range(1)));
+  std::string text(state.range(0), 'a');
+  text.back() = '$';
+  taotu::ByteSet byte_set("\r\n$*");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(taotu::byte_scanner::FindAnyOf(
+        text.data(), text.data() + text.size(), byte_set));
+  }
+  SetUp(state, text.size());
+}
+
+// Headers arriving in 512-byte pieces, searched after each piece from the
+// beginning (as before) or from where the last search stopped
+void BM_IncrementalFinding(benchmark::State& state) {
+  bool is_resumable = state.range(1) != 0;
+  std::string headers = MakeHeaders(state.range(0));
+  constexpr size_t kPieceSize = 512;
+  taotu::IoBuffer io_buffer;
+  for (auto _ : state) {
+    size_t scanned_bytes = 0;
+    const char* position = nullptr;
+    for (size_t offset = 0; position == nullptr; offset += kPieceSize) {
+      size_t len = std::min(kPieceSize, headers.size() - offset);
+      io_buffer.Append(headers.data() + offset, len);
+      if (is_resumable) {
+        position = io_buffer.FindDoubleCrlfFrom(&scanned_bytes);
+      } else {
+        position = static_cast<const char*>(
+            ::memmem(io_buffer.GetReadablePosition(),
+                     io_buffer.GetReadableBytes(), "\r\n\r\n", 4));
+      }
+    }
+    benchmark::DoNotOptimize(position);
+    io_buffer.RefreshRW();
+  }
+  SetUp(state, headers.size());
+}
+
+void LevelArguments(benchmark::internal::Benchmark* benchmark) {
+  for (int64_t len : {64, 1024, 16 * 1024, 64 * 1024}) {
+    for (auto scan_level :
+         {taotu::ScanLevel::kScalar, taotu::ScanLevel::kSse42,
+          taotu::ScanLevel::kAvx2}) {
+      benchmark->Args({len, static_cast<int64_t>(scan_level)});
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_FindCrlfMemmem)->Arg(64)->Arg(1024)->Arg(16 * 1024)->Arg(64 * 1024);
+BENCHMARK(BM_FindCrlf)->Apply(LevelArguments);
+BENCHMARK(BM_FindDoubleCrlfMemmem)
+    ->Arg(64)
+    ->Arg(1024)
+    ->Arg(16 * 1024)
+    ->Arg(64 * 1024);
+BENCHMARK(BM_FindDoubleCrlf)->Apply(LevelArguments);
+BENCHMARK(BM_FindAnyOfStringView)
+    ->Arg(64)
+    ->Arg(1024)
+    ->Arg(16 * 1024)
+    ->Arg(64 * 1024);
+BENCHMARK(BM_FindAnyOf)->Apply(LevelArguments);
+BENCHMARK(BM_IncrementalFinding)
+    ->ArgsProduct({{4 * 1024, 16 * 1024, 64 * 1024}, {0, 1}});
+
+BENCHMARK_MAIN();
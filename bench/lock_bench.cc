@@ -0,0 +1,44 @@
+/**
+ * @file lock_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of "MutexLock" under contention against "std::mutex".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include <mutex>
+
+#include "../src/spin_lock.h"
+
+namespace {
+
+taotu::MutexLock mutex_lock;
+std::mutex std_mutex;
+int64_t shared_counter = 0;
+
+// All threads keep taking the same lock for a tiny critical section
+void BM_MutexLockContention(benchmark::State& state) {
+  for (auto _ : state) {
+    taotu::LockGuard lock_guard(mutex_lock);
+    benchmark::DoNotOptimize(++shared_counter);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+void BM_StdMutexContention(benchmark::State& state) {
+  for (auto _ : state) {
+    std::lock_guard<std::mutex> lock_guard(std_mutex);
+    benchmark::DoNotOptimize(++shared_counter);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_MutexLockContention)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_StdMutexContention)->ThreadRange(1, 16)->UseRealTime();
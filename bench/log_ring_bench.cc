@@ -0,0 +1,241 @@
+/**
+ * @file log_ring_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of putting log records into per-thread "LogRing"s (on the
+ * heap or in a crash file) against the shared ring of string slots used by the
+ * logger before.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/log_crash_file.h"
+#include "../src/log_ring.h"
+
+namespace {
+
+constexpr size_t kRingByte = 1024 * 1024;
+constexpr size_t kSlotAmount = 1024 * 16;  // Power of two
+
+// The shared ring of the logger before: every producer takes a slot by CAS on
+// one index and moves a heap-allocated string into it
+class SlotRing {
+ public:
+  SlotRing() {
+    for (size_t i = 0; i < kSlotAmount; ++i) {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool Enqueue(std::string&& data) {
+    size_t pos = write_index_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots_[pos & (kSlotAmount - 1)];
+      size_t seq = slot.seq.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (0 == diff) {
+        if (write_index_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          slot.data = std::move(data);
+          slot.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = write_index_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool Dequeue(std::string* out) {
+    size_t pos = read_index_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[pos & (kSlotAmount - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+      return false;
+    }
+    read_index_.store(pos + 1, std::memory_order_relaxed);
+    out->swap(slot.data);
+    slot.seq.store(pos + kSlotAmount, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> seq{0};
+    std::string data;
+  };
+
+  alignas(64) std::atomic<size_t> write_index_{0};
+  alignas(64) std::atomic<size_t> read_index_{0};
+  std::array<Slot, kSlotAmount> slots_;
+};
+
+// One consumer thread (like the writer thread of the logger) drains the
+// records while the benchmark threads produce them (started and stopped by
+// the first benchmark thread, while the others only touch what is guarded)
+struct Consumer {
+  std::thread thread;
+  std::atomic<bool> is_stopping{false};
+  std::atomic<int64_t> consumed{0};
+
+  std::mutex rings_mutex;
+  std::vector<std::shared_ptr<taotu::logger::LogRing>> rings;
+  SlotRing slot_ring;
+};
+Consumer consumer;
+
+void ConsumeRings() {
+  std::vector<std::shared_ptr<taotu::logger::LogRing>> rings;
+  while (!consumer.is_stopping.load(std::memory_order_acquire)) {
+    {
+      std::lock_guard<std::mutex> lock(consumer.rings_mutex);
+      rings = consumer.rings;
+    }
+    int64_t amount = 0;
+    for (const auto& ring : rings) {
+      amount += static_cast<int64_t>(
+          ring->Drain([](const char* record, size_t record_size) {
+            benchmark::DoNotOptimize(record[record_size - 1]);
+          }));
+      // Rings in the crash file get room back only here
+      ring->ReleaseDrained();
+    }
+    consumer.consumed.fetch_add(amount, std::memory_order_relaxed);
+  }
+}
+
+void ConsumeSlots() {
+  std::string record;
+  while (!consumer.is_stopping.load(std::memory_order_acquire)) {
+    while (consumer.slot_ring.Dequeue(&record)) {
+      benchmark::DoNotOptimize(record.back());
+      consumer.consumed.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void StartConsumer(benchmark::State& state, void (*consume)()) {
+  if (0 == state.thread_index()) {
+    consumer.is_stopping.store(false, std::memory_order_release);
+    consumer.consumed.store(0, std::memory_order_relaxed);
+    consumer.thread = std::thread(consume);
+  }
+}
+
+void StopConsumer(benchmark::State& state) {
+  if (0 == state.thread_index()) {
+    consumer.is_stopping.store(true, std::memory_order_release);
+    consumer.thread.join();
+    state.counters["consumed"] =
+        static_cast<double>(consumer.consumed.load(std::memory_order_relaxed));
+    std::lock_guard<std::mutex> lock(consumer.rings_mutex);
+    consumer.rings.clear();
+  }
+}
+
+const char kFormat[] = "[ Thu Oct 18 12:00:00 2026 ] Log(Info): Thread(%d) "
+                       "records the message(%d) of %s.\n";
+
+// Each thread formats records right into its own ring
+void PutIntoRing(benchmark::State& state,
+                 const std::shared_ptr<taotu::logger::LogRing>& ring) {
+  {
+    std::lock_guard<std::mutex> lock(consumer.rings_mutex);
+    consumer.rings.push_back(ring);
+  }
+  int i = 0;
+  int64_t dropped = 0;
+  for (auto _ : state) {
+    ++i;
+    int size = ::snprintf(nullptr, 0, kFormat, state.thread_index(), i,
+                          "the benchmark");
+    char* record = ring->Reserve(static_cast<size_t>(size) + 1);
+    if (nullptr == record) {
+      ++dropped;
+      continue;
+    }
+    ::snprintf(record, static_cast<size_t>(size) + 1, kFormat,
+               state.thread_index(), i, "the benchmark");
+    ring->Commit(static_cast<size_t>(size));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["dropped"] =
+      benchmark::Counter(static_cast<double>(dropped),
+                         benchmark::Counter::kAvgThreads);
+}
+
+void BM_PerThreadLogRing(benchmark::State& state) {
+  StartConsumer(state, ConsumeRings);
+  PutIntoRing(state, std::make_shared<taotu::logger::LogRing>(kRingByte));
+  StopConsumer(state);
+}
+
+// Rings in a file mapped in memory, kept after a crash (the file is removed
+// at once since the mapping is enough here)
+taotu::logger::LogCrashFile* GetCrashFile() {
+  static auto crash_file = [] {
+    auto crash_file = std::make_shared<taotu::logger::LogCrashFile>();
+    if (!crash_file->Open("log_ring_bench.crash", kRingByte, 8)) {
+      crash_file.reset();
+    }
+    ::remove("log_ring_bench.crash");
+    return crash_file;
+  }();
+  return crash_file.get();
+}
+
+void BM_CrashFileLogRing(benchmark::State& state) {
+  auto* crash_file = GetCrashFile();
+  auto ring = crash_file != nullptr ? crash_file->CreateRing() : nullptr;
+  if (nullptr == ring) {
+    state.SkipWithError("No segment of the crash file is free!");
+    return;
+  }
+  StartConsumer(state, ConsumeRings);
+  PutIntoRing(state, ring);
+  StopConsumer(state);
+}
+
+// All threads share one ring of string slots
+void BM_SharedSlotRing(benchmark::State& state) {
+  StartConsumer(state, ConsumeSlots);
+  int i = 0;
+  int64_t dropped = 0;
+  for (auto _ : state) {
+    ++i;
+    int size = ::snprintf(nullptr, 0, kFormat, state.thread_index(), i,
+                          "the benchmark");
+    std::string record(static_cast<size_t>(size) + 1, '\0');
+    ::snprintf(&record[0], record.size(), kFormat, state.thread_index(), i,
+               "the benchmark");
+    record.pop_back();
+    if (!consumer.slot_ring.Enqueue(std::move(record))) {
+      ++dropped;
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["dropped"] =
+      benchmark::Counter(static_cast<double>(dropped),
+                         benchmark::Counter::kAvgThreads);
+  StopConsumer(state);
+}
+
+}  // namespace
+
+BENCHMARK(BM_PerThreadLogRing)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_CrashFileLogRing)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_SharedSlotRing)->ThreadRange(1, 8)->UseRealTime();
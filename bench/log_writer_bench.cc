@@ -0,0 +1,106 @@
+/**
+ * @file log_writer_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of writing log files in batches by io_uring against
+ * "fwrite()" and "fflush()".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "../src/log_file_writer.h"
+
+namespace {
+
+constexpr char kBenchLogName[] = "log_writer_bench.log";
+// Lines of one drain of the rings by the writer thread
+constexpr int kLinesPerFlush = 64;
+// Start over before the file gets too large
+constexpr int64_t kMaxBenchFileByte = 256 * 1024 * 1024;
+
+const std::string& GetLine() {
+  static const std::string line =
+      "[ 2026-10-18T12:00:00.123456+08:00 ] Log(Info): Thread(3) records "
+      "the message(123456) of the benchmark.\n";
+  return line;
+}
+
+// What the writer thread does: append lines, then flush once drained. The
+// longest flush is the longest stall of the writer thread, during which the
+// rings of producers fill up.
+void BM_LogFileWriter(benchmark::State& state) {
+  taotu::logger::LogWriteOptions options;
+  options.batch_byte = static_cast<size_t>(state.range(0)) * 1024;
+  options.is_direct = state.range(1) != 0;
+  taotu::logger::LogFileWriter writer;
+  writer.Open(kBenchLogName, options);
+  const std::string& line = GetLine();
+  double max_flush_us = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kLinesPerFlush; ++i) {
+      writer.Append(line.c_str(), line.size());
+    }
+    auto start = std::chrono::steady_clock::now();
+    writer.Flush();
+    max_flush_us = std::max(
+        max_flush_us, std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+    if (writer.GetFileByte() >= kMaxBenchFileByte) {
+      writer.Open(kBenchLogName, options);
+    }
+  }
+  writer.Close();
+  ::remove(kBenchLogName);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          kLinesPerFlush * static_cast<int64_t>(line.size()));
+  state.counters["max_flush_us"] = max_flush_us;
+}
+
+// The former way
+void BM_StdioWriter(benchmark::State& state) {
+  FILE* file = ::fopen(kBenchLogName, "wb");
+  const std::string& line = GetLine();
+  double max_flush_us = 0;
+  int64_t file_byte = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kLinesPerFlush; ++i) {
+      ::fwrite(line.c_str(), line.size(), 1, file);
+    }
+    auto start = std::chrono::steady_clock::now();
+    ::fflush(file);
+    max_flush_us = std::max(
+        max_flush_us, std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+    file_byte += kLinesPerFlush * static_cast<int64_t>(line.size());
+    if (file_byte >= kMaxBenchFileByte) {
+      file = ::freopen(kBenchLogName, "wb", file);
+      file_byte = 0;
+    }
+  }
+  ::fclose(file);
+  ::remove(kBenchLogName);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          kLinesPerFlush * static_cast<int64_t>(line.size()));
+  state.counters["max_flush_us"] = max_flush_us;
+}
+
+}  // namespace
+
+// Batches of 1 MiB and 4 MiB, through the page cache or not
+BENCHMARK(BM_LogFileWriter)
+    ->Args({1024, 0})
+    ->Args({4096, 0})
+    ->Args({1024, 1})
+    ->Args({4096, 1})
+    ->UseRealTime();
+BENCHMARK(BM_StdioWriter)->UseRealTime();
@@ -0,0 +1,73 @@
+/**
+ * @file logger_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of recording logs by several threads at once.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <time.h>
+
+#include <mutex>
+#include <string>
+
+#include "../src/log_clock.h"
+#include "../src/logger.h"
+
+namespace {
+
+// The logger is started by "main()" of the benchmarks
+void BM_RecordLogs(benchmark::State& state) {
+  int i = 0;
+  for (auto _ : state) {
+    taotu::LOG_INFO("Thread(%d) records the message(%d) of %s.",
+                    state.thread_index(), ++i, "the benchmark");
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Logs of a level off cost one relaxed atomic load
+void BM_SkipLogsOfLevelOff(benchmark::State& state) {
+  taotu::SET_LOG_LEVEL(taotu::logger::kWarn);
+  int i = 0;
+  for (auto _ : state) {
+    taotu::LOG_INFO("Thread(%d) skips the message(%d) of %s.",
+                    state.thread_index(), ++i, "the benchmark");
+  }
+  taotu::SET_LOG_LEVEL(taotu::logger::kDebug);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Timestamps of records in a few seconds formatted by several threads
+void BM_FormatTimestamp(benchmark::State& state) {
+  char buffer[taotu::logger::LogClock::kTimestampByte];
+  int64_t time_us = taotu::logger::LogClock::Now();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        taotu::logger::LogClock::FormatTimestamp(time_us, buffer));
+    time_us += 37;
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// The former way: "localtime()" and "asctime()" under a mutex, copied out
+void BM_FormatAsctimeLocked(benchmark::State& state) {
+  static std::mutex time_mutex;
+  for (auto _ : state) {
+    time_t now = ::time(nullptr);
+    std::lock_guard<std::mutex> lock(time_mutex);
+    std::string time_str(::asctime(::localtime(&now)));
+    benchmark::DoNotOptimize(time_str);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_FormatTimestamp)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_FormatAsctimeLocked)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_RecordLogs)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_SkipLogsOfLevelOff)->UseRealTime();
@@ -0,0 +1,71 @@
+/**
+ * @file poller_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of the round trip of submitting I/O operations to
+ * "Poller" and handling their completions, over a pair of sockets.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "../src/eventer.h"
+#include "../src/poller.h"
+
+namespace {
+
+void OnDone(struct io_uring_cqe* cqe, taotu::Poller::IoUringOp* op) {
+  auto* done_amount = static_cast<int*>(op->context);
+  if (cqe->res >= 0) {
+    ++*done_amount;
+  }
+}
+
+// Write "range(0)" bytes into one end and read them from the other end, both
+// through the ring
+void BM_PollerWriteReadRoundTrip(benchmark::State& state) {
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+    state.SkipWithError("socketpair() failed");
+    return;
+  }
+  {
+    taotu::Poller poller;
+    taotu::Eventer writing_eventer(&poller, fds[0]);
+    taotu::Eventer reading_eventer(&poller, fds[1]);
+    std::string message(state.range(0), 'x');
+    std::string received(state.range(0), '\0');
+    taotu::Poller::EventerList active_eventers;
+    for (auto _ : state) {
+      int done_amount = 0;
+      struct iovec write_iov {
+        message.data(), message.size()
+      };
+      struct iovec read_iov {
+        received.data(), received.size()
+      };
+      poller.SubmitWrite(&writing_eventer, &write_iov, 1, OnDone,
+                         &done_amount);
+      poller.SubmitRead(&reading_eventer, &read_iov, 1, OnDone, &done_amount);
+      while (done_amount < 2) {
+        active_eventers.clear();
+        poller.Poll(1, &active_eventers);
+      }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            state.range(0));
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+}  // namespace
+
+BENCHMARK(BM_PollerWriteReadRoundTrip)->Range(64, 16 * 1024);
@@ -0,0 +1,98 @@
+/**
+ * @file pool_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of "MemoryPool" and "ObjectPool" against "malloc()" and
+ * "new".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/memory_pool.h"
+#include "../src/object_pool.h"
+
+namespace {
+
+// Some object as big as a small connection state
+struct Object {
+  Object() : name("taotu") {}
+  std::string name;
+  int64_t numbers[4] = {0, 0, 0, 0};
+};
+
+// Each iteration takes "range(0)" blocks and then gives them all back
+void BM_Malloc(benchmark::State& state) {
+  std::vector<void*> blocks(state.range(0));
+  for (auto _ : state) {
+    for (auto& block : blocks) {
+      block = ::malloc(sizeof(Object));
+    }
+    benchmark::DoNotOptimize(blocks.data());
+    for (auto* block : blocks) {
+      ::free(block);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+void BM_MemoryPool(benchmark::State& state) {
+  taotu::MemoryPool<sizeof(Object)> memory_pool;
+  std::vector<void*> blocks(state.range(0));
+  for (auto _ : state) {
+    for (auto& block : blocks) {
+      block = memory_pool.Allocate();
+    }
+    benchmark::DoNotOptimize(blocks.data());
+    for (auto* block : blocks) {
+      memory_pool.Deallocate(block);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+void BM_NewDelete(benchmark::State& state) {
+  std::vector<Object*> objects(state.range(0));
+  for (auto _ : state) {
+    for (auto& object : objects) {
+      object = new Object;
+    }
+    benchmark::DoNotOptimize(objects.data());
+    for (auto* object : objects) {
+      delete object;
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+void BM_ObjectPool(benchmark::State& state) {
+  taotu::ObjectPool<Object> object_pool;
+  std::vector<Object*> objects(state.range(0));
+  for (auto _ : state) {
+    for (auto& object : objects) {
+      object = object_pool.New();
+    }
+    benchmark::DoNotOptimize(objects.data());
+    for (auto* object : objects) {
+      object_pool.Delete(object);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_Malloc)->Range(1, 4096);
+BENCHMARK(BM_MemoryPool)->Range(1, 4096);
+BENCHMARK(BM_NewDelete)->Range(1, 4096);
+BENCHMARK(BM_ObjectPool)->Range(1, 4096);
@@ -0,0 +1,82 @@
+/**
+ * @file rpc_codec_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of encoding, decoding and checksums of "RpcCodec".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "../src/io_buffer.h"
+#include "../src/rpc.pb.h"
+#include "../src/rpc_channel.h"
+#include "../src/rpc_codec.h"
+
+namespace {
+
+taotu::RpcCodec MakeCodec() {
+  return taotu::RpcCodec{&taotu::RpcMessage::default_instance(),
+                         taotu::kRpcTag,
+                         taotu::RpcCodec::AsyncProtobufMessageCallback{}};
+}
+
+// A request carrying "payload_size" bytes
+taotu::RpcMessage MakeRequest(size_t payload_size) {
+  taotu::RpcMessage message;
+  message.set_type(taotu::REQUEST);
+  message.set_id(711);
+  message.set_service("timeservice.TimeService");
+  message.set_method("GetTime");
+  message.set_request(std::string(payload_size, 'x'));
+  return message;
+}
+
+void BM_RpcEncode(benchmark::State& state) {
+  auto codec = MakeCodec();
+  auto message = MakeRequest(state.range(0));
+  taotu::IoBuffer io_buffer;
+  for (auto _ : state) {
+    codec.FillEmptyBuffer(&io_buffer, message);
+    benchmark::DoNotOptimize(io_buffer.GetReadablePosition());
+    io_buffer.RefreshRW();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+void BM_RpcDecode(benchmark::State& state) {
+  auto codec = MakeCodec();
+  taotu::IoBuffer io_buffer;
+  codec.FillEmptyBuffer(&io_buffer, MakeRequest(state.range(0)));
+  const char* frame =
+      io_buffer.GetReadablePosition() + taotu::RpcCodec::kHeaderLength;
+  int32_t frame_length = io_buffer.GetReadableInt32();
+  taotu::RpcMessage message;
+  for (auto _ : state) {
+    auto error_code = codec.Parse(frame, frame_length, &message);
+    benchmark::DoNotOptimize(error_code);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+void BM_RpcChecksum(benchmark::State& state) {
+  std::string buffer(state.range(0), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(taotu::RpcCodec::Checksum(
+        buffer.data(), static_cast<int>(buffer.size())));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_RpcEncode)->Range(16, 64 * 1024);
+BENCHMARK(BM_RpcDecode)->Range(16, 64 * 1024);
+BENCHMARK(BM_RpcChecksum)->Range(16, 64 * 1024);
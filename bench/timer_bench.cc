@@ -0,0 +1,65 @@
+/**
+ * @file timer_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Benchmarks of adding and expiring time tasks of "Timer".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "../src/time_point.h"
+#include "../src/timer.h"
+
+namespace {
+
+// Adding "range(0)" tasks spread over the next second
+void BM_TimerAdd(benchmark::State& state) {
+  int64_t task_amount = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto timer = std::make_unique<taotu::Timer>();
+    state.ResumeTiming();
+    for (int64_t i = 0; i < task_amount; ++i) {
+      int64_t delay_microseconds = (i * 7919) % (1000 * 1000);
+      timer->AddTimeTask(taotu::TimePoint{delay_microseconds}, []() {});
+    }
+    state.PauseTiming();
+    timer.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          task_amount);
+}
+
+// Taking "range(0)" due tasks and running them
+void BM_TimerExpire(benchmark::State& state) {
+  int64_t task_amount = state.range(0);
+  int64_t done_amount = 0;
+  taotu::Timer timer;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int64_t i = 0; i < task_amount; ++i) {
+      timer.AddTimeTask(taotu::TimePoint{0}, [&done_amount]() {
+        ++done_amount;
+      });
+    }
+    state.ResumeTiming();
+    for (auto& time_task : timer.GetExpiredTimeTasks()) {
+      time_task.second();
+    }
+  }
+  benchmark::DoNotOptimize(done_amount);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          task_amount);
+}
+
+}  // namespace
+
+BENCHMARK(BM_TimerAdd)->Range(64, 64 * 1024);
+BENCHMARK(BM_TimerExpire)->Range(64, 64 * 1024);
@@ -12,9 +12,23 @@
 
 #include <stdio.h>
 
+namespace {
+
+// Each one runs its own loop (in its own thread, except the first one)
+std::vector<taotu::EventManager*> CreateEventManagers(size_t amount) {
+  std::vector<taotu::EventManager*> event_managers;
+  event_managers.reserve(amount);
+  for (size_t i = 0; i < amount; ++i) {
+    event_managers.push_back(new taotu::EventManager);
+  }
+  return event_managers;
+}
+
+}  // namespace
+
 ChatServer::ChatServer(const taotu::NetAddress& listen_address,
                        bool should_reuse_port, size_t io_thread_amount)
-    : event_managers_(io_thread_amount, new taotu::EventManager),
+    : event_managers_(CreateEventManagers(io_thread_amount)),
       server_(std::make_unique<taotu::Server>(&event_managers_, listen_address,
                                               should_reuse_port)),
       codec_([this](taotu::Connecting& connection, const std::string& message,
@@ -31,6 +45,7 @@ ChatServer::ChatServer(const taotu::NetAddress& listen_address,
   });
 }
 ChatServer::~ChatServer() {
+  server_.reset();  // Before the event managers it uses
   size_t event_managers_size = event_managers_.size();
   for (size_t i = 0; i < event_managers_size; ++i) {
     delete event_managers_[i];
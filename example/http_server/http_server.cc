@@ -15,9 +15,23 @@
 #include "http_parser.h"
 #include "http_response.h"
 
+namespace {
+
+// Each one runs its own loop (in its own thread, except the first one)
+std::vector<taotu::EventManager*> CreateEventManagers(size_t amount) {
+  std::vector<taotu::EventManager*> event_managers;
+  event_managers.reserve(amount);
+  for (size_t i = 0; i < amount; ++i) {
+    event_managers.push_back(new taotu::EventManager);
+  }
+  return event_managers;
+}
+
+}  // namespace
+
 HttpServer::HttpServer(const taotu::NetAddress& listen_address,
                        bool should_reuse_port, size_t io_thread_amount)
-    : event_managers_(io_thread_amount, new taotu::EventManager),
+    : event_managers_(CreateEventManagers(io_thread_amount)),
       server_(std::make_unique<taotu::Server>(&event_managers_, listen_address,
                                               should_reuse_port)) {
   server_->SetConnectionCallback([this](taotu::Connecting& connection) {
@@ -31,6 +45,7 @@ HttpServer::HttpServer(const taotu::NetAddress& listen_address,
 }
 
 HttpServer::~HttpServer() {
+  server_.reset();  // Before the event managers it uses
   size_t event_managers_size = event_managers_.size();
   for (size_t i = 0; i < event_managers_size; ++i) {
     delete event_managers_[i];
@@ -40,6 +55,11 @@ HttpServer::~HttpServer() {
 
 void HttpServer::Start() { server_->Start(); }
 
+void HttpServer::EnableHandoff(const taotu::NetAddress& handoff_address,
+                               int64_t drain_timeout_microseconds) {
+  server_->EnableHandoff(handoff_address, drain_timeout_microseconds);
+}
+
 void HttpServer::OnConnectionCallback(taotu::Connecting& connection) {
   if (connection.IsConnected()) {
     connection.SetContext<HttpParser>(llhttp_type_t::HTTP_REQUEST);
@@ -49,8 +69,12 @@ void HttpServer::OnConnectionCallback(taotu::Connecting& connection) {
 void HttpServer::OnMessageCallback(taotu::Connecting& connection,
                                    taotu::IoBuffer* io_buffer,
                                    taotu::TimePoint time_point) {
-  auto& parser_any = connection.GetMutableContext();
-  auto& parser = std::any_cast<HttpParser&>(parser_any);
+  auto* parser_ptr = connection.GetContext<HttpParser>();
+  if (parser_ptr == nullptr) {
+    io_buffer->RefreshRW();
+    return;
+  }
+  auto& parser = *parser_ptr;
   std::string message{io_buffer->RetrieveAllAsString()};
   if (!parser.Parse(message.c_str(), message.size())) {
     connection.Send("HTTP/1.1 400 Bad Request\r\n\r\n");
@@ -67,9 +91,11 @@ void HttpServer::OnRequest(taotu::Connecting& connection,
                              ? connection_info_optional.value()
                              : std::string{};
   auto version_pair = http_parser.GetVersionPair();
+  // A draining server sends the peer away to the new process
   bool should_close = ("close" == connection_info ||
                        (1 == version_pair.first && 0 == version_pair.second &&
-                        connection_info != "keep-alive"));
+                        connection_info != "keep-alive") ||
+                       server_->IsDraining());
   HttpResponse http_response(should_close);
   HttpCallback_(http_parser, &http_response);
   taotu::IoBuffer io_buffer;
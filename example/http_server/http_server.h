@@ -11,6 +11,8 @@
 #ifndef TAOTU_EXAMPLE_HTTP_SERVER_HTTP_SERVER_H_
 #define TAOTU_EXAMPLE_HTTP_SERVER_HTTP_SERVER_H_
 
+#include <stdint.h>
+
 #include <functional>
 #include <memory>
 
@@ -29,6 +31,12 @@ class HttpServer : taotu::NonCopyableMovable {
   // Start the server
   void Start();
 
+  // Serve the handoff socket for hot restarts (see "taotu::Server::
+  // EnableHandoff()"), after which keep-alive connections are closed once
+  // their next response is sent
+  void EnableHandoff(const taotu::NetAddress& handoff_address,
+                     int64_t drain_timeout_microseconds);
+
   void SetHttpCallback(const std::function<void(const HttpParser&,
                                                 HttpResponse*)>& HttpCallback) {
     HttpCallback_ = HttpCallback;
@@ -8,8 +8,18 @@
  *
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "../../src/listener_handoff.h"
 #include "http_server.h"
 
+namespace {
+constexpr int64_t kDrainTimeoutMicroseconds = 10 * 1000 * 1000;
+}  // namespace
+
 void OnRequest(const HttpParser& http_parser, HttpResponse* http_response) {
   http_response->SetVersion(1, 1);
   time_t time_now;
@@ -62,35 +72,32 @@ void OnRequest(const HttpParser& http_parser, HttpResponse* http_response) {
 }
 
 // Call it by:
-// './http_server [port [amount-of-I/O-threads]]'
+// './http_server [port [amount-of-I/O-threads [handoff-socket-path]]]'
 int main(int argc, char* argv[]) {
   taotu::START_LOG("http_server_log.txt");
-  if (1 == argc) {
-    HttpServer http_server{taotu::NetAddress{4567}, false};
-    http_server.SetHttpCallback(
-        [](const HttpParser& http_parser, HttpResponse* http_response) {
-          OnRequest(http_parser, http_response);
-        });
-    http_server.Start();
-  } else if (2 == argc) {
-    HttpServer http_server{taotu::NetAddress{static_cast<uint16_t>(
-                               std::stoi(std::string{argv[1]}))},
-                           false};
-    http_server.SetHttpCallback(
-        [](const HttpParser& http_parser, HttpResponse* http_response) {
-          OnRequest(http_parser, http_response);
-        });
-    http_server.Start();
-  } else {
-    HttpServer http_server{
-        taotu::NetAddress{
-            static_cast<uint16_t>(std::stoi(std::string{argv[1]}))},
-        false, static_cast<size_t>(std::stoi(std::string{argv[2]}))};
-    http_server.SetHttpCallback(
-        [](const HttpParser& http_parser, HttpResponse* http_response) {
-          OnRequest(http_parser, http_response);
-        });
-    http_server.Start();
+  uint16_t port = 4567;
+  size_t io_thread_amount = 4;
+  if (argc > 1) {
+    port = static_cast<uint16_t>(std::stoi(std::string{argv[1]}));
+  }
+  if (argc > 2) {
+    io_thread_amount = static_cast<size_t>(std::stoi(std::string{argv[2]}));
+  }
+  taotu::NetAddress handoff_address;
+  if (argc > 3) {
+    // Take over the listening sockets of the running one (if any), which
+    // drains then
+    handoff_address = taotu::NetAddress::FromUnixPath(std::string{argv[3]});
+    taotu::ListenerHandoff::Inherit(handoff_address);
+  }
+  HttpServer http_server{taotu::NetAddress{port}, false, io_thread_amount};
+  http_server.SetHttpCallback(
+      [](const HttpParser& http_parser, HttpResponse* http_response) {
+        OnRequest(http_parser, http_response);
+      });
+  if (argc > 3) {
+    http_server.EnableHandoff(handoff_address, kDrainTimeoutMicroseconds);
   }
+  http_server.Start();
   return 0;
 }
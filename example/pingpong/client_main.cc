@@ -18,6 +18,8 @@
 // Call it by:
 // './pingpong_client IP port amount-of-I/O-threads size-of-block-sent
 // amount-of-sessions time-for-waiting'
+// ("unix:/path/of/socket" as the IP connects to the Unix domain socket, and
+// the port is ignored then)
 int main(int argc, char* argv[]) {
   taotu::START_LOG("pingpong_client_log.txt");
   if (argc != 7) {
@@ -25,11 +27,15 @@ int main(int argc, char* argv[]) {
               "Usage: client <host_ip> <port> <threads> <blocksize> <sessions> "
               "<time>\n");
   } else {
+    std::string host{argv[1]};
+    const std::string unix_prefix{"unix:"};
+    taotu::NetAddress server_address =
+        host.compare(0, unix_prefix.size(), unix_prefix) == 0
+            ? taotu::NetAddress::FromUnixPath(host.substr(unix_prefix.size()))
+            : taotu::NetAddress{host, static_cast<uint16_t>(::atoi(argv[2]))};
     std::shared_ptr<PingpongClient> pingpong_client =
         std::make_shared<PingpongClient>(
-            taotu::NetAddress{std::string{argv[1]},
-                              static_cast<uint16_t>(::atoi(argv[2]))},
-            static_cast<size_t>(::atoi(argv[4])),
+            server_address, static_cast<size_t>(::atoi(argv[4])),
             static_cast<size_t>(::atoi(argv[5])), ::atoi(argv[6]),
             static_cast<size_t>(::atoi(argv[3])));
     pingpong_client->Start();
@@ -0,0 +1,137 @@
+/**
+ * @file latency_bench.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Round-trip latency benchmark of the pingpong server over TCP loopback
+ * and a Unix domain socket served by the same "Server".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pingpong_server.h"
+
+namespace {
+
+int Connect(const taotu::NetAddress& address) {
+  int fd = ::socket(address.GetFamily(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || ::connect(fd, address.GetNetAddress(),
+                          static_cast<socklen_t>(address.GetSize())) < 0) {
+    ::perror("connect");
+    ::exit(1);
+  }
+  if (!address.IsUnix()) {
+    int opt = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt,
+                 static_cast<socklen_t>(sizeof(opt)));
+  }
+  return fd;
+}
+
+// Send one block and wait for all of it to come back, "round_trip_amount"
+// times, and return the time (in nanoseconds) each round trip took
+std::vector<int64_t> PingPong(const taotu::NetAddress& address,
+                              size_t block_size, size_t round_trip_amount) {
+  int fd = Connect(address);
+  std::string block(block_size, 'x');
+  std::vector<char> echo(block_size);
+  std::vector<int64_t> latencies;
+  latencies.reserve(round_trip_amount);
+  for (size_t i = 0; i < round_trip_amount; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    if (::write(fd, block.data(), block.size()) !=
+        static_cast<ssize_t>(block.size())) {
+      ::perror("write");
+      ::exit(1);
+    }
+    size_t received = 0;
+    while (received < block_size) {
+      ssize_t n = ::read(fd, echo.data() + received, block_size - received);
+      if (n <= 0) {
+        ::perror("read");
+        ::exit(1);
+      }
+      received += static_cast<size_t>(n);
+    }
+    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+  }
+  ::close(fd);
+  return latencies;
+}
+
+void Report(const char* transport, std::vector<int64_t>* latencies) {
+  std::sort(latencies->begin(), latencies->end());
+  size_t amount = latencies->size();
+  double sum = 0.0;
+  for (auto latency : *latencies) {
+    sum += static_cast<double>(latency);
+  }
+  auto percentile = [latencies, amount](double p) {
+    size_t index = static_cast<size_t>(p * static_cast<double>(amount - 1));
+    return static_cast<double>((*latencies)[index]) / 1000;
+  };
+  ::printf("%-10s%-12.2lf%-12.2lf%-12.2lf%-12.2lf\n", transport,
+           sum / static_cast<double>(amount) / 1000, percentile(0.5),
+           percentile(0.99), percentile(0.999));
+}
+
+}  // namespace
+
+// Call it by:
+// './pingpong_latency_bench [port [size-of-block [amount-of-round-trips]]]'
+int main(int argc, char* argv[]) {
+  uint16_t port = argc > 1 ? static_cast<uint16_t>(::atoi(argv[1])) : 4567;
+  size_t block_size = argc > 2 ? static_cast<size_t>(::atoi(argv[2])) : 64;
+  size_t round_trip_amount =
+      argc > 3 ? static_cast<size_t>(::atoi(argv[3])) : 100000;
+  if (0 == block_size || 0 == round_trip_amount) {
+    ::fprintf(stderr, "Usage: pingpong_latency_bench [port [blocksize "
+                      "[round_trips]]]\n");
+    return 0;
+  }
+  taotu::START_LOG("pingpong_latency_bench_log.txt");
+  const std::string unix_path =
+      "/tmp/taotu_pingpong_" + std::to_string(::getpid()) + ".sock";
+  auto tcp_address = taotu::NetAddress{port, true};
+  auto unix_address = taotu::NetAddress::FromUnixPath(unix_path);
+
+  // One server listens to both, so only the transport differs
+  PingpongServer pingpong_server{tcp_address, false, 1};
+  pingpong_server.AddListener(unix_address);
+  std::thread server_thread([&pingpong_server]() { pingpong_server.Start(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Warm up both paths first
+  PingPong(tcp_address, block_size, round_trip_amount / 10 + 1);
+  PingPong(unix_address, block_size, round_trip_amount / 10 + 1);
+  auto tcp_latencies = PingPong(tcp_address, block_size, round_trip_amount);
+  auto unix_latencies = PingPong(unix_address, block_size, round_trip_amount);
+
+  ::printf("Round trips of %zu-byte blocks (in microseconds):\n", block_size);
+  ::printf("%-10s%-12s%-12s%-12s%-12s\n", "transport", "mean", "p50", "p99",
+           "p99.9");
+  Report("tcp", &tcp_latencies);
+  Report("unix", &unix_latencies);
+  ::fflush(stdout);
+
+  pingpong_server.Stop();
+  server_thread.join();
+  return 0;
+}
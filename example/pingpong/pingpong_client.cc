@@ -2,7 +2,7 @@
  * @file pingpong_client.cc
  * @author Sigma711 (sigma711 at foxmail dot com)
  * @brief Implementation of class "PingpongClient" which is a pingpong total
- * client and class "Session" which manage one connection to the server.
+ * client keeping its sessions in a "ClientPool".
  * @date 2022-03-28
  *
  * @copyright Copyright (c) 2022 Sigma711
@@ -15,7 +15,6 @@
 
 #include <utility>
 
-#include "../../src/balancer.h"
 #include "../../src/logger.h"
 
 PingpongClient::PingpongClient(const taotu::NetAddress& server_address,
@@ -38,10 +37,29 @@ PingpongClient::PingpongClient(const taotu::NetAddress& server_address,
   for (size_t i = 1; i <= block_size; ++i) {
     message_.emplace_back(static_cast<char>(i % 128));
   }
-  balancer_ = std::make_unique<taotu::Balancer>(&event_managers_, 0);
+  EventManagers pool_event_managers;
+  for (auto* event_manager : event_managers_) {
+    if (event_manager != nullptr) {
+      pool_event_managers.push_back(event_manager);
+      session_stats_.emplace_back();
+      session_stats_.back().event_manager = event_manager;
+    }
+  }
+  client_pool_ = std::make_unique<taotu::ClientPool>(
+      pool_event_managers, std::vector<taotu::NetAddress>{server_address_},
+      session_count_);
+  client_pool_->SetReconnectOn(false);
+  client_pool_->SetConnectionCallback([this](taotu::Connecting& connection) {
+    this->OnConnectionCallback(connection);
+  });
+  client_pool_->SetMessageCallback([this](taotu::Connecting& connection,
+                                          taotu::IoBuffer* io_buffer,
+                                          taotu::TimePoint time_point) {
+    this->OnMessageCallback(connection, io_buffer, std::move(time_point));
+  });
 }
 PingpongClient::~PingpongClient() {
-  sessions_.clear();
+  client_pool_.reset();
   size_t thread_count = event_managers_.size();
   for (size_t i = 1; i < thread_count; ++i) {
     auto* event_manager = event_managers_[i];
@@ -57,11 +75,7 @@ PingpongClient::~PingpongClient() {
 void PingpongClient::Start() {
   event_managers_[1]->RunAfter(timeout_ * 1000 * 1000,
                                [this]() { this->DoWithTimeout(); });
-  for (size_t i = 0; i < session_count_; ++i) {
-    sessions_.emplace_back(std::make_unique<Session>(
-        balancer_->PickOneEventManager(), server_address_, shared_from_this()));
-    sessions_[i]->Start();
-  }
+  client_pool_->Start();
   if (event_managers_.size() > 1) {
     event_managers_[1]->Work();
   }
@@ -78,17 +92,38 @@ void PingpongClient::Start() {
   }
 }
 
-void PingpongClient::OnConnecting() {
-  if (conn_num_.fetch_add(1) + 1 == session_count_) {
-    taotu::LOG_INFO("All connected!");
+void PingpongClient::OnConnectionCallback(taotu::Connecting& connection) {
+  if (connection.IsConnected()) {
+    connection.SetTcpNoDelay(true);
+    connection.Send(&(*(message_.begin())), message_.size());
+    if (conn_num_.fetch_add(1) + 1 == session_count_) {
+      taotu::LOG_INFO("All connected!");
+    }
+  } else if (conn_num_.fetch_sub(1) - 1 == 0) {
+    ReportStatsOnce();
+    RequestQuit();
   }
 }
 
-void PingpongClient::OnDisconnecting(taotu::Connecting& connection) {
-  if (conn_num_.fetch_sub(1) - 1 == 0) {
-    ReportStatsOnce();
-    RequestQuit();
+void PingpongClient::OnMessageCallback(taotu::Connecting& connection,
+                                       taotu::IoBuffer* io_buffer,
+                                       taotu::TimePoint) {
+  auto* session_stats = FindSessionStats(connection);
+  ++session_stats->messages_read;
+  session_stats->bytes_read +=
+      static_cast<int64_t>(io_buffer->GetReadableBytes());
+  connection.Send(io_buffer);
+}
+
+PingpongClient::SessionStats* PingpongClient::FindSessionStats(
+    taotu::Connecting& connection) {
+  auto* event_manager = &connection.GetEventManager();
+  for (auto& session_stats : session_stats_) {
+    if (session_stats.event_manager == event_manager) {
+      return &session_stats;
+    }
   }
+  return &session_stats_.front();
 }
 
 void PingpongClient::DoWithTimeout() {
@@ -97,9 +132,7 @@ void PingpongClient::DoWithTimeout() {
   ReportStatsOnce();
 
   // Stop sessions (best effort)
-  for (auto& session : sessions_) {
-    session->Stop();
-  }
+  client_pool_->Stop();
   // Force quit immediately - don't wait for disconnect callbacks
   RequestQuit();
 }
@@ -110,9 +143,9 @@ void PingpongClient::ReportStatsOnce() {
   }
   int64_t total_bytes_read = 0;
   int64_t total_messages_read = 0;
-  for (const auto& session : sessions_) {
-    total_bytes_read += session->GetBytesRead();
-    total_messages_read += session->GetMessagesRead();
+  for (const auto& session_stats : session_stats_) {
+    total_bytes_read += session_stats.bytes_read;
+    total_messages_read += session_stats.messages_read;
   }
   ::printf(
       "Totally,\n%ldbytes read\nand %ldmessages read,\nthe average message "
@@ -138,48 +171,3 @@ void PingpongClient::RequestQuit() {
     }
   }
 }
-
-Session::Session(taotu::EventManager* event_manager,
-                 const taotu::NetAddress& server_address,
-                 const std::shared_ptr<PingpongClient>& master_client)
-    : client_(event_manager, server_address, true),
-      master_client_(master_client),
-      bytes_read_(0),
-      messages_read_(0) {
-  client_.SetConnectionCallback([this](taotu::Connecting& connection) {
-    this->OnConnectionCallback(connection);
-  });
-  client_.SetMessageCallback([this](taotu::Connecting& connection,
-                                    taotu::IoBuffer* io_buffer,
-                                    taotu::TimePoint time_point) {
-    this->OnMessageCallback(connection, io_buffer, std::move(time_point));
-  });
-}
-
-void Session::Start() { client_.Connect(); }
-
-void Session::Stop() { client_.Stop(); }
-
-void Session::OnConnectionCallback(taotu::Connecting& connection) {
-  if (connection.IsConnected()) {
-    connection.SetTcpNoDelay(true);
-    std::shared_ptr<PingpongClient> master_client(master_client_.lock());
-    if (master_client) {
-      const auto& message = master_client->GetMessage();
-      connection.Send(&(*(message.begin())), message.size());
-      master_client->OnConnecting();
-    }
-  } else {
-    std::shared_ptr<PingpongClient> master_client(master_client_.lock());
-    if (master_client) {
-      master_client->OnDisconnecting(connection);
-    }
-  }
-}
-
-void Session::OnMessageCallback(taotu::Connecting& connection,
-                                taotu::IoBuffer* io_buffer, taotu::TimePoint) {
-  ++messages_read_;
-  bytes_read_ += static_cast<int64_t>(io_buffer->GetReadableBytes());
-  connection.Send(io_buffer);
-}
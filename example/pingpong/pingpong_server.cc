@@ -29,6 +29,7 @@ PingpongServer::PingpongServer(const taotu::NetAddress& listen_address,
   });
 }
 PingpongServer::~PingpongServer() {
+  server_.reset();  // Before the event managers it uses
   size_t event_managers_size = event_managers_.size();
   for (size_t i = 0; i < event_managers_size; ++i) {
     delete event_managers_[i];
@@ -36,7 +37,12 @@ PingpongServer::~PingpongServer() {
   taotu::END_LOG();
 }
 
+void PingpongServer::AddListener(const taotu::NetAddress& listen_address) {
+  server_->AddListener(listen_address);
+}
+
 void PingpongServer::Start() { server_->Start(); }
+void PingpongServer::Stop() { event_managers_[0]->Quit(); }
 
 void PingpongServer::OnConnectionCallback(taotu::Connecting& connection) {
   if (connection.IsConnected()) {
@@ -23,9 +23,15 @@ class PingpongServer : taotu::NonCopyableMovable {
                  bool should_reuse_port, size_t io_thread_amount = 5);
   ~PingpongServer();
 
+  // Listen to one more address (like a Unix domain socket) before starting
+  void AddListener(const taotu::NetAddress& listen_address);
+
   // Start the server
   void Start();
 
+  // Stop the server (from another thread)
+  void Stop();
+
  private:
   // Called after one connection creating and before one connection destroying
   void OnConnectionCallback(taotu::Connecting& connection);
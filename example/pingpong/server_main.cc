@@ -16,23 +16,24 @@
 #include "pingpong_server.h"
 
 // Call it by:
-// './pingpong_server [port [amount-of-I/O-threads]]'
+// './pingpong_server [port [amount-of-I/O-threads [unix-socket-path]]]'
 int main(int argc, char* argv[]) {
   taotu::START_LOG("pingpong_server_log.txt");
-  if (1 == argc) {
-    PingpongServer pingpong_server{taotu::NetAddress{4567}, false};
-    pingpong_server.Start();
-  } else if (2 == argc) {
-    PingpongServer pingpong_server{taotu::NetAddress{static_cast<uint16_t>(
-                                       std::stoi(std::string{argv[1]}))},
-                                   false};
-    pingpong_server.Start();
-  } else {
-    PingpongServer pingpong_server{
-        taotu::NetAddress{
-            static_cast<uint16_t>(std::stoi(std::string{argv[1]}))},
-        false, static_cast<size_t>(std::stoi(std::string{argv[2]}))};
-    pingpong_server.Start();
+  uint16_t port = 4567;
+  size_t io_thread_amount = 5;
+  if (argc > 1) {
+    port = static_cast<uint16_t>(std::stoi(std::string{argv[1]}));
   }
+  if (argc > 2) {
+    io_thread_amount = static_cast<size_t>(std::stoi(std::string{argv[2]}));
+  }
+  PingpongServer pingpong_server{taotu::NetAddress{port}, false,
+                                 io_thread_amount};
+  if (argc > 3) {
+    // Serve co-located clients on the Unix domain socket too
+    pingpong_server.AddListener(
+        taotu::NetAddress::FromUnixPath(std::string{argv[3]}));
+  }
+  pingpong_server.Start();
   return 0;
 }
@@ -8,6 +8,10 @@
  *
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
 #include <vector>
 
 #include "../../../src/event_manager.h"
@@ -34,13 +38,23 @@ class TimeServiceImpl : public timeservice::TimeService {
   }
 };
 
-int main() {
+// Call it by:
+// './time_service_server [port [amount-of-I/O-threads]]'
+int main(int argc, char* argv[]) {
   taotu::START_LOG("time_service_server_log.txt");
-  std::vector<taotu::EventManager*> event_managers(4, nullptr);
+  uint16_t port = 4567;
+  size_t io_thread_amount = 4;
+  if (argc > 1) {
+    port = static_cast<uint16_t>(std::stoi(std::string{argv[1]}));
+  }
+  if (argc > 2) {
+    io_thread_amount = static_cast<size_t>(std::stoi(std::string{argv[2]}));
+  }
+  std::vector<taotu::EventManager*> event_managers(io_thread_amount, nullptr);
   for (auto& event_manager : event_managers) {
     event_manager = new taotu::EventManager{};
   }
-  taotu::RpcServer rpc_server(&event_managers, taotu::NetAddress{4567});
+  taotu::RpcServer rpc_server(&event_managers, taotu::NetAddress{port});
   TimeServiceImpl time_service_impl;
   rpc_server.RegisterService(&time_service_impl);
   rpc_server.Start();
@@ -13,9 +13,23 @@
 #include <functional>
 #include <string>
 
+namespace {
+
+// Each one runs its own loop (in its own thread, except the first one)
+std::vector<taotu::EventManager*> CreateEventManagers(size_t amount) {
+  std::vector<taotu::EventManager*> event_managers;
+  event_managers.reserve(amount);
+  for (size_t i = 0; i < amount; ++i) {
+    event_managers.push_back(new taotu::EventManager);
+  }
+  return event_managers;
+}
+
+}  // namespace
+
 EchoServer::EchoServer(const taotu::NetAddress& listen_address,
                        bool should_reuse_port, size_t io_thread_amount)
-    : event_managers_(io_thread_amount, new taotu::EventManager),
+    : event_managers_(CreateEventManagers(io_thread_amount)),
       server_(std::make_unique<taotu::Server>(&event_managers_, listen_address,
                                               should_reuse_port)) {
   server_->SetMessageCallback([this](taotu::Connecting& connection,
@@ -25,6 +39,7 @@ EchoServer::EchoServer(const taotu::NetAddress& listen_address,
   });
 }
 EchoServer::~EchoServer() {
+  server_.reset();  // Before the event managers it uses
   size_t event_managers_size = event_managers_.size();
   for (size_t i = 0; i < event_managers_size; ++i) {
     delete event_managers_[i];
@@ -38,7 +53,8 @@ void EchoServer::OnMessageCallback(taotu::Connecting& connection,
                                    taotu::IoBuffer* io_buffer,
                                    taotu::TimePoint time_point) {
   std::string message{io_buffer->RetrieveAllAsString()};
-  taotu::LOG_DEBUG("Fd(%d) is receiving %u bytes at %lld.", connection.Fd(),
-                   message.size(), time_point.GetMicroseconds());
+  taotu::LOG_DEBUG("Fd(%d) is receiving %zu bytes at %lld.", connection.Fd(),
+                   message.size(),
+                   static_cast<long long>(time_point.GetMicroseconds()));
   connection.Send(message);
 }
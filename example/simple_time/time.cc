@@ -14,9 +14,23 @@
 #include <sys/time.h>
 #include <sys/types.h>
 
+namespace {
+
+// Each one runs its own loop (in its own thread, except the first one)
+std::vector<taotu::EventManager*> CreateEventManagers(size_t amount) {
+  std::vector<taotu::EventManager*> event_managers;
+  event_managers.reserve(amount);
+  for (size_t i = 0; i < amount; ++i) {
+    event_managers.push_back(new taotu::EventManager);
+  }
+  return event_managers;
+}
+
+}  // namespace
+
 TimeServer::TimeServer(const taotu::NetAddress& listen_address,
                        bool should_reuse_port, size_t io_thread_amount)
-    : event_managers_(io_thread_amount, new taotu::EventManager),
+    : event_managers_(CreateEventManagers(io_thread_amount)),
       server_(std::make_unique<taotu::Server>(&event_managers_, listen_address,
                                               should_reuse_port)) {
   server_->SetMessageCallback([this](taotu::Connecting& connection,
@@ -26,6 +40,7 @@ TimeServer::TimeServer(const taotu::NetAddress& listen_address,
   });
 }
 TimeServer::~TimeServer() {
+  server_.reset();  // Before the event managers it uses
   size_t event_managers_size = event_managers_.size();
   for (size_t i = 0; i < event_managers_size; ++i) {
     delete event_managers_[i];
@@ -41,10 +56,10 @@ void TimeServer::OnMessageCallback(taotu::Connecting& connection,
   std::string message{io_buffer->RetrieveAllAsString()};
   ssize_t msg_len = message.size();
   message = message.substr(0, msg_len - 1);
-  taotu::LOG_DEBUG("Fd(%d) is receiving %u bytes(%s) at %lld.", connection.Fd(),
-                   message.size(),
+  taotu::LOG_DEBUG("Fd(%d) is receiving %zu bytes(%s) at %lld.",
+                   connection.Fd(), message.size(),
                    message.substr(0, message.size() - 1).c_str(),
-                   time_point.GetMicroseconds());
+                   static_cast<long long>(time_point.GetMicroseconds()));
   int64_t now_time = time_point.GetMicroseconds();
   time_t seconds = static_cast<time_t>(now_time / (1000 * 1000));
   struct tm tm_time;
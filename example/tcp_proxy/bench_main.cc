@@ -0,0 +1,144 @@
+/**
+ * @file bench_main.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Throughput benchmark of the TCP proxy: blaster threads push blocks
+ * through the proxy into a discarding backend, which measures the bytes
+ * arriving.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic_bool is_stopped{false};
+std::atomic_uint64_t received_bytes{0};
+
+// Plain blocking sockets keep the benchmark independent of the library
+int Listen(uint16_t port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  int opt_val = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt_val, sizeof(opt_val));
+  struct sockaddr_in address {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (::bind(fd, reinterpret_cast<struct sockaddr*>(&address),
+             sizeof(address)) < 0 ||
+      ::listen(fd, SOMAXCONN) < 0) {
+    ::perror("listen");
+    ::exit(1);
+  }
+  return fd;
+}
+
+int Connect(const char* ip, uint16_t port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_in address {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  ::inet_pton(AF_INET, ip, &address.sin_addr);
+  if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                sizeof(address)) < 0) {
+    ::perror("connect");
+    ::exit(1);
+  }
+  int opt_val = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt_val, sizeof(opt_val));
+  return fd;
+}
+
+void Sink(int fd) {
+  std::vector<char> buffer(256 * 1024);
+  ssize_t n;
+  while ((n = ::read(fd, buffer.data(), buffer.size())) > 0) {
+    received_bytes.fetch_add(static_cast<uint64_t>(n),
+                             std::memory_order_relaxed);
+  }
+  ::close(fd);
+}
+
+void Blast(const char* ip, uint16_t port, size_t block_size) {
+  int fd = Connect(ip, port);
+  std::string block(block_size, 'x');
+  while (!is_stopped.load(std::memory_order_relaxed)) {
+    if (::write(fd, block.data(), block.size()) <= 0) {
+      break;
+    }
+  }
+  ::close(fd);
+}
+
+}  // namespace
+
+// Call it by:
+// './tcp_proxy_bench proxy-IP proxy-port backend-port amount-of-connections
+// size-of-block-sent time-for-waiting'
+// (with './tcp_proxy proxy-port 127.0.0.1 backend-port [splice|copy]' running)
+int main(int argc, char* argv[]) {
+  if (argc != 7) {
+    ::fprintf(stderr,
+              "Usage: tcp_proxy_bench <proxy_ip> <proxy_port> <backend_port> "
+              "<connections> <blocksize> <time>\n");
+    return 0;
+  }
+  const char* proxy_ip = argv[1];
+  auto proxy_port = static_cast<uint16_t>(::atoi(argv[2]));
+  int listen_fd = Listen(static_cast<uint16_t>(::atoi(argv[3])));
+  auto connection_amount = static_cast<size_t>(::atoi(argv[4]));
+  auto block_size = static_cast<size_t>(::atoi(argv[5]));
+  int timeout = ::atoi(argv[6]);
+
+  std::vector<std::thread> sinks;
+  std::thread acceptor([listen_fd, connection_amount, &sinks]() {
+    for (size_t i = 0; i < connection_amount; ++i) {
+      int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd < 0) {
+        break;
+      }
+      sinks.emplace_back(Sink, fd);
+    }
+  });
+  std::vector<std::thread> blasters;
+  for (size_t i = 0; i < connection_amount; ++i) {
+    blasters.emplace_back(Blast, proxy_ip, proxy_port, block_size);
+  }
+  acceptor.join();
+
+  // Measure only after all connections are relaying
+  uint64_t start_bytes = received_bytes.load();
+  auto start_time = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(timeout));
+  uint64_t total_bytes = received_bytes.load() - start_bytes;
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  is_stopped.store(true);
+  for (auto& blaster : blasters) {
+    blaster.join();
+  }
+  for (auto& sink : sinks) {
+    sink.join();
+  }
+  ::close(listen_fd);
+  ::printf("%lubytes relayed in %lfs,\nand the throughput is %lfMiB/s.\n",
+           total_bytes, seconds,
+           static_cast<double>(total_bytes) / (seconds * 1024 * 1024));
+  return 0;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file main.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Main entrance of the TCP proxy (forwards each connection to a
+ * backend server).
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "../../src/logger.h"
+#include "tcp_proxy.h"
+
+// Call it by:
+// './tcp_proxy listen-port backend-IP backend-port [splice|copy
+// [amount-of-I/O-threads]]'
+int main(int argc, char* argv[]) {
+  if (argc < 4) {
+    ::fprintf(stderr,
+              "Usage: tcp_proxy <listen_port> <backend_ip> <backend_port> "
+              "[splice|copy [threads]]\n");
+    return 0;
+  }
+  taotu::START_LOG("tcp_proxy_log.txt");
+  TcpProxy::RelayMode relay_mode =
+      argc > 4 && ::strcmp(argv[4], "copy") == 0 ? TcpProxy::RelayMode::kCopy
+                                                 : TcpProxy::RelayMode::kSplice;
+  size_t io_thread_amount =
+      argc > 5 ? static_cast<size_t>(std::stoi(std::string{argv[5]})) : 3;
+  TcpProxy tcp_proxy{
+      taotu::NetAddress{static_cast<uint16_t>(std::stoi(std::string{argv[1]}))},
+      taotu::NetAddress{std::string{argv[2]},
+                        static_cast<uint16_t>(std::stoi(std::string{argv[3]}))},
+      relay_mode, io_thread_amount};
+  tcp_proxy.Start();
+  return 0;
+}
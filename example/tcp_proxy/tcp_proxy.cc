@@ -0,0 +1,134 @@
+/**
+ * @file tcp_proxy.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "TcpProxy" which forwards each accepted
+ * connection to a backend server.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "tcp_proxy.h"
+
+#include <utility>
+
+#include "../../src/logger.h"
+
+TcpProxy::TcpProxy(const taotu::NetAddress& listen_address,
+                   const taotu::NetAddress& backend_address,
+                   RelayMode relay_mode, size_t io_thread_amount)
+    : backend_address_(backend_address), relay_mode_(relay_mode) {
+  // Each pair of connections is served in one loop, so give each I/O thread
+  // its own loop
+  for (size_t i = 0; i < io_thread_amount; ++i) {
+    event_managers_.push_back(new taotu::EventManager);
+  }
+  server_ = std::make_unique<taotu::Server>(&event_managers_, listen_address,
+                                            false);
+  server_->SetConnectionCallback([this](taotu::Connecting& connection) {
+    this->OnDownstreamConnectionCallback(connection);
+  });
+  server_->SetMessageCallback([this](taotu::Connecting& connection,
+                                     taotu::IoBuffer* io_buffer,
+                                     taotu::TimePoint time_point) {
+    this->OnDownstreamMessageCallback(connection, io_buffer, time_point);
+  });
+}
+TcpProxy::~TcpProxy() {
+  server_.reset();
+  for (auto* event_manager : event_managers_) {
+    delete event_manager;
+  }
+  taotu::END_LOG();
+}
+
+void TcpProxy::Start() { server_->Start(); }
+
+void TcpProxy::OnDownstreamConnectionCallback(taotu::Connecting& connection) {
+  if (connection.IsConnected()) {
+    connection.SetTcpNoDelay(true);
+    // Its backend connection lives in this loop, so it must stay here too
+    connection.SetMigratable(false);
+    auto tunnel = std::make_shared<Tunnel>();
+    tunnel->downstream = &connection;
+    // The backend is connected in the same loop, which "Connecting::Relay()"
+    // requires
+    tunnel->client = std::make_unique<taotu::Client>(
+        &connection.GetEventManager(), backend_address_, false);
+    std::weak_ptr<Tunnel> weak_tunnel(tunnel);
+    tunnel->client->SetConnectionCallback(
+        [this, weak_tunnel](taotu::Connecting& upstream) {
+          this->OnUpstreamConnectionCallback(weak_tunnel, upstream);
+        });
+    tunnel->client->SetMessageCallback(
+        [weak_tunnel](taotu::Connecting&, taotu::IoBuffer* io_buffer,
+                      taotu::TimePoint) {
+          auto tunnel = weak_tunnel.lock();
+          if (tunnel && tunnel->downstream != nullptr) {
+            tunnel->downstream->Send(io_buffer);
+          } else {
+            io_buffer->RefreshRW();
+          }
+        });
+    connection.SetContext<std::shared_ptr<Tunnel>>(tunnel);
+    tunnel->client->Connect();
+  } else {
+    auto* tunnel_ptr = connection.GetContext<std::shared_ptr<Tunnel>>();
+    if (tunnel_ptr == nullptr || !*tunnel_ptr) {
+      return;
+    }
+    std::shared_ptr<Tunnel> tunnel(std::move(*tunnel_ptr));
+    connection.ResetContext();
+    tunnel->downstream = nullptr;
+    if (tunnel->upstream != nullptr) {
+      tunnel->upstream->ForceClose();
+    }
+    // The upstream connection has been closed (or is not created yet), so
+    // the client can go once this callback returns
+    connection.GetEventManager().RunSoon([tunnel]() { tunnel->client.reset(); });
+  }
+}
+
+void TcpProxy::OnDownstreamMessageCallback(taotu::Connecting& connection,
+                                           taotu::IoBuffer* io_buffer,
+                                           taotu::TimePoint) {
+  auto* tunnel_ptr = connection.GetContext<std::shared_ptr<Tunnel>>();
+  if (tunnel_ptr == nullptr || !*tunnel_ptr) {
+    io_buffer->RefreshRW();
+    return;
+  }
+  auto& tunnel = *tunnel_ptr;
+  if (tunnel->upstream != nullptr) {
+    tunnel->upstream->Send(io_buffer);
+  } else {
+    tunnel->pending_message += io_buffer->RetrieveAllAsString();
+  }
+}
+
+void TcpProxy::OnUpstreamConnectionCallback(
+    const std::weak_ptr<Tunnel>& weak_tunnel, taotu::Connecting& connection) {
+  auto tunnel = weak_tunnel.lock();
+  if (connection.IsConnected()) {
+    if (!tunnel || tunnel->downstream == nullptr) {
+      connection.ForceClose();
+      return;
+    }
+    connection.SetTcpNoDelay(true);
+    tunnel->upstream = &connection;
+    if (!tunnel->pending_message.empty()) {
+      connection.Send(tunnel->pending_message);
+      tunnel->pending_message.clear();
+    }
+    if (RelayMode::kSplice == relay_mode_ &&
+        !taotu::Connecting::Relay(*tunnel->downstream, connection)) {
+      taotu::LOG_WARN("Fd(%d) and fd(%d) fall back to copying.",
+                      tunnel->downstream->Fd(), connection.Fd());
+    }
+  } else if (tunnel) {
+    tunnel->upstream = nullptr;
+    if (tunnel->downstream != nullptr) {
+      tunnel->downstream->ForceClose();
+    }
+  }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file tcp_proxy.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "TcpProxy" which forwards each accepted
+ * connection to a backend server.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_EXAMPLE_TCP_PROXY_TCP_PROXY_H_
+#define TAOTU_EXAMPLE_TCP_PROXY_TCP_PROXY_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../src/client.h"
+#include "../../src/server.h"
+
+class TcpProxy : taotu::NonCopyableMovable {
+ public:
+  typedef std::vector<taotu::EventManager*> EventManagers;
+
+  // Splice data in the kernel ("Connecting::Relay()") or copy it through
+  // user-space buffers (for comparison)
+  enum class RelayMode { kSplice, kCopy };
+
+  TcpProxy(const taotu::NetAddress& listen_address,
+           const taotu::NetAddress& backend_address, RelayMode relay_mode,
+           size_t io_thread_amount = 3);
+  ~TcpProxy();
+
+  // Start the proxy
+  void Start();
+
+ private:
+  // One downstream (accepted) connection and its upstream (backend) one
+  struct Tunnel {
+    std::unique_ptr<taotu::Client> client;
+    taotu::Connecting* downstream{nullptr};
+    taotu::Connecting* upstream{nullptr};
+    std::string pending_message;  // Arrived before the upstream connected
+  };
+
+  // Called after the downstream connection creating and before it destroying
+  void OnDownstreamConnectionCallback(taotu::Connecting& connection);
+
+  // Called after messages arriving from the downstream connection (only
+  // before relaying or in copying mode)
+  void OnDownstreamMessageCallback(taotu::Connecting& connection,
+                                   taotu::IoBuffer* io_buffer,
+                                   taotu::TimePoint);
+
+  // Called after the upstream connection creating and before it destroying
+  void OnUpstreamConnectionCallback(const std::weak_ptr<Tunnel>& weak_tunnel,
+                                    taotu::Connecting& connection);
+
+  EventManagers event_managers_;
+  taotu::NetAddress backend_address_;
+  RelayMode relay_mode_;
+  std::unique_ptr<taotu::Server> server_;
+};
+
+#endif  // !TAOTU_EXAMPLE_TCP_PROXY_TCP_PROXY_H_
@@ -26,6 +26,9 @@
 #include "poller.h"
 
 namespace taotu {
+
+USE_LOG_CATEGORY(logger::kAcceptorLog);
+
 namespace {
 constexpr int kMaxEventAmount = 600000;
 
@@ -49,23 +52,31 @@ const char* StrError(int err, char* buf, size_t len) {
 }
 
 NetAddress GetPeerAddress(int socket_fd) {
-  struct sockaddr_in6 local_addr;
-  ::memset(&local_addr, 0, sizeof(local_addr));
-  auto addr_len = static_cast<socklen_t>(sizeof(local_addr));
-  if (::getpeername(socket_fd, reinterpret_cast<struct sockaddr*>(&local_addr),
+  struct sockaddr_storage peer_addr;
+  ::memset(&peer_addr, 0, sizeof(peer_addr));
+  auto addr_len = static_cast<socklen_t>(sizeof(peer_addr));
+  if (::getpeername(socket_fd, reinterpret_cast<struct sockaddr*>(&peer_addr),
                     &addr_len) < 0) {
     LOG_ERROR("Fail to get local network info when accepting!!!");
   }
-  return NetAddress(local_addr);
+  NetAddress peer_address;
+  peer_address.SetRawAddr(peer_addr, addr_len);
+  return peer_address;
 }
 
 }  // namespace
 
 Acceptor::Acceptor(Poller* poller, const NetAddress& listen_address,
-                   bool should_reuse_port)
-    : accept_socketer_(Socketer::CreateNonblockingTcpSocket(listen_address)),
+                   bool should_reuse_port, bool is_ipv6_only)
+    : listen_address_(listen_address),
+      accept_socketer_(Socketer::CreateNonblockingTcpSocket(listen_address)),
       accept_eventer_(poller, accept_socketer_.Fd()),
       is_listening_(false),
+      is_paused_(false),
+      is_stopped_(false),
+      is_handed_over_(false),
+      accept_key_(0),
+      admission_controller_(nullptr),
       idle_fd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)) {
   if (accept_socketer_.Fd() < 0) {
     int saved_errno = errno;
@@ -73,18 +84,49 @@ Acceptor::Acceptor(Poller* poller, const NetAddress& listen_address,
               ::strerror(saved_errno));
     ::exit(-1);
   }
-  accept_socketer_.SetReuseAddress(true);
-  accept_socketer_.SetReusePort(should_reuse_port);
+  if (listen_address.IsUnix()) {
+    if (!listen_address.IsAbstract()) {
+      ::unlink(listen_address.GetUnixPath().c_str());
+    }
+  } else {
+    accept_socketer_.SetReuseAddress(true);
+    accept_socketer_.SetReusePort(should_reuse_port);
+    if (listen_address.GetFamily() == AF_INET6) {
+      accept_socketer_.SetIpv6Only(is_ipv6_only);
+    }
+  }
   accept_socketer_.BindAddress(listen_address);
   accept_eventer_.RegisterReadCallback([this](const TimePoint&) {
     this->SubmitAcceptOnce();
   });  // Trigger one submission; the actual accept goes through io_uring.
   LOG_DEBUG("Acceptor init on fd(%d)", accept_socketer_.Fd());
 }
+Acceptor::Acceptor(Poller* poller, const NetAddress& listen_address,
+                   int inherited_fd)
+    : listen_address_(listen_address),
+      accept_socketer_(inherited_fd),
+      accept_eventer_(poller, accept_socketer_.Fd()),
+      is_listening_(false),
+      is_paused_(false),
+      is_stopped_(false),
+      is_handed_over_(false),
+      accept_key_(0),
+      admission_controller_(nullptr),
+      idle_fd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)) {
+  // Already bound (and maybe listening), so neither bind it again nor touch
+  // the socket file
+  accept_eventer_.RegisterReadCallback(
+      [this](const TimePoint&) { this->SubmitAcceptOnce(); });
+  LOG_DEBUG("Acceptor init on inherited fd(%d)", accept_socketer_.Fd());
+}
 Acceptor::~Acceptor() {
   LOG_DEBUG("Acceptor with fd(%d) is closing.", accept_socketer_.Fd());
   is_listening_ = false;
   ::close(idle_fd_);
+  if (listen_address_.IsUnix() && !listen_address_.IsAbstract() &&
+      !is_handed_over_) {
+    ::unlink(listen_address_.GetUnixPath().c_str());
+  }
 }
 
 void Acceptor::Listen() {
@@ -96,8 +138,47 @@ void Acceptor::Listen() {
 
 void Acceptor::DoReading() { SubmitAcceptOnce(); }
 
+void Acceptor::PauseAccepting() {
+  if (is_paused_) {
+    return;
+  }
+  is_paused_ = true;
+  // Connections accepted meanwhile still come and are rejected
+  accept_eventer_.GetPoller()->InterruptOp(accept_key_);
+  LOG_WARN("Acceptor with fd(%d) pauses accepting.", accept_socketer_.Fd());
+}
+void Acceptor::ResumeAccepting() {
+  if (!is_paused_ || is_stopped_) {
+    return;
+  }
+  is_paused_ = false;
+  SubmitAcceptOnce();
+  LOG_WARN("Acceptor with fd(%d) resumes accepting.", accept_socketer_.Fd());
+}
+
+void Acceptor::StopAccepting() {
+  if (is_stopped_) {
+    return;
+  }
+  is_stopped_ = true;
+  if (!is_paused_) {
+    is_paused_ = true;
+    accept_eventer_.GetPoller()->InterruptOp(accept_key_);
+  }
+  LOG_NOTICE("Acceptor with fd(%d) stops accepting.", accept_socketer_.Fd());
+}
+
+void Acceptor::RejectConnection(int socket_fd) {
+  struct linger linger_option {};
+  linger_option.l_onoff = 1;
+  linger_option.l_linger = 0;
+  ::setsockopt(socket_fd, SOL_SOCKET, SO_LINGER, &linger_option,
+               static_cast<socklen_t>(sizeof(linger_option)));
+  ::close(socket_fd);
+}
+
 void Acceptor::SubmitAcceptOnce() {
-  if (!is_listening_) {
+  if (!is_listening_ || is_paused_) {
     return;
   }
   auto* ctx = new AcceptContext();
@@ -113,6 +194,8 @@ void Acceptor::SubmitAcceptOnce() {
     LOG_ERROR("Submit accept failed on fd(%d)", accept_socketer_.Fd());
     return;
   }
+  ctx->key = key;
+  accept_key_ = key;
   LOG_DEBUG("Submit accept on fd(%d)", accept_socketer_.Fd());
 }
 
@@ -121,12 +204,43 @@ void Acceptor::OnAcceptComplete(struct io_uring_cqe* cqe,
   auto* ctx = static_cast<AcceptContext*>(op->context);
   auto* self = ctx->self;
   int conn_fd = static_cast<int>(cqe->res);
-  if (conn_fd >= 0 && conn_fd <= kMaxEventAmount) {
+  auto* admission_controller = self->admission_controller_;
+  // Connections accepted before stopping are served, since nobody else can
+  // take them any more
+  if (conn_fd > kMaxEventAmount ||
+      (conn_fd >= 0 && self->is_paused_ && !self->is_stopped_)) {
+    if (admission_controller != nullptr) {
+      admission_controller->AddRejected();
+    }
+    RejectConnection(conn_fd);
+  } else if (conn_fd >= 0) {
     LOG_DEBUG("Accept fd(%d) -> new fd(%d)", self->accept_socketer_.Fd(),
               conn_fd);
     if (self->NewConnectionCallback_) {
       NetAddress peer_address = GetPeerAddress(conn_fd);
-      self->NewConnectionCallback_(conn_fd, peer_address);
+      auto verdict = AdmissionController::Verdict::kAdmitted;
+      if (admission_controller != nullptr) {
+        verdict = admission_controller->Admit(
+            peer_address, TimePoint::FNow() / (1000 * 1000));
+      }
+      bool should_pause =
+          admission_controller != nullptr &&
+          AdmissionPolicy::kPauseAccepting ==
+              admission_controller->GetLimits().policy &&
+          (verdict == AdmissionController::Verdict::kTooManyConnections ||
+           admission_controller->IsFull());
+      if (verdict != AdmissionController::Verdict::kAdmitted) {
+        LOG_DEBUG("Reject fd(%d) from IP(%s) for reason(%d).", conn_fd,
+                  peer_address.GetIp().c_str(), static_cast<int>(verdict));
+        admission_controller->AddRejected();
+        RejectConnection(conn_fd);
+      } else {
+        self->NewConnectionCallback_(conn_fd, peer_address);
+      }
+      if (should_pause) {
+        // Other acceptors of the server pause on their first overflow
+        self->PauseAccepting();
+      }
     } else {
       LOG_ERROR("Acceptor with fd(%d) is closing!!!",
                 self->accept_socketer_.Fd());
@@ -136,7 +250,7 @@ void Acceptor::OnAcceptComplete(struct io_uring_cqe* cqe,
     int saved_errno = (conn_fd < 0) ? -conn_fd : 0;
     if (saved_errno == 0) saved_errno = errno;
     if (saved_errno != EAGAIN && saved_errno != EWOULDBLOCK &&
-        saved_errno != EINTR) {
+        saved_errno != EINTR && saved_errno != ECANCELED) {
       char errbuf[128]{};
       const char* err_str = StrError(saved_errno, errbuf, sizeof(errbuf));
       if (err_str == nullptr || *err_str == '\0') {
@@ -155,8 +269,12 @@ void Acceptor::OnAcceptComplete(struct io_uring_cqe* cqe,
     }
   }
   if (!(cqe->flags & IORING_CQE_F_MORE)) {
+    // Only the current request is renewed (an interrupted one may end after
+    // accepting has been resumed)
+    bool is_current = ctx->key == self->accept_key_;
     delete ctx;
-    if (self->is_listening_) {
+    op->context = nullptr;
+    if (is_current && self->is_listening_) {
       self->SubmitAcceptOnce();
     }
   }
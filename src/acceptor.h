@@ -12,8 +12,11 @@
 #ifndef TAOTU_SRC_ACCEPTOR_H_
 #define TAOTU_SRC_ACCEPTOR_H_
 
+#include <stdint.h>
+
 #include <functional>
 
+#include "admission_controller.h"
 #include "event_manager.h"
 #include "eventer.h"
 #include "net_address.h"
@@ -34,8 +37,14 @@ class Acceptor : NonCopyableMovable {
  public:
   typedef std::function<void(int, const NetAddress&)> NewConnectionCallback;
 
+  // An IPv6 one takes IPv4 connections too unless "is_ipv6_only", and a Unix
+  // domain one bound to a path replaces the stale socket file left there
+  Acceptor(Poller* poller, const NetAddress& listen_address,
+           bool should_reuse_port, bool is_ipv6_only = false);
+  // Take over a socket already bound to the address (like one inherited from
+  // the old process by "ListenerHandoff")
   Acceptor(Poller* poller, const NetAddress& listen_address,
-           bool should_reuse_port);
+           int inherited_fd);
   ~Acceptor();
 
   // Get the file descriptor of this accepting socket
@@ -54,9 +63,38 @@ class Acceptor : NonCopyableMovable {
   // descriptor of this connecting socket and record its net address info
   void DoReading();
 
+  const NetAddress& GetListenAddress() const { return listen_address_; }
+
+  // Admission control of new connections (shared by all acceptors of one
+  // server, and the ones admitted must be released after being closed)
+  void SetAdmissionController(AdmissionController* admission_controller) {
+    admission_controller_ = admission_controller;
+  }
+
+  // Stop taking connections out of the kernel backlog, and go on (both called
+  // in the accepting thread)
+  void PauseAccepting();
+  void ResumeAccepting();
+  bool IsPaused() const { return is_paused_; }
+
+  // Stop accepting for good to drain the server, the connections already
+  // taken out of the kernel backlog are still served (called in the
+  // accepting thread)
+  void StopAccepting();
+  bool IsStopped() const { return is_stopped_; }
+
+  // The socket lives on in the process it has been handed to, so leave the
+  // socket file of a Unix domain one there when closing
+  void HandOver() { is_handed_over_ = true; }
+
+  // Close the connection with an immediate RST, so the peer fails fast and
+  // nothing lingers in TIME_WAIT
+  static void RejectConnection(int socket_fd);
+
  private:
   struct AcceptContext {
     Acceptor* self{nullptr};
+    uint64_t key{0};
     struct sockaddr_storage addr {};
     socklen_t len{sizeof(addr)};
   };
@@ -64,6 +102,8 @@ class Acceptor : NonCopyableMovable {
   static void OnAcceptComplete(struct io_uring_cqe* cqe, Poller::IoUringOp* op);
   void SubmitAcceptOnce();
 
+  NetAddress listen_address_;
+
   // Socketer which is about configurations of the socket
   Socketer accept_socketer_;
 
@@ -71,6 +111,14 @@ class Acceptor : NonCopyableMovable {
   Eventer accept_eventer_;
 
   bool is_listening_;
+  bool is_paused_;
+  bool is_stopped_;
+  bool is_handed_over_;
+
+  // Key of the current accepting request
+  uint64_t accept_key_;
+
+  AdmissionController* admission_controller_;
 
   // For discarding failed connections
   int idle_fd_;
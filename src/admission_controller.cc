@@ -0,0 +1,174 @@
+/**
+ * @file admission_controller.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "AdmissionController" which decides whether a
+ * newly accepted TCP connection may be served.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "admission_controller.h"
+
+#include <string.h>
+
+namespace taotu {
+
+namespace {
+// Use the IPv4-mapped IPv6 address for IPv4 so both share the same key
+struct in6_addr GetIpKey(const NetAddress& net_address) {
+  struct in6_addr ip {};
+  if (net_address.GetFamily() == AF_INET) {
+    const auto* address = reinterpret_cast<const struct sockaddr_in*>(
+        net_address.GetNetAddress());
+    ip.s6_addr[10] = 0xff;
+    ip.s6_addr[11] = 0xff;
+    ::memcpy(&ip.s6_addr[12], &address->sin_addr, sizeof(address->sin_addr));
+  } else {
+    const auto* address = reinterpret_cast<const struct sockaddr_in6*>(
+        net_address.GetNetAddress());
+    ip = address->sin6_addr;
+  }
+  return ip;
+}
+
+size_t HashIp(const struct in6_addr& ip) {
+  uint64_t high;
+  uint64_t low;
+  ::memcpy(&high, &ip.s6_addr[0], sizeof(high));
+  ::memcpy(&low, &ip.s6_addr[8], sizeof(low));
+  uint64_t hash = (high ^ (low * 0x9e3779b97f4a7c15ULL)) * 0xbf58476d1ce4e5b9;
+  return static_cast<size_t>(hash ^ (hash >> 31));
+}
+
+size_t RoundUpToPowerOf2(size_t n) {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+}  // namespace
+
+AdmissionController::AdmissionController()
+    : used_slot_amount_(0), connection_amount_(0), rejected_amount_(0) {}
+
+void AdmissionController::SetLimits(const AdmissionLimits& limits) {
+  LockGuard lock_guard(lock_);
+  limits_ = limits;
+  if (0 == limits_.max_tracked_ips) {
+    limits_.max_tracked_ips = 1;
+  }
+  ip_states_.clear();
+  used_slot_amount_ = 0;
+  if (HasPerIpLimits()) {
+    ip_states_.resize(RoundUpToPowerOf2(2 * limits_.max_tracked_ips));
+  }
+}
+
+AdmissionController::Verdict AdmissionController::Admit(
+    const NetAddress& peer_address, int64_t now_seconds) {
+  LockGuard lock_guard(lock_);
+  if (limits_.max_connections > 0 &&
+      connection_amount_.load(std::memory_order_relaxed) >=
+          limits_.max_connections) {
+    return Verdict::kTooManyConnections;
+  }
+  if (HasPerIpLimits() && !peer_address.IsUnix()) {
+    IpState* ip_state = FindIpState(GetIpKey(peer_address), true, now_seconds);
+    if (nullptr == ip_state) {
+      return Verdict::kTooManyIps;
+    }
+    if (ip_state->window_second != now_seconds) {
+      ip_state->window_second = now_seconds;
+      ip_state->accepts_in_window = 0;
+    }
+    // Rejected attempts count too, so retrying fast does not help
+    ++ip_state->accepts_in_window;
+    if (limits_.max_accepts_per_ip_per_second > 0 &&
+        ip_state->accepts_in_window > limits_.max_accepts_per_ip_per_second) {
+      return Verdict::kTooFrequentFromIp;
+    }
+    if (limits_.max_connections_per_ip > 0 &&
+        ip_state->connections >= limits_.max_connections_per_ip) {
+      return Verdict::kTooManyConnectionsFromIp;
+    }
+    ++ip_state->connections;
+  }
+  connection_amount_.fetch_add(1, std::memory_order_relaxed);
+  return Verdict::kAdmitted;
+}
+
+bool AdmissionController::Release(const NetAddress& peer_address) {
+  LockGuard lock_guard(lock_);
+  if (HasPerIpLimits() && !peer_address.IsUnix()) {
+    IpState* ip_state = FindIpState(GetIpKey(peer_address), false, 0);
+    if (ip_state != nullptr && ip_state->connections > 0) {
+      --ip_state->connections;
+    }
+  }
+  size_t connection_amount =
+      connection_amount_.fetch_sub(1, std::memory_order_relaxed);
+  return limits_.max_connections > 0 &&
+         connection_amount >= limits_.max_connections;
+}
+
+bool AdmissionController::IsFull() const {
+  return limits_.max_connections > 0 &&
+         connection_amount_.load(std::memory_order_relaxed) >=
+             limits_.max_connections;
+}
+
+AdmissionController::IpState* AdmissionController::FindIpState(
+    const struct in6_addr& ip, bool should_insert, int64_t now_seconds) {
+  size_t mask = ip_states_.size() - 1;
+  size_t index = HashIp(ip) & mask;
+  while (ip_states_[index].is_used) {
+    if (::memcmp(&ip_states_[index].ip, &ip, sizeof(ip)) == 0) {
+      return &ip_states_[index];
+    }
+    index = (index + 1) & mask;
+  }
+  if (!should_insert) {
+    return nullptr;
+  }
+  if (used_slot_amount_ >= limits_.max_tracked_ips) {
+    Purge(now_seconds);
+    if (used_slot_amount_ >= limits_.max_tracked_ips) {
+      return nullptr;
+    }
+    return FindIpState(ip, true, now_seconds);
+  }
+  IpState& ip_state = ip_states_[index];
+  ip_state.ip = ip;
+  ip_state.connections = 0;
+  ip_state.accepts_in_window = 0;
+  ip_state.window_second = now_seconds;
+  ip_state.is_used = true;
+  ++used_slot_amount_;
+  return &ip_state;
+}
+
+void AdmissionController::Purge(int64_t now_seconds) {
+  // Rebuild the table (rare), which is simpler than deleting from the middle
+  // of probing chains
+  std::vector<IpState> old_ip_states(ip_states_.size());
+  old_ip_states.swap(ip_states_);
+  used_slot_amount_ = 0;
+  size_t mask = ip_states_.size() - 1;
+  for (const auto& ip_state : old_ip_states) {
+    if (!ip_state.is_used || (0 == ip_state.connections &&
+                              ip_state.window_second != now_seconds)) {
+      continue;
+    }
+    size_t index = HashIp(ip_state.ip) & mask;
+    while (ip_states_[index].is_used) {
+      index = (index + 1) & mask;
+    }
+    ip_states_[index] = ip_state;
+    ++used_slot_amount_;
+  }
+}
+
+}  // namespace taotu
@@ -0,0 +1,126 @@
+/**
+ * @file admission_controller.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "AdmissionController" which decides whether a
+ * newly accepted TCP connection may be served.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_ADMISSION_CONTROLLER_H_
+#define TAOTU_SRC_ADMISSION_CONTROLLER_H_
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "net_address.h"
+#include "non_copyable_movable.h"
+#include "spin_lock.h"
+
+namespace taotu {
+
+// What to do when the limit of all connections is reached
+enum AdmissionPolicy {
+  kResetOverflow = 0,  // Keep accepting and reset the ones over the limit
+  kPauseAccepting = 1,  // Stop accepting until some connection is closed, so
+                        // the kernel backlog absorbs bursts
+};
+
+// Limits of admission ("0" means no limit)
+struct AdmissionLimits {
+  size_t max_connections{0};           // Of the whole server
+  size_t max_connections_per_loop{0};  // Of each I/O thread
+  uint32_t max_connections_per_ip{0};  // Unix domain peers are not counted
+  uint32_t max_accepts_per_ip_per_second{0};
+  size_t max_tracked_ips{65536};  // Capacity of the per-IP table
+  int policy{AdmissionPolicy::kResetOverflow};
+};
+
+/**
+ * @brief "AdmissionController" counts the connections being served in total
+ * and per source IP. Per-IP states live in a flat open-addressing hash table
+ * with linear probing, so admitting one connection touches only a few
+ * adjacent slots. It is called by the accepting thread ("Admit()") and by I/O
+ * threads ("Release()").
+ *
+ */
+class AdmissionController : NonCopyableMovable {
+ public:
+  enum Verdict {
+    kAdmitted = 0,
+    kTooManyConnections = 1,
+    kTooManyConnectionsFromIp = 2,
+    kTooFrequentFromIp = 3,
+    kTooManyIps = 4,
+  };
+
+  AdmissionController();
+
+  // Set the limits (before serving)
+  void SetLimits(const AdmissionLimits& limits);
+  const AdmissionLimits& GetLimits() const { return limits_; }
+
+  // Decide whether the connection from "peer_address" may be served, and
+  // count it in if so ("now_seconds" is the current time in seconds)
+  Verdict Admit(const NetAddress& peer_address, int64_t now_seconds);
+
+  // Count out one connection admitted before, return true if the limit of all
+  // connections was reached before that
+  bool Release(const NetAddress& peer_address);
+
+  // Whether the limit of all connections is reached
+  bool IsFull() const;
+
+  size_t GetConnectionAmount() const {
+    return connection_amount_.load(std::memory_order_relaxed);
+  }
+  size_t GetRejectedAmount() const {
+    return rejected_amount_.load(std::memory_order_relaxed);
+  }
+  void AddRejected() {
+    rejected_amount_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+ private:
+  struct IpState {
+    struct in6_addr ip {};
+    uint32_t connections{0};
+    uint32_t accepts_in_window{0};
+    int64_t window_second{0};
+    bool is_used{false};
+  };
+
+  bool HasPerIpLimits() const {
+    return limits_.max_connections_per_ip > 0 ||
+           limits_.max_accepts_per_ip_per_second > 0;
+  }
+
+  // Find the state of the IP (inserting one if "should_insert"), nullptr if
+  // not found or the table is full
+  IpState* FindIpState(const struct in6_addr& ip, bool should_insert,
+                       int64_t now_seconds);
+
+  // Drop states which hold no connection and no recent accepting
+  void Purge(int64_t now_seconds);
+
+  AdmissionLimits limits_;
+
+  // Power-of-2 sized, at most half of the slots are used
+  std::vector<IpState> ip_states_;
+  size_t used_slot_amount_;
+
+  std::atomic_size_t connection_amount_;
+  std::atomic_size_t rejected_amount_;
+
+  MutexLock lock_;
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_ADMISSION_CONTROLLER_H_
@@ -12,16 +12,29 @@
 #include "balancer.h"
 
 #include "event_manager.h"
+#include "loop_metrics.h"
 #include "reactor_manager.h"
+#include "time_point.h"
 
 namespace taotu {
 
 Balancer::Balancer(ServerReactorManager::EventManagers* event_managers,
                    int strategy)
-    : event_managers_(event_managers), strategy_(strategy), cursor_(0) {}
+    : event_managers_(event_managers),
+      strategy_(strategy),
+      cursor_(0),
+      random_state_(static_cast<uint64_t>(TimePoint::FNow()) | 1) {}
+
+void Balancer::SetWeights(const std::vector<int>& weights) {
+  weights_ = weights;
+  current_weights_.assign(weights_.size(), 0);
+}
 
 EventManager* Balancer::PickOneEventManager() {
   auto evt_mng_num = event_managers_->size();
+  if (evt_mng_num <= 1) {  // The only one also accepts
+    return (*event_managers_)[0];
+  }
   switch (strategy_) {
     // "Round Robin"
     case BalancerStrategy::kRoundRobin:
@@ -31,19 +44,102 @@ EventManager* Balancer::PickOneEventManager() {
       break;
     // Pick the I/O thread holding least "Eventer"s
     case BalancerStrategy::kMinEvents:
-      size_t pos = 1;
-      uint32_t min_evts = (*event_managers_)[pos]->GetEventerAmount();
-      for (size_t i = 2; i < evt_mng_num; ++i) {
-        if ((*event_managers_)[i]->GetEventerAmount() < min_evts) {
-          pos = i;
-          min_evts =
-              static_cast<int>((*event_managers_)[pos]->GetEventerAmount());
-        }
-        cursor_ = pos;
-      }
+      cursor_ = PickLeastLoaded([](const LoopMetrics& loop_metrics) {
+        return static_cast<uint64_t>(loop_metrics.GetActiveConnections());
+      });
+      break;
+    case BalancerStrategy::kPowerOfTwoChoices:
+      cursor_ = PickByPowerOfTwoChoices();
+      break;
+    case BalancerStrategy::kLeastLatency:
+      cursor_ = PickLeastLoaded([](const LoopMetrics& loop_metrics) {
+        return loop_metrics.GetLoopLatencyUs();
+      });
+      break;
+    case BalancerStrategy::kLeastBytesPerSecond:
+      cursor_ = PickLeastLoaded([](const LoopMetrics& loop_metrics) {
+        return loop_metrics.GetBytesPerSecond();
+      });
+      break;
+    case BalancerStrategy::kWeighted:
+      cursor_ = PickByWeights();
       break;
   }
   return (*event_managers_)[cursor_];
 }
 
+template <class LoadGetter>
+size_t Balancer::PickLeastLoaded(LoadGetter GetLoad) const {
+  auto evt_mng_num = event_managers_->size();
+  // Connections break ties, or new connections would all go to the first idle
+  // I/O thread until its load is published
+  size_t pos = 1;
+  const auto* loop_metrics = &(*event_managers_)[pos]->GetLoopMetrics();
+  uint64_t min_load = GetLoad(*loop_metrics);
+  uint32_t min_connections = loop_metrics->GetActiveConnections();
+  for (size_t i = 2; i < evt_mng_num; ++i) {
+    loop_metrics = &(*event_managers_)[i]->GetLoopMetrics();
+    uint64_t load = GetLoad(*loop_metrics);
+    uint32_t connections = loop_metrics->GetActiveConnections();
+    if (load < min_load ||
+        (load == min_load && connections < min_connections)) {
+      pos = i;
+      min_load = load;
+      min_connections = connections;
+    }
+  }
+  return pos;
+}
+
+size_t Balancer::PickByPowerOfTwoChoices() {
+  // Indexes of I/O threads are in [1, evt_mng_num)
+  auto candidate_num = event_managers_->size() - 1;
+  size_t first = 1 + NextRandom() % candidate_num;
+  if (candidate_num == 1) {
+    return first;
+  }
+  size_t second = 1 + (first + NextRandom() % (candidate_num - 1)) %
+                          candidate_num;  // Differs from "first"
+  const auto& first_metrics = (*event_managers_)[first]->GetLoopMetrics();
+  const auto& second_metrics = (*event_managers_)[second]->GetLoopMetrics();
+  uint32_t first_busy = first_metrics.GetBusyPermille();
+  uint32_t second_busy = second_metrics.GetBusyPermille();
+  if (first_busy != second_busy) {
+    return first_busy < second_busy ? first : second;
+  }
+  return first_metrics.GetActiveConnections() <=
+                 second_metrics.GetActiveConnections()
+             ? first
+             : second;
+}
+
+size_t Balancer::PickByWeights() {
+  auto evt_mng_num = event_managers_->size();
+  if (current_weights_.size() < evt_mng_num) {
+    current_weights_.resize(evt_mng_num, 0);
+  }
+  size_t pos = 1;
+  int64_t total_weight = 0;
+  for (size_t i = 1; i < evt_mng_num; ++i) {
+    int weight = i < weights_.size() ? weights_[i] : 1;
+    if (weight <= 0) {
+      continue;
+    }
+    current_weights_[i] += weight;
+    total_weight += weight;
+    if (current_weights_[i] > current_weights_[pos] || total_weight == weight) {
+      pos = i;
+    }
+  }
+  current_weights_[pos] -= total_weight;
+  return pos;
+}
+
+uint64_t Balancer::NextRandom() {
+  random_state_ ^= random_state_ >> 12;
+  random_state_ ^= random_state_ << 25;
+  random_state_ ^= random_state_ >> 27;
+  return random_state_ * 0x2545F4914F6CDD1DULL;
+}
+
 }  // namespace taotu
@@ -12,6 +12,9 @@
 #ifndef TAOTU_SRC_BALANCER_H_
 #define TAOTU_SRC_BALANCER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <vector>
 
 #include "reactor_manager.h"
@@ -22,6 +25,11 @@ enum BalancerStrategy {
   kRoundRobin = 0,  // Use "Round Robin" strategy
   kMinEvents = 1,  // Use the strategy which always picks the I/O thread holding
                    // least "Eventer"s
+  kPowerOfTwoChoices = 2,  // Pick the less busy one of two random I/O threads
+  kLeastLatency = 3,  // Pick the I/O thread whose recent loop iterations took
+                      // the least time
+  kLeastBytesPerSecond = 4,  // Pick the I/O thread moving the least bytes
+  kWeighted = 5,  // Use "Smooth Weighted Round Robin" with the weights set
 };
 
 /**
@@ -39,10 +47,24 @@ class Balancer {
   // I/O thread("EventManager")
   void SetStrategy(int strategy) { strategy_ = strategy; }
 
+  // Set the weight of each I/O thread("EventManager") for the weighted
+  // strategy (indexed like the "EventManager"s, missing ones weigh 1)
+  void SetWeights(const std::vector<int>& weights);
+
   // Get one "EventManager" in the least busy I/O thread
   EventManager* PickOneEventManager();
 
  private:
+  // Pick the index of the I/O thread with the least value given by "GetLoad"
+  template <class LoadGetter>
+  size_t PickLeastLoaded(LoadGetter GetLoad) const;
+
+  size_t PickByPowerOfTwoChoices();
+  size_t PickByWeights();
+
+  // Cheap pseudo-random number ("xorshift64*")
+  uint64_t NextRandom();
+
   // Weak reference from the set of "EventManager"s from "Reactor" in the main
   // thread
   ServerReactorManager::EventManagers* event_managers_;
@@ -53,6 +75,12 @@ class Balancer {
 
   // The mark of the index of the chosen "EventManager" in "event_managers_"
   size_t cursor_;
+
+  // Weights and current weights of "Smooth Weighted Round Robin"
+  std::vector<int> weights_;
+  std::vector<int64_t> current_weights_;
+
+  uint64_t random_state_;
 };
 
 }  // namespace taotu
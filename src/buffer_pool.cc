@@ -0,0 +1,168 @@
+/**
+ * @file buffer_pool.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "BufferPool" which is the block pool backing
+ * the storage of "IoBuffer"s in one I/O thread.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "buffer_pool.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+
+#include "logger.h"
+
+namespace taotu {
+
+namespace {
+std::atomic<size_t> global_bytes_in_use{0};
+std::atomic<size_t> global_budget_bytes{0};
+std::atomic_bool is_over_budget{false};
+
+// Lock ("MutexLock") protecting the budget callback
+MutexLock budget_callback_lock;
+BufferPool::BudgetExceededCallback budget_exceeded_callback;
+}  // namespace
+
+BufferPool::BufferPool()
+    : free_lists_(),
+      bytes_in_use_(0),
+      bytes_cached_(0),
+      max_cached_bytes_(kDefaultMaxCachedBytes),
+      max_retained_capacity_(kDefaultMaxRetainedCapacity),
+      should_release_idle_input_(false) {
+  free_lists_.fill(nullptr);
+}
+BufferPool::~BufferPool() {
+  LockGuard lock_guard(pool_lock_);
+  for (auto& free_list_head : free_lists_) {
+    while (free_list_head != nullptr) {
+      MemoryBlockNode* tmp_node = free_list_head;
+      free_list_head = free_list_head->next_node_;
+      ::free(reinterpret_cast<void*>(tmp_node));
+    }
+  }
+  if (bytes_in_use_ != 0) {
+    LOG_WARN("Buffer pool is destroyed with %zu bytes still in use!",
+             bytes_in_use_);
+  }
+}
+
+char* BufferPool::Allocate(size_t size, size_t* block_size) {
+  char* block = nullptr;
+  if (size > kMaxBlockSize) {
+    // Too large to be cached, round it up to a multiple of the minimum block
+    *block_size = (size + kMinBlockSize - 1) & ~(kMinBlockSize - 1);
+    block = static_cast<char*>(::malloc(*block_size));
+    LockGuard lock_guard(pool_lock_);
+    bytes_in_use_ += *block_size;
+  } else {
+    size_t class_index = GetClassIndex(size);
+    *block_size = kMinBlockSize << class_index;
+    LockGuard lock_guard(pool_lock_);
+    MemoryBlockNode*& free_list_head = free_lists_[class_index];
+    if (free_list_head != nullptr) {
+      block = &free_list_head->data_;
+      free_list_head = free_list_head->next_node_;
+      bytes_cached_ -= *block_size;
+    } else {
+      block = static_cast<char*>(::malloc(*block_size));
+    }
+    bytes_in_use_ += *block_size;
+  }
+  if (block == nullptr) {
+    LOG_CRIT("Buffer pool fails to allocate %zu bytes!!!", *block_size);
+    ::abort();
+  }
+  AddGlobalUsage(*block_size);
+  return block;
+}
+
+void BufferPool::Deallocate(char* block, size_t block_size) {
+  if (block == nullptr) {
+    return;
+  }
+  SubGlobalUsage(block_size);
+  {
+    LockGuard lock_guard(pool_lock_);
+    // The block may come from another pool (migrated connections)
+    bytes_in_use_ -= bytes_in_use_ < block_size ? bytes_in_use_ : block_size;
+    if (block_size <= kMaxBlockSize &&
+        bytes_cached_ + block_size <= max_cached_bytes_) {
+      MemoryBlockNode* tmp_node = reinterpret_cast<MemoryBlockNode*>(block);
+      MemoryBlockNode*& free_list_head = free_lists_[GetClassIndex(block_size)];
+      tmp_node->next_node_ = free_list_head;
+      free_list_head = tmp_node;
+      bytes_cached_ += block_size;
+      return;
+    }
+  }
+  ::free(static_cast<void*>(block));
+}
+
+size_t BufferPool::GetBytesInUse() const {
+  LockGuard lock_guard(pool_lock_);
+  return bytes_in_use_;
+}
+size_t BufferPool::GetBytesCached() const {
+  LockGuard lock_guard(pool_lock_);
+  return bytes_cached_;
+}
+
+void BufferPool::SetMemoryBudget(size_t budget_bytes,
+                                 const BudgetExceededCallback& cb) {
+  {
+    LockGuard lock_guard(budget_callback_lock);
+    budget_exceeded_callback = cb;
+  }
+  global_budget_bytes.store(budget_bytes, std::memory_order_relaxed);
+  is_over_budget.store(false, std::memory_order_relaxed);
+}
+
+size_t BufferPool::GetGlobalBytesInUse() {
+  return global_bytes_in_use.load(std::memory_order_relaxed);
+}
+
+size_t BufferPool::GetClassIndex(size_t size) {
+  size_t class_index = 0;
+  size_t class_size = kMinBlockSize;
+  while (class_size < size) {
+    class_size <<= 1;
+    ++class_index;
+  }
+  return class_index;
+}
+
+void BufferPool::AddGlobalUsage(size_t bytes) {
+  size_t used_bytes =
+      global_bytes_in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  size_t budget_bytes = global_budget_bytes.load(std::memory_order_relaxed);
+  // Only report once each time the usage goes beyond the budget
+  if (budget_bytes != 0 && used_bytes > budget_bytes &&
+      !is_over_budget.exchange(true, std::memory_order_relaxed)) {
+    BudgetExceededCallback cb;
+    {
+      LockGuard lock_guard(budget_callback_lock);
+      cb = budget_exceeded_callback;
+    }
+    LOG_WARN("I/O buffers use %zu bytes beyond the budget of %zu bytes!",
+             used_bytes, budget_bytes);
+    if (cb) {
+      cb(used_bytes, budget_bytes);
+    }
+  }
+}
+void BufferPool::SubGlobalUsage(size_t bytes) {
+  size_t used_bytes =
+      global_bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+  if (used_bytes <= global_budget_bytes.load(std::memory_order_relaxed)) {
+    is_over_budget.store(false, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace taotu
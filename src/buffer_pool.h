@@ -0,0 +1,104 @@
+/**
+ * @file buffer_pool.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "BufferPool" which is the block pool backing the
+ * storage of "IoBuffer"s in one I/O thread.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_BUFFER_POOL_H_
+#define TAOTU_SRC_BUFFER_POOL_H_
+
+#include <stddef.h>
+
+#include <array>
+#include <functional>
+
+#include "memory_pool.h"
+#include "non_copyable_movable.h"
+#include "spin_lock.h"
+
+namespace taotu {
+
+/**
+ * @brief "BufferPool" hands out power-of-two memory blocks (from 1KiB to 64KiB)
+ * to "IoBuffer"s and caches the returned ones in per-size free lists, so an
+ * emptied buffer can give its storage back and take it again cheaply. Larger
+ * blocks bypass the cache. Every block is allocated on its own, so a block may
+ * be returned to a pool other than the one it came from. All pools share one
+ * global memory budget whose overrun is reported by a callback.
+ *
+ */
+class BufferPool : NonCopyableMovable {
+ public:
+  typedef std::function<void(size_t used_bytes, size_t budget_bytes)>
+      BudgetExceededCallback;
+
+  static constexpr size_t kMinBlockSize = 1024;
+  static constexpr size_t kMaxBlockSize = 64 * 1024;
+  static constexpr size_t kDefaultMaxRetainedCapacity = 64 * 1024;
+  static constexpr size_t kDefaultMaxCachedBytes = 32 * 1024 * 1024;
+
+  BufferPool();
+  ~BufferPool();
+
+  // Allocate a block holding at least "size" bytes (the real size is written
+  // into "block_size")
+  char* Allocate(size_t size, size_t* block_size);
+
+  // Give a block back (the size must be the one got from Allocate())
+  void Deallocate(char* block, size_t block_size);
+
+  // Largest capacity an "IoBuffer" of this pool keeps after being drained
+  size_t GetMaxRetainedCapacity() const { return max_retained_capacity_; }
+  void SetMaxRetainedCapacity(size_t capacity) {
+    max_retained_capacity_ = capacity;
+  }
+
+  // Upper bound of bytes kept in the free lists of this pool
+  void SetMaxCachedBytes(size_t bytes) { max_cached_bytes_ = bytes; }
+
+  // Whether idle connections release their input storage and wait for
+  // readability before posting a new read buffer
+  bool ShouldReleaseIdleInput() const { return should_release_idle_input_; }
+  void SetReleaseIdleInput(bool on) { should_release_idle_input_ = on; }
+
+  size_t GetBytesInUse() const;
+  size_t GetBytesCached() const;
+
+  // Set the memory budget shared by all pools (0 means unlimited)
+  static void SetMemoryBudget(size_t budget_bytes,
+                              const BudgetExceededCallback& cb);
+
+  // Bytes handed out by all pools and not returned yet
+  static size_t GetGlobalBytesInUse();
+
+ private:
+  static constexpr size_t kClassAmount = 7;  // 1KiB, 2KiB, ..., 64KiB
+
+  // Get the index of the smallest size class holding "size" bytes
+  static size_t GetClassIndex(size_t size);
+
+  // Record bytes handed out and check the global budget
+  static void AddGlobalUsage(size_t bytes);
+  static void SubGlobalUsage(size_t bytes);
+
+  // Free linked lists of each size class
+  std::array<MemoryBlockNode*, kClassAmount> free_lists_;
+
+  size_t bytes_in_use_;
+  size_t bytes_cached_;
+  size_t max_cached_bytes_;
+  size_t max_retained_capacity_;
+  bool should_release_idle_input_;
+
+  // Lock ("MutexLock") protecting the free lists and the counters
+  mutable MutexLock pool_lock_;
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_BUFFER_POOL_H_
@@ -0,0 +1,355 @@
+/**
+ * @file byte_scanner.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of the delimiter scanning kernels (and class "ByteSet")
+ * used by "IoBuffer".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "byte_scanner.h"
+
+#include <string.h>
+
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define TAOTU_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace taotu {
+
+ByteSet::ByteSet(const char* bytes, size_t len)
+    : bitmap_{0, 0, 0, 0},
+      members_{},
+      member_amount_(0),
+      low_table_{},
+      high_table_{} {
+  for (size_t i = 0; i < len; ++i) {
+    Insert(static_cast<unsigned char>(bytes[i]));
+  }
+}
+ByteSet::ByteSet(const char* bytes) : ByteSet(bytes, ::strlen(bytes)) {}
+
+void ByteSet::Insert(unsigned char byte) {
+  if (Contains(byte)) {
+    return;
+  }
+  bitmap_[byte >> 6] |= static_cast<uint64_t>(1) << (byte & 63);
+  if (member_amount_ < sizeof(members_)) {
+    members_[member_amount_] = static_cast<char>(byte);
+  }
+  ++member_amount_;
+  uint8_t low_nibble = byte & 0x0F;
+  uint8_t high_nibble = byte >> 4;
+  if (high_nibble < 8) {
+    low_table_[low_nibble] |= static_cast<uint8_t>(1 << high_nibble);
+  } else {
+    high_table_[low_nibble] |= static_cast<uint8_t>(1 << (high_nibble - 8));
+  }
+}
+
+namespace {
+
+const char* ScalarFindCrlf(const char* begin, const char* end) {
+  const char* position = begin;
+  while (end - position >= 2) {
+    position = static_cast<const char*>(
+        ::memchr(position, '\r', end - position - 1));
+    if (position == nullptr) {
+      return nullptr;
+    }
+    if (position[1] == '\n') {
+      return position;
+    }
+    ++position;
+  }
+  return nullptr;
+}
+
+const char* ScalarFindDoubleCrlf(const char* begin, const char* end) {
+  const char* position = begin;
+  while (end - position >= 4) {
+    position = ScalarFindCrlf(position, end - 2);
+    if (position == nullptr) {
+      return nullptr;
+    }
+    if (position[2] == '\r' && position[3] == '\n') {
+      return position;
+    }
+    // "position[1]" is '\n' so the next candidate is "position[2]"
+    position += 2;
+  }
+  return nullptr;
+}
+
+const char* ScalarFindAnyOf(const char* begin, const char* end,
+                            const ByteSet& byte_set) {
+  for (const char* position = begin; position < end; ++position) {
+    if (byte_set.Contains(static_cast<unsigned char>(*position))) {
+      return position;
+    }
+  }
+  return nullptr;
+}
+
+#ifdef TAOTU_SCANNER_X86
+
+// Lines are mostly free of '\r', so check the following '\n' only for blocks
+// having some '\r'
+__attribute__((target("sse4.2"))) const char* Sse42FindCrlf(const char* begin,
+                                                             const char* end) {
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const char* position = begin;
+  while (end - position >= 17) {
+    __m128i cr_mask = _mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(position)), cr);
+    if (!_mm_testz_si128(cr_mask, cr_mask)) {
+      __m128i lf_mask = _mm_cmpeq_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 1)), lf);
+      int mask = _mm_movemask_epi8(_mm_and_si128(cr_mask, lf_mask));
+      if (mask != 0) {
+        return position + __builtin_ctz(mask);
+      }
+    }
+    position += 16;
+  }
+  return ScalarFindCrlf(position, end);
+}
+
+__attribute__((target("sse4.2"))) const char* Sse42FindDoubleCrlf(
+    const char* begin, const char* end) {
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const char* position = begin;
+  while (end - position >= 19) {
+    __m128i crlf_mask = _mm_and_si128(
+        _mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(position)), cr),
+        _mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 1)),
+            lf));
+    __m128i next_crlf_mask = _mm_and_si128(
+        _mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 2)),
+            cr),
+        _mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 3)),
+            lf));
+    int mask = _mm_movemask_epi8(_mm_and_si128(crlf_mask, next_crlf_mask));
+    if (mask != 0) {
+      return position + __builtin_ctz(mask);
+    }
+    position += 16;
+  }
+  return ScalarFindDoubleCrlf(position, end);
+}
+
+__attribute__((target("sse4.2"))) const char* Sse42FindAnyOf(
+    const char* begin, const char* end, const ByteSet& byte_set) {
+  size_t member_amount = byte_set.GetMemberAmount();
+  if (member_amount == 0 || member_amount > 16) {
+    return ScalarFindAnyOf(begin, end, byte_set);
+  }
+  const __m128i members = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(byte_set.GetMembers()));
+  const char* position = begin;
+  while (end - position >= 16) {
+    int index = _mm_cmpestri(
+        members, static_cast<int>(member_amount),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(position)), 16,
+        _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+    if (index < 16) {
+      return position + index;
+    }
+    position += 16;
+  }
+  return ScalarFindAnyOf(position, end, byte_set);
+}
+
+__attribute__((target("avx2"))) const char* Avx2FindCrlf(const char* begin,
+                                                          const char* end) {
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  const char* position = begin;
+  while (end - position >= 65) {
+    __m256i first_cr_mask = _mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position)), cr);
+    __m256i second_cr_mask = _mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + 32)),
+        cr);
+    __m256i cr_mask = _mm256_or_si256(first_cr_mask, second_cr_mask);
+    if (!_mm256_testz_si256(cr_mask, cr_mask)) {
+      __m256i first_lf_mask = _mm256_cmpeq_epi8(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + 1)),
+          lf);
+      __m256i second_lf_mask = _mm256_cmpeq_epi8(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + 33)),
+          lf);
+      uint64_t mask =
+          static_cast<uint32_t>(_mm256_movemask_epi8(
+              _mm256_and_si256(first_cr_mask, first_lf_mask))) |
+          static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(
+              _mm256_and_si256(second_cr_mask, second_lf_mask))))
+              << 32;
+      if (mask != 0) {
+        return position + __builtin_ctzll(mask);
+      }
+    }
+    position += 64;
+  }
+  return Sse42FindCrlf(position, end);
+}
+
+__attribute__((target("avx2"))) const char* Avx2FindDoubleCrlf(
+    const char* begin, const char* end) {
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  const char* position = begin;
+  while (end - position >= 35) {
+    __m256i crlf_mask = _mm256_and_si256(
+        _mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position)),
+            cr),
+        _mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + 1)),
+            lf));
+    __m256i next_crlf_mask = _mm256_and_si256(
+        _mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + 2)),
+            cr),
+        _mm256_cmpeq_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + 3)),
+            lf));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_and_si256(crlf_mask, next_crlf_mask)));
+    if (mask != 0) {
+      return position + __builtin_ctz(mask);
+    }
+    position += 32;
+  }
+  return Sse42FindDoubleCrlf(position, end);
+}
+
+// Classify 32 bytes at once by looking their low nibbles up in the tables of
+// the set and checking the bit selected by their high nibbles
+__attribute__((target("avx2"))) const char* Avx2FindAnyOf(
+    const char* begin, const char* end, const ByteSet& byte_set) {
+  const __m256i low_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(byte_set.GetLowTable())));
+  const __m256i high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(byte_set.GetHighTable())));
+  const __m256i bit_table =
+      _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64,
+                       -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32,
+                       64, -128);
+  const __m256i sign_bits = _mm256_set1_epi8(-128);
+  const __m256i low_nibble_mask = _mm256_set1_epi8(0x0F);
+  const char* position = begin;
+  while (end - position >= 32) {
+    __m256i data =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position));
+    // A shuffle index with the sign bit set yields 0, so each table only
+    // answers for its own half of the byte values
+    __m256i row_bits = _mm256_or_si256(
+        _mm256_shuffle_epi8(low_table, data),
+        _mm256_shuffle_epi8(high_table, _mm256_xor_si256(data, sign_bits)));
+    __m256i column_bits = _mm256_shuffle_epi8(
+        bit_table,
+        _mm256_and_si256(_mm256_srli_epi16(data, 4), low_nibble_mask));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_and_si256(row_bits, column_bits),
+                          column_bits)));
+    if (mask != 0) {
+      return position + __builtin_ctz(mask);
+    }
+    position += 32;
+  }
+  return ScalarFindAnyOf(position, end, byte_set);
+}
+
+#endif  // TAOTU_SCANNER_X86
+
+struct Kernels {
+  const char* (*FindCrlf)(const char*, const char*);
+  const char* (*FindDoubleCrlf)(const char*, const char*);
+  const char* (*FindAnyOf)(const char*, const char*, const ByteSet&);
+};
+
+#ifdef TAOTU_SCANNER_X86
+constexpr Kernels kKernels[] = {
+    {ScalarFindCrlf, ScalarFindDoubleCrlf, ScalarFindAnyOf},
+    {Sse42FindCrlf, Sse42FindDoubleCrlf, Sse42FindAnyOf},
+    {Avx2FindCrlf, Avx2FindDoubleCrlf, Avx2FindAnyOf},
+};
+#else
+constexpr Kernels kKernels[] = {
+    {ScalarFindCrlf, ScalarFindDoubleCrlf, ScalarFindAnyOf},
+};
+#endif
+
+// Index of the kernels in use (-1 means not detected yet)
+std::atomic<int> scan_level_index{-1};
+
+ScanLevel DetectScanLevel() {
+#ifdef TAOTU_SCANNER_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return ScanLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return ScanLevel::kSse42;
+  }
+#endif
+  return ScanLevel::kScalar;
+}
+
+const Kernels& GetKernels() {
+  int index = scan_level_index.load(std::memory_order_relaxed);
+  if (index < 0) {
+    index = static_cast<int>(DetectScanLevel());
+    scan_level_index.store(index, std::memory_order_relaxed);
+  }
+  return kKernels[index];
+}
+
+}  // namespace
+
+namespace byte_scanner {
+
+const char* FindCrlf(const char* begin, const char* end) {
+  return GetKernels().FindCrlf(begin, end);
+}
+
+const char* FindDoubleCrlf(const char* begin, const char* end) {
+  return GetKernels().FindDoubleCrlf(begin, end);
+}
+
+const char* FindAnyOf(const char* begin, const char* end,
+                      const ByteSet& byte_set) {
+  return GetKernels().FindAnyOf(begin, end, byte_set);
+}
+
+ScanLevel GetScanLevel() {
+  GetKernels();
+  return static_cast<ScanLevel>(
+      scan_level_index.load(std::memory_order_relaxed));
+}
+
+void SetScanLevel(ScanLevel scan_level) {
+  ScanLevel supported_level = DetectScanLevel();
+  if (scan_level > supported_level) {
+    scan_level = supported_level;
+  }
+  scan_level_index.store(static_cast<int>(scan_level),
+                         std::memory_order_relaxed);
+}
+
+}  // namespace byte_scanner
+
+}  // namespace taotu
@@ -0,0 +1,82 @@
+/**
+ * @file byte_scanner.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of the delimiter scanning kernels (and class "ByteSet")
+ * used by "IoBuffer".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_BYTE_SCANNER_H_
+#define TAOTU_SRC_BYTE_SCANNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace taotu {
+
+/**
+ * @brief "ByteSet" is a set of bytes to be searched for in one pass. It is
+ * built once and then kept in the forms needed by each scanning kernel.
+ *
+ */
+class ByteSet {
+ public:
+  ByteSet(const char* bytes, size_t len);
+
+  // Build from a null-terminated string
+  explicit ByteSet(const char* bytes);
+
+  bool Contains(unsigned char byte) const {
+    return (bitmap_[byte >> 6] >> (byte & 63)) & 1;
+  }
+
+  // Members as a string (valid only if there are no more than 16 of them)
+  const char* GetMembers() const { return members_; }
+  size_t GetMemberAmount() const { return member_amount_; }
+
+  // Nibble lookup tables (indexed by the low 4 bits, each bit of an entry
+  // tells whether the high 4 bits (0 ~ 7 or 8 ~ 15) match)
+  const uint8_t* GetLowTable() const { return low_table_; }
+  const uint8_t* GetHighTable() const { return high_table_; }
+
+ private:
+  void Insert(unsigned char byte);
+
+  uint64_t bitmap_[4];
+  char members_[16];
+  size_t member_amount_;
+  uint8_t low_table_[16];
+  uint8_t high_table_[16];
+};
+
+// Instruction sets the scanning kernels can use
+enum class ScanLevel { kScalar = 0, kSse42, kAvx2 };
+
+namespace byte_scanner {
+
+// Find the first "\r\n" in [begin, end) (nullptr if not found)
+const char* FindCrlf(const char* begin, const char* end);
+
+// Find the first "\r\n\r\n" in [begin, end) (nullptr if not found)
+const char* FindDoubleCrlf(const char* begin, const char* end);
+
+// Find the first byte in [begin, end) which belongs to the set (nullptr if
+// not found)
+const char* FindAnyOf(const char* begin, const char* end,
+                      const ByteSet& byte_set);
+
+// Get the level chosen by detecting the CPU at the first use
+ScanLevel GetScanLevel();
+
+// Force a level (for tests and benchmarks), which is lowered to the best one
+// the CPU supports
+void SetScanLevel(ScanLevel scan_level);
+
+}  // namespace byte_scanner
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_BYTE_SCANNER_H_
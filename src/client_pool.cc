@@ -0,0 +1,231 @@
+/**
+ * @file client_pool.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "ClientPool" which keeps many client-end TCP
+ * connections to one or more servers spread over several I/O threads.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "client_pool.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "logger.h"
+
+namespace taotu {
+
+namespace {
+NetAddress GetLocalAddress(int socket_fd) {
+  struct sockaddr_storage local_addr;
+  ::memset(&local_addr, 0, sizeof(local_addr));
+  auto addr_len = static_cast<socklen_t>(sizeof(local_addr));
+  if (::getsockname(socket_fd, reinterpret_cast<struct sockaddr*>(&local_addr),
+                    &addr_len) < 0) {
+    LOG_ERROR("Fail to get local network info when connecting!!!");
+  }
+  NetAddress local_address;
+  local_address.SetRawAddr(local_addr, addr_len);
+  return local_address;
+}
+NetAddress GetPeerAddress(int socket_fd) {
+  struct sockaddr_storage peer_addr;
+  ::memset(&peer_addr, 0, sizeof(peer_addr));
+  auto addr_len = static_cast<socklen_t>(sizeof(peer_addr));
+  if (::getpeername(socket_fd, reinterpret_cast<struct sockaddr*>(&peer_addr),
+                    &addr_len) < 0) {
+    LOG_ERROR("Fail to get peer network info when connecting!!!");
+  }
+  NetAddress peer_address;
+  peer_address.SetRawAddr(peer_addr, addr_len);
+  return peer_address;
+}
+}  // namespace
+
+ClientPool::Member::Member(EventManager* event_manager,
+                           const NetAddress& server_address, size_t index,
+                           const std::shared_ptr<SharedState>& shared_state)
+    : event_manager_(event_manager),
+      server_address_(server_address),
+      index_(index),
+      connector_(event_manager, server_address),
+      shared_state_(shared_state),
+      connection_(nullptr),
+      in_flight_(0),
+      is_stopped_(true) {}
+
+bool ClientPool::Member::Send(std::string message) {
+  if (!IsConnected()) {
+    return false;
+  }
+  in_flight_.fetch_add(1, std::memory_order_relaxed);
+  std::weak_ptr<Member> weak_member = shared_from_this();
+  event_manager_->RunSoon([weak_member, message = std::move(message)]() {
+    auto member = weak_member.lock();
+    Connecting* connection =
+        member != nullptr ? member->connection_.load(std::memory_order_acquire)
+                          : nullptr;
+    if (connection != nullptr && connection->IsConnected()) {
+      connection->Send(message);
+    }  // Or it is given up with the connection (whose count is reset)
+  });
+  return true;
+}
+
+ClientPool::ClientPool(const EventManagers& event_managers,
+                       const std::vector<NetAddress>& server_addresses,
+                       size_t connection_amount)
+    : shared_state_(std::make_shared<SharedState>()),
+      next_index_(0),
+      strategy_(PickStrategy::kRoundRobin) {
+  if (event_managers.empty() || server_addresses.empty()) {
+    LOG_ERROR("Client pool needs event managers and server addresses!!!");
+    return;
+  }
+  members_.reserve(connection_amount);
+  for (size_t i = 0; i < connection_amount; ++i) {
+    auto member = std::make_shared<Member>(
+        event_managers[i % event_managers.size()],
+        server_addresses[i % server_addresses.size()], i, shared_state_);
+    std::weak_ptr<Member> weak_member = member;
+    member->connector_.RegisterNewConnectionCallback(
+        [weak_member](int socket_fd) {
+          auto member = weak_member.lock();
+          if (member != nullptr) {
+            member->LaunchNewConnection(socket_fd);
+          } else {
+            ::close(socket_fd);
+          }
+        });
+    members_.push_back(std::move(member));
+  }
+}
+ClientPool::~ClientPool() {
+  LOG_DEBUG("Client pool is destroying.");
+  // Each member is kept by its task until torn down in its own loop
+  for (auto& member : members_) {
+    member->is_stopped_ = true;
+    member->event_manager_->RunSoon([member]() { member->Close(); });
+  }
+}
+
+void ClientPool::Start() {
+  for (auto& member : members_) {
+    member->is_stopped_ = false;
+    member->connector_.Start();
+  }
+}
+void ClientPool::Stop() {
+  for (auto& member : members_) {
+    member->is_stopped_ = true;
+    member->event_manager_->RunSoon([member]() { member->Close(); });
+  }
+}
+
+ClientPool::Member* ClientPool::Pick() {
+  size_t member_amount = members_.size();
+  if (0 == member_amount) {
+    return nullptr;
+  }
+  // Start from a rotating position, so ties are spread too
+  size_t start = next_index_.fetch_add(1, std::memory_order_relaxed);
+  if (PickStrategy::kLeastPending == strategy_) {
+    Member* least_pending_member = nullptr;
+    size_t least_in_flight = SIZE_MAX;
+    for (size_t i = 0; i < member_amount; ++i) {
+      Member* member = members_[(start + i) % member_amount].get();
+      if (member->IsConnected() && member->GetInFlight() < least_in_flight) {
+        least_in_flight = member->GetInFlight();
+        least_pending_member = member;
+      }
+    }
+    return least_pending_member;
+  }
+  for (size_t i = 0; i < member_amount; ++i) {
+    Member* member = members_[(start + i) % member_amount].get();
+    if (member->IsConnected()) {
+      return member;
+    }
+  }
+  return nullptr;
+}
+
+ClientPool::Member* ClientPool::FindMember(const Connecting& connection) {
+  LockGuard lock_guard(shared_state_->fd_members_lock);
+  auto it = shared_state_->fd_members.find(connection.Fd());
+  return it != shared_state_->fd_members.end() ? it->second : nullptr;
+}
+
+void ClientPool::CompleteOne(const Connecting& connection) {
+  Member* member = FindMember(connection);
+  if (member != nullptr && member->GetInFlight() > 0) {
+    member->in_flight_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ClientPool::Member::LaunchNewConnection(int socket_fd) {
+  if (is_stopped_) {
+    ::close(socket_fd);
+    return;
+  }
+  auto new_connection = event_manager_->InsertNewConnection(
+      socket_fd, GetLocalAddress(socket_fd), GetPeerAddress(socket_fd));
+  new_connection->RegisterOnConnectionCallback(
+      shared_state_->OnConnectionCallback);
+  new_connection->RegisterOnMessageCallback(shared_state_->OnMessageCallback);
+  new_connection->RegisterWriteCallback(shared_state_->OnWriteCompleteCallback);
+  std::weak_ptr<Member> weak_member = shared_from_this();
+  new_connection->RegisterCloseCallback([weak_member](Connecting& connection) {
+    auto member = weak_member.lock();
+    if (member != nullptr) {
+      member->OnConnectionClosed(connection);
+    } else {
+      connection.ForceClose();
+    }
+  });
+  {
+    LockGuard lock_guard(shared_state_->fd_members_lock);
+    shared_state_->fd_members[socket_fd] = this;
+  }
+  in_flight_ = 0;
+  connection_.store(new_connection, std::memory_order_release);
+  shared_state_->connected_amount.fetch_add(1, std::memory_order_relaxed);
+  new_connection->OnEstablishing();  // Set the status flag on and start reading
+}
+
+void ClientPool::Member::OnConnectionClosed(Connecting& connection) {
+  if (connection_.load() == &connection) {
+    connection_.store(nullptr, std::memory_order_release);
+    in_flight_ = 0;
+    shared_state_->connected_amount.fetch_sub(1, std::memory_order_relaxed);
+    {
+      LockGuard lock_guard(shared_state_->fd_members_lock);
+      shared_state_->fd_members.erase(connection.Fd());
+    }
+    if (shared_state_->OnCloseCallback) {
+      shared_state_->OnCloseCallback(connection);
+    }
+    if (shared_state_->should_reconnect && !is_stopped_) {
+      LOG_DEBUG("Member(%zu) of the client pool is connecting again.", index_);
+      connector_.Restart();
+    }
+  }
+  connection.ForceClose();
+}
+
+void ClientPool::Member::Close() {
+  connector_.Stop();
+  Connecting* connection = connection_.load();
+  if (connection != nullptr) {
+    connection->ForceClose();  // Which calls "OnConnectionClosed()" at once
+  }
+}
+
+}  // namespace taotu
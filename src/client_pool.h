@@ -0,0 +1,187 @@
+/**
+ * @file client_pool.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "ClientPool" which keeps many client-end TCP
+ * connections to one or more servers spread over several I/O threads.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_CLIENT_POOL_H_
+#define TAOTU_SRC_CLIENT_POOL_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "connecting.h"
+#include "connector.h"
+#include "event_manager.h"
+#include "net_address.h"
+#include "non_copyable_movable.h"
+#include "spin_lock.h"
+
+namespace taotu {
+
+/**
+ * @brief "ClientPool" opens a fixed amount of connections, which are assigned
+ * to the server addresses and the "EventManager"s in turn, and keeps them
+ * open: a connection closed is connected again, and failed connecting is
+ * retried by "Connector" with exponential backoff. Unlike "Client", it never
+ * quits the event loops it runs in, so they can be shared with others. Members
+ * are torn down in their own loops, which keep them (and what their callbacks
+ * share) alive until then, so the pool can be destroyed from any thread.
+ *
+ */
+class ClientPool : NonCopyableMovable {
+ public:
+  typedef std::vector<EventManager*> EventManagers;
+  typedef Connecting::NormalCallback NormalCallback;
+  typedef Connecting::OnMessageCallback MessageCallback;
+
+ private:
+  struct SharedState;
+
+ public:
+
+  enum PickStrategy {
+    kRoundRobin = 0,    // Go round the connected ones
+    kLeastPending = 1,  // Pick the connected one with the fewest requests in
+                        // flight
+  };
+
+  /**
+   * @brief "Member" is one connection slot of the pool, which stays while its
+   * connection comes and goes.
+   *
+   */
+  class Member : NonCopyableMovable,
+                 public std::enable_shared_from_this<Member> {
+   public:
+    Member(EventManager* event_manager, const NetAddress& server_address,
+           size_t index, const std::shared_ptr<SharedState>& shared_state);
+
+    EventManager* GetEventManager() const { return event_manager_; }
+    const NetAddress& GetServerAddress() const { return server_address_; }
+    size_t GetIndex() const { return index_; }
+
+    bool IsConnected() const {
+      return connection_.load(std::memory_order_acquire) != nullptr;
+    }
+
+    // Requests sent but not completed yet ("ClientPool::CompleteOne()")
+    size_t GetInFlight() const {
+      return in_flight_.load(std::memory_order_relaxed);
+    }
+
+    // Send one request (from any thread) in the loop of this member, which is
+    // in flight until completed, return false if it is not connected now
+    bool Send(std::string message);
+
+   private:
+    friend class ClientPool;
+
+    // Build the new connection in the loop thread
+    void LaunchNewConnection(int socket_fd);
+
+    // Forget the closed connection and connect again
+    void OnConnectionClosed(Connecting& connection);
+
+    // Stop connecting and close the connection (in the loop thread)
+    void Close();
+
+    EventManager* event_manager_;
+    NetAddress server_address_;
+    size_t index_;
+    Connector connector_;
+    std::shared_ptr<SharedState> shared_state_;
+
+    // Written in the loop thread only
+    std::atomic<Connecting*> connection_;
+    std::atomic_size_t in_flight_;
+    std::atomic_bool is_stopped_;
+  };
+
+  // "connection_amount" connections, where the i-th one goes to
+  // "server_addresses[i % size]" in "event_managers[i % size]" (whose loops
+  // are run by users)
+  ClientPool(const EventManagers& event_managers,
+             const std::vector<NetAddress>& server_addresses,
+             size_t connection_amount);
+  ~ClientPool();
+
+  void SetConnectionCallback(const NormalCallback& cb) {
+    shared_state_->OnConnectionCallback = cb;
+  }
+  void SetMessageCallback(const MessageCallback& cb) {
+    shared_state_->OnMessageCallback = cb;
+  }
+  void SetWriteCompleteCallback(const NormalCallback& cb) {
+    shared_state_->OnWriteCompleteCallback = cb;
+  }
+  void SetCloseCallback(const NormalCallback& cb) {
+    shared_state_->OnCloseCallback = cb;
+  }
+
+  // Set how "Pick()" chooses (see "PickStrategy", round robin by default)
+  void SetPickStrategy(int strategy) { strategy_ = strategy; }
+
+  // Whether to connect again after a connection is closed (true by default)
+  void SetReconnectOn(bool on) { shared_state_->should_reconnect = on; }
+
+  // Connect all (before or after the loops start)
+  void Start();
+
+  // Close all and stop connecting again
+  void Stop();
+
+  // Pick one connected member (from any thread), nullptr if there is none
+  Member* Pick();
+
+  Member* GetMember(size_t index) { return members_[index].get(); }
+  size_t GetMemberAmount() const { return members_.size(); }
+  size_t GetConnectedAmount() const {
+    return shared_state_->connected_amount.load(std::memory_order_relaxed);
+  }
+
+  // Find the member which the connection belongs to (in its loop thread)
+  Member* FindMember(const Connecting& connection);
+
+  // Mark one request of the connection as completed (in its loop thread,
+  // like in the message callback)
+  void CompleteOne(const Connecting& connection);
+
+ private:
+  typedef std::shared_ptr<Member> MemberPtr;
+
+  // What the callbacks of members use besides the members themselves
+  struct SharedState {
+    // Members by file descriptors of their connections
+    std::unordered_map<int, Member*> fd_members;
+    MutexLock fd_members_lock;
+
+    std::atomic_size_t connected_amount{0};
+    bool should_reconnect = true;
+
+    NormalCallback OnConnectionCallback;
+    MessageCallback OnMessageCallback;
+    NormalCallback OnWriteCompleteCallback;
+    NormalCallback OnCloseCallback;
+  };
+
+  std::vector<MemberPtr> members_;
+  std::shared_ptr<SharedState> shared_state_;
+
+  std::atomic_size_t next_index_;
+  int strategy_;
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_CLIENT_POOL_H_
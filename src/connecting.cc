@@ -12,17 +12,52 @@
 #include "connecting.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+#include "buffer_pool.h"
 #include "event_manager.h"
 #include "logger.h"
 
 namespace taotu {
+
+USE_LOG_CATEGORY(logger::kConnectionLog);
+
 namespace {
+// Reads start small (one minimum pool block) and grow up to this size while
+// they keep filling the input buffer up
+constexpr size_t kInitialReadSize =
+    BufferPool::kMinBlockSize - IoBuffer::kReservedCapacity;
+constexpr size_t kMaxReadSize = 64 * 1024;
+// Bytes of a file moved at most each time (the default capacity of a pipe)
+constexpr size_t kFileChunkSize = 64 * 1024;
+
+// Open a pipe and return its capacity (0 on failure)
+size_t OpenPipeFds(int* pipe_fds) {
+  if (::pipe2(pipe_fds, O_CLOEXEC | O_NONBLOCK) < 0) {
+    pipe_fds[0] = -1;
+    pipe_fds[1] = -1;
+    return 0;
+  }
+  int capacity = ::fcntl(pipe_fds[1], F_GETPIPE_SZ);
+  return capacity > 0 ? static_cast<size_t>(capacity) : kFileChunkSize;
+}
+void ClosePipeFds(int* pipe_fds) {
+  if (pipe_fds[0] >= 0) {
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+    pipe_fds[0] = -1;
+    pipe_fds[1] = -1;
+  }
+}
+
 const char* StrError(int err, char* buf, size_t len) {
 #if defined(_GNU_SOURCE)
   char* msg = ::strerror_r(err, buf, len);
@@ -51,22 +86,38 @@ Connecting::Connecting(EventManager* event_manager, int socket_fd,
       eventer_(event_manager->GetPoller(), socket_fd),
       local_address_(local_address),
       peer_address_(peer_address),
-      state_(ConnectionState::kConnecting) {
+      input_buffer_(event_manager->GetBufferPool()),
+      output_buffer_(event_manager->GetBufferPool()),
+      pending_output_buffer_(event_manager->GetBufferPool()),
+      state_(ConnectionState::kConnecting),
+      file_regions_(),
+      pipe_fds_{-1, -1},
+      pipe_bytes_(0),
+      read_size_hint_(kInitialReadSize) {
   socketer_.SetKeepAlive(true);
   eventer_.RegisterReadCallback(
       [this](TimePoint receive_time) { this->DoReading(receive_time); });
   eventer_.RegisterWriteCallback([this] { this->DoWriting(); });
   eventer_.RegisterCloseCallback([this] { this->DoClosing(); });
   eventer_.RegisterErrorCallback([this] { this->DoWithError(); });
-  LOG_DEBUG("The TCP connection with fd(%d) is being created.", socket_fd);
+  LOG_KV(logger::kDebug, "conn_create", "fd", socket_fd);
 }
 Connecting::~Connecting() {
   CancelPendingIo();
-  LOG_DEBUG("The TCP connection with fd(%d) is closing.", Fd());
+  // Failed in "DoClosing()" if it is closed, and the user is not called back
+  // from a connection half destroyed
+  file_regions_.clear();
+  ClosePipe();
+  StopRelaying();
+  LOG_KV(logger::kDebug, "conn_destroy", "fd", Fd());
 }
 
 void Connecting::DoReading(TimePoint receive_time) {
   (void)receive_time;
+  if (is_waiting_readable_) {
+    is_waiting_readable_ = false;
+    eventer_.DisableReadEvents();
+  }
   if (!read_in_flight_) {
     SubmitReadOnce();
   }
@@ -89,12 +140,16 @@ void Connecting::OnReadComplete(struct io_uring_cqe* cqe,
     connecting->read_in_flight_ = false;
     delete ctx;
     op->context = nullptr;
+    if (connecting->migration_target_ != nullptr) {
+      connecting->ContinueMigrating();
+    }
     return;
   }
   if (!more) {
     connecting->read_in_flight_ = false;
   }
   if (res > 0) {
+    connecting->AddTransferredBytes(static_cast<size_t>(res));
     // Update the input buffer.
     if (ctx->multishot && has_buffer) {
       auto* buf =
@@ -105,23 +160,29 @@ void Connecting::OnReadComplete(struct io_uring_cqe* cqe,
         LOG_WARN("buffer id out of range(%u)", ctx->buf_id);
       }
     } else {
-      size_t writable = ctx->writable;
-      if (static_cast<size_t>(res) <= writable) {
-        connecting->input_buffer_.RefreshW(static_cast<size_t>(res));
-      } else {
-        connecting->input_buffer_.RefreshW(writable);
-        connecting->input_buffer_.Append(ctx->extra_buffer,
-                                         static_cast<size_t>(res) - writable);
+      connecting->input_buffer_.RefreshW(static_cast<size_t>(res));
+      // Ask for more next time if this read filled the buffer up, and for less
+      // if it used only a small part of it
+      if (static_cast<size_t>(res) >= ctx->writable) {
+        connecting->read_size_hint_ =
+            std::min(ctx->writable * 2, kMaxReadSize);
+      } else if (static_cast<size_t>(res) < connecting->read_size_hint_ / 4) {
+        connecting->read_size_hint_ =
+            std::max(connecting->read_size_hint_ / 2, kInitialReadSize);
       }
     }
-    if (connecting->OnMessageCallback_) {
+    if (connecting->relay_ != nullptr) {  // Began relaying during this read
+      if (connecting->relay_->peer != nullptr) {
+        connecting->relay_->peer->Send(&connecting->input_buffer_);
+      }
+    } else if (connecting->OnMessageCallback_) {
       connecting->OnMessageCallback_(*connecting, &connecting->input_buffer_,
                                      TimePoint{});
     }
     // Submit the next read continuously (re-armed after one-shot or
     // when multishot completes).
     if (!more) {
-      connecting->SubmitReadOnce();
+      connecting->ContinueReading();
     }
   } else if (res == 0) {  // Peer closed.
     connecting->DoClosing();
@@ -130,24 +191,29 @@ void Connecting::OnReadComplete(struct io_uring_cqe* cqe,
       if (!more) {
         connecting->SubmitReadOnce();
       }
+    } else if (err == ECANCELED && connecting->migration_target_ != nullptr) {
+      // Interrupted for migrating
     } else if (err == ECONNRESET || err == ECONNABORTED || err == EPIPE) {
       char errbuf[128];
       const char* err_str = StrError(err, errbuf, sizeof(errbuf));
       if (err_str == nullptr || *err_str == '\0') {
         err_str = "unknown";
       }
-      LOG_INFO("Peer closed/reset the connection fd(%d) err(%d - %s)",
-               connecting->Fd(), err, err_str);
+      LOG_KV(logger::kInfo, "conn_peer_close", "fd", connecting->Fd(), "err",
+             err, "reason", err_str);
       connecting->DoClosing();
     } else {
-      LOG_ERROR("OnReadComplete error: fd(%d) res(%zd) err(%d)",
-                connecting->Fd(), res, err);
+      LOG_KV(logger::kError, "conn_read_error", "fd", connecting->Fd(), "res",
+             res, "err", err);
       connecting->DoWithError(err);
     }
   }
   if (!more) {
     delete ctx;
     op->context = nullptr;
+    if (connecting->migration_target_ != nullptr) {
+      connecting->ContinueMigrating();
+    }
   }
 }
 
@@ -161,57 +227,95 @@ void Connecting::OnWriteComplete(struct io_uring_cqe* cqe,
   LOG_DEBUG("Write complete fd(%d) res(%zd) err(%d)", connecting->Fd(), res,
             err);
   if (res > 0) {
+    connecting->AddTransferredBytes(static_cast<size_t>(res));
     connecting->output_buffer_.Refresh(static_cast<size_t>(res));
-    if (connecting->output_buffer_.GetReadableBytes() > 0) {
-      connecting->SubmitWriteOnce();
-    } else {
-      if (connecting->pending_output_buffer_.GetReadableBytes() > 0) {
-        connecting->output_buffer_.Swap(connecting->pending_output_buffer_);
-        connecting->SubmitWriteOnce();
-        delete ctx;
-        return;
-      }
-      if (connecting->WriteCompleteCallback_) {
-        connecting->WriteCompleteCallback_(*connecting);
-      }
-      if (Connecting::ConnectionState::kDisconnecting ==
-              connecting->state_.load() &&
-          connecting->output_buffer_.GetReadableBytes() == 0 &&
-          connecting->pending_output_buffer_.GetReadableBytes() == 0) {
-        connecting->socketer_.ShutdownWrite();
-      }
-    }
+    connecting->ContinueWriting();
   } else {
     if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR) {
       connecting->SubmitWriteOnce();
+    } else if (err == ECANCELED && connecting->migration_target_ != nullptr) {
+      // Interrupted for migrating
     } else {
-      LOG_ERROR("OnWriteComplete error: fd(%d) res(%zd) err(%d)",
-                connecting->Fd(), res, err);
+      LOG_KV(logger::kError, "conn_write_error", "fd", connecting->Fd(),
+             "res", res, "err", err);
       connecting->DoWithError(err);
     }
   }
   delete ctx;
   op->context = nullptr;
+  if (connecting->migration_target_ != nullptr) {
+    connecting->ContinueMigrating();
+  }
+}
+
+void Connecting::OnSpliceComplete(struct io_uring_cqe* cqe,
+                                  Poller::IoUringOp* op) {
+  auto* ctx = static_cast<SpliceContext*>(op->context);
+  auto* connecting = ctx->self;
+  connecting->write_in_flight_ = false;
+  ssize_t res = cqe->res;
+  int err = res < 0 ? -res : 0;
+  LOG_DEBUG("Splice complete fd(%d) res(%zd) err(%d)", connecting->Fd(), res,
+            err);
+  if (connecting->file_regions_.empty()) {  // Given up already
+    delete ctx;
+    op->context = nullptr;
+    return;
+  }
+  FileRegion& file_region = *connecting->file_regions_.front();
+  if (res > 0) {
+    if (ctx->is_to_socket) {
+      connecting->AddTransferredBytes(static_cast<size_t>(res));
+      connecting->pipe_bytes_ -= static_cast<size_t>(res);
+      file_region.sent_bytes += static_cast<size_t>(res);
+      if (file_region.ProgressCallback) {
+        file_region.ProgressCallback(*connecting, file_region.sent_bytes,
+                                     file_region.total_bytes);
+      }
+    } else {
+      file_region.offset += static_cast<off_t>(res);
+      file_region.unread_bytes -= static_cast<size_t>(res);
+      connecting->pipe_bytes_ += static_cast<size_t>(res);
+    }
+    connecting->ContinueWriting();
+  } else if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR) {
+    if (ctx->is_to_socket && err != EINTR) {  // The socket is full
+      connecting->is_waiting_writable_ = true;
+      connecting->eventer_.EnableWriteEvents();
+    } else {
+      connecting->SubmitWriteOnce();
+    }
+  } else if (!ctx->is_to_socket && err == EINVAL) {
+    // This kind of file can not be spliced (the pipe is empty now)
+    file_region.should_use_sendfile = true;
+    connecting->SubmitWriteOnce();
+  } else if (!ctx->is_to_socket) {
+    err = res == 0 ? ENODATA : err;  // The file ends too early
+    LOG_ERROR("Fd(%d) fails to read the file fd(%d) err(%d)!!!",
+              connecting->Fd(), file_region.fd, err);
+    connecting->FailFileRegions(err);
+    // The peer can never get the rest of the output stream
+    connecting->ForceClose();
+  } else {
+    LOG_ERROR("OnSpliceComplete error: fd(%d) res(%zd) err(%d)",
+              connecting->Fd(), res, err);
+    connecting->FailFileRegions(err);
+    connecting->DoWithError(err);
+  }
+  delete ctx;
+  op->context = nullptr;
 }
 
 void Connecting::SubmitReadOnce() {
-  if (read_in_flight_) {
+  if (read_in_flight_ || migration_target_ != nullptr) {
+    return;
+  }
+  if (relay_ != nullptr) {
+    SubmitRelayReadOnce();
     return;
   }
   auto* ctx = new ReadContext();
   ctx->self = this;
-  ctx->writable = input_buffer_.GetWritableBytes();
-  ctx->iov[0].iov_base = const_cast<char*>(input_buffer_.GetWritablePosition());
-  ctx->iov[0].iov_len = ctx->writable;
-  ctx->iov[1].iov_base = ctx->extra_buffer;
-  ctx->iov[1].iov_len = sizeof(ctx->extra_buffer);
-  int iovcnt;
-  if (ctx->writable == 0) {
-    iovcnt = 1;
-    ctx->iov[0] = ctx->iov[1];
-  } else {
-    iovcnt = ctx->writable < sizeof(ctx->extra_buffer) ? 2 : 1;
-  }
   // ctx->key = next_io_key_++; // Deprecated: let Poller generate key
   // read_cancel_key_ = ctx->key; // Do not set yet
   read_in_flight_ = true;
@@ -233,8 +337,14 @@ void Connecting::SubmitReadOnce() {
   }
 #endif
   ctx->multishot = false;
+  // Read into the input buffer directly (its storage must stay untouched until
+  // the completion arrives)
+  input_buffer_.EnsureWritableSpace(read_size_hint_);
+  ctx->writable = input_buffer_.GetWritableBytes();
+  ctx->iov.iov_base = const_cast<char*>(input_buffer_.GetWritablePosition());
+  ctx->iov.iov_len = ctx->writable;
   uint64_t key = event_manager_->GetPoller()->SubmitRead(
-      &eventer_, ctx->iov.data(), iovcnt, &Connecting::OnReadComplete, ctx, 0,
+      &eventer_, &ctx->iov, 1, &Connecting::OnReadComplete, ctx, 0,
       [](void* ptr) { delete static_cast<ReadContext*>(ptr); });
   if (key == 0) {
     read_in_flight_ = false;
@@ -245,15 +355,52 @@ void Connecting::SubmitReadOnce() {
   ctx->key = key;
   read_cancel_key_ = key;
 }
+void Connecting::ContinueReading() {
+  auto* buffer_pool = event_manager_->GetBufferPool();
+  if (buffer_pool->ShouldReleaseIdleInput() &&
+      input_buffer_.GetReadableBytes() == 0) {
+    input_buffer_.ReleaseIfEmpty();
+    WaitForReadable();
+  } else {
+    input_buffer_.Trim(buffer_pool->GetMaxRetainedCapacity());
+    SubmitReadOnce();
+  }
+}
+void Connecting::WaitForReadable() {
+  if (!is_waiting_readable_ && !read_in_flight_ &&
+      migration_target_ == nullptr) {
+    is_waiting_readable_ = true;
+    eventer_.EnableReadEvents();
+  }
+}
 void Connecting::DoWriting() {
-  if (!write_in_flight_ && output_buffer_.GetReadableBytes() > 0) {
+  if (is_waiting_writable_) {
+    is_waiting_writable_ = false;
+    eventer_.DisableWriteEvents();
+    ContinueWriting();
+  } else if (!write_in_flight_ && output_buffer_.GetReadableBytes() > 0) {
     SubmitWriteOnce();
   }
 }
 void Connecting::SubmitWriteOnce() {
-  if (write_in_flight_ || output_buffer_.GetReadableBytes() == 0) {
+  if (write_in_flight_ || is_waiting_writable_ ||
+      migration_target_ != nullptr ||
+      ConnectionState::kDisconnected == state_.load()) {
     return;
   }
+  if (output_buffer_.GetReadableBytes() == 0) {
+    if (pending_output_buffer_.GetReadableBytes() == 0) {
+      if (!file_regions_.empty()) {
+        SubmitFileOnce();
+      } else if (relay_ != nullptr) {
+        SubmitRelayWriteOnce();
+      }
+      return;
+    }
+    output_buffer_.Swap(pending_output_buffer_);
+    // The drained storage is not needed until the next pending message
+    pending_output_buffer_.ReleaseIfEmpty();
+  }
   auto* ctx = new WriteContext();
   ctx->self = this;
   ctx->to_send = output_buffer_.GetReadableBytes();
@@ -274,19 +421,172 @@ void Connecting::SubmitWriteOnce() {
   ctx->key = key;
   write_cancel_key_ = key;
 }
+void Connecting::SubmitFileOnce() {
+  FileRegion& file_region = *file_regions_.front();
+  if (pipe_bytes_ == 0 && file_region.unread_bytes == 0) {
+    FinishFileRegion();
+    SubmitWriteOnce();
+    return;
+  }
+  auto* poller = event_manager_->GetPoller();
+  if (pipe_bytes_ == 0 && (file_region.should_use_sendfile ||
+                           !poller->SpliceSupported() || !OpenPipe())) {
+    SendFileDirectly();
+    return;
+  }
+  // Move the file into the pipe and then the pipe into the socket
+  auto* ctx = new SpliceContext();
+  ctx->self = this;
+  ctx->is_to_socket = pipe_bytes_ > 0;
+  write_in_flight_ = true;
+  uint64_t key = 0;
+  if (ctx->is_to_socket) {
+    key = poller->SubmitSplice(
+        &eventer_, pipe_fds_[0], -1, Fd(), -1,
+        static_cast<unsigned int>(pipe_bytes_), &Connecting::OnSpliceComplete,
+        ctx, 0, [](void* ptr) { delete static_cast<SpliceContext*>(ptr); });
+  } else {
+    key = poller->SubmitSplice(
+        &eventer_, file_region.fd, file_region.offset, pipe_fds_[1], -1,
+        static_cast<unsigned int>(
+            std::min(file_region.unread_bytes, kFileChunkSize)),
+        &Connecting::OnSpliceComplete, ctx, 0,
+        [](void* ptr) { delete static_cast<SpliceContext*>(ptr); });
+  }
+  if (key == 0) {
+    write_in_flight_ = false;
+    write_cancel_key_ = 0;
+    delete ctx;
+    return;
+  }
+  ctx->key = key;
+  write_cancel_key_ = key;
+}
+void Connecting::SendFileDirectly() {
+  FileRegion& file_region = *file_regions_.front();
+  while (file_region.unread_bytes > 0) {
+    ssize_t res =
+        ::sendfile(Fd(), file_region.fd, &file_region.offset,
+                   std::min(file_region.unread_bytes, kFileChunkSize));
+    if (res > 0) {
+      AddTransferredBytes(static_cast<size_t>(res));
+      file_region.unread_bytes -= static_cast<size_t>(res);
+      file_region.sent_bytes += static_cast<size_t>(res);
+      if (file_region.ProgressCallback) {
+        file_region.ProgressCallback(*this, file_region.sent_bytes,
+                                     file_region.total_bytes);
+        if (ConnectionState::kDisconnected == state_.load()) {
+          return;
+        }
+      }
+    } else if (res < 0 && errno == EINTR) {
+      continue;
+    } else if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Go on when the socket becomes writable
+      is_waiting_writable_ = true;
+      eventer_.EnableWriteEvents();
+      return;
+    } else if (res == 0) {  // The file ends too early
+      LOG_ERROR("Fd(%d) fails to read the file fd(%d) err(%d)!!!", Fd(),
+                file_region.fd, ENODATA);
+      FailFileRegions(ENODATA);
+      ForceClose();
+      return;
+    } else {
+      int err = errno;
+      LOG_ERROR("Fd(%d) fails to send the file fd(%d) err(%d)!!!", Fd(),
+                file_region.fd, err);
+      FailFileRegions(err);
+      DoWithError(err);
+      return;
+    }
+  }
+  FinishFileRegion();
+  SubmitWriteOnce();
+}
+void Connecting::FinishFileRegion() {
+  std::unique_ptr<FileRegion> file_region = std::move(file_regions_.front());
+  file_regions_.pop_front();
+  // Messages sent after the file region are the next ones to send (the output
+  // buffers are both empty now)
+  output_buffer_.Swap(file_region->trailing_buffer);
+  if (file_region->CompleteCallback) {
+    file_region->CompleteCallback(*this, 0);
+  }
+}
+void Connecting::FailFileRegions(int err) {
+  std::deque<std::unique_ptr<FileRegion>> file_regions;
+  file_regions.swap(file_regions_);
+  ClosePipe();
+  for (auto& file_region : file_regions) {
+    if (file_region->CompleteCallback) {
+      file_region->CompleteCallback(*this, err);
+    }
+  }
+}
+void Connecting::ContinueWriting() {
+  SubmitWriteOnce();
+  if (!write_in_flight_ && !is_waiting_writable_) {
+    OnOutputDrained();
+  }
+}
+void Connecting::OnOutputDrained() {
+  if (GetQueuedBytes() > 0 || !file_regions_.empty()) {
+    return;
+  }
+  // Hold no output storage (nor pipe) while there is nothing to send
+  output_buffer_.ReleaseIfEmpty();
+  ClosePipe();
+  if (relay_ != nullptr && relay_->peer != nullptr &&
+      !relay_->is_output_ended && relay_->peer->relay_->is_input_ended) {
+    // Everything before the half close of the peer has been relayed, so pass
+    // the half close on
+    relay_->is_output_ended = true;
+    socketer_.ShutdownWrite();
+    CheckRelayEnding();
+    return;
+  }
+  if (WriteCompleteCallback_) {
+    WriteCompleteCallback_(*this);
+  }
+  if (ConnectionState::kDisconnecting == state_.load() && !write_in_flight_ &&
+      GetQueuedBytes() == 0 && file_regions_.empty()) {
+    socketer_.ShutdownWrite();
+  }
+}
+bool Connecting::OpenPipe() {
+  if (pipe_fds_[0] >= 0) {
+    return true;
+  }
+  if (OpenPipeFds(pipe_fds_) == 0) {
+    LOG_WARN("Fd(%d) fails to open a pipe, so use sendfile() instead!", Fd());
+    return false;
+  }
+  return true;
+}
+void Connecting::ClosePipe() {
+  ClosePipeFds(pipe_fds_);
+  pipe_bytes_ = 0;
+}
 void Connecting::DoClosing() {
   if (state_.load() != ConnectionState::kDisconnected) {
-    LOG_DEBUG("Fd(%d) with state(\"%s\") is closing.", Fd(),
-              GetConnectionStateInfo(state_).c_str());
+    LOG_KV(logger::kDebug, "conn_close", "fd", Fd(), "state",
+           GetConnectionStateInfo(state_));
     SetState(ConnectionState::kDisconnected);
     StopReadingWriting();
     CancelPendingIo();
+    // File regions never sent are told before the connection is told gone
+    FailFileRegions(ECANCELED);
+    Connecting* relay_peer = StopRelaying();
     if (OnConnectionCallback_) {
       OnConnectionCallback_(*this);
     }
     if (CloseCallback_) {
       CloseCallback_(*this);
     }
+    if (relay_peer != nullptr) {  // A relaying pair lives and dies together
+      relay_peer->ForceClose();
+    }
     event_manager_->DeleteConnection(
         Fd());  // Postpone the real destroying to the end of this loop
   }
@@ -318,8 +618,8 @@ void Connecting::DoWithError(int err) const {
   if (err_str == nullptr || *err_str == '\0') {
     err_str = "unknown";
   }
-  LOG_ERROR("Fd(%d) gets an error -- errno(%d) -- %s!!!", Fd(), saved_errno,
-            err_str);
+  LOG_KV(logger::kError, "conn_error", "fd", Fd(), "err", saved_errno, "reason",
+         err_str);
 }
 
 void Connecting::OnEstablishing() {
@@ -327,7 +627,7 @@ void Connecting::OnEstablishing() {
       state_.load()) {  // This TCP connection can only be created once
     SetState(ConnectionState::kConnected);
     OnConnectionCallback_(*this);
-    SubmitReadOnce();
+    ContinueReading();
   }
 }
 
@@ -338,13 +638,14 @@ void Connecting::Send(const void* message, size_t msg_len) {
     return;
   }
   if (ConnectionState::kConnected == state_.load()) {
-    size_t queued_len = output_buffer_.GetReadableBytes() +
-                        pending_output_buffer_.GetReadableBytes();
+    size_t queued_len = GetQueuedBytes();
     if (HighWaterMarkCallback_ && queued_len + msg_len >= high_water_mark_ &&
         queued_len < high_water_mark_) {
       HighWaterMarkCallback_(*this, queued_len + msg_len);
     }
-    if (write_in_flight_) {
+    if (!file_regions_.empty()) {  // Keep the order with files
+      file_regions_.back()->trailing_buffer.Append(message, msg_len);
+    } else if (write_in_flight_) {
       pending_output_buffer_.Append(message, msg_len);
     } else {
       output_buffer_.Append(message, msg_len);
@@ -360,12 +661,49 @@ void Connecting::Send(IoBuffer* io_buffer) {
   io_buffer->RefreshRW();
 }
 
+void Connecting::SendFile(int fd, off_t offset, size_t len,
+                          const SendFileCompleteCallback& cb,
+                          const SendFileProgressCallback& progress_cb) {
+  if (ConnectionState::kConnected != state_.load()) {
+    LOG_ERROR("Fd(%d) is not connected, so give up sending the file!!!", Fd());
+    if (cb) {
+      cb(*this, ENOTCONN);
+    }
+    return;
+  }
+  size_t queued_len = GetQueuedBytes();
+  if (HighWaterMarkCallback_ && queued_len + len >= high_water_mark_ &&
+      queued_len < high_water_mark_) {
+    HighWaterMarkCallback_(*this, queued_len + len);
+  }
+  auto file_region = std::make_unique<FileRegion>(
+      fd, offset, len, event_manager_->GetBufferPool());
+  file_region->CompleteCallback = cb;
+  file_region->ProgressCallback = progress_cb;
+  file_regions_.push_back(std::move(file_region));
+  ContinueWriting();
+}
+
+size_t Connecting::GetQueuedBytes() const {
+  size_t queued_len = output_buffer_.GetReadableBytes() +
+                      pending_output_buffer_.GetReadableBytes() + pipe_bytes_;
+  for (const auto& file_region : file_regions_) {
+    queued_len += file_region->unread_bytes +
+                  file_region->trailing_buffer.GetReadableBytes();
+  }
+  if (relay_ != nullptr && relay_->peer != nullptr) {
+    queued_len += relay_->peer->relay_->pipe_bytes;
+  }
+  return queued_len;
+}
+
 void Connecting::ShutDownWrite() {
   if (ConnectionState::kConnected == state_.load()) {
     SetState(ConnectionState::kDisconnecting);
-    if (!eventer_
-             .HasWriteEvents()) {  // If the writing event is not paid attention
-                                   // to, shut down the writing end (this end)
+    // Shut down the writing end (this end) now if nothing is waiting to be
+    // sent, or after everything has been sent
+    if (!write_in_flight_ && !is_waiting_writable_ && GetQueuedBytes() == 0 &&
+        file_regions_.empty()) {
       socketer_.ShutdownWrite();
     }
   }
@@ -382,12 +720,101 @@ void Connecting::ForceClose() {
 // destroyed.
 void Connecting::ForceCloseAfter(int64_t delay_microseconds) {
   if (ConnectionState::kDisconnected != state_.load()) {
-    event_manager_->RunAfter(delay_microseconds,
-                             [this]() { this->ForceClose(); });
+    // The timer runs in this loop, so the connection must stay here till then
+    ++armed_close_timers_;
+    event_manager_->RunAfter(delay_microseconds, [this]() {
+      --this->armed_close_timers_;
+      this->ForceClose();
+    });
+  }
+}
+
+void Connecting::AddTransferredBytes(size_t bytes) {
+  transferred_bytes_ += bytes;
+  event_manager_->GetMutableLoopMetrics()->AddBytes(bytes);
+}
+size_t Connecting::SampleTransferredBytes() {
+  size_t bytes = transferred_bytes_ - sampled_bytes_;
+  sampled_bytes_ = transferred_bytes_;
+  return bytes;
+}
+
+bool Connecting::StartMigrating(EventManager* target) {
+  if (target == nullptr || target == event_manager_ || !is_migratable_ ||
+      migration_target_ != nullptr || relay_ != nullptr ||
+      !file_regions_.empty() || armed_close_timers_ > 0 || !IsConnected()) {
+    return false;
+  }
+  LOG_DEBUG("Fd(%d) begins migrating.", Fd());
+  migration_target_ = target;
+  if (is_waiting_readable_) {
+    is_waiting_readable_ = false;
+    eventer_.DisableReadEvents();
+  }
+  if (is_waiting_writable_) {
+    is_waiting_writable_ = false;
+    eventer_.DisableWriteEvents();
+  }
+  // Completions still come (and nothing is lost), but no new I/O is submitted
+  auto* poller = event_manager_->GetPoller();
+  if (read_in_flight_) {
+    poller->InterruptOp(read_cancel_key_);
+  }
+  if (write_in_flight_) {
+    poller->InterruptOp(write_cancel_key_);
   }
+  ContinueMigrating();
+  return true;
+}
+void Connecting::ContinueMigrating() {
+  if (read_in_flight_ || write_in_flight_) {
+    return;  // Go on after the last completion
+  }
+  // Hand over after the callback running now (which may still use this) has
+  // returned
+  EventManager* event_manager = event_manager_;
+  int fd = Fd();
+  event_manager->RunSoon(
+      [event_manager, fd]() { event_manager->HandOverConnection(fd); });
+}
+EventManager* Connecting::DetachForMigrating() {
+  EventManager* target = migration_target_;
+  if (target == nullptr || read_in_flight_ || write_in_flight_) {
+    return nullptr;
+  }
+  if (ConnectionState::kDisconnected == state_.load()) {
+    migration_target_ = nullptr;  // Closed meanwhile, just be destroyed here
+    return nullptr;
+  }
+  eventer_.DisableAllEvents();
+  eventer_.RemoveMyself();
+  // Storage from the pool of this loop must be given back in this thread
+  input_buffer_.Rebind(nullptr);
+  output_buffer_.Rebind(nullptr);
+  pending_output_buffer_.Rebind(nullptr);
+  return target;
+}
+void Connecting::FinishMigrating(EventManager* event_manager) {
+  event_manager_ = event_manager;
+  eventer_.JoinPoller(event_manager->GetPoller());
+  input_buffer_.Rebind(event_manager->GetBufferPool());
+  output_buffer_.Rebind(event_manager->GetBufferPool());
+  pending_output_buffer_.Rebind(event_manager->GetBufferPool());
+  migration_target_ = nullptr;
+  LOG_DEBUG("Fd(%d) ends migrating.", Fd());
+  SubmitReadOnce();
+  SubmitWriteOnce();
 }
 
 void Connecting::CancelPendingIo() {
+  if (is_waiting_readable_) {
+    is_waiting_readable_ = false;
+    eventer_.DisableReadEvents();
+  }
+  if (is_waiting_writable_) {
+    is_waiting_writable_ = false;
+    eventer_.DisableWriteEvents();
+  }
   if (read_in_flight_) {
     if (read_cancel_key_ != 0) {
       event_manager_->GetPoller()->CancelOp(read_cancel_key_);
@@ -404,6 +831,195 @@ void Connecting::CancelPendingIo() {
   }
 }
 
+bool Connecting::Relay(Connecting& a, Connecting& b) {
+  if (&a == &b || a.event_manager_ != b.event_manager_) {
+    LOG_ERROR("Fd(%d) and fd(%d) can not be relayed out of the same loop!!!",
+              a.Fd(), b.Fd());
+    return false;
+  }
+  if (!a.IsConnected() || !b.IsConnected() || a.relay_ != nullptr ||
+      b.relay_ != nullptr) {
+    return false;
+  }
+  if (!a.event_manager_->GetPoller()->SpliceSupported()) {
+    LOG_WARN("Splicing is unsupported, so fd(%d) and fd(%d) are not relayed!",
+             a.Fd(), b.Fd());
+    return false;
+  }
+  auto a_relay = std::make_unique<RelayState>();
+  auto b_relay = std::make_unique<RelayState>();
+  a_relay->pipe_capacity = OpenPipeFds(a_relay->pipe_fds);
+  b_relay->pipe_capacity = OpenPipeFds(b_relay->pipe_fds);
+  if (a_relay->pipe_capacity == 0 || b_relay->pipe_capacity == 0) {
+    LOG_WARN("Fail to open pipes for relaying fd(%d) and fd(%d)!", a.Fd(),
+             b.Fd());
+    ClosePipeFds(a_relay->pipe_fds);
+    ClosePipeFds(b_relay->pipe_fds);
+    return false;
+  }
+  a_relay->peer = &b;
+  b_relay->peer = &a;
+  a.relay_ = std::move(a_relay);
+  b.relay_ = std::move(b_relay);
+  LOG_DEBUG("Fd(%d) and fd(%d) begin relaying.", a.Fd(), b.Fd());
+  a.StartRelaying();
+  b.StartRelaying();
+  return true;
+}
+void Connecting::StartRelaying() {
+  // Messages which have been read are relayed by copying (a read in flight is
+  // handled in the same way when it completes)
+  if (input_buffer_.GetReadableBytes() > 0) {
+    relay_->peer->Send(&input_buffer_);
+  }
+  input_buffer_.ReleaseIfEmpty();
+  SubmitReadOnce();
+}
+void Connecting::SubmitRelayReadOnce() {
+  if (read_in_flight_ || is_waiting_readable_ || relay_->is_input_ended ||
+      relay_->pipe_bytes >= relay_->pipe_capacity ||
+      ConnectionState::kDisconnected == state_.load()) {
+    return;  // Reading goes on after the peer drains the pipe if it is full
+  }
+  if (input_buffer_.GetBufferCapacity() > 0) {
+    input_buffer_.ReleaseIfEmpty();
+  }
+  auto* ctx = new SpliceContext();
+  ctx->self = this;
+  read_in_flight_ = true;
+  uint64_t key = event_manager_->GetPoller()->SubmitSplice(
+      &eventer_, Fd(), -1, relay_->pipe_fds[1], -1,
+      static_cast<unsigned int>(relay_->pipe_capacity - relay_->pipe_bytes),
+      &Connecting::OnRelayReadComplete, ctx, 0,
+      [](void* ptr) { delete static_cast<SpliceContext*>(ptr); });
+  if (key == 0) {
+    read_in_flight_ = false;
+    read_cancel_key_ = 0;
+    delete ctx;
+    return;
+  }
+  ctx->key = key;
+  read_cancel_key_ = key;
+}
+void Connecting::SubmitRelayWriteOnce() {
+  Connecting* peer = relay_->peer;
+  if (peer == nullptr || peer->relay_->pipe_bytes == 0) {
+    return;
+  }
+  auto* ctx = new SpliceContext();
+  ctx->self = this;
+  ctx->is_to_socket = true;
+  write_in_flight_ = true;
+  uint64_t key = event_manager_->GetPoller()->SubmitSplice(
+      &eventer_, peer->relay_->pipe_fds[0], -1, Fd(), -1,
+      static_cast<unsigned int>(peer->relay_->pipe_bytes),
+      &Connecting::OnRelayWriteComplete, ctx, 0,
+      [](void* ptr) { delete static_cast<SpliceContext*>(ptr); });
+  if (key == 0) {
+    write_in_flight_ = false;
+    write_cancel_key_ = 0;
+    delete ctx;
+    return;
+  }
+  ctx->key = key;
+  write_cancel_key_ = key;
+}
+void Connecting::OnRelayReadComplete(struct io_uring_cqe* cqe,
+                                     Poller::IoUringOp* op) {
+  auto* ctx = static_cast<SpliceContext*>(op->context);
+  auto* connecting = ctx->self;
+  connecting->read_in_flight_ = false;
+  ssize_t res = cqe->res;
+  int err = res < 0 ? -res : 0;
+  LOG_DEBUG("Relay read complete fd(%d) res(%zd) err(%d)", connecting->Fd(),
+            res, err);
+  RelayState* relay = connecting->relay_.get();
+  if (relay == nullptr || relay->peer == nullptr) {  // Stopped already
+    delete ctx;
+    op->context = nullptr;
+    return;
+  }
+  if (res > 0) {
+    connecting->AddTransferredBytes(static_cast<size_t>(res));
+    relay->pipe_bytes += static_cast<size_t>(res);
+    relay->relayed_bytes += static_cast<size_t>(res);
+    relay->peer->SubmitWriteOnce();
+    connecting->SubmitRelayReadOnce();
+  } else if (res == 0) {  // The peer of the socket has sent FIN
+    relay->is_input_ended = true;
+    relay->peer->ContinueWriting();
+  } else if (err == EAGAIN || err == EWOULDBLOCK) {
+    connecting->WaitForReadable();
+  } else if (err == EINTR) {
+    connecting->SubmitRelayReadOnce();
+  } else {
+    if (err == ECONNRESET || err == ECONNABORTED || err == EPIPE) {
+      LOG_INFO("Peer closed/reset the relaying connection fd(%d) err(%d)",
+               connecting->Fd(), err);
+    } else {
+      LOG_ERROR("OnRelayReadComplete error: fd(%d) res(%zd) err(%d)",
+                connecting->Fd(), res, err);
+    }
+    connecting->ForceClose();
+  }
+  delete ctx;
+  op->context = nullptr;
+}
+void Connecting::OnRelayWriteComplete(struct io_uring_cqe* cqe,
+                                      Poller::IoUringOp* op) {
+  auto* ctx = static_cast<SpliceContext*>(op->context);
+  auto* connecting = ctx->self;
+  connecting->write_in_flight_ = false;
+  ssize_t res = cqe->res;
+  int err = res < 0 ? -res : 0;
+  LOG_DEBUG("Relay write complete fd(%d) res(%zd) err(%d)", connecting->Fd(),
+            res, err);
+  RelayState* relay = connecting->relay_.get();
+  if (relay == nullptr || relay->peer == nullptr) {  // Stopped already
+    delete ctx;
+    op->context = nullptr;
+    return;
+  }
+  if (res > 0) {
+    connecting->AddTransferredBytes(static_cast<size_t>(res));
+    Connecting* peer = relay->peer;
+    peer->relay_->pipe_bytes -= static_cast<size_t>(res);
+    // Reading of the peer stops while the pipe is full
+    peer->SubmitRelayReadOnce();
+    connecting->ContinueWriting();
+  } else if (err == EAGAIN || err == EWOULDBLOCK) {  // The socket is full
+    connecting->is_waiting_writable_ = true;
+    connecting->eventer_.EnableWriteEvents();
+  } else if (err == EINTR) {
+    connecting->SubmitWriteOnce();
+  } else {
+    LOG_ERROR("OnRelayWriteComplete error: fd(%d) res(%zd) err(%d)",
+              connecting->Fd(), res, err);
+    connecting->ForceClose();
+  }
+  delete ctx;
+  op->context = nullptr;
+}
+void Connecting::CheckRelayEnding() {
+  if (relay_->is_output_ended && relay_->peer->relay_->is_output_ended) {
+    LOG_DEBUG("Fd(%d) and fd(%d) end relaying.", Fd(), relay_->peer->Fd());
+    ForceClose();
+  }
+}
+Connecting* Connecting::StopRelaying() {
+  if (relay_ == nullptr) {
+    return nullptr;
+  }
+  Connecting* peer = relay_->peer;
+  if (peer != nullptr) {
+    peer->relay_->peer = nullptr;
+  }
+  // Splicing in flight keeps its own references to the pipe
+  ClosePipeFds(relay_->pipe_fds);
+  relay_.reset();
+  return peer;
+}
+
 std::string Connecting::GetConnectionStateInfo(ConnectionState state) {
   switch (state) {
     case ConnectionState::kDisconnected:
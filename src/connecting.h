@@ -12,14 +12,16 @@
 #define TAOTU_SRC_CONNECTING_H_
 
 #include <stddef.h>
+#include <sys/types.h>
 
-#include <any>
-#include <array>
 #include <atomic>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <string>
 #include <utility>
 
+#include "connection_context.h"
 #include "eventer.h"
 #include "io_buffer.h"
 #include "net_address.h"
@@ -48,6 +50,11 @@ class Connecting : NonCopyableMovable {
   typedef std::function<void(Connecting&, IoBuffer*, TimePoint)>
       OnMessageCallback;
   typedef std::function<void(Connecting&, size_t)> HighWaterMarkCallback;
+  // Arguments: sent bytes and total bytes of the file region
+  typedef std::function<void(Connecting&, size_t, size_t)>
+      SendFileProgressCallback;
+  // Argument: error number (0 means the file region is completely sent)
+  typedef std::function<void(Connecting&, int)> SendFileCompleteCallback;
 
   Connecting(EventManager* event_manager, int socket_fd,
              const NetAddress& local_address, const NetAddress& peer_address);
@@ -60,12 +67,21 @@ class Connecting : NonCopyableMovable {
 
   EventManager& GetEventManager() { return *event_manager_; }
 
+  // Bind an object of "T" to this connection (replacing the former one)
   template <class T, class... Args>
-  void SetContext(Args... args) {
-    context_ = std::make_any<T>(args...);
+  T& SetContext(Args&&... args) {
+    return context_.Emplace<T>(std::forward<Args>(args)...);
   }
-  const std::any& GetConstContext() const { return context_; }
-  std::any& GetMutableContext() { return context_; }
+  // Get the object bound if it is of "T" (nullptr if not)
+  template <class T>
+  T* GetContext() {
+    return context_.Get<T>();
+  }
+  template <class T>
+  const T* GetContext() const {
+    return context_.Get<T>();
+  }
+  void ResetContext() { context_.Reset(); }
 
   void RegisterOnConnectionCallback(const NormalCallback& cb) {
     OnConnectionCallback_ = cb;
@@ -117,6 +133,63 @@ class Connecting : NonCopyableMovable {
   // Send the message (asynchronously at most time)
   void Send(IoBuffer* io_buffer);
 
+  // Send "len" bytes of the file from "offset" in order with the messages
+  // sent before and after, without copying them to user space. The file
+  // descriptor is not owned and must stay open until "cb" is called (with 0,
+  // or an error number like "ECANCELED" if it is closed before all are sent,
+  // in which case "cb" is called before the connection callback)
+  void SendFile(int fd, off_t offset, size_t len,
+                const SendFileCompleteCallback& cb = SendFileCompleteCallback{},
+                const SendFileProgressCallback& progress_cb =
+                    SendFileProgressCallback{});
+
+  // Bytes queued for sending (including the unsent parts of files)
+  size_t GetQueuedBytes() const;
+
+  // Relay the two connections (of the same "EventManager", called in its
+  // thread) to each other in the kernel by splicing each direction through a
+  // pipe. Messages left in the input buffers are relayed first, no message
+  // callback is called after that, and the end of each direction is passed on
+  // as a half close. Both are closed once both directions end or either one
+  // fails. Return false if relaying is unavailable (the caller may relay the
+  // messages by itself then)
+  static bool Relay(Connecting& a, Connecting& b);
+
+  bool IsRelaying() const { return relay_ != nullptr; }
+
+  // Bytes of the input relayed to the peer
+  size_t GetRelayedBytes() const {
+    return relay_ != nullptr ? relay_->relayed_bytes : 0;
+  }
+
+  // Move this connection into another loop (called in the thread of its own
+  // loop). In-flight reading and writing are interrupted, and once their
+  // completions have arrived, the connection (with its buffers, callbacks and
+  // context) is handed over and resumed there. Return false if it can not be
+  // moved now (not migratable, relaying, sending files, being moved or waiting
+  // for a delayed closing)
+  bool StartMigrating(EventManager* target);
+
+  // Only called by "EventManager"s: leave the current loop (returning the
+  // target, or nullptr if it should not move now), and join the target one
+  EventManager* DetachForMigrating();
+  void FinishMigrating(EventManager* event_manager);
+
+  bool IsMigrating() const { return migration_target_ != nullptr; }
+
+  // Whether this connection may be moved into another loop (only the ones
+  // accepted by "Server" may by default)
+  void SetMigratable(bool on) { is_migratable_ = on; }
+  bool IsMigratable() const { return is_migratable_; }
+
+  // Whether this connection was admitted by a server (rather than connected by
+  // a client sharing the loop), so it is counted out when destroyed
+  void SetAdmitted(bool on) { is_admitted_ = on; }
+  bool IsAdmitted() const { return is_admitted_; }
+
+  // Bytes read and written since the last call (for finding heavy connections)
+  size_t SampleTransferredBytes();
+
   // Shut down the writing end (close half == stop writing indeed)
   void ShutDownWrite();
 
@@ -134,19 +207,24 @@ class Connecting : NonCopyableMovable {
     ++pending_io_retries_;
   }
 
-  void SetTcpNoDelay(bool on) { socketer_.SetTcpNoDelay(on); }
+  void SetTcpNoDelay(bool on) {
+    if (!local_address_.IsUnix()) {  // Nothing to delay on Unix domain sockets
+      socketer_.SetTcpNoDelay(on);
+    }
+  }
 
   // Close this TCP connection directly (at the end of this loop)
   void ForceClose();
 
+  // Close it after the delay (in the current loop, so it won't migrate until
+  // then)
   void ForceCloseAfter(int64_t delay_microseconds);
 
  private:
   struct ReadContext {
     Connecting* self{nullptr};
-    std::array<struct iovec, 2> iov{};
+    struct iovec iov {};
     size_t writable{0};
-    char extra_buffer[64 * 1024];
     uint64_t key{0};
     bool multishot{false};
     uint16_t buf_id{0};
@@ -159,8 +237,90 @@ class Connecting : NonCopyableMovable {
     uint64_t key{0};
   };
 
+  // File region queued in the output stream
+  struct FileRegion {
+    FileRegion(int file_fd, off_t file_offset, size_t len,
+               BufferPool* buffer_pool)
+        : fd(file_fd),
+          offset(file_offset),
+          total_bytes(len),
+          unread_bytes(len),
+          sent_bytes(0),
+          should_use_sendfile(false),
+          trailing_buffer(buffer_pool) {}
+
+    int fd;
+    off_t offset;         // Next offset to read from the file
+    size_t total_bytes;
+    size_t unread_bytes;  // Bytes not read from the file yet
+    size_t sent_bytes;    // Bytes written into the socket
+    bool should_use_sendfile;
+    SendFileCompleteCallback CompleteCallback;
+    SendFileProgressCallback ProgressCallback;
+    // Messages sent after this file region
+    IoBuffer trailing_buffer;
+  };
+
+  // State of relaying the input of this connection to the peer
+  struct RelayState {
+    Connecting* peer{nullptr};
+    int pipe_fds[2]{-1, -1};
+    size_t pipe_capacity{0};
+    size_t pipe_bytes{0};  // Input bytes in the pipe
+    size_t relayed_bytes{0};
+    bool is_input_ended{false};   // The peer of the socket has sent FIN
+    bool is_output_ended{false};  // The writing end has been shut down
+  };
+
+  struct SpliceContext {
+    Connecting* self{nullptr};
+    bool is_to_socket{false};
+    uint64_t key{0};
+  };
+
   void SubmitReadOnce();
+  // Send the next part of the output stream (buffered messages or files)
   void SubmitWriteOnce();
+  // Send the next part of the file region at the front
+  void SubmitFileOnce();
+  // Send the file region at the front by "sendfile()" (if splicing is
+  // unavailable) until the socket is full
+  void SendFileDirectly();
+  // Pop the completed file region at the front
+  void FinishFileRegion();
+  // Give up all queued file regions with an error
+  void FailFileRegions(int err);
+  // Go on writing after a completed write has been handled
+  void ContinueWriting();
+  // Be called once everything queued has been sent
+  void OnOutputDrained();
+
+  // Count bytes read or written into the load of the loop
+  void AddTransferredBytes(size_t bytes);
+
+  // Hand this connection over to the target loop once nothing is in flight
+  void ContinueMigrating();
+  bool OpenPipe();
+  void ClosePipe();
+  static void OnSpliceComplete(struct io_uring_cqe* cqe,
+                               Poller::IoUringOp* op);
+  // Relay what has been read and go on splicing the input into the pipe
+  void StartRelaying();
+  void SubmitRelayReadOnce();
+  // Splice the input of the peer from its pipe into the socket
+  void SubmitRelayWriteOnce();
+  // Close both once both directions have ended
+  void CheckRelayEnding();
+  // Unlink the peer (returned) and close the pipe
+  Connecting* StopRelaying();
+  static void OnRelayReadComplete(struct io_uring_cqe* cqe,
+                                  Poller::IoUringOp* op);
+  static void OnRelayWriteComplete(struct io_uring_cqe* cqe,
+                                   Poller::IoUringOp* op);
+  // Go on reading after a completed read has been handled
+  void ContinueReading();
+  // Hold no input storage until the socket becomes readable
+  void WaitForReadable();
   static void OnReadComplete(struct io_uring_cqe* cqe, Poller::IoUringOp* op);
   static void OnWriteComplete(struct io_uring_cqe* cqe, Poller::IoUringOp* op);
   void CancelPendingIo();
@@ -227,8 +387,34 @@ class Connecting : NonCopyableMovable {
   // Connection state (atomic)
   std::atomic<ConnectionState> state_;
 
+  // File regions waiting to be sent (after the buffered messages)
+  std::deque<std::unique_ptr<FileRegion>> file_regions_;
+
+  // Pipe which file contents are spliced through (only opened while sending
+  // files)
+  int pipe_fds_[2];
+
+  // Bytes spliced into the pipe but not into the socket yet
+  size_t pipe_bytes_;
+
+  // Only exists while relaying
+  std::unique_ptr<RelayState> relay_;
+
+  // Bytes the next read asks for (grows when reads fill it up)
+  size_t read_size_hint_;
+
+  bool is_waiting_readable_{false};
+  bool is_waiting_writable_{false};
   bool read_in_flight_{false};
   bool write_in_flight_{false};
+  // Loop this connection is moving into
+  EventManager* migration_target_{nullptr};
+  bool is_migratable_{false};
+  // "ForceCloseAfter()" timers armed in the current loop, which pin it here
+  int armed_close_timers_{0};
+  bool is_admitted_{false};
+  size_t transferred_bytes_{0};
+  size_t sampled_bytes_{0};
   uint64_t next_io_key_{1};
   uint64_t read_cancel_key_{0};
   uint64_t write_cancel_key_{0};
@@ -236,7 +422,7 @@ class Connecting : NonCopyableMovable {
   int pending_io_retries_{0};
 
   // Context for any object bound
-  std::any context_;
+  ConnectionContext context_;
 };
 
 }  // namespace taotu
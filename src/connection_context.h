@@ -0,0 +1,109 @@
+/**
+ * @file connection_context.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration and implementation of class "ConnectionContext" which is
+ * a typed slot for per-connection user state.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_CONNECTION_CONTEXT_H_
+#define TAOTU_SRC_CONNECTION_CONTEXT_H_
+
+#include <stddef.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "non_copyable_movable.h"
+
+namespace taotu {
+
+/**
+ * @brief "ConnectionContext" holds one object of any type. Objects which are
+ * small enough (like a "std::shared_ptr" or a few counters) are constructed
+ * inside the slot itself, so no heap allocation is needed, and larger ones
+ * are allocated once when they are set. The stored type is tagged by the
+ * address of a per-type variable, so getting it back needs no RTTI.
+ *
+ */
+class ConnectionContext : NonCopyableMovable {
+ public:
+  static constexpr size_t kInlineSize = 64;
+
+  // Whether an object of "T" lives inside the slot
+  template <class T>
+  static constexpr bool IsStoredInline() {
+    return sizeof(T) <= kInlineSize &&
+           alignof(T) <= alignof(std::max_align_t) &&
+           std::is_nothrow_destructible_v<T>;
+  }
+
+  ConnectionContext() = default;
+  ~ConnectionContext() { Reset(); }
+
+  // Destroy the object held (if any) and construct a new one of "T"
+  template <class T, class... Args>
+  T& Emplace(Args&&... args) {
+    Reset();
+    T* object;
+    if constexpr (IsStoredInline<T>()) {
+      object = ::new (static_cast<void*>(storage_))
+          T(std::forward<Args>(args)...);
+    } else {
+      object = new T(std::forward<Args>(args)...);
+    }
+    object_ = object;
+    destroy_ = &Destroy<T>;
+    tag_ = &kTypeTag<T>;
+    return *object;
+  }
+
+  // Get the object held if it is of "T" (nullptr if not)
+  template <class T>
+  T* Get() {
+    return tag_ == &kTypeTag<T> ? static_cast<T*>(object_) : nullptr;
+  }
+  template <class T>
+  const T* Get() const {
+    return tag_ == &kTypeTag<T> ? static_cast<const T*>(object_) : nullptr;
+  }
+
+  bool HasValue() const { return object_ != nullptr; }
+
+  // Destroy the object held
+  void Reset() {
+    if (object_ != nullptr) {
+      void* object = object_;
+      object_ = nullptr;
+      tag_ = nullptr;
+      destroy_(object);
+    }
+  }
+
+ private:
+  template <class T>
+  static constexpr char kTypeTag = 0;
+
+  template <class T>
+  static void Destroy(void* object) {
+    if constexpr (IsStoredInline<T>()) {
+      static_cast<T*>(object)->~T();
+    } else {
+      delete static_cast<T*>(object);
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  void* object_{nullptr};
+  void (*destroy_)(void*){nullptr};
+  const void* tag_{nullptr};
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_CONNECTION_CONTEXT_H_
@@ -23,9 +23,13 @@
 
 #include "connecting.h"
 #include "logger.h"
+#include "socketer.h"
 #include "time_point.h"
 
 namespace taotu {
+
+USE_LOG_CATEGORY(logger::kConnectionLog);
+
 namespace {
 constexpr int kMaxRetryDelayMicroseconds = 30 * 1000 * 1000;
 constexpr int kInitRetryDelayMicroseconds = 500 * 1000;
@@ -88,12 +92,18 @@ Connector::Connector(EventManager* event_manager,
       server_address_(server_address),
       state_(ConnectState::kDisconnected),
       can_connect_(false),
-      retry_delay_microseconds_(static_cast<int>(kInitRetryDelayMicroseconds)) {
-}
+      retry_delay_microseconds_(static_cast<int>(kInitRetryDelayMicroseconds)),
+      alive_token_(std::make_shared<bool>(true)) {}
 
 void Connector::Start() {
   can_connect_ = true;
-  event_manager_->RunSoon([this]() { this->Connect(); });
+  std::weak_ptr<bool> alive_token = alive_token_;
+  event_manager_->RunSoon([this, alive_token]() {
+    // Not stopped (or destroyed) since
+    if (!alive_token.expired() && this->can_connect_) {
+      this->Connect();
+    }
+  });
 }
 void Connector::Restart() {
   SetState(ConnectState::kDisconnected);
@@ -123,7 +133,8 @@ void Connector::Stop() {
 void Connector::Connect() {
   int sock_fd =
       ::socket(server_address_.GetFamily(),
-               SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+               SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+               Socketer::GetStreamProtocol(server_address_));
   if (sock_fd < 0) {
     int saved_errno = errno;
     char errbuf[128]{};
@@ -183,8 +194,14 @@ void Connector::DoRetrying(int conn_fd) {
   SetState(ConnectState::kDisconnected);
   if (can_connect_) {
     LOG_DEBUG("Connector fd(%d) is retrying to connect.", conn_fd);
+    std::weak_ptr<bool> alive_token = alive_token_;
     event_manager_->RunAfter(retry_delay_microseconds_,
-                             [this]() { this->Start(); });
+                             [this, alive_token]() {
+                               if (!alive_token.expired() &&
+                                   this->can_connect_) {
+                                 this->Start();
+                               }
+                             });
     retry_delay_microseconds_ =
         std::min(retry_delay_microseconds_ * 2,
                  static_cast<int>(kMaxRetryDelayMicroseconds));
@@ -244,7 +261,7 @@ void Connector::DoWithError() {
     return;
   }
   LOG_ERROR("Connector fd(%d) has the error with the state(%d).",
-            eventer_->Fd(), state_);
+            eventer_->Fd(), static_cast<int>(state_));
   if (ConnectState::kConnecting == state_) {
     int conn_fd = RemoveAndReset();
     int error = GetSocketError(conn_fd);
@@ -13,6 +13,7 @@
 #define TAOTU_SRC_CONNECTOR_H_
 
 #include <functional>
+#include <memory>
 
 #include "connecting.h"
 #include "event_manager.h"
@@ -87,6 +88,10 @@ class Connector : NonCopyableMovable {
   NewConnectionCallback NewConnectionCallback_;
 
   EventerPtr eventer_;
+
+  // Expires with this connector, so its tasks left in the loop do nothing
+  // (it has to be destroyed in the loop thread)
+  std::shared_ptr<bool> alive_token_;
 };
 
 }  // namespace taotu
@@ -16,8 +16,10 @@
 #include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "connecting.h"
 #include "eventer.h"
@@ -27,6 +29,8 @@
 
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kPollerLog);
+
 EventManager::EventManager()
     : poller_(), thread_(), wake_up_eventer_(&poller_, []() -> int {
         int event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
@@ -101,13 +105,10 @@ Connecting* EventManager::InsertNewConnection(int socket_fd,
     }
     ref_conn = connection_map_[socket_fd].get();
   }
-  LOG_DEBUG(
-      "Create a new connection with fd(%d) between local net address "
-      "[ IP(%s), Port(%s) ] and peer net address [ IP(%s), Port(%s) ].",
-      socket_fd, local_address.GetIp().c_str(),
-      std::to_string(local_address.GetPort()).c_str(),
-      peer_address.GetIp().c_str(),
-      std::to_string(peer_address.GetPort()).c_str());
+  loop_metrics_.OnConnectionInserted();
+  LOG_KV(logger::kDebug, "conn_open", "fd", socket_fd, "local_ip",
+         local_address.GetIp(), "local_port", local_address.GetPort(),
+         "peer_ip", peer_address.GetIp(), "peer_port", peer_address.GetPort());
   return ref_conn;
 }
 
@@ -160,6 +161,89 @@ void EventManager::DeleteConnection(int fd) {
   closed_fds_.insert(fd);
 }
 
+bool EventManager::MigrateConnection(int fd, EventManager* target) {
+  Connecting* connection = nullptr;
+  {
+    LockGuard lock_guard(connection_map_mutex_lock_);
+    auto it = connection_map_.find(fd);
+    if (it != connection_map_.end()) {
+      connection = it->second.get();
+    }
+  }
+  return connection != nullptr && connection->StartMigrating(target);
+}
+bool EventManager::MigrateHeaviestConnection(EventManager* target) {
+  Connecting* heaviest_connection = nullptr;
+  size_t max_bytes = 0;
+  {
+    LockGuard lock_guard(connection_map_mutex_lock_);
+    for (const auto& it : connection_map_) {
+      if (!it.second || !it.second->IsMigratable()) {
+        continue;
+      }
+      size_t bytes = it.second->SampleTransferredBytes();
+      if (bytes > max_bytes) {
+        max_bytes = bytes;
+        heaviest_connection = it.second.get();
+      }
+    }
+  }
+  return heaviest_connection != nullptr &&
+         heaviest_connection->StartMigrating(target);
+}
+void EventManager::HandOverConnection(int fd) {
+  std::unique_ptr<Connecting> connection_ptr;
+  EventManager* target = nullptr;
+  {
+    LockGuard lock_guard(connection_map_mutex_lock_);
+    auto it = connection_map_.find(fd);
+    if (it == connection_map_.end() || !it->second) {
+      return;
+    }
+    target = it->second->DetachForMigrating();
+    if (target == nullptr) {
+      return;
+    }
+    connection_ptr = std::move(it->second);
+    connection_map_.erase(it);
+  }
+  loop_metrics_.OnConnectionRemoved();
+  // Owned by the task, so the connection is destroyed (and closed) if the task
+  // is dropped before it runs
+  auto connection_holder =
+      std::make_shared<std::unique_ptr<Connecting>>(std::move(connection_ptr));
+  target->RunSoon([target, connection_holder]() {
+    target->AdoptConnection(std::move(*connection_holder));
+  });
+}
+void EventManager::AdoptConnection(std::unique_ptr<Connecting> connection) {
+  Connecting* connecting = connection.get();
+  {
+    LockGuard lock_guard(connection_map_mutex_lock_);
+    connection_map_[connecting->Fd()] = std::move(connection);
+  }
+  loop_metrics_.OnConnectionInserted();
+  connecting->FinishMigrating(this);
+}
+
+void EventManager::ForEachConnection(
+    const std::function<void(Connecting&)>& visitor) {
+  std::vector<Connecting*> connections;
+  {
+    LockGuard lock_guard(connection_map_mutex_lock_);
+    connections.reserve(connection_map_.size());
+    for (const auto& it : connection_map_) {
+      if (it.second && it.second->IsConnected()) {
+        connections.push_back(it.second.get());
+      }
+    }
+  }
+  // The visitor may close the connection, which takes the lock too
+  for (auto* connection : connections) {
+    visitor(*connection);
+  }
+}
+
 void EventManager::WakeUp() {
   uint64_t msg = 1;
   ssize_t n = ::write(wake_up_eventer_.Fd(), reinterpret_cast<void*>(&msg),
@@ -168,7 +252,7 @@ void EventManager::WakeUp() {
     LOG_ERROR(
         "The wake_up_eventer in I/O thread(%lu) writes %llubytes instead of 8 "
         "bytes!!!",
-        ::pthread_self(), msg);
+        ::pthread_self(), static_cast<unsigned long long>(msg));
   }
 }
 
@@ -180,14 +264,24 @@ void EventManager::Quit() {
 void EventManager::Start() {
   should_quit_.store(false);
   LOG_DEBUG("The event loop in thread(%lu) is starting.", ::pthread_self());
+  // Wake up at least once a window, so the metrics of an idle loop decay
+  static constexpr int kMaxPollingMs =
+      static_cast<int>(LoopMetrics::kWindowMicroseconds / 1000);
   while (!should_quit_.load()) {
+    int timeout = timer_.GetMinTimeDuration();
+    if (timeout < 0 || timeout > kMaxPollingMs) {
+      timeout = kMaxPollingMs;
+    }
     auto return_time =
-        poller_.Poll(timer_.GetMinTimeDuration(),
-                     &active_events_);  // Return time is the time point of
-                                        // the end of this polling
+        poller_.Poll(timeout, &active_events_);  // Return time is the time
+                                                 // point of the end of this
+                                                 // polling
     DoWithActiveTasks(return_time);
     DoExpiredTimeTasks(return_time);
     DestroyClosedConnections();
+    int64_t now_us = TimePoint::FNow();
+    loop_metrics_.OnLoopIteration(now_us, now_us - poller_.GetLastWakeUpTime(),
+                                  poller_.GetLastCqeAmount());
   }
   LOG_DEBUG("The event loop in thread(%lu) is stopping.", ::pthread_self());
   std::vector<Connecting*> connections_to_close;
@@ -284,6 +378,7 @@ void EventManager::DestroyClosedConnections() {
         }
         connection_ptr = std::move(it->second);
         connection_map_.erase(it);
+        loop_metrics_.OnConnectionRemoved();
       }
     }
     if (connection_ptr) {
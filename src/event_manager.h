@@ -22,8 +22,10 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "buffer_pool.h"
 #include "connecting.h"
 #include "eventer.h"
+#include "loop_metrics.h"
 #include "net_address.h"
 #include "non_copyable_movable.h"
 #include "poller.h"
@@ -70,12 +72,18 @@ class EventManager : NonCopyableMovable {
 
   Poller* GetPoller() { return &poller_; }
 
+  // Pool of the storage of I/O buffers of connections in this loop
+  BufferPool* GetBufferPool() { return &buffer_pool_; }
+
   // For the Balancer to pick a EventManager with the lowest load
   uint32_t GetEventerAmount() const {
-    LockGuard lock_guard(connection_map_mutex_lock_);
-    return connection_map_.size();
+    return loop_metrics_.GetActiveConnections();
   }
 
+  // Load of this loop published by its own thread (readable from any thread)
+  const LoopMetrics& GetLoopMetrics() const { return loop_metrics_; }
+  LoopMetrics* GetMutableLoopMetrics() { return &loop_metrics_; }
+
   // Register a time task which should be done in a future time point
   void RunAt(const TimePoint& time_point, Timer::TimeCallback TimeTask);
   // Register a time task which should be done after a certain duration
@@ -92,6 +100,20 @@ class EventManager : NonCopyableMovable {
   // Delete the specific connection of this loop
   void DeleteConnection(int fd);
 
+  // Move the specific connection of this loop into another one (called in
+  // this thread), return false if it can not be moved now
+  bool MigrateConnection(int fd, EventManager* target);
+
+  // Move the connection which has transferred the most bytes since the last
+  // call into another one (called in this thread)
+  bool MigrateHeaviestConnection(EventManager* target);
+
+  // Give the migrating connection to its target loop once it has stopped
+  void HandOverConnection(int fd);
+
+  // Visit every connection of this loop (called in this thread)
+  void ForEachConnection(const std::function<void(Connecting&)>& visitor);
+
   // Wake up this I/O thread
   void WakeUp();
 
@@ -113,9 +135,18 @@ class EventManager : NonCopyableMovable {
   // Destroy connections which should be destroyed
   void DestroyClosedConnections();
 
+  // Take in a connection moved from another loop
+  void AdoptConnection(std::unique_ptr<Connecting> connection);
+
+  // Block pool of I/O buffers (outlives everything using it)
+  BufferPool buffer_pool_;
+
   // I/O multiplexing manager
   Poller poller_;
 
+  // Load of this loop
+  LoopMetrics loop_metrics_;
+
   // All connections in this loop (also within this thread) (Mapping: file
   // descriptor -> connection class pointer)
   ConnectionMap connection_map_;
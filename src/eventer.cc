@@ -21,6 +21,8 @@
 
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kPollerLog);
+
 Eventer::Eventer(Poller* poller, int fd)
     : poller_(poller),
       fd_(fd),
@@ -110,6 +112,12 @@ void Eventer::RemoveMyself() {
   }
 }
 
+void Eventer::JoinPoller(Poller* poller) {
+  poller_ = poller;
+  out_events_ = kNoEvent;
+  poller_->AddEventer(this);
+}
+
 void Eventer::OnReadDone(const ReadResult& res, TimePoint tp) {
   if (res.bytes > 0) {
     if (ReadCallback_) {
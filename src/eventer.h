@@ -89,6 +89,10 @@ class Eventer : NonCopyableMovable {
 
   void RemoveMyself();
 
+  // Join another poller after RemoveMyself() (called in the thread of the new
+  // poller, with nothing of this in flight)
+  void JoinPoller(Poller* poller);
+
  private:
   void UpdateEvents();
 
@@ -0,0 +1,165 @@
+/**
+ * @file hdr_histogram.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "HdrHistogram" which records values (like
+ * latencies) with a fixed relative precision over a wide range.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "hdr_histogram.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace taotu {
+
+HdrHistogram::HdrHistogram(int64_t highest_trackable_value,
+                           int significant_figures)
+    : highest_trackable_value_(std::max<int64_t>(highest_trackable_value, 2)),
+      total_count_(0),
+      min_(INT64_MAX),
+      max_(0) {
+  significant_figures = std::min(std::max(significant_figures, 1), 5);
+
+  // Values below it are counted one by one
+  int64_t largest_value_with_single_unit_resolution = 2;
+  for (int i = 0; i < significant_figures; ++i) {
+    largest_value_with_single_unit_resolution *= 10;
+  }
+  int sub_bucket_count_magnitude = static_cast<int>(
+      ::ceil(::log2(static_cast<double>(
+          largest_value_with_single_unit_resolution))));
+  sub_bucket_half_count_magnitude_ =
+      std::max(sub_bucket_count_magnitude, 1) - 1;
+  int64_t sub_bucket_count = INT64_C(1)
+                             << (sub_bucket_half_count_magnitude_ + 1);
+  sub_bucket_half_count_ = sub_bucket_count / 2;
+  sub_bucket_mask_ = sub_bucket_count - 1;
+
+  // Each bucket doubles the range of the former one
+  int64_t smallest_untrackable_value = sub_bucket_count;
+  size_t bucket_count = 1;
+  while (smallest_untrackable_value <= highest_trackable_value_) {
+    if (smallest_untrackable_value > INT64_MAX / 2) {
+      ++bucket_count;
+      break;
+    }
+    smallest_untrackable_value <<= 1;
+    ++bucket_count;
+  }
+  counts_.assign(
+      (bucket_count + 1) * static_cast<size_t>(sub_bucket_half_count_), 0);
+}
+
+void HdrHistogram::RecordN(int64_t value, int64_t count) {
+  value = std::min(std::max<int64_t>(value, 0), highest_trackable_value_);
+  counts_[GetCountsIndex(value)] += count;
+  total_count_ += count;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+void HdrHistogram::Merge(const HdrHistogram& other) {
+  if (other.counts_.size() != counts_.size()) {
+    // Settings differ, so go value by value
+    size_t counts_length = other.counts_.size();
+    for (size_t i = 0; i < counts_length; ++i) {
+      if (other.counts_[i] > 0) {
+        RecordN(other.GetValueFromIndex(i), other.counts_[i]);
+      }
+    }
+    return;
+  }
+  size_t counts_length = counts_.size();
+  for (size_t i = 0; i < counts_length; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  if (other.total_count_ > 0) {
+    total_count_ += other.total_count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+}
+
+void HdrHistogram::Reset() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  total_count_ = 0;
+  min_ = INT64_MAX;
+  max_ = 0;
+}
+
+double HdrHistogram::GetMean() const {
+  if (0 == total_count_) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  size_t counts_length = counts_.size();
+  for (size_t i = 0; i < counts_length; ++i) {
+    if (counts_[i] > 0) {
+      // Take the middle of the equivalent range
+      int64_t value = GetValueFromIndex(i);
+      double median = (static_cast<double>(value) +
+                       static_cast<double>(GetHighestEquivalentValue(value))) /
+                      2;
+      sum += median * static_cast<double>(counts_[i]);
+    }
+  }
+  return sum / static_cast<double>(total_count_);
+}
+
+int64_t HdrHistogram::GetValueAtPercentile(double percentile) const {
+  if (0 == total_count_) {
+    return 0;
+  }
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  auto count_at_percentile = static_cast<int64_t>(
+      percentile / 100 * static_cast<double>(total_count_) + 0.5);
+  count_at_percentile = std::max<int64_t>(count_at_percentile, 1);
+  int64_t total = 0;
+  size_t counts_length = counts_.size();
+  for (size_t i = 0; i < counts_length; ++i) {
+    total += counts_[i];
+    if (total >= count_at_percentile) {
+      return std::min(GetHighestEquivalentValue(GetValueFromIndex(i)), max_);
+    }
+  }
+  return max_;
+}
+
+size_t HdrHistogram::GetCountsIndex(int64_t value) const {
+  int bucket_index =
+      (64 - __builtin_clzll(static_cast<uint64_t>(value | sub_bucket_mask_))) -
+      (sub_bucket_half_count_magnitude_ + 1);
+  int64_t sub_bucket_index = value >> bucket_index;
+  return static_cast<size_t>(
+      (static_cast<int64_t>(bucket_index + 1)
+       << sub_bucket_half_count_magnitude_) +
+      (sub_bucket_index - sub_bucket_half_count_));
+}
+
+int64_t HdrHistogram::GetValueFromIndex(size_t index) const {
+  auto signed_index = static_cast<int64_t>(index);
+  int64_t bucket_index =
+      (signed_index >> sub_bucket_half_count_magnitude_) - 1;
+  int64_t sub_bucket_index =
+      (signed_index & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+  if (bucket_index < 0) {
+    sub_bucket_index -= sub_bucket_half_count_;
+    bucket_index = 0;
+  }
+  return sub_bucket_index << bucket_index;
+}
+
+int64_t HdrHistogram::GetHighestEquivalentValue(int64_t value) const {
+  int bucket_index =
+      (64 - __builtin_clzll(static_cast<uint64_t>(value | sub_bucket_mask_))) -
+      (sub_bucket_half_count_magnitude_ + 1);
+  int64_t lowest_equivalent_value = (value >> bucket_index) << bucket_index;
+  return lowest_equivalent_value + (INT64_C(1) << bucket_index) - 1;
+}
+
+}  // namespace taotu
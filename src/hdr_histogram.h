@@ -0,0 +1,73 @@
+/**
+ * @file hdr_histogram.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "HdrHistogram" which records values (like
+ * latencies) with a fixed relative precision over a wide range.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_HDR_HISTOGRAM_H_
+#define TAOTU_SRC_HDR_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace taotu {
+
+/**
+ * @brief "HdrHistogram" is a High Dynamic Range histogram: values in
+ * [0, highest trackable value] are counted in buckets whose width grows with
+ * the value, so any value is kept with "significant_figures" decimal digits.
+ * Recording is O(1) without allocating, and histograms of the same settings
+ * can be merged. It is not thread-safe.
+ *
+ */
+class HdrHistogram {
+ public:
+  // 1 hour in nanoseconds with 3 significant figures by default
+  explicit HdrHistogram(
+      int64_t highest_trackable_value = 3600LL * 1000 * 1000 * 1000,
+      int significant_figures = 3);
+
+  // Values out of range are clamped into it
+  void Record(int64_t value) { RecordN(value, 1); }
+  void RecordN(int64_t value, int64_t count);
+
+  // Add all values of the other one (of the same settings)
+  void Merge(const HdrHistogram& other);
+
+  void Reset();
+
+  int64_t GetTotalCount() const { return total_count_; }
+  int64_t GetMin() const { return 0 == total_count_ ? 0 : min_; }
+  int64_t GetMax() const { return max_; }
+  double GetMean() const;
+
+  // The value which "percentile" (in [0, 100]) of all values are not above
+  // (as the highest value equivalent to it)
+  int64_t GetValueAtPercentile(double percentile) const;
+
+ private:
+  size_t GetCountsIndex(int64_t value) const;
+  int64_t GetValueFromIndex(size_t index) const;
+  int64_t GetHighestEquivalentValue(int64_t value) const;
+
+  int64_t highest_trackable_value_;
+  int sub_bucket_half_count_magnitude_;
+  int64_t sub_bucket_half_count_;
+  int64_t sub_bucket_mask_;
+
+  std::vector<int64_t> counts_;
+  int64_t total_count_;
+  int64_t min_;
+  int64_t max_;
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_HDR_HISTOGRAM_H_
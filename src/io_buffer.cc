@@ -22,43 +22,115 @@
 
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kConnectionLog);
+
 namespace {
-constexpr char kCrlf[] = "\r\n";
+// Search [begin + *scanned_bytes, end) and record how far it has gone when
+// nothing is found (keeping the last "pattern_len - 1" bytes, which may be the
+// beginning of a pattern split by the end)
+template <typename Finder>
+const char* ResumeFinding(const char* begin, const char* end,
+                          size_t pattern_len, size_t* scanned_bytes,
+                          Finder Find) {
+  size_t readable_bytes = end - begin;
+  size_t start = *scanned_bytes < readable_bytes ? *scanned_bytes
+                                                 : readable_bytes;
+  const char* position = Find(begin + start, end);
+  if (position != nullptr) {
+    *scanned_bytes = 0;
+  } else if (readable_bytes >= pattern_len) {
+    *scanned_bytes = readable_bytes - pattern_len + 1;
+  }
+  return position;
+}
 }  // namespace
 
 IoBuffer::IoBuffer(size_t initial_capacity)
-    : buffer_(kReservedCapacity + initial_capacity),
+    : buffer_(nullptr),
+      buffer_size_(0),
       reading_index_(kReservedCapacity),
-      writing_index_(kReservedCapacity) {}
+      writing_index_(kReservedCapacity),
+      buffer_pool_(nullptr) {
+  buffer_ = AllocateStorage(kReservedCapacity + initial_capacity, &buffer_size_);
+}
+IoBuffer::IoBuffer(BufferPool* buffer_pool, size_t initial_capacity)
+    : buffer_(nullptr),
+      buffer_size_(0),
+      reading_index_(0),
+      writing_index_(0),
+      buffer_pool_(buffer_pool) {
+  if (initial_capacity > 0) {
+    ReserveWritableSpace(initial_capacity);
+  }
+}
+IoBuffer::~IoBuffer() { FreeStorage(); }
 
 void IoBuffer::Swap(IoBuffer& io_buffer) {
-  buffer_.swap(io_buffer.buffer_);
+  std::swap(buffer_, io_buffer.buffer_);
+  std::swap(buffer_size_, io_buffer.buffer_size_);
   std::swap(reading_index_, io_buffer.reading_index_);
   std::swap(writing_index_, io_buffer.writing_index_);
+  std::swap(buffer_pool_, io_buffer.buffer_pool_);
 }
 
 const char* IoBuffer::FindCrlf() const {
-  return static_cast<const char*>(::memmem(GetReadablePosition(),
-                                           GetReadableBytes(), kCrlf,
-                                           static_cast<size_t>(2)));
+  return byte_scanner::FindCrlf(GetReadablePosition(), GetWritablePosition());
 }
-
 const char* IoBuffer::FindCrlf(const char* start_position) const {
-  return static_cast<const char*>(
-      ::memmem(start_position, GetWritablePosition() - start_position, kCrlf,
-               static_cast<size_t>(2)));
+  return byte_scanner::FindCrlf(start_position, GetWritablePosition());
+}
+const char* IoBuffer::FindCrlfFrom(size_t* scanned_bytes) const {
+  return ResumeFinding(GetReadablePosition(), GetWritablePosition(), 2,
+                       scanned_bytes, byte_scanner::FindCrlf);
+}
+
+const char* IoBuffer::FindDoubleCrlf() const {
+  return byte_scanner::FindDoubleCrlf(GetReadablePosition(),
+                                      GetWritablePosition());
+}
+const char* IoBuffer::FindDoubleCrlf(const char* start_position) const {
+  return byte_scanner::FindDoubleCrlf(start_position, GetWritablePosition());
+}
+const char* IoBuffer::FindDoubleCrlfFrom(size_t* scanned_bytes) const {
+  return ResumeFinding(GetReadablePosition(), GetWritablePosition(), 4,
+                       scanned_bytes, byte_scanner::FindDoubleCrlf);
 }
 
+// "memchr()" of the C library is already vectorized, so keep using it
 const char* IoBuffer::FindEof() const {
-  return static_cast<const char*>(
-      ::memchr(GetReadablePosition(), '\n', GetReadableBytes()));
+  return FindEof(GetReadablePosition());
 }
 const char* IoBuffer::FindEof(const char* start_position) const {
-  return static_cast<const char*>(
-      ::memchr(start_position, '\n', GetWritablePosition() - start_position));
+  size_t len = GetWritablePosition() - start_position;
+  if (len == 0) {
+    return nullptr;
+  }
+  return static_cast<const char*>(::memchr(start_position, '\n', len));
+}
+const char* IoBuffer::FindEofFrom(size_t* scanned_bytes) const {
+  return ResumeFinding(GetReadablePosition(), GetWritablePosition(), 1,
+                       scanned_bytes, [this](const char* begin, const char*) {
+                         return FindEof(begin);
+                       });
+}
+
+const char* IoBuffer::FindAnyOf(const ByteSet& byte_set) const {
+  return byte_scanner::FindAnyOf(GetReadablePosition(), GetWritablePosition(),
+                                 byte_set);
+}
+const char* IoBuffer::FindAnyOfFrom(const ByteSet& byte_set,
+                                    size_t* scanned_bytes) const {
+  return ResumeFinding(GetReadablePosition(), GetWritablePosition(), 1,
+                       scanned_bytes,
+                       [&byte_set](const char* begin, const char* end) {
+                         return byte_scanner::FindAnyOf(begin, end, byte_set);
+                       });
 }
 
 void IoBuffer::RefreshRW() {
+  if (buffer_ == nullptr) {  // No storage is held now
+    return;
+  }
   reading_index_ = kReservedCapacity;
   writing_index_ = kReservedCapacity;
 }
@@ -221,14 +293,54 @@ void IoBuffer::ShrinkWritableSpace(size_t len) {
   // We do not use the member function of vector<> -- shrink_to_fit() because it
   // is a non-binding request
   if (len <= 32) {  // Reserving too little writable space is meaningless
-    LOG_WARN("Shrinking buffer to %ubytes failed!", len);
+    LOG_WARN("Shrinking buffer to %zubytes failed!", len);
+    return;
+  }
+  Reallocate(kReservedCapacity + GetReadableBytes() + len);
+}
+
+void IoBuffer::ReleaseIfEmpty() {
+  if (buffer_ != nullptr && GetReadableBytes() == 0) {
+    FreeStorage();
+  }
+}
+
+void IoBuffer::Rebind(BufferPool* buffer_pool) {
+  if (buffer_pool == buffer_pool_) {
+    return;
+  }
+  size_t readable_bytes = GetReadableBytes();
+  char* new_buffer = nullptr;
+  size_t new_buffer_size = 0;
+  if (buffer_ != nullptr && readable_bytes > 0) {
+    BufferPool* old_buffer_pool = buffer_pool_;
+    buffer_pool_ = buffer_pool;
+    new_buffer =
+        AllocateStorage(kReservedCapacity + readable_bytes, &new_buffer_size);
+    buffer_pool_ = old_buffer_pool;
+    ::memcpy(static_cast<void*>(new_buffer + kReservedCapacity),
+             static_cast<const void*>(GetReadablePosition()), readable_bytes);
+  }
+  FreeStorage();
+  buffer_pool_ = buffer_pool;
+  if (new_buffer != nullptr) {
+    buffer_ = new_buffer;
+    buffer_size_ = new_buffer_size;
+    reading_index_ = kReservedCapacity;
+    writing_index_ = kReservedCapacity + readable_bytes;
+  }
+}
+
+void IoBuffer::Trim(size_t max_retained_capacity) {
+  if (buffer_ == nullptr) {
     return;
   }
-  IoBuffer buffer;
-  buffer.EnsureWritableSpace(kReservedCapacity + GetReadableBytes() + len);
-  buffer.Append(static_cast<const void*>(GetReadablePosition()),
-                GetReadableBytes());
-  Swap(buffer);
+  if (GetReadableBytes() == 0) {
+    FreeStorage();
+  } else if (buffer_size_ > max_retained_capacity &&
+             kReservedCapacity + GetReadableBytes() < max_retained_capacity) {
+    Reallocate(kReservedCapacity + GetReadableBytes());
+  }
 }
 
 ssize_t IoBuffer::ReadFromFd(int fd, int* tmp_errno) {
@@ -264,7 +376,7 @@ ssize_t IoBuffer::ReadFromFd(int fd, int* tmp_errno) {
   } else if (static_cast<size_t>(n) <= static_cast<size_t>(writable_bytes)) {
     writing_index_ += n;
   } else {
-    writing_index_ = buffer_.size();
+    writing_index_ = buffer_size_;
     Append(static_cast<const void*>(extra_buffer),
            static_cast<size_t>(n - writable_bytes));
   }
@@ -295,8 +407,15 @@ ssize_t IoBuffer::WriteToFd(int fd) {
 }
 
 void IoBuffer::ReserveWritableSpace(size_t len) {
-  if (GetWritableBytes() + GetReservedBytes() - kReservedCapacity < len) {
-    buffer_.resize(writing_index_ + len);
+  if (buffer_ == nullptr) {  // Take the storage only when it is needed
+    buffer_ = AllocateStorage(kReservedCapacity + len, &buffer_size_);
+    reading_index_ = kReservedCapacity;
+    writing_index_ = kReservedCapacity;
+  } else if (GetWritableBytes() + GetReservedBytes() - kReservedCapacity <
+             len) {
+    // Grow geometrically like what "std::vector<>" does
+    size_t size = kReservedCapacity + GetReadableBytes() + len;
+    Reallocate(size > buffer_size_ * 2 ? size : buffer_size_ * 2);
   } else {
     // Move forward to-read contents if too much space are reserved in the
     // front of the buffer, and then the writable space will be enough without
@@ -310,4 +429,41 @@ void IoBuffer::ReserveWritableSpace(size_t len) {
   }
 }
 
+void IoBuffer::Reallocate(size_t size) {
+  size_t readable_bytes = GetReadableBytes();
+  size_t new_buffer_size = 0;
+  char* new_buffer = AllocateStorage(size, &new_buffer_size);
+  if (readable_bytes > 0) {
+    ::memcpy(static_cast<void*>(new_buffer + kReservedCapacity),
+             static_cast<const void*>(GetReadablePosition()), readable_bytes);
+  }
+  FreeStorage();
+  buffer_ = new_buffer;
+  buffer_size_ = new_buffer_size;
+  reading_index_ = kReservedCapacity;
+  writing_index_ = kReservedCapacity + readable_bytes;
+}
+
+char* IoBuffer::AllocateStorage(size_t size, size_t* real_size) {
+  if (buffer_pool_ != nullptr) {
+    return buffer_pool_->Allocate(size, real_size);
+  }
+  *real_size = size;
+  return static_cast<char*>(::malloc(size));
+}
+void IoBuffer::FreeStorage() {
+  if (buffer_ == nullptr) {
+    return;
+  }
+  if (buffer_pool_ != nullptr) {
+    buffer_pool_->Deallocate(buffer_, buffer_size_);
+  } else {
+    ::free(static_cast<void*>(buffer_));
+  }
+  buffer_ = nullptr;
+  buffer_size_ = 0;
+  reading_index_ = 0;
+  writing_index_ = 0;
+}
+
 }  // namespace taotu
@@ -29,7 +29,10 @@
 #include <string>
 #include <vector>
 
+#include "buffer_pool.h"
+#include "byte_scanner.h"
 #include "logger.h"
+#include "non_copyable_movable.h"
 
 namespace taotu {
 
@@ -44,23 +47,30 @@ namespace taotu {
  * I/O buffer. It records the reading and writing indexes and always reserves
  * more than 8 bytes in the front of the buffer as an optional message header.
  * For Coping with large traffic, it provides a solution using discrete reading.
+ * If a "BufferPool" is given, the storage is taken from the pool only when
+ * something is going to be written, and it can be given back as soon as the
+ * buffer is drained (the header space is unavailable before that).
  *
  */
-class IoBuffer {
+class IoBuffer : NonCopyableMovable {
  public:
   static constexpr size_t kReservedCapacity = 8;  // Optional header bytes.
   static constexpr size_t kInitialCapacity = 1024;
 
   explicit IoBuffer(size_t initial_capacity = kInitialCapacity);
+  explicit IoBuffer(BufferPool* buffer_pool, size_t initial_capacity = 0);
+  ~IoBuffer();
 
   void Swap(IoBuffer& io_buffer);
 
   size_t GetReadableBytes() const { return writing_index_ - reading_index_; }
-  size_t GetWritableBytes() const { return buffer_.size() - writing_index_; }
+  size_t GetWritableBytes() const { return buffer_size_ - writing_index_; }
   size_t GetReservedBytes() const { return reading_index_; }
 
-  size_t GetBufferSize() const { return buffer_.size(); }
-  size_t GetBufferCapacity() const { return buffer_.capacity(); }
+  size_t GetBufferSize() const { return buffer_size_; }
+  size_t GetBufferCapacity() const { return buffer_size_; }
+
+  BufferPool* GetBufferPool() const { return buffer_pool_; }
 
   const char* GetReadablePosition() const {
     return GetBufferBegin() + reading_index_;
@@ -72,9 +82,27 @@ class IoBuffer {
   const char* FindCrlf() const;
   const char* FindCrlf(const char* start_position) const;
 
+  const char* FindDoubleCrlf() const;
+  const char* FindDoubleCrlf(const char* start_position) const;
+
   const char* FindEof() const;
   const char* FindEof(const char* start_position) const;
 
+  // Find the first readable byte belonging to the set
+  const char* FindAnyOf(const ByteSet& byte_set) const;
+
+  // Resumable versions of the finding above for a message arriving in pieces
+  // (named apart, so "nullptr" given to the ones above is not ambiguous):
+  // "scanned_bytes" (0 at first) counts the readable bytes already searched in
+  // vain, so each call only scans what has newly arrived. It is reset to 0
+  // when a match is found, and must be reset by the caller after retrieving
+  // anything from the buffer
+  const char* FindCrlfFrom(size_t* scanned_bytes) const;
+  const char* FindDoubleCrlfFrom(size_t* scanned_bytes) const;
+  const char* FindEofFrom(size_t* scanned_bytes) const;
+  const char* FindAnyOfFrom(const ByteSet& byte_set,
+                            size_t* scanned_bytes) const;
+
   // Reset reading and writing index to initial status
   void RefreshRW();
 
@@ -160,6 +188,20 @@ class IoBuffer {
   // Only be called in user code
   void ShrinkWritableSpace(size_t len);
 
+  // Give the storage back if there is nothing to read (the buffer must not be
+  // used by any in-flight I/O)
+  void ReleaseIfEmpty();
+
+  // Move the content into storage of another pool (nullptr means the heap),
+  // called in the thread owning both pools (the buffer must not be used by
+  // any in-flight I/O)
+  void Rebind(BufferPool* buffer_pool);
+
+  // Give the storage back if there is nothing to read, or move the content
+  // into a smaller storage if the current one is larger than
+  // "max_retained_capacity" (the buffer must not be used by any in-flight I/O)
+  void Trim(size_t max_retained_capacity);
+
   // Retrieve content from the file descriptor with discrete reading(coping with
   // sudden large traffic) to the buffer
   ssize_t ReadFromFd(int fd, int* tmp_errno);
@@ -169,17 +211,27 @@ class IoBuffer {
   ssize_t WriteToFd(int fd);
 
  private:
-  typedef std::vector<char> BufferType;
-
   // Get the raw begin of the buffer
-  const char* GetBufferBegin() const { return &*buffer_.begin(); }
+  const char* GetBufferBegin() const { return buffer_; }
 
   // Reserve space for writing
   void ReserveWritableSpace(size_t len);
 
-  BufferType buffer_;
+  // Move the readable content into a new storage holding at least "size"
+  // bytes
+  void Reallocate(size_t size);
+
+  // Allocate and free the storage (from the pool if there is one)
+  char* AllocateStorage(size_t size, size_t* real_size);
+  void FreeStorage();
+
+  char* buffer_;
+  size_t buffer_size_;
   size_t reading_index_;
   size_t writing_index_;
+
+  // Pool which the storage comes from (nullptr means the heap)
+  BufferPool* buffer_pool_;
 };
 
 }  // namespace taotu
@@ -0,0 +1,227 @@
+/**
+ * @file listener_handoff.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "ListenerHandoff" which passes listening
+ * sockets from an old process to a new one over a Unix domain socket.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "listener_handoff.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "logger.h"
+#include "spin_lock.h"
+
+namespace taotu {
+
+USE_LOG_CATEGORY(logger::kAcceptorLog);
+
+namespace {
+
+// Listening sockets inherited but not taken yet (Mapping: key of the bound
+// address -> file descriptor)
+struct InheritedListeners {
+  std::unordered_map<std::string, int> fds;
+  MutexLock lock;
+};
+InheritedListeners& GetInheritedListeners() {
+  static InheritedListeners inherited_listeners;
+  return inherited_listeners;
+}
+
+std::string GetAddressKey(const NetAddress& address) {
+  if (address.IsUnix()) {
+    return "unix:" + address.GetUnixPath();
+  }
+  return std::to_string(address.GetFamily()) + ":" + address.GetIp() + ":" +
+         std::to_string(address.GetPort());
+}
+
+NetAddress GetBoundAddress(int socket_fd) {
+  struct sockaddr_storage local_addr;
+  ::memset(&local_addr, 0, sizeof(local_addr));
+  auto addr_len = static_cast<socklen_t>(sizeof(local_addr));
+  if (::getsockname(socket_fd, reinterpret_cast<struct sockaddr*>(&local_addr),
+                    &addr_len) < 0) {
+    LOG_ERROR("Fail to get the address of the inherited fd(%d)!!!", socket_fd);
+  }
+  NetAddress local_address;
+  local_address.SetRawAddr(local_addr, addr_len);
+  return local_address;
+}
+
+}  // namespace
+
+size_t ListenerHandoff::Inherit(const NetAddress& handoff_address,
+                                int64_t timeout_milliseconds) {
+  int socket_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (socket_fd < 0) {
+    LOG_ERROR("Fail to create the handoff socket!!! errno(%d): %s", errno,
+              ::strerror(errno));
+    return 0;
+  }
+  if (::connect(socket_fd, handoff_address.GetNetAddress(),
+                static_cast<socklen_t>(handoff_address.GetSize())) < 0) {
+    // Nothing to inherit (the first start)
+    LOG_DEBUG("No old process on handoff socket(%s).",
+              handoff_address.GetUnixPath().c_str());
+    ::close(socket_fd);
+    return 0;
+  }
+  struct timeval timeout {};
+  timeout.tv_sec = static_cast<time_t>(timeout_milliseconds / 1000);
+  timeout.tv_usec =
+      static_cast<suseconds_t>((timeout_milliseconds % 1000) * 1000);
+  ::setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+               static_cast<socklen_t>(sizeof(timeout)));
+  size_t amount = ReceiveListeners(socket_fd);
+  ::close(socket_fd);
+  LOG_NOTICE("Inherit %zu listening socket(s) from handoff socket(%s).",
+             amount, handoff_address.GetUnixPath().c_str());
+  return amount;
+}
+
+int ListenerHandoff::TakeInherited(const NetAddress& listen_address) {
+  auto& inherited_listeners = GetInheritedListeners();
+  LockGuard lock_guard(inherited_listeners.lock);
+  auto itr = inherited_listeners.fds.find(GetAddressKey(listen_address));
+  if (itr == inherited_listeners.fds.end()) {
+    return -1;
+  }
+  int fd = itr->second;
+  inherited_listeners.fds.erase(itr);
+  return fd;
+}
+
+bool ListenerHandoff::SendListeners(int socket_fd,
+                                    const std::vector<int>& listening_fds) {
+  if (!IsPeerTrusted(socket_fd)) {
+    return false;
+  }
+  if (listening_fds.empty() || listening_fds.size() > kMaxListenerAmount) {
+    LOG_ERROR("Can not hand off %zu listening sockets!!!",
+              listening_fds.size());
+    return false;
+  }
+  // The amount is sent along for checking what arrives
+  auto amount = static_cast<uint32_t>(listening_fds.size());
+  struct iovec iov {};
+  iov.iov_base = &amount;
+  iov.iov_len = sizeof(amount);
+  char control[CMSG_SPACE(sizeof(int) * kMaxListenerAmount)];
+  ::memset(control, 0, sizeof(control));
+  struct msghdr message {};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = CMSG_SPACE(sizeof(int) * listening_fds.size());
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * listening_fds.size());
+  ::memcpy(CMSG_DATA(cmsg), listening_fds.data(),
+           sizeof(int) * listening_fds.size());
+  ssize_t n = 0;
+  do {
+    n = ::sendmsg(socket_fd, &message, MSG_NOSIGNAL);
+  } while (n < 0 && EINTR == errno);
+  if (n != static_cast<ssize_t>(sizeof(amount))) {
+    LOG_ERROR("Fail to hand off listening sockets on fd(%d)!!! errno(%d): %s",
+              socket_fd, errno, ::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+size_t ListenerHandoff::ReceiveListeners(int socket_fd) {
+  if (!IsPeerTrusted(socket_fd)) {
+    return 0;
+  }
+  uint32_t amount = 0;
+  struct iovec iov {};
+  iov.iov_base = &amount;
+  iov.iov_len = sizeof(amount);
+  char control[CMSG_SPACE(sizeof(int) * kMaxListenerAmount)];
+  ::memset(control, 0, sizeof(control));
+  struct msghdr message {};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  ssize_t n = 0;
+  do {
+    n = ::recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC);
+  } while (n < 0 && EINTR == errno);
+  std::vector<int> fds;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&message, cmsg)) {
+    if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+      size_t fd_amount = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const auto* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+      fds.insert(fds.end(), data, data + fd_amount);
+    }
+  }
+  if (n != static_cast<ssize_t>(sizeof(amount)) || fds.size() != amount ||
+      (message.msg_flags & MSG_CTRUNC) != 0) {
+    LOG_ERROR("Receive broken listening sockets on fd(%d)!!!", socket_fd);
+    for (int fd : fds) {
+      ::close(fd);
+    }
+    return 0;
+  }
+  auto& inherited_listeners = GetInheritedListeners();
+  LockGuard lock_guard(inherited_listeners.lock);
+  for (int fd : fds) {
+    auto key = GetAddressKey(GetBoundAddress(fd));
+    auto itr = inherited_listeners.fds.find(key);
+    if (itr != inherited_listeners.fds.end()) {
+      ::close(itr->second);  // Replaced by the newer one
+    }
+    inherited_listeners.fds[key] = fd;
+  }
+  return fds.size();
+}
+
+bool ListenerHandoff::IsPeerTrusted(int socket_fd) {
+  struct ucred credentials {};
+  auto length = static_cast<socklen_t>(sizeof(credentials));
+  if (::getsockopt(socket_fd, SOL_SOCKET, SO_PEERCRED, &credentials,
+                   &length) < 0) {
+    LOG_ERROR("Fail to get the peer credentials on fd(%d)!!! errno(%d): %s",
+              socket_fd, errno, ::strerror(errno));
+    return false;
+  }
+  if (credentials.uid != ::geteuid()) {
+    LOG_ERROR("Refuse the handoff peer of uid(%u) pid(%d) on fd(%d)!!!",
+              static_cast<unsigned>(credentials.uid),
+              static_cast<int>(credentials.pid), socket_fd);
+    return false;
+  }
+  return true;
+}
+
+bool ListenerHandoff::RestrictToOwner(const NetAddress& handoff_address) {
+  if (!handoff_address.IsUnix() || handoff_address.IsAbstract()) {
+    return true;
+  }
+  if (::chmod(handoff_address.GetUnixPath().c_str(), S_IRUSR | S_IWUSR) < 0) {
+    LOG_ERROR("Fail to restrict handoff socket(%s)!!! errno(%d): %s",
+              handoff_address.GetUnixPath().c_str(), errno, ::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+}  // namespace taotu
@@ -0,0 +1,69 @@
+/**
+ * @file listener_handoff.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "ListenerHandoff" which passes listening sockets
+ * from an old process to a new one over a Unix domain socket.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LISTENER_HANDOFF_H_
+#define TAOTU_SRC_LISTENER_HANDOFF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "net_address.h"
+#include "non_copyable_movable.h"
+
+namespace taotu {
+
+/**
+ * @brief "ListenerHandoff" makes hot restarts possible. The old process serves
+ * a handoff socket (see "Server::EnableHandoff()"), and the new process calls
+ * "Inherit()" before creating its servers. The old one then sends the file
+ * descriptors of its listening sockets ("SCM_RIGHTS") and starts draining,
+ * while the new one listens on the same sockets instead of binding new ones.
+ * Connections coming meanwhile wait in the shared backlog, so none is
+ * refused.
+ *
+ */
+class ListenerHandoff : NonCopyableMovable {
+ public:
+  // At most so many listening sockets are passed at once
+  static constexpr size_t kMaxListenerAmount = 64;
+
+  // Connect to the handoff socket of the old process and take its listening
+  // sockets, return how many are taken (0 if no old process is there)
+  static size_t Inherit(const NetAddress& handoff_address,
+                        int64_t timeout_milliseconds = 5000);
+
+  // Take the inherited listening socket bound to the address, -1 if none
+  // (each one is taken once)
+  static int TakeInherited(const NetAddress& listen_address);
+
+  // Send the listening sockets over the connected Unix domain socket
+  static bool SendListeners(int socket_fd,
+                            const std::vector<int>& listening_fds);
+
+  // Receive listening sockets from the connected Unix domain socket (blocking)
+  // and keep them to be taken, return how many are received
+  static size_t ReceiveListeners(int socket_fd);
+
+  // Whether the peer of the connected Unix domain socket runs as the same
+  // effective user, since only such one may give or take listening sockets
+  static bool IsPeerTrusted(int socket_fd);
+
+  // Make the (bound but not listening yet) handoff socket connectable by its
+  // owner only (abstract ones have no permissions, where only the peer checks
+  // above guard), return false if failed
+  static bool RestrictToOwner(const NetAddress& handoff_address);
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LISTENER_HANDOFF_H_
@@ -0,0 +1,154 @@
+/**
+ * @file log_clock.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LogClock" which gives the time of log
+ * records and formats it.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "log_clock.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+
+namespace taotu {
+namespace logger {
+
+namespace {
+
+// "YYYY-MM-DDTHH:MM:SS" followed by "+hh:mm"
+constexpr size_t kDateTimeByte = 19;
+constexpr size_t kOffsetByte = 6;
+constexpr size_t kSecondTextWord = 4;
+
+// The text of one second
+struct SecondText {
+  int64_t second = -1;
+  char text[kSecondTextWord * sizeof(uint64_t)];
+};
+
+// The latest second published by a seqlock (an odd sequence means being
+// written, and the text is kept in atomic words so reading is race-free)
+struct PublishedSecond {
+  std::atomic<uint64_t> seq{0};
+  std::atomic<int64_t> second{-1};
+  std::atomic<uint64_t> text[kSecondTextWord];
+};
+PublishedSecond published_second;
+
+thread_local SecondText thread_second;
+
+char* WriteDigits(uint32_t value, size_t width, char* position) {
+  for (size_t i = width; i > 0; --i) {
+    position[i - 1] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  return position + width;
+}
+
+void ComputeSecond(int64_t second, SecondText* second_text) {
+  auto tmp_time = static_cast<time_t>(second);
+  struct tm tmp_tm;
+  // In consideration of time zone
+  ::localtime_r(&tmp_time, &tmp_tm);
+  char* position = second_text->text;
+  position = WriteDigits(static_cast<uint32_t>(tmp_tm.tm_year + 1900), 4,
+                         position);
+  *position++ = '-';
+  position = WriteDigits(static_cast<uint32_t>(tmp_tm.tm_mon + 1), 2, position);
+  *position++ = '-';
+  position = WriteDigits(static_cast<uint32_t>(tmp_tm.tm_mday), 2, position);
+  *position++ = 'T';
+  position = WriteDigits(static_cast<uint32_t>(tmp_tm.tm_hour), 2, position);
+  *position++ = ':';
+  position = WriteDigits(static_cast<uint32_t>(tmp_tm.tm_min), 2, position);
+  *position++ = ':';
+  position = WriteDigits(static_cast<uint32_t>(tmp_tm.tm_sec), 2, position);
+  long offset_minutes = tmp_tm.tm_gmtoff / 60;
+  *position++ = offset_minutes < 0 ? '-' : '+';
+  if (offset_minutes < 0) {
+    offset_minutes = -offset_minutes;
+  }
+  position = WriteDigits(static_cast<uint32_t>(offset_minutes / 60), 2,
+                         position);
+  *position++ = ':';
+  WriteDigits(static_cast<uint32_t>(offset_minutes % 60), 2, position);
+  second_text->second = second;
+}
+
+bool LoadPublishedSecond(int64_t second, SecondText* second_text) {
+  uint64_t seq = published_second.seq.load(std::memory_order_acquire);
+  if ((seq & 1) != 0 ||
+      published_second.second.load(std::memory_order_relaxed) != second) {
+    return false;
+  }
+  uint64_t words[kSecondTextWord];
+  for (size_t i = 0; i < kSecondTextWord; ++i) {
+    words[i] = published_second.text[i].load(std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (published_second.seq.load(std::memory_order_relaxed) != seq) {
+    return false;  // Changed meanwhile
+  }
+  ::memcpy(second_text->text, words, sizeof(words));
+  second_text->second = second;
+  return true;
+}
+
+void PublishSecond(const SecondText& second_text) {
+  uint64_t seq = published_second.seq.load(std::memory_order_relaxed);
+  // Never go back, and give up if another thread is publishing
+  if ((seq & 1) != 0 ||
+      published_second.second.load(std::memory_order_relaxed) >=
+          second_text.second ||
+      !published_second.seq.compare_exchange_strong(
+          seq, seq + 1, std::memory_order_relaxed)) {
+    return;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  uint64_t words[kSecondTextWord];
+  ::memcpy(words, second_text.text, sizeof(words));
+  published_second.second.store(second_text.second, std::memory_order_relaxed);
+  for (size_t i = 0; i < kSecondTextWord; ++i) {
+    published_second.text[i].store(words[i], std::memory_order_relaxed);
+  }
+  published_second.seq.store(seq + 2, std::memory_order_release);
+}
+
+}  // namespace
+
+int64_t LogClock::Now() {
+  struct timespec now;
+  ::clock_gettime(CLOCK_REALTIME, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000 +
+         static_cast<int64_t>(now.tv_nsec / 1000);
+}
+
+size_t LogClock::FormatTimestamp(int64_t time_us, char* buffer) {
+  int64_t second = time_us / 1000000;
+  int64_t microsecond = time_us % 1000000;
+  if (microsecond < 0) {
+    --second;
+    microsecond += 1000000;
+  }
+  SecondText& second_text = thread_second;
+  if (second_text.second != second &&
+      !LoadPublishedSecond(second, &second_text)) {
+    ComputeSecond(second, &second_text);
+    PublishSecond(second_text);
+  }
+  ::memcpy(buffer, second_text.text, kDateTimeByte);
+  char* position = buffer + kDateTimeByte;
+  *position++ = '.';
+  position = WriteDigits(static_cast<uint32_t>(microsecond), 6, position);
+  ::memcpy(position, second_text.text + kDateTimeByte, kOffsetByte);
+  return kTimestampByte;
+}
+
+}  // namespace logger
+}  // namespace taotu
@@ -0,0 +1,46 @@
+/**
+ * @file log_clock.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LogClock" which gives the time of log records
+ * and formats it.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOG_CLOCK_H_
+#define TAOTU_SRC_LOG_CLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "non_copyable_movable.h"
+
+namespace taotu {
+namespace logger {
+
+/**
+ * @brief "LogClock" formats timestamps in ISO-8601 of the local time with
+ * microseconds, like "2026-10-18T12:00:00.123456+08:00". The part of the
+ * second (computed by "localtime_r()", which takes the lock of time zone) is
+ * done once for each second: it is published by a seqlock for all threads and
+ * kept by each thread, so formatting mostly costs a few loads and copies.
+ *
+ */
+class LogClock : NonCopyableMovable {
+ public:
+  static constexpr size_t kTimestampByte = 32;
+
+  // Microseconds of the wall clock
+  static int64_t Now();
+
+  // Write the timestamp of "time_us" (without '\0'), return
+  // "kTimestampByte"
+  static size_t FormatTimestamp(int64_t time_us, char* buffer);
+};
+
+}  // namespace logger
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOG_CLOCK_H_
@@ -0,0 +1,411 @@
+/**
+ * @file log_crash_file.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LogCrashFile" which keeps the rings of
+ * logging threads in a file mapped in memory, so the records left in them can
+ * be recovered after a crash.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "log_crash_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <unordered_map>
+
+#include "log_record.h"
+
+namespace taotu {
+namespace logger {
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'A', 'O', 'T', 'U', 'C', 'R', 'F'};
+constexpr uint32_t kVersion = 1;
+
+constexpr uint32_t kRunningState = 1;
+constexpr uint32_t kClosedState = 2;
+
+constexpr size_t kPageByte = 4096;
+
+// Layout: the file header, the format area, the headers of segments, then
+// the buffers of segments
+constexpr size_t kFormatAreaOffset = kPageByte;
+constexpr size_t kFormatAreaByte = 1024 * 1024;
+constexpr size_t kSignalStackByte = 64 * 1024;
+constexpr size_t kSegmentHeadersOffset = kFormatAreaOffset + kFormatAreaByte;
+
+struct FileHeader {
+  char magic[sizeof(kMagic)];
+  uint32_t version;
+  uint32_t segment_amount;
+  uint64_t segment_byte;
+  int64_t pid;
+  // Bytes used in the format area
+  std::atomic<uint64_t> format_byte;
+  std::atomic<uint32_t> state;
+  std::atomic<int32_t> signal_number;
+  std::atomic<int64_t> crash_time_us;
+};
+
+struct alignas(64) SegmentHeader {
+  LogRingPositions positions;
+  std::atomic<uint32_t> is_used;
+};
+
+// An entry of the format area is [uint64 address][uint32 length][uint32] and
+// the bytes of the format, aligned to 8 bytes (the address is stored last, so
+// an entry with a zero address is not done)
+constexpr size_t kFormatEntryHeaderByte =
+    sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint32_t);
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t GetSegmentsOffset(size_t segment_amount) {
+  return AlignUp(kSegmentHeadersOffset + segment_amount * sizeof(SegmentHeader),
+                 kPageByte);
+}
+
+// Errors are printed instead of logged, since it is the logger that fails
+void PrintError(const char* what, const std::string& file_name) {
+  ::fprintf(stderr, "Log crash file: %s %s failed: %s\n", what,
+            file_name.c_str(), ::strerror(errno));
+}
+
+// The file a process left without closing it is kept for recovering
+void KeepLastFile(const std::string& file_name) {
+  int fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  FileHeader header;
+  ssize_t n = ::pread(fd, static_cast<void*>(&header), sizeof(header), 0);
+  ::close(fd);
+  if (n != static_cast<ssize_t>(sizeof(header)) ||
+      ::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      kClosedState == header.state.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::string last_name{file_name + ".last"};
+  if (::rename(file_name.c_str(), last_name.c_str()) != 0) {
+    PrintError("Renaming", file_name);
+    return;
+  }
+  ::fprintf(stderr,
+            "Log crash file: %s is left unclosed, so it is kept as %s (read "
+            "by taotu-log-recover).\n",
+            file_name.c_str(), last_name.c_str());
+}
+
+constexpr int kFatalSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+constexpr size_t kFatalSignalAmount =
+    sizeof(kFatalSignals) / sizeof(kFatalSignals[0]);
+
+std::atomic<uint64_t> last_file_id{0};
+
+// Used by the catcher of fatal signals
+std::atomic<FileHeader*> crashing_file_header{nullptr};
+struct sigaction previous_actions[kFatalSignalAmount];
+
+// The alternate stack of a thread, disabled before being freed
+struct SignalStack {
+  ~SignalStack() {
+    stack_t current;
+    if (stack != nullptr && 0 == ::sigaltstack(nullptr, &current) &&
+        current.ss_sp == stack.get()) {
+      stack_t disabled{};
+      disabled.ss_flags = SS_DISABLE;
+      ::sigaltstack(&disabled, nullptr);
+    }
+  }
+
+  std::unique_ptr<char[]> stack;
+};
+
+}  // namespace
+
+const char LogCrashFile::kLostFormat[] = "(the format is lost)";
+
+LogCrashFile::LogCrashFile()
+    : id_(last_file_id.fetch_add(1, std::memory_order_relaxed) + 1),
+      fd_(-1),
+      data_(nullptr),
+      size_(0),
+      segment_byte_(0),
+      segment_amount_(0),
+      is_format_area_full_(false) {}
+
+LogCrashFile::~LogCrashFile() {
+  if (data_ != nullptr) {
+    auto* header = reinterpret_cast<FileHeader*>(data_);
+    // The catcher has nothing to stamp then
+    FileHeader* expected = header;
+    crashing_file_header.compare_exchange_strong(expected, nullptr);
+    ::munmap(data_, size_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool LogCrashFile::Open(const std::string& file_name, size_t segment_byte,
+                        size_t segment_amount) {
+  KeepLastFile(file_name);
+  segment_byte_ = LogRing::RoundCapacity(std::max(segment_byte, kPageByte));
+  segment_amount_ = segment_amount;
+  size_ = GetSegmentsOffset(segment_amount_) + segment_byte_ * segment_amount_;
+  fd_ = ::open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+               0644);
+  if (fd_ < 0) {
+    PrintError("Opening", file_name);
+    return false;
+  }
+  // Blocks are allocated ahead, or writing into the mapping gets "SIGBUS"
+  // once the disk is full
+  int ret = ::posix_fallocate(fd_, 0, static_cast<off_t>(size_));
+  void* data = MAP_FAILED;
+  if (ret != 0) {
+    errno = ret;
+  } else {
+    data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (MAP_FAILED == data) {
+    PrintError("Mapping", file_name);
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  data_ = static_cast<char*>(data);
+  auto* header = new (data_) FileHeader;
+  ::memcpy(header->magic, kMagic, sizeof(kMagic));
+  header->version = kVersion;
+  header->segment_amount = static_cast<uint32_t>(segment_amount_);
+  header->segment_byte = segment_byte_;
+  header->pid = static_cast<int64_t>(::getpid());
+  header->format_byte.store(0, std::memory_order_relaxed);
+  header->signal_number.store(0, std::memory_order_relaxed);
+  header->crash_time_us.store(0, std::memory_order_relaxed);
+  header->state.store(kRunningState, std::memory_order_release);
+  for (size_t i = segment_amount_; i > 0; --i) {
+    new (data_ + kSegmentHeadersOffset + (i - 1) * sizeof(SegmentHeader))
+        SegmentHeader;
+    free_segments_.push_back(i - 1);
+  }
+  return true;
+}
+
+void LogCrashFile::MarkRunning() {
+  if (data_ != nullptr) {
+    reinterpret_cast<FileHeader*>(data_)->state.store(
+        kRunningState, std::memory_order_release);
+  }
+}
+
+void LogCrashFile::MarkClosed() {
+  if (data_ != nullptr) {
+    reinterpret_cast<FileHeader*>(data_)->state.store(
+        kClosedState, std::memory_order_release);
+  }
+}
+
+std::shared_ptr<LogRing> LogCrashFile::CreateRing() {
+  size_t index = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_segments_.empty()) {
+      return nullptr;
+    }
+    index = free_segments_.back();
+    free_segments_.pop_back();
+  }
+  auto* segment = reinterpret_cast<SegmentHeader*>(
+      data_ + kSegmentHeadersOffset + index * sizeof(SegmentHeader));
+  char* buffer = data_ + GetSegmentsOffset(segment_amount_) +
+                 index * segment_byte_;
+  // Fault the pages in now rather than when logging
+  for (size_t offset = 0; offset < segment_byte_; offset += kPageByte) {
+    buffer[offset] = 0;
+  }
+  auto* ring = new LogRing(segment_byte_, buffer, &segment->positions);
+  segment->is_used.store(1, std::memory_order_release);
+  auto self = shared_from_this();
+  return std::shared_ptr<LogRing>(ring, [self, index](LogRing* ring) {
+    delete ring;
+    self->ReleaseSegment(index);
+  });
+}
+
+void LogCrashFile::ReleaseSegment(size_t index) {
+  auto* segment = reinterpret_cast<SegmentHeader*>(
+      data_ + kSegmentHeadersOffset + index * sizeof(SegmentHeader));
+  segment->is_used.store(0, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_segments_.push_back(index);
+}
+
+void LogCrashFile::AppendFormat(const char* format) {
+  std::lock_guard<std::mutex> lock(format_mutex_);
+  if (is_format_area_full_ || !kept_formats_.insert(format).second) {
+    return;
+  }
+  auto* header = reinterpret_cast<FileHeader*>(data_);
+  size_t length = ::strlen(format);
+  size_t entry_byte = AlignUp(kFormatEntryHeaderByte + length, 8);
+  uint64_t offset = header->format_byte.load(std::memory_order_relaxed);
+  if (offset + entry_byte > kFormatAreaByte) {
+    // Records of this format and later ones can not be recovered
+    is_format_area_full_ = true;
+    ::fprintf(stderr,
+              "Log crash file: the area of %zu bytes for formats is full, so "
+              "records of new formats can not be recovered after a crash.\n",
+              kFormatAreaByte);
+    return;
+  }
+  header->format_byte.store(offset + entry_byte, std::memory_order_relaxed);
+  char* entry = data_ + kFormatAreaOffset + offset;
+  auto entry_length = static_cast<uint32_t>(length);
+  ::memcpy(entry + sizeof(uint64_t), &entry_length, sizeof(entry_length));
+  ::memcpy(entry + kFormatEntryHeaderByte, format, length);
+  reinterpret_cast<std::atomic<uint64_t>*>(entry)->store(
+      reinterpret_cast<uint64_t>(format), std::memory_order_release);
+}
+
+void LogCrashFile::CatchFatalSignals() {
+  crashing_file_header.store(reinterpret_cast<FileHeader*>(data_),
+                             std::memory_order_release);
+  struct sigaction action;
+  ::memset(&action, 0, sizeof(action));
+  action.sa_handler = &LogCrashFile::HandleFatalSignal;
+  action.sa_flags = SA_ONSTACK;
+  ::sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < kFatalSignalAmount; ++i) {
+    ::sigaction(kFatalSignals[i], &action, &previous_actions[i]);
+  }
+  SetUpSignalStack();
+}
+
+void LogCrashFile::SetUpSignalStack() {
+  thread_local SignalStack signal_stack;
+  stack_t current;
+  if (signal_stack.stack != nullptr ||
+      (0 == ::sigaltstack(nullptr, &current) &&
+       0 == (current.ss_flags & SS_DISABLE))) {
+    return;  // Set up already (maybe by others)
+  }
+  signal_stack.stack = std::make_unique<char[]>(kSignalStackByte);
+  stack_t alternate{};
+  alternate.ss_sp = signal_stack.stack.get();
+  alternate.ss_size = kSignalStackByte;
+  if (::sigaltstack(&alternate, nullptr) != 0) {
+    signal_stack.stack.reset();
+  }
+}
+
+void LogCrashFile::HandleFatalSignal(int signal_number) {
+  // Only what is async-signal-safe is done here
+  FileHeader* header = crashing_file_header.load(std::memory_order_acquire);
+  if (header != nullptr) {
+    struct timespec now;
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    header->crash_time_us.store(
+        static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000,
+        std::memory_order_relaxed);
+    header->signal_number.store(signal_number, std::memory_order_release);
+  }
+  // Then handled as before (like dumping the core)
+  for (size_t i = 0; i < kFatalSignalAmount; ++i) {
+    if (kFatalSignals[i] == signal_number) {
+      ::sigaction(signal_number, &previous_actions[i], nullptr);
+    }
+  }
+  ::raise(signal_number);
+}
+
+bool LogCrashFile::ReadRecords(const char* data, size_t size,
+                               LogCrashState* state,
+                               const RecordHandle& handle) {
+  if (size < kSegmentHeadersOffset ||
+      ::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+  const auto* header = reinterpret_cast<const FileHeader*>(data);
+  size_t segment_amount = header->segment_amount;
+  size_t segment_byte = header->segment_byte;
+  size_t segments_offset = GetSegmentsOffset(segment_amount);
+  if (header->version != kVersion || 0 == segment_byte ||
+      (segment_byte & (segment_byte - 1)) != 0 ||
+      size < segments_offset + segment_byte * segment_amount) {
+    return false;
+  }
+  state->is_closed =
+      kClosedState == header->state.load(std::memory_order_acquire);
+  state->signal_number =
+      header->signal_number.load(std::memory_order_acquire);
+  state->crash_time_us =
+      header->crash_time_us.load(std::memory_order_relaxed);
+  state->pid = header->pid;
+  // Mapping: address of a format in the process -> the format
+  std::unordered_map<uint64_t, std::string> formats;
+  uint64_t format_byte = std::min<uint64_t>(
+      header->format_byte.load(std::memory_order_acquire), kFormatAreaByte);
+  for (uint64_t offset = 0; offset + kFormatEntryHeaderByte <= format_byte;) {
+    const char* entry = data + kFormatAreaOffset + offset;
+    uint64_t address = 0;
+    uint32_t length = 0;
+    ::memcpy(&address, entry, sizeof(address));
+    ::memcpy(&length, entry + sizeof(address), sizeof(length));
+    if (0 == length ||
+        offset + kFormatEntryHeaderByte + length > format_byte) {
+      break;  // Cut off by the crash
+    }
+    if (address != 0) {
+      formats[address].assign(entry + kFormatEntryHeaderByte, length);
+    }
+    offset += AlignUp(kFormatEntryHeaderByte + length, 8);
+  }
+  for (size_t i = 0; i < segment_amount; ++i) {
+    const auto* segment = reinterpret_cast<const SegmentHeader*>(
+        data + kSegmentHeadersOffset + i * sizeof(SegmentHeader));
+    if (0 == segment->is_used.load(std::memory_order_acquire)) {
+      continue;
+    }
+    // Records of a broken ring are handed until where it breaks
+    LogRing::ForEachRecord(
+        data + segments_offset + i * segment_byte, segment_byte,
+        segment->positions.tail.load(std::memory_order_acquire),
+        segment->positions.head.load(std::memory_order_acquire),
+        [&formats, &handle](const char* record, size_t record_size) {
+          if (record_size < kLogRecordHeaderByte) {
+            return;
+          }
+          uint64_t address = 0;
+          ::memcpy(&address, record, sizeof(address));
+          const char* format = nullptr;
+          if (address != 0) {
+            auto itr = formats.find(address);
+            format = itr == formats.end() ? kLostFormat : itr->second.c_str();
+          }
+          handle(format, record + kLogRecordFormatByte,
+                 record_size - kLogRecordFormatByte);
+        });
+  }
+  return true;
+}
+
+}  // namespace logger
+}  // namespace taotu
@@ -0,0 +1,147 @@
+/**
+ * @file log_crash_file.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LogCrashFile" which keeps the rings of logging
+ * threads in a file mapped in memory, so the records left in them can be
+ * recovered after a crash.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOG_CRASH_FILE_H_
+#define TAOTU_SRC_LOG_CRASH_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "log_ring.h"
+#include "non_copyable_movable.h"
+
+namespace taotu {
+namespace logger {
+
+// Default amount of rings kept in a crash file (threads logging beyond get
+// rings on the heap)
+constexpr size_t kLogCrashSegmentAmount = 32;
+
+// What a crash file tells about the process which wrote it
+struct LogCrashState {
+  // Closed by "EndLogger()" with all records written down
+  bool is_closed = false;
+  // The fatal signal caught (0 for none, like killed by "SIGKILL")
+  int signal_number = 0;
+  // When the signal is caught (in microseconds since the epoch)
+  int64_t crash_time_us = 0;
+  int64_t pid = 0;
+};
+
+/**
+ * @brief "LogCrashFile" is a file mapped in memory with "MAP_SHARED", divided
+ * into segments each of which is the buffer of one "LogRing" with the
+ * positions of the ring copied ahead. Producers write records into segments
+ * just like into rings on the heap, and the page cache keeps them even if the
+ * process dies. Formats are pointers in records, so each format is also
+ * copied into the file once. A catcher of fatal signals (running on an
+ * alternate stack of each logging thread, so even a stack overflow is caught)
+ * stamps the crash into the file, then "taotu-log-recover" prints the records
+ * left between the positions of each ring.
+ *
+ */
+class LogCrashFile : NonCopyableMovable,
+                     public std::enable_shared_from_this<LogCrashFile> {
+ public:
+  // Called with the format (nullptr for a plain message, or "kLostFormat" if
+  // it is not kept, valid only during the call) and the body of each record
+  typedef std::function<void(const char*, const char*, size_t)> RecordHandle;
+
+  static const char kLostFormat[];
+
+  LogCrashFile();
+  ~LogCrashFile();
+
+  // Create the file of "segment_amount" segments of at least "segment_byte"
+  // bytes each (a file left by a process which did not close it is renamed
+  // with the suffix ".last" first), false if it fails
+  bool Open(const std::string& file_name, size_t segment_byte,
+            size_t segment_amount);
+
+  // Mark whether the logger is running (a file not closed is kept by the
+  // next "Open()")
+  void MarkRunning();
+  void MarkClosed();
+
+  // Take a free segment for the ring of a thread, nullptr if there is none
+  // (the segment is freed with the ring)
+  std::shared_ptr<LogRing> CreateRing();
+
+  // Copy the format into the file unless it is there (checked in the cache of
+  // this thread first)
+  void KeepFormat(const char* format) {
+    thread_local KeptFormat kept_formats[kFormatCacheSize];
+    KeptFormat& kept_format =
+        kept_formats[(reinterpret_cast<uintptr_t>(format) >> 3) &
+                     (kFormatCacheSize - 1)];
+    if (kept_format.format != format || kept_format.file_id != id_) {
+      kept_format.format = format;
+      kept_format.file_id = id_;
+      AppendFormat(format);
+    }
+  }
+
+  // Stamp fatal signals into this file before the handling done before
+  void CatchFatalSignals();
+
+  // Give the calling thread an alternate stack to catch fatal signals on,
+  // unless it has one (freed when the thread exits)
+  static void SetUpSignalStack();
+
+  // Hand each record left in the crash file of "data" in order of the rings,
+  // false if it is not a crash file
+  static bool ReadRecords(const char* data, size_t size, LogCrashState* state,
+                          const RecordHandle& handle);
+
+ private:
+  static constexpr size_t kFormatCacheSize = 256;  // Power of two
+
+  struct KeptFormat {
+    const char* format;
+    uint64_t file_id;
+  };
+
+  void AppendFormat(const char* format);
+
+  void ReleaseSegment(size_t index);
+
+  // The catcher of fatal signals
+  static void HandleFatalSignal(int signal_number);
+
+  // Unique in the process (0 for none)
+  uint64_t id_;
+  int fd_;
+  char* data_;
+  size_t size_;
+  size_t segment_byte_;
+  size_t segment_amount_;
+
+  std::mutex mutex_;
+  std::vector<size_t> free_segments_;
+
+  // Formats copied into the file (missed in the caches of threads)
+  std::mutex format_mutex_;
+  std::unordered_set<const char*> kept_formats_;
+  bool is_format_area_full_;
+};
+
+}  // namespace logger
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOG_CRASH_FILE_H_
@@ -0,0 +1,291 @@
+/**
+ * @file log_file_writer.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LogFileWriter" which writes log files in
+ * large batches by io_uring.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "log_file_writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "time_point.h"
+
+namespace taotu {
+namespace logger {
+
+namespace {
+
+// Alignment of buffers, offsets and sizes for "O_DIRECT"
+constexpr size_t kAlignment = 4096;
+constexpr unsigned kRingEntries = 4;
+
+constexpr uint64_t kWriteTag = 1;
+constexpr uint64_t kSyncTag = 2;
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// Errors are printed instead of logged, since it is the logger that fails
+void PrintError(const char* what, int error) {
+  ::fprintf(stderr, "Log file writer: %s failed: %s\n", what,
+            ::strerror(error));
+}
+
+}  // namespace
+
+LogFileWriter::LogFileWriter()
+    : fd_(-1),
+      is_ring_ready_(false),
+      pending_completion_amount_(0),
+      filling_index_(0),
+      batch_capacity_(0),
+      file_offset_(0),
+      file_byte_(0),
+      last_sync_time_(0) {
+  ::memset(static_cast<void*>(&ring_), 0, sizeof(ring_));
+}
+
+LogFileWriter::~LogFileWriter() {
+  Close();
+  if (is_ring_ready_) {
+    ::io_uring_queue_exit(&ring_);
+  }
+  for (auto& batch : batches_) {
+    ::free(batch.data);
+  }
+}
+
+bool LogFileWriter::Open(const std::string& file_name,
+                         const LogWriteOptions& options) {
+  Close();
+  options_ = options;
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+  if (options_.is_direct) {
+    fd_ = ::open(file_name.c_str(), flags | O_DIRECT, 0644);
+    if (fd_ < 0) {
+      // Like on tmpfs
+      PrintError("Opening with O_DIRECT", errno);
+      options_.is_direct = false;
+    }
+  }
+  if (fd_ < 0) {
+    fd_ = ::open(file_name.c_str(), flags, 0644);
+  }
+  if (fd_ < 0) {
+    return false;
+  }
+  size_t batch_capacity = AlignUp(std::max(options_.batch_byte, kAlignment));
+  if (batch_capacity != batch_capacity_) {
+    for (auto& batch : batches_) {
+      ::free(batch.data);
+      void* data = nullptr;
+      if (::posix_memalign(&data, kAlignment, batch_capacity) != 0) {
+        ::abort();
+      }
+      batch.data = static_cast<char*>(data);
+    }
+    batch_capacity_ = batch_capacity;
+  }
+  for (auto& batch : batches_) {
+    batch.size = 0;
+    batch.is_writing = false;
+  }
+  filling_index_ = 0;
+  file_offset_ = 0;
+  file_byte_ = 0;
+  last_sync_time_ = TimePoint::FNow();
+  if (!is_ring_ready_) {
+    // Not polled by a kernel thread, since the logger is seldom busy
+    int ret = ::io_uring_queue_init(kRingEntries, &ring_, 0);
+    if (ret < 0) {
+      PrintError("io_uring_queue_init (writing synchronously instead)", -ret);
+    } else {
+      is_ring_ready_ = true;
+    }
+  }
+  return true;
+}
+
+void LogFileWriter::Append(const char* data, size_t size) {
+  if (fd_ < 0) {
+    return;
+  }
+  file_byte_ += static_cast<int64_t>(size);
+  while (size > 0) {
+    Batch& batch = batches_[filling_index_];
+    size_t copied_size = std::min(size, batch_capacity_ - batch.size);
+    ::memcpy(batch.data + batch.size, data, copied_size);
+    batch.size += copied_size;
+    data += copied_size;
+    size -= copied_size;
+    if (batch.size == batch_capacity_) {
+      SubmitFilling();
+    }
+  }
+}
+
+void LogFileWriter::Flush() {
+  if (fd_ >= 0 && batches_[filling_index_].size > 0) {
+    SubmitFilling();
+  }
+}
+
+void LogFileWriter::Close() {
+  if (fd_ < 0) {
+    return;
+  }
+  WaitWriting();
+  Batch& batch = batches_[filling_index_];
+  if (batch.size > 0) {
+    WriteDirectly(batch.data, batch.size, file_offset_);
+    file_offset_ += static_cast<int64_t>(batch.size);
+    batch.size = 0;
+  }
+  if (options_.sync_interval_microseconds >= 0) {
+    ::fdatasync(fd_);
+  }
+  ::close(fd_);
+  fd_ = -1;
+}
+
+void LogFileWriter::SubmitFilling() {
+  // The other batch is free once written
+  WaitWriting();
+  Batch& batch = batches_[filling_index_];
+  size_t size = batch.size;
+  if (options_.is_direct) {
+    size &= ~(kAlignment - 1);
+    if (0 == size) {
+      return;
+    }
+  }
+  // The tail out of alignment goes on with the other batch
+  Batch& next_batch = batches_[filling_index_ ^ 1];
+  next_batch.size = batch.size - size;
+  ::memcpy(next_batch.data, batch.data + size, next_batch.size);
+  batch.size = size;
+  bool should_sync = ShouldSync();
+  struct io_uring_sqe* sqe =
+      is_ring_ready_ ? ::io_uring_get_sqe(&ring_) : nullptr;
+  if (sqe != nullptr) {
+    ::io_uring_prep_write(sqe, fd_, batch.data, static_cast<unsigned>(size),
+                          static_cast<__u64>(file_offset_));
+    ::io_uring_sqe_set_data64(sqe, kWriteTag);
+    pending_completion_amount_ = 1;
+    struct io_uring_sqe* sync_sqe =
+        should_sync ? ::io_uring_get_sqe(&ring_) : nullptr;
+    if (sync_sqe != nullptr) {
+      // Only after the write
+      sqe->flags |= IOSQE_IO_LINK;
+      ::io_uring_prep_fsync(sync_sqe, fd_, IORING_FSYNC_DATASYNC);
+      ::io_uring_sqe_set_data64(sync_sqe, kSyncTag);
+      ++pending_completion_amount_;
+      should_sync = false;
+    }
+    int ret = ::io_uring_submit(&ring_);
+    if (ret < 0) {
+      PrintError("io_uring_submit (writing synchronously instead)", -ret);
+      // Completions left are never waited for
+      is_ring_ready_ = false;
+      pending_completion_amount_ = 0;
+      sqe = nullptr;
+    }
+  }
+  if (sqe != nullptr) {
+    batch.is_writing = true;
+  } else {
+    WriteDirectly(batch.data, size, file_offset_);
+    batch.size = 0;
+  }
+  if (should_sync) {
+    ::fdatasync(fd_);
+  }
+  file_offset_ += static_cast<int64_t>(size);
+  filling_index_ ^= 1;
+}
+
+void LogFileWriter::WaitWriting() {
+  Batch& batch = batches_[filling_index_ ^ 1];
+  if (!batch.is_writing) {
+    return;
+  }
+  // Where the batch starts in the file
+  int64_t offset = file_offset_ - static_cast<int64_t>(batch.size);
+  while (pending_completion_amount_ > 0) {
+    struct io_uring_cqe* cqe = nullptr;
+    int ret = ::io_uring_wait_cqe(&ring_, &cqe);
+    if (-EINTR == ret) {
+      continue;
+    }
+    if (ret < 0) {
+      PrintError("io_uring_wait_cqe", -ret);
+      break;
+    }
+    uint64_t tag = ::io_uring_cqe_get_data64(cqe);
+    int res = cqe->res;
+    ::io_uring_cqe_seen(&ring_, cqe);
+    --pending_completion_amount_;
+    if (kWriteTag == tag && res != static_cast<int>(batch.size)) {
+      // Write what is left (the linked sync is canceled then)
+      size_t written_size = res > 0 ? static_cast<size_t>(res) : 0;
+      WriteDirectly(batch.data + written_size, batch.size - written_size,
+                    offset + static_cast<int64_t>(written_size));
+    } else if (kSyncTag == tag && res < 0) {
+      ::fdatasync(fd_);
+    }
+  }
+  pending_completion_amount_ = 0;
+  batch.is_writing = false;
+  batch.size = 0;
+}
+
+void LogFileWriter::WriteDirectly(const char* data, size_t size,
+                                  int64_t offset) {
+  while (size > 0) {
+    ssize_t n = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+    if (n < 0 && EINTR == errno) {
+      continue;
+    }
+    if (n < 0 && EINVAL == errno && options_.is_direct) {
+      // Out of alignment for "O_DIRECT"
+      ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT);
+      options_.is_direct = false;
+      continue;
+    }
+    if (n <= 0) {
+      PrintError("pwrite", errno);
+      return;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+    offset += n;
+  }
+}
+
+bool LogFileWriter::ShouldSync() {
+  if (options_.sync_interval_microseconds < 0) {
+    return false;
+  }
+  int64_t now = TimePoint::FNow();
+  if (now - last_sync_time_ < options_.sync_interval_microseconds) {
+    return false;
+  }
+  last_sync_time_ = now;
+  return true;
+}
+
+}  // namespace logger
+}  // namespace taotu
@@ -0,0 +1,112 @@
+/**
+ * @file log_file_writer.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LogFileWriter" which writes log files in large
+ * batches by io_uring.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOG_FILE_WRITER_H_
+#define TAOTU_SRC_LOG_FILE_WRITER_H_
+
+#include <liburing.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "non_copyable_movable.h"
+
+namespace taotu {
+namespace logger {
+
+// Default size of each batch
+constexpr size_t kLogBatchByte = 1024 * 1024;
+
+struct LogWriteOptions {
+  // Size of each of the 2 batches (rounded up to 4 KiB)
+  size_t batch_byte = kLogBatchByte;
+  // Open log files with "O_DIRECT" to bypass the page cache (the last less
+  // than 4 KiB waits for more or for closing)
+  bool is_direct = false;
+  // "fdatasync()" after a batch at most once in the interval (0 for after
+  // each batch, negative for never)
+  int64_t sync_interval_microseconds = -1;
+};
+
+/**
+ * @brief "LogFileWriter" is used by the writer thread of the logger only.
+ * Lines are copied into one batch while the other one is being written by
+ * io_uring, so formatting goes on during writing, and the file gets a few
+ * large writes instead of many small ones. It writes synchronously if io_uring
+ * is not available.
+ *
+ */
+class LogFileWriter : NonCopyableMovable {
+ public:
+  LogFileWriter();
+  ~LogFileWriter();
+
+  // Open (and truncate) the file, false if it can not be opened
+  bool Open(const std::string& file_name, const LogWriteOptions& options);
+
+  bool IsOpen() const { return fd_ >= 0; }
+
+  // Copy into the batch being filled, which is written once full
+  void Append(const char* data, size_t size);
+
+  // Start writing what is batched (waiting for the batch being written)
+  void Flush();
+
+  // Wait until what is flushed is written (into the page cache at least)
+  void WaitFlushed() { WaitWriting(); }
+
+  // Write down everything, then close the file
+  void Close();
+
+  // Bytes given to this file
+  int64_t GetFileByte() const { return file_byte_; }
+
+ private:
+  struct Batch {
+    char* data = nullptr;
+    size_t size = 0;
+    bool is_writing = false;
+  };
+
+  // Start writing the batch filled and switch to the other one
+  void SubmitFilling();
+
+  // Wait until the batch being written is written
+  void WaitWriting();
+
+  // Write synchronously (for what io_uring leaves or without it)
+  void WriteDirectly(const char* data, size_t size, int64_t offset);
+
+  bool ShouldSync();
+
+  int fd_;
+  LogWriteOptions options_;
+
+  struct io_uring ring_;
+  bool is_ring_ready_;
+  // CQEs of the batch being written
+  int pending_completion_amount_;
+
+  Batch batches_[2];
+  size_t filling_index_;
+  size_t batch_capacity_;
+
+  // Where the next batch goes in the file
+  int64_t file_offset_;
+  int64_t file_byte_;
+  int64_t last_sync_time_;
+};
+
+}  // namespace logger
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOG_FILE_WRITER_H_
@@ -0,0 +1,60 @@
+/**
+ * @file log_rate_limiter.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LogRateLimiter" which limits how often the logs
+ * of one call site are recorded.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOG_RATE_LIMITER_H_
+#define TAOTU_SRC_LOG_RATE_LIMITER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <limits>
+
+#include "log_clock.h"
+#include "non_copyable_movable.h"
+
+namespace taotu {
+namespace logger {
+
+/**
+ * @brief "LogRateLimiter" is kept by each call site of "LOG_EVERY_N()" or
+ * "LOG_EVERY_MS()" (a static object shared by all threads).
+ *
+ */
+class LogRateLimiter : NonCopyableMovable {
+ public:
+  // True for the 1st, (n+1)th, (2n+1)th... call
+  bool IsEveryN(uint64_t n) {
+    return counter_.fetch_add(1, std::memory_order_relaxed) % n == 0;
+  }
+
+  // True if no call has been true in the last "interval_ms" milliseconds
+  bool IsEveryMs(int64_t interval_ms) {
+    int64_t now = LogClock::Now();
+    int64_t last_time = last_time_.load(std::memory_order_relaxed);
+    if (last_time != kNeverTime && now - last_time < interval_ms * 1000) {
+      return false;
+    }
+    // Only one of the threads racing wins
+    return last_time_.compare_exchange_strong(last_time, now,
+                                              std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr int64_t kNeverTime = std::numeric_limits<int64_t>::min();
+
+  std::atomic<uint64_t> counter_{0};
+  std::atomic<int64_t> last_time_{kNeverTime};
+};
+
+}  // namespace logger
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOG_RATE_LIMITER_H_
@@ -0,0 +1,495 @@
+/**
+ * @file log_record.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LogLineFormatter" which turns log records
+ * into text lines.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "log_record.h"
+
+#include <stdio.h>
+#include <sys/types.h>
+
+#include <cmath>
+
+#include "log_clock.h"
+#include "logger.h"
+
+namespace taotu {
+namespace logger {
+
+namespace {
+
+// An argument decoded
+struct LogArg {
+  LogArgType type;
+  union {
+    int64_t signed_value;
+    uint64_t unsigned_value;
+    double double_value;
+  };
+  const char* string_value;
+};
+
+bool DecodeArg(const char** position, const char* end, LogArg* arg) {
+  if (*position >= end) {
+    return false;
+  }
+  arg->type = static_cast<LogArgType>(**position);
+  ++*position;
+  if (kStringArg == arg->type) {
+    uint32_t length = 0;
+    if (static_cast<size_t>(end - *position) < sizeof(length)) {
+      return false;
+    }
+    ::memcpy(&length, *position, sizeof(length));
+    *position += sizeof(length);
+    if (static_cast<size_t>(end - *position) <
+        static_cast<size_t>(length) + 1) {
+      return false;
+    }
+    arg->string_value = *position;
+    *position += length + 1;
+    return true;
+  }
+  if (static_cast<size_t>(end - *position) < sizeof(uint64_t)) {
+    return false;
+  }
+  ::memcpy(&arg->unsigned_value, *position, sizeof(uint64_t));
+  *position += sizeof(uint64_t);
+  return true;
+}
+
+int64_t GetSigned(const LogArg& arg) {
+  if (kDoubleArg == arg.type) {
+    return static_cast<int64_t>(arg.double_value);
+  }
+  return arg.signed_value;
+}
+
+double GetDouble(const LogArg& arg) {
+  if (kSignedArg == arg.type || kBoolArg == arg.type) {
+    return static_cast<double>(arg.signed_value);
+  }
+  if (kUnsignedArg == arg.type || kPointerArg == arg.type) {
+    return static_cast<double>(arg.unsigned_value);
+  }
+  return arg.double_value;
+}
+
+// Narrow the integer like the length modifier of the conversion tells
+int64_t NarrowSigned(int64_t value, const char* length) {
+  if (::strcmp(length, "hh") == 0) {
+    return static_cast<signed char>(value);
+  }
+  if (::strcmp(length, "h") == 0) {
+    return static_cast<int16_t>(value);
+  }
+  if (length[0] == '\0') {
+    return static_cast<int>(value);
+  }
+  return value;
+}
+uint64_t NarrowUnsigned(uint64_t value, const char* length) {
+  if (::strcmp(length, "hh") == 0) {
+    return static_cast<unsigned char>(value);
+  }
+  if (::strcmp(length, "h") == 0) {
+    return static_cast<uint16_t>(value);
+  }
+  if (length[0] == '\0') {
+    return static_cast<unsigned int>(value);
+  }
+  return value;
+}
+
+template <typename T>
+void AppendFormatted(const char* spec, T value, std::string* line) {
+  char buffer[128];
+  int length = ::snprintf(buffer, sizeof(buffer), spec, value);
+  if (length < 0) {
+    return;
+  }
+  if (static_cast<size_t>(length) < sizeof(buffer)) {
+    line->append(buffer, static_cast<size_t>(length));
+    return;
+  }
+  size_t old_size = line->size();
+  line->resize(old_size + static_cast<size_t>(length) + 1);
+  ::snprintf(&(*line)[old_size], static_cast<size_t>(length) + 1, spec, value);
+  line->resize(old_size + static_cast<size_t>(length));
+}
+
+// Format the arguments following the format like "snprintf()" does
+void AppendMessage(const char* format, const char* args, const char* end,
+                   size_t arg_amount, std::string* line) {
+  LogArg arg;
+  auto next_arg = [&args, end, &arg_amount, &arg]() {
+    if (0 == arg_amount || !DecodeArg(&args, end, &arg)) {
+      return false;
+    }
+    --arg_amount;
+    return true;
+  };
+  const char* position = format;
+  while (*position != '\0') {
+    const char* percent = ::strchr(position, '%');
+    if (nullptr == percent) {
+      line->append(position);
+      break;
+    }
+    line->append(position, static_cast<size_t>(percent - position));
+    position = percent + 1;
+    if ('%' == *position) {
+      line->push_back('%');
+      ++position;
+      continue;
+    }
+    // Rebuild the conversion with "ll" as its length modifier and the
+    // values of '*' filled in
+    char spec[64] = "%";
+    size_t spec_size = 1;
+    auto push_spec = [&spec, &spec_size](const char* str, size_t size) {
+      if (spec_size + size < sizeof(spec) - 3) {
+        ::memcpy(spec + spec_size, str, size);
+        spec_size += size;
+        spec[spec_size] = '\0';
+      }
+    };
+    auto push_star = [&](bool is_precision) {
+      if (!next_arg()) {
+        return;
+      }
+      auto value = static_cast<int>(GetSigned(arg));
+      if (is_precision && value < 0) {
+        spec_size -= 1;  // A negative precision is taken as omitted
+        spec[spec_size] = '\0';
+        return;
+      }
+      char digits[16];
+      int size = ::snprintf(digits, sizeof(digits), "%d", value);
+      push_spec(digits, static_cast<size_t>(size));
+    };
+    while (*position != '\0' && ::strchr("-+ #0'", *position) != nullptr) {
+      push_spec(position++, 1);
+    }
+    if ('*' == *position) {
+      push_star(false);
+      ++position;
+    }
+    while (*position >= '0' && *position <= '9') {
+      push_spec(position++, 1);
+    }
+    if ('.' == *position) {
+      push_spec(position++, 1);
+      if ('*' == *position) {
+        push_star(true);
+        ++position;
+      }
+      while (*position >= '0' && *position <= '9') {
+        push_spec(position++, 1);
+      }
+    }
+    char length[3] = {'\0', '\0', '\0'};
+    size_t length_size = 0;
+    while (*position != '\0' && ::strchr("hljztLq", *position) != nullptr) {
+      if (length_size < 2) {
+        length[length_size++] = *position;
+      }
+      ++position;
+    }
+    char conversion = *position;
+    if ('\0' == conversion) {
+      break;
+    }
+    ++position;
+    if ('n' == conversion) {
+      next_arg();  // Never write back
+      continue;
+    }
+    if (::strchr("diouxXcfFeEgGaAsp", conversion) == nullptr) {
+      line->push_back('%');
+      line->push_back(conversion);
+      continue;
+    }
+    if (!next_arg()) {
+      line->append("(?)");
+      continue;
+    }
+    char conversion_spec[2] = {conversion, '\0'};
+    switch (conversion) {
+      case 'd':
+      case 'i':
+        push_spec("ll", 2);
+        push_spec(conversion_spec, 1);
+        AppendFormatted(
+            spec, static_cast<long long>(NarrowSigned(GetSigned(arg), length)),
+            line);
+        break;
+      case 'o':
+      case 'u':
+      case 'x':
+      case 'X':
+        push_spec("ll", 2);
+        push_spec(conversion_spec, 1);
+        AppendFormatted(spec,
+                        static_cast<unsigned long long>(NarrowUnsigned(
+                            static_cast<uint64_t>(GetSigned(arg)), length)),
+                        line);
+        break;
+      case 'c':
+        push_spec(conversion_spec, 1);
+        AppendFormatted(spec, static_cast<int>(GetSigned(arg)), line);
+        break;
+      case 's':
+        push_spec(conversion_spec, 1);
+        if (kStringArg == arg.type) {
+          AppendFormatted(spec, arg.string_value, line);
+        } else {
+          line->append("(?)");
+        }
+        break;
+      case 'p':
+        push_spec(conversion_spec, 1);
+        // C strings are kept by value, so their addresses are gone
+        if (kPointerArg == arg.type) {
+          AppendFormatted(
+              spec, reinterpret_cast<const void*>(arg.unsigned_value), line);
+        } else {
+          line->append("(?)");
+        }
+        break;
+      default:
+        push_spec(conversion_spec, 1);
+        AppendFormatted(spec, GetDouble(arg), line);
+        break;
+    }
+  }
+}
+
+const char* GetLevelName(uint8_t level) {
+  static const char* const kLevelNames[]{
+      "emergency", "alert", "critical", "error",
+      "warn",      "notice", "info",    "debug",
+  };
+  return level <= kDebug ? kLevelNames[level] : "unknown";
+}
+
+void AppendJsonString(const char* str, std::string* line) {
+  line->push_back('"');
+  for (const char* position = nullptr == str ? "" : str; *position != '\0';
+       ++position) {
+    auto c = static_cast<unsigned char>(*position);
+    switch (c) {
+      case '"':
+        line->append("\\\"");
+        break;
+      case '\\':
+        line->append("\\\\");
+        break;
+      case '\n':
+        line->append("\\n");
+        break;
+      case '\r':
+        line->append("\\r");
+        break;
+      case '\t':
+        line->append("\\t");
+        break;
+      default:
+        if (c < 0x20) {
+          char escaped[8];
+          ::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          line->append(escaped);
+        } else {
+          line->push_back(static_cast<char>(c));
+        }
+        break;
+    }
+  }
+  line->push_back('"');
+}
+
+// Quoted only if it has to be
+void AppendLogfmtString(const char* str, std::string* line) {
+  if (nullptr == str) {
+    str = "";
+  }
+  bool should_quote = '\0' == *str;
+  for (const char* position = str; *position != '\0' && !should_quote;
+       ++position) {
+    should_quote = static_cast<unsigned char>(*position) <= ' ' ||
+                   '=' == *position || '"' == *position;
+  }
+  if (!should_quote) {
+    line->append(str);
+    return;
+  }
+  AppendJsonString(str, line);
+}
+
+// Append the value of a field, quoted in JSON if it is not a number
+void AppendFieldValue(const LogArg& arg, LogLineStyle style,
+                      std::string* line) {
+  char buffer[64];
+  int length = 0;
+  switch (arg.type) {
+    case kSignedArg:
+      length = ::snprintf(buffer, sizeof(buffer), "%lld",
+                          static_cast<long long>(arg.signed_value));
+      break;
+    case kUnsignedArg:
+      length = ::snprintf(buffer, sizeof(buffer), "%llu",
+                          static_cast<unsigned long long>(arg.unsigned_value));
+      break;
+    case kDoubleArg:
+      if (kJsonLine == style && !std::isfinite(arg.double_value)) {
+        line->append("null");
+        return;
+      }
+      length = ::snprintf(buffer, sizeof(buffer), "%.15g", arg.double_value);
+      break;
+    case kBoolArg:
+      line->append(arg.unsigned_value != 0 ? "true" : "false");
+      return;
+    case kStringArg:
+      if (kJsonLine == style) {
+        AppendJsonString(arg.string_value, line);
+      } else {
+        AppendLogfmtString(arg.string_value, line);
+      }
+      return;
+    default:
+      length = ::snprintf(buffer, sizeof(buffer), kJsonLine == style
+                                                      ? "\"%p\""
+                                                      : "%p",
+                          reinterpret_cast<const void*>(arg.unsigned_value));
+      break;
+  }
+  if (length > 0) {
+    line->append(buffer, static_cast<size_t>(length));
+  }
+}
+
+// Append the fields of a record of "LOG_KV()" like ",\"key\":value" in JSON
+// or " key=value" in logfmt
+void AppendKeyValues(const char* args, const char* end, size_t arg_amount,
+                     LogLineStyle style, std::string* line) {
+  LogArg key;
+  LogArg value;
+  for (; arg_amount >= 2; arg_amount -= 2) {
+    if (!DecodeArg(&args, end, &key) || !DecodeArg(&args, end, &value)) {
+      return;
+    }
+    const char* key_name = kStringArg == key.type ? key.string_value : "?";
+    if (kJsonLine == style) {
+      line->push_back(',');
+      AppendJsonString(key_name, line);
+      line->push_back(':');
+    } else {
+      line->push_back(' ');
+      AppendLogfmtString(key_name, line);
+      line->push_back('=');
+    }
+    AppendFieldValue(value, style, line);
+  }
+}
+
+}  // namespace
+
+void LogLineFormatter::AppendLine(const char* record, size_t record_size,
+                                  std::string* line) {
+  if (record_size < kLogRecordHeaderByte) {
+    return;
+  }
+  const char* format = nullptr;
+  ::memcpy(&format, record, sizeof(format));
+  AppendLine(format, record + kLogRecordFormatByte,
+             record_size - kLogRecordFormatByte, line);
+}
+
+void LogLineFormatter::AppendLine(const char* format, const char* body,
+                                  size_t body_size, std::string* line) {
+  if (body_size < kLogRecordBodyHeaderByte) {
+    return;
+  }
+  int64_t time_us = 0;
+  ::memcpy(&time_us, body, sizeof(time_us));
+  auto level = static_cast<uint8_t>(body[sizeof(time_us)]);
+  auto arg_amount = static_cast<uint8_t>(body[sizeof(time_us) + 1]);
+  const char* args = body + kLogRecordBodyHeaderByte;
+  const char* end = body + body_size;
+  bool is_key_value = (level & kKeyValueRecordFlag) != 0;
+  level = static_cast<uint8_t>(level & ~kKeyValueRecordFlag);
+  if (!is_key_value) {
+    message_.clear();
+    if (nullptr == format) {
+      // A plain message
+      LogArg arg;
+      if (DecodeArg(&args, end, &arg) && kStringArg == arg.type) {
+        message_.append(arg.string_value);
+      }
+    } else {
+      AppendMessage(format, args, end, arg_amount, &message_);
+    }
+  }
+  if (kJsonLine == style_) {
+    line->append("{\"time\":\"");
+    AppendTime(time_us, line);
+    line->append("\",\"level\":\"");
+    line->append(GetLevelName(level));
+    line->push_back('"');
+    if (is_key_value) {
+      line->append(",\"event\":");
+      AppendJsonString(format, line);
+      AppendKeyValues(args, end, arg_amount, kJsonLine, line);
+    } else {
+      line->append(",\"message\":");
+      AppendJsonString(message_.c_str(), line);
+    }
+    line->append("}\n");
+    return;
+  }
+  if (kLogfmtLine == style_) {
+    line->append("time=");
+    AppendTime(time_us, line);
+    line->append(" level=");
+    line->append(GetLevelName(level));
+    if (is_key_value) {
+      line->append(" event=");
+      AppendLogfmtString(format, line);
+      AppendKeyValues(args, end, arg_amount, kLogfmtLine, line);
+    } else {
+      line->append(" msg=");
+      AppendLogfmtString(message_.c_str(), line);
+    }
+    line->push_back('\n');
+    return;
+  }
+  line->append("[ ");
+  AppendTime(time_us, line);
+  line->append(" ] ");
+  if (level <= kDebug) {
+    line->append(Log_level_info_prefix[level]);
+  }
+  if (is_key_value) {
+    // The event followed by "key=value" pairs
+    line->append(nullptr == format ? "" : format);
+    AppendKeyValues(args, end, arg_amount, kLogfmtLine, line);
+  } else {
+    line->append(message_);
+  }
+  line->push_back('\n');
+}
+
+void LogLineFormatter::AppendTime(int64_t time_us, std::string* line) {
+  char buffer[LogClock::kTimestampByte];
+  line->append(buffer, LogClock::FormatTimestamp(time_us, buffer));
+}
+
+}  // namespace logger
+}  // namespace taotu
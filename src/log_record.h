@@ -0,0 +1,246 @@
+/**
+ * @file log_record.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Encoding of log records (the static format and the raw arguments)
+ * and declaration of class "LogLineFormatter" which turns records into text
+ * lines later.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOG_RECORD_H_
+#define TAOTU_SRC_LOG_RECORD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "non_copyable_movable.h"
+
+namespace taotu {
+namespace logger {
+
+// A record in a "LogRing" is:
+//   [const char* format][int64_t time in microseconds][uint8_t level]
+//   [uint8_t argument amount][arguments...]
+// where each argument is a "LogArgType" and its value (8 bytes, or a uint32_t
+// length, the bytes and '\0' of a string). The format is a static string (a
+// literal given to "LOG_*()"), nullptr for a record of one plain message. The
+// part after the format pointer is the body, which is also what binary log
+// files keep. A record of "LOG_KV()" has "kKeyValueRecordFlag" in its level,
+// the event name as its format, and arguments of keys and values in turn.
+constexpr size_t kLogRecordFormatByte = sizeof(const char*);
+constexpr size_t kLogRecordBodyHeaderByte =
+    sizeof(int64_t) + sizeof(uint8_t) + sizeof(uint8_t);
+constexpr size_t kLogRecordHeaderByte =
+    kLogRecordFormatByte + kLogRecordBodyHeaderByte;
+constexpr size_t kMaxLogArgAmount = 255;
+constexpr uint8_t kKeyValueRecordFlag = 0x80;
+
+enum LogArgType : uint8_t {
+  kSignedArg = 0,
+  kUnsignedArg,
+  kDoubleArg,
+  kStringArg,
+  kPointerArg,
+  kBoolArg,
+};
+
+// How text lines look
+enum LogLineStyle {
+  // "[ 2026-10-18T12:00:00.123456+08:00 ] Log(Info): message"
+  kPlainLine = 0,
+  // {"time":"2026-10-18T12:00:00.123456+08:00","level":"info",...}
+  kJsonLine,
+  // time=2026-10-18T12:00:00.123456+08:00 level=info ...
+  kLogfmtLine,
+};
+
+// A binary log file is the magic followed by entries of
+//   [uint8_t entry kind][uint32_t format id][uint32_t size][bytes]
+// where a format entry defines the id (its bytes are the format), and a record
+// entry carries the body of a record (the id 0 means no format). Ids are valid
+// within one file.
+constexpr char kBinaryLogMagic[8] = {'T', 'A', 'O', 'T', 'U', 'L', 'G', '1'};
+constexpr size_t kBinaryLogEntryHeaderByte =
+    sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+enum BinaryLogEntryKind : uint8_t {
+  kFormatEntry = 1,
+  kRecordEntry,
+};
+
+/**
+ * @brief "LogArgEncoder" keeps what is given to "printf()" in raw bytes, which
+ * are decoded by "LogLineFormatter" on the writer thread. Integers, floating
+ * points, C strings (copied, so they can be freed once logged) and other
+ * pointers are supported. An argument whose type doesn't fit its conversion
+ * is shown as "(?)", like a C string for "%p" (only its bytes are kept) or
+ * another pointer for "%s".
+ *
+ */
+template <typename T, typename Enable = void>
+struct LogArgEncoder {
+  static_assert(std::is_pointer<T>::value,
+                "Only what printf() takes can be logged!!!");
+  static size_t GetSize(T) { return sizeof(uint8_t) + sizeof(uint64_t); }
+  static char* Encode(T arg, char* position) {
+    auto value = reinterpret_cast<uint64_t>(arg);
+    *position = static_cast<char>(kPointerArg);
+    ::memcpy(position + 1, &value, sizeof(value));
+    return position + 1 + sizeof(value);
+  }
+};
+
+template <typename T>
+struct LogArgEncoder<
+    T, typename std::enable_if<std::is_integral<T>::value ||
+                               std::is_enum<T>::value>::type> {
+  static size_t GetSize(T) { return sizeof(uint8_t) + sizeof(uint64_t); }
+  static char* Encode(T arg, char* position) {
+    if (std::is_enum<T>::value || std::is_signed<T>::value) {
+      auto value = static_cast<int64_t>(arg);
+      *position = static_cast<char>(kSignedArg);
+      ::memcpy(position + 1, &value, sizeof(value));
+    } else {
+      auto value = static_cast<uint64_t>(arg);
+      *position = static_cast<char>(kUnsignedArg);
+      ::memcpy(position + 1, &value, sizeof(value));
+    }
+    return position + 1 + sizeof(uint64_t);
+  }
+};
+
+template <typename T>
+struct LogArgEncoder<
+    T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static size_t GetSize(T) { return sizeof(uint8_t) + sizeof(double); }
+  static char* Encode(T arg, char* position) {
+    auto value = static_cast<double>(arg);
+    *position = static_cast<char>(kDoubleArg);
+    ::memcpy(position + 1, &value, sizeof(value));
+    return position + 1 + sizeof(value);
+  }
+};
+
+// Encode a string of "length" bytes
+inline size_t GetEncodedStringSize(size_t length) {
+  return sizeof(uint8_t) + sizeof(uint32_t) + length + 1;
+}
+inline char* EncodeString(const char* str, size_t length, char* position) {
+  auto encoded_length = static_cast<uint32_t>(length);
+  *position = static_cast<char>(kStringArg);
+  ::memcpy(position + 1, &encoded_length, sizeof(encoded_length));
+  position += 1 + sizeof(encoded_length);
+  ::memcpy(position, str, length);
+  position[length] = '\0';
+  return position + length + 1;
+}
+
+template <>
+struct LogArgEncoder<const char*> {
+  static size_t GetSize(const char* arg) {
+    return GetEncodedStringSize(nullptr == arg ? 6 : ::strlen(arg));
+  }
+  static char* Encode(const char* arg, char* position) {
+    if (nullptr == arg) {
+      return EncodeString("(null)", 6, position);
+    }
+    return EncodeString(arg, ::strlen(arg), position);
+  }
+};
+template <>
+struct LogArgEncoder<char*> : LogArgEncoder<const char*> {};
+
+template <>
+struct LogArgEncoder<std::string> {
+  static size_t GetSize(const std::string& arg) {
+    return GetEncodedStringSize(arg.size());
+  }
+  static char* Encode(const std::string& arg, char* position) {
+    return EncodeString(arg.data(), arg.size(), position);
+  }
+};
+
+template <>
+struct LogArgEncoder<std::string_view> {
+  static size_t GetSize(std::string_view arg) {
+    return GetEncodedStringSize(arg.size());
+  }
+  static char* Encode(std::string_view arg, char* position) {
+    return EncodeString(arg.data(), arg.size(), position);
+  }
+};
+
+template <>
+struct LogArgEncoder<bool> {
+  static size_t GetSize(bool) { return sizeof(uint8_t) + sizeof(uint64_t); }
+  static char* Encode(bool arg, char* position) {
+    uint64_t value = arg ? 1 : 0;
+    *position = static_cast<char>(kBoolArg);
+    ::memcpy(position + 1, &value, sizeof(value));
+    return position + 1 + sizeof(value);
+  }
+};
+
+template <>
+struct LogArgEncoder<std::nullptr_t> {
+  static size_t GetSize(std::nullptr_t) {
+    return sizeof(uint8_t) + sizeof(uint64_t);
+  }
+  static char* Encode(std::nullptr_t, char* position) {
+    return LogArgEncoder<const void*>::Encode(nullptr, position);
+  }
+};
+
+// Write the header of a record
+inline char* EncodeLogRecordHeader(const char* format, int64_t time_us,
+                                   uint8_t level, uint8_t arg_amount,
+                                   char* position) {
+  ::memcpy(position, &format, sizeof(format));
+  position += sizeof(format);
+  ::memcpy(position, &time_us, sizeof(time_us));
+  position += sizeof(time_us);
+  *position++ = static_cast<char>(level);
+  *position++ = static_cast<char>(arg_amount);
+  return position;
+}
+
+/**
+ * @brief "LogLineFormatter" formats records into lines like
+ * "[ 2026-10-18T12:00:00.123456+08:00 ] Log(Info): message\n" (or JSON or
+ * logfmt lines). It walks the format and formats each conversion with its own
+ * argument, so it works on records from binary log files as well.
+ *
+ */
+class LogLineFormatter : NonCopyableMovable {
+ public:
+  explicit LogLineFormatter(LogLineStyle style = kPlainLine) : style_(style) {}
+
+  void SetStyle(LogLineStyle style) { style_ = style; }
+
+  // Append the line of the record (taken from a "LogRing")
+  void AppendLine(const char* record, size_t record_size, std::string* line);
+
+  // Append the line of the record body, whose format is given separately
+  // (nullptr for a plain message)
+  void AppendLine(const char* format, const char* body, size_t body_size,
+                  std::string* line);
+
+ private:
+  void AppendTime(int64_t time_us, std::string* line);
+
+  LogLineStyle style_;
+  // The message formatted before being escaped
+  std::string message_;
+};
+
+}  // namespace logger
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOG_RECORD_H_
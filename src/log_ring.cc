@@ -0,0 +1,105 @@
+/**
+ * @file log_ring.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LogRing" which is a bounded single-producer
+ * single-consumer ring of log records in bytes.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "log_ring.h"
+
+namespace taotu {
+namespace logger {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t size) {
+  size_t power = 64;
+  while (power < size) {
+    power <<= 1;
+  }
+  return power;
+}
+
+}  // namespace
+
+LogRing::LogRing(size_t capacity)
+    : LogRing(RoundUpToPowerOfTwo(capacity), nullptr, nullptr) {}
+
+LogRing::LogRing(size_t capacity, char* buffer, LogRingPositions* positions)
+    : buffer_(buffer),
+      capacity_(capacity),
+      mask_(capacity_ - 1),
+      positions_(positions),
+      head_(0),
+      cached_tail_(0),
+      reserved_head_(0),
+      discard_head_(0),
+      tail_(0),
+      drained_tail_(0),
+      discarded_amount_(0),
+      is_retired_(false) {
+  if (nullptr == buffer_) {
+    heap_buffer_.reset(new char[capacity_]);
+    buffer_ = heap_buffer_.get();
+  }
+  if (positions_ != nullptr) {
+    positions_->head.store(0, std::memory_order_relaxed);
+    positions_->tail.store(0, std::memory_order_release);
+  }
+}
+
+size_t LogRing::RoundCapacity(size_t capacity) {
+  return RoundUpToPowerOfTwo(capacity);
+}
+
+char* LogRing::Reserve(size_t size) {
+  size_t need = Align(kHeaderByte + size);
+  if (need > capacity_ || size >= kPaddingFlag) {
+    return nullptr;
+  }
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t offset = head & mask_;
+  size_t to_end = capacity_ - offset;
+  // A record never wraps, so the end of the buffer is skipped if too short
+  size_t total = need > to_end ? to_end + need : need;
+  if (capacity_ - (head - cached_tail_) < total) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (capacity_ - (head - cached_tail_) < total) {
+      return nullptr;
+    }
+  }
+  if (need > to_end) {
+    ::memcpy(buffer_ + offset, &kPaddingFlag, sizeof(kPaddingFlag));
+    head += to_end;
+  }
+  reserved_head_ = head;
+  return buffer_ + (head & mask_) + kHeaderByte;
+}
+
+bool LogRing::IsMostlyFull() {
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t limit = capacity_ - capacity_ / 4;
+  // The cached tail only makes the ring look fuller
+  if (head - cached_tail_ <= limit) {
+    return false;
+  }
+  cached_tail_ = tail_.load(std::memory_order_acquire);
+  return head - cached_tail_ > limit;
+}
+
+void LogRing::Commit(size_t size) {
+  auto header = static_cast<uint32_t>(size);
+  ::memcpy(buffer_ + (reserved_head_ & mask_), &header, sizeof(header));
+  size_t head = reserved_head_ + Align(kHeaderByte + size);
+  head_.store(head, std::memory_order_release);
+  if (positions_ != nullptr) {
+    positions_->head.store(head, std::memory_order_release);
+  }
+}
+
+}  // namespace logger
+}  // namespace taotu
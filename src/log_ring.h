@@ -0,0 +1,195 @@
+/**
+ * @file log_ring.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LogRing" which is a bounded single-producer
+ * single-consumer ring of log records in bytes.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOG_RING_H_
+#define TAOTU_SRC_LOG_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <memory>
+
+#include "non_copyable_movable.h"
+
+namespace taotu {
+namespace logger {
+
+// Positions of a ring copied where they outlive the process (like in a file
+// mapped in memory), so the records left can be found after a crash
+struct LogRingPositions {
+  std::atomic<uint64_t> head;
+  std::atomic<uint64_t> tail;
+};
+
+/**
+ * @brief "LogRing" belongs to one logging thread (the producer) and is drained
+ * by the writer thread of the logger (the consumer). Each record is kept in
+ * one contiguous piece led by its size, so it is written in place by the
+ * producer and read in place by the consumer without any copy or lock.
+ *
+ */
+class LogRing : NonCopyableMovable {
+ public:
+  // Rounded up to a power of two
+  explicit LogRing(size_t capacity);
+
+  // Keep records in "buffer" of "capacity" bytes (a power of two) with the
+  // positions copied into "positions", where room is given back only by
+  // "ReleaseDrained()"
+  LogRing(size_t capacity, char* buffer, LogRingPositions* positions);
+
+  // The capacity of a ring asked for "capacity" bytes
+  static size_t RoundCapacity(size_t capacity);
+
+  // (Producer) Reserve room for a record of at most "size" bytes, nullptr if
+  // the ring is too full (nothing is published until "Commit()")
+  char* Reserve(size_t size);
+
+  // (Producer) Publish the record reserved, whose real size is "size" (no more
+  // than the reserved one)
+  void Commit(size_t size);
+
+  // (Consumer) Hand each published record to "handle(const char*, size_t)"
+  // in order, return how many are handed
+  template <typename Handle>
+  size_t Drain(Handle&& handle) {
+    size_t tail = drained_tail_;
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t discard_head = discard_head_.load(std::memory_order_acquire);
+    size_t amount = 0;
+    while (tail != head) {
+      size_t offset = tail & mask_;
+      uint32_t header;
+      ::memcpy(&header, buffer_ + offset, sizeof(header));
+      if ((header & kPaddingFlag) != 0) {
+        tail += capacity_ - offset;  // Skip the end of the buffer
+      } else {
+        if (tail < discard_head) {
+          ++discarded_amount_;
+        } else {
+          const char* record = buffer_ + offset + kHeaderByte;
+          handle(record, static_cast<size_t>(header));
+          ++amount;
+        }
+        tail += Align(kHeaderByte + header);
+      }
+      drained_tail_ = tail;
+      if (nullptr == positions_) {
+        // Give the room back at once
+        tail_.store(tail, std::memory_order_release);
+      }
+    }
+    return amount;
+  }
+
+  // (Consumer) Give back the room of the records drained, which have been
+  // written down (only needed for a ring with its positions copied)
+  void ReleaseDrained() {
+    if (positions_ != nullptr) {
+      tail_.store(drained_tail_, std::memory_order_release);
+      positions_->tail.store(drained_tail_, std::memory_order_release);
+    }
+  }
+
+  // Hand each record between "tail" and "head" in "buffer" (of a ring of
+  // "capacity" bytes) to "handle(const char*, size_t)" in order, false if
+  // the records are broken (like those of a crashed process)
+  template <typename Handle>
+  static bool ForEachRecord(const char* buffer, size_t capacity,
+                            uint64_t tail, uint64_t head, Handle&& handle) {
+    if (head < tail || head - tail > capacity) {
+      return false;
+    }
+    size_t mask = capacity - 1;
+    while (tail != head) {
+      size_t offset = tail & mask;
+      uint32_t header;
+      ::memcpy(&header, buffer + offset, sizeof(header));
+      size_t size = (header & kPaddingFlag) != 0
+                        ? capacity - offset
+                        : Align(kHeaderByte + header);
+      if (size > head - tail || size > capacity - offset) {
+        return false;
+      }
+      if (0 == (header & kPaddingFlag)) {
+        handle(buffer + offset + kHeaderByte, static_cast<size_t>(header));
+      }
+      tail += size;
+    }
+    return true;
+  }
+
+  // (Producer) Ask the consumer to discard the records published so far
+  // instead of handing them, which makes room faster
+  void RequestDiscard() {
+    discard_head_.store(head_.load(std::memory_order_relaxed),
+                        std::memory_order_release);
+  }
+
+  // (Producer) Whether more than 3/4 of the ring is used
+  bool IsMostlyFull();
+
+  // (Consumer) Return how many records are discarded since the last call
+  size_t TakeDiscardedAmount() {
+    size_t discarded_amount = discarded_amount_;
+    discarded_amount_ = 0;
+    return discarded_amount;
+  }
+
+  bool IsEmpty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  size_t GetCapacity() const { return capacity_; }
+
+  // The producer thread has exited, so the ring can go once drained
+  void Retire() { is_retired_.store(true, std::memory_order_release); }
+  bool IsRetired() const {
+    return is_retired_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr uint32_t kPaddingFlag = 0x80000000U;
+  static constexpr size_t kHeaderByte = sizeof(uint32_t);
+
+  // Records are aligned so that headers never cross the end of the buffer
+  static size_t Align(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+  }
+
+  std::unique_ptr<char[]> heap_buffer_;
+  char* buffer_;
+  size_t capacity_;
+  size_t mask_;
+  // nullptr if the positions are not copied
+  LogRingPositions* positions_;
+
+  // Written by the producer
+  alignas(64) std::atomic<size_t> head_;
+  size_t cached_tail_;
+  size_t reserved_head_;
+  std::atomic<size_t> discard_head_;
+
+  // Written by the consumer
+  alignas(64) std::atomic<size_t> tail_;
+  size_t drained_tail_;
+  size_t discarded_amount_;
+
+  std::atomic<bool> is_retired_;
+};
+
+}  // namespace logger
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOG_RING_H_
@@ -0,0 +1,249 @@
+/**
+ * @file log_rotator.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LogRotator" which rotates log files by size
+ * and time, and compresses and removes the rotated ones in the background.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "log_rotator.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "log_clock.h"
+
+namespace taotu {
+namespace logger {
+
+namespace {
+
+constexpr size_t kCompressChunkByte = 256 * 1024;
+
+// For "ioprio_set()" (no wrapper in glibc)
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioIdle = 3 << 13;
+
+// Errors are printed instead of logged, since it is the logger that fails
+void PrintError(const char* what, const std::string& file_name) {
+  ::fprintf(stderr, "Log rotator: %s %s failed: %s\n", what,
+            file_name.c_str(), ::strerror(errno));
+}
+
+int64_t GetFileByte(const std::string& file_name) {
+  struct stat file_stat;
+  if (::stat(file_name.c_str(), &file_stat) != 0) {
+    return 0;
+  }
+  return static_cast<int64_t>(file_stat.st_size);
+}
+
+bool DoesFileExist(const std::string& file_name) {
+  return ::access(file_name.c_str(), F_OK) == 0;
+}
+
+}  // namespace
+
+LogRotator::LogRotator() : next_rotate_time_(0), is_stopping_(false) {}
+
+LogRotator::~LogRotator() { Stop(); }
+
+void LogRotator::Start(const std::string& file_name,
+                       const LogRotateOptions& options) {
+  Stop();
+  file_name_ = file_name;
+  options_ = options;
+  is_stopping_ = false;
+  // Rotated files kept before, in the order of their timestamps
+  size_t slash_pos = file_name_.rfind('/');
+  std::string path_prefix = std::string::npos == slash_pos
+                                ? std::string{}
+                                : file_name_.substr(0, slash_pos + 1);
+  std::string name_prefix{file_name_.substr(path_prefix.size()) + "."};
+  std::vector<std::string> rotated_names;
+  DIR* dir = ::opendir(path_prefix.empty() ? "." : path_prefix.c_str());
+  if (dir != nullptr) {
+    while (struct dirent* entry = ::readdir(dir)) {
+      std::string name{entry->d_name};
+      if (name.size() > name_prefix.size() &&
+          name.compare(0, name_prefix.size(), name_prefix) == 0 &&
+          ::isdigit(static_cast<unsigned char>(name[name_prefix.size()]))) {
+        rotated_names.push_back(path_prefix + name);
+      }
+    }
+    ::closedir(dir);
+  }
+  std::sort(rotated_names.begin(), rotated_names.end());
+  rotated_files_.clear();
+  for (const auto& rotated_name : rotated_names) {
+    if (rotated_name.size() > 4 &&
+        rotated_name.compare(rotated_name.size() - 4, 4, ".tmp") == 0) {
+      // Left by compressing when the last run exited
+      ::unlink(rotated_name.c_str());
+      continue;
+    }
+    rotated_files_.emplace_back(rotated_name, GetFileByte(rotated_name));
+  }
+  // Keep what the last run wrote instead of truncating it
+  struct stat file_stat;
+  if (::stat(file_name_.c_str(), &file_stat) == 0 && file_stat.st_size > 0) {
+    Rotate(static_cast<int64_t>(file_stat.st_mtime) * 1000000);
+  }
+  ComputeNextRotateTime(LogClock::Now());
+  thread_ = std::thread([this]() { this->DoBackgroundWork(); });
+}
+
+void LogRotator::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  cond_var_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void LogRotator::Rotate(int64_t time_us) {
+  ComputeNextRotateTime(time_us);
+  auto second = static_cast<time_t>(time_us / 1000000);
+  struct tm tmp_tm;
+  ::localtime_r(&second, &tmp_tm);
+  char stamp[32];
+  ::strftime(stamp, sizeof(stamp), ".%Y%m%d-%H%M%S", &tmp_tm);
+  std::string rotated_name{file_name_ + stamp};
+  // Rotated more than once in one second
+  for (int i = 1;
+       DoesFileExist(rotated_name) || DoesFileExist(rotated_name + ".gz");
+       ++i) {
+    rotated_name = file_name_ + stamp + "." + std::to_string(i);
+  }
+  if (::rename(file_name_.c_str(), rotated_name.c_str()) != 0) {
+    PrintError("Renaming", file_name_);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_files_.push_back(std::move(rotated_name));
+  }
+  cond_var_.notify_one();
+}
+
+void LogRotator::DoBackgroundWork() {
+  // The lowest priority of CPU and IO, for this thread only
+  auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+  ::setpriority(PRIO_PROCESS, tid, 19);
+  ::syscall(SYS_ioprio_set, kIoprioWhoProcess, static_cast<int>(tid),
+            kIoprioIdle);
+  RemoveOldFiles();
+  while (true) {
+    std::string rotated_name;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_var_.wait(lock, [this]() {
+        return this->is_stopping_ || !this->pending_files_.empty();
+      });
+      if (pending_files_.empty()) {
+        break;  // Stopping with nothing left
+      }
+      rotated_name = std::move(pending_files_.front());
+      pending_files_.pop_front();
+    }
+    std::string kept_name =
+        options_.should_compress ? Compress(rotated_name) : rotated_name;
+    rotated_files_.emplace_back(kept_name, GetFileByte(kept_name));
+    RemoveOldFiles();
+  }
+}
+
+std::string LogRotator::Compress(const std::string& rotated_name) {
+  std::string compressed_name{rotated_name + ".gz"};
+  std::string tmp_name{compressed_name + ".tmp"};
+  int fd = ::open(rotated_name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    PrintError("Opening", rotated_name);
+    return rotated_name;
+  }
+  gzFile gz_file = ::gzopen(tmp_name.c_str(), "wb");
+  if (nullptr == gz_file) {
+    PrintError("Opening", tmp_name);
+    ::close(fd);
+    return rotated_name;
+  }
+  std::vector<char> chunk(kCompressChunkByte);
+  bool is_ok = true;
+  while (true) {
+    ssize_t n = ::read(fd, chunk.data(), chunk.size());
+    if (n < 0 && EINTR == errno) {
+      continue;
+    }
+    if (n <= 0) {
+      is_ok = 0 == n;
+      break;
+    }
+    if (::gzwrite(gz_file, chunk.data(), static_cast<unsigned>(n)) != n) {
+      is_ok = false;
+      break;
+    }
+  }
+  ::close(fd);
+  is_ok = Z_OK == ::gzclose(gz_file) && is_ok;
+  if (!is_ok || ::rename(tmp_name.c_str(), compressed_name.c_str()) != 0) {
+    PrintError("Compressing", rotated_name);
+    ::unlink(tmp_name.c_str());
+    return rotated_name;
+  }
+  ::unlink(rotated_name.c_str());
+  return compressed_name;
+}
+
+void LogRotator::RemoveOldFiles() {
+  int64_t total_byte = 0;
+  for (const auto& rotated_file : rotated_files_) {
+    total_byte += rotated_file.second;
+  }
+  while (!rotated_files_.empty() &&
+         (rotated_files_.size() > options_.retained_file_amount ||
+          (options_.max_total_byte > 0 &&
+           total_byte > options_.max_total_byte))) {
+    ::unlink(rotated_files_.front().first.c_str());
+    total_byte -= rotated_files_.front().second;
+    rotated_files_.pop_front();
+  }
+}
+
+void LogRotator::ComputeNextRotateTime(int64_t time_us) {
+  if (options_.interval_seconds <= 0) {
+    next_rotate_time_ = 0;
+    return;
+  }
+  // Boundaries are of the local time, like midnight for 86400
+  auto second = static_cast<time_t>(time_us / 1000000);
+  struct tm tmp_tm;
+  ::localtime_r(&second, &tmp_tm);
+  int64_t local_second = static_cast<int64_t>(second) + tmp_tm.tm_gmtoff;
+  int64_t next_second =
+      (local_second / options_.interval_seconds + 1) *
+          options_.interval_seconds -
+      tmp_tm.tm_gmtoff;
+  next_rotate_time_ = next_second * 1000000;
+}
+
+}  // namespace logger
+}  // namespace taotu
@@ -0,0 +1,110 @@
+/**
+ * @file log_rotator.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LogRotator" which rotates log files by size
+ * and time, and compresses and removes the rotated ones in the background.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOG_ROTATOR_H_
+#define TAOTU_SRC_LOG_ROTATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "non_copyable_movable.h"
+
+namespace taotu {
+namespace logger {
+
+constexpr int64_t kLogFileMaxByte = 1024 * 1024 * 1024;  // 1GiB
+
+struct LogRotateOptions {
+  // Rotate once the file reaches the size (0 for never)
+  int64_t max_file_byte = kLogFileMaxByte / 2;
+  // Rotate at each boundary of the interval of the local wall clock, like
+  // 3600 for on the hour (0 for never)
+  int64_t interval_seconds = 0;
+  // Rotated files kept (the oldest ones are removed beyond)
+  size_t retained_file_amount = 8;
+  // Cap of the bytes of all rotated files kept (0 for no cap)
+  int64_t max_total_byte = 0;
+  // Compress rotated files into ".gz" files
+  bool should_compress = true;
+};
+
+/**
+ * @brief "LogRotator" is driven by the writer thread of the logger. The
+ * active file always has the name given, and a rotated file is renamed like
+ * "log.txt.20261018-120000" (".gz" once compressed). Compressing and removing
+ * files are done by a background thread of the lowest CPU and IO priority,
+ * never by the writer thread.
+ *
+ */
+class LogRotator : NonCopyableMovable {
+ public:
+  LogRotator();
+  ~LogRotator();
+
+  // Take the rotated files of the active file kept before, and rotate the
+  // active file left by the last run if it is not empty (called before the
+  // active file is opened)
+  void Start(const std::string& file_name, const LogRotateOptions& options);
+
+  // Wait for the background work left, then stop the background thread
+  void Stop();
+
+  // Whether the active file should be rotated before writing a record of the
+  // time (in microseconds)
+  bool ShouldRotate(int64_t file_byte, int64_t time_us) const {
+    return (options_.max_file_byte > 0 &&
+            file_byte >= options_.max_file_byte) ||
+           (next_rotate_time_ > 0 && time_us >= next_rotate_time_);
+  }
+
+  // Rename the active file (closed already) by the time, and hand it to the
+  // background thread
+  void Rotate(int64_t time_us);
+
+ private:
+  // Loop of the background thread
+  void DoBackgroundWork();
+
+  // Return the name of the file kept
+  std::string Compress(const std::string& rotated_name);
+
+  // Remove the oldest files beyond the amount or the cap
+  void RemoveOldFiles();
+
+  void ComputeNextRotateTime(int64_t time_us);
+
+  std::string file_name_;
+  LogRotateOptions options_;
+  int64_t next_rotate_time_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  // Files rotated but not handled by the background thread yet
+  std::deque<std::string> pending_files_;
+  bool is_stopping_;
+  std::thread thread_;
+
+  // Files kept from the oldest, with their sizes (used by the background
+  // thread only once started)
+  std::deque<std::pair<std::string, int64_t>> rotated_files_;
+};
+
+}  // namespace logger
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOG_ROTATOR_H_
@@ -11,30 +11,178 @@
 
 #include "logger.h"
 
-#include <functional>
+#include <ctype.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
 #include <utility>
 
+#include "log_clock.h"
+
 namespace taotu {
 namespace logger {
 
+namespace {
+
+#ifdef TAOTU_DEBUG
+constexpr int kDefaultLevel = kDebug;
+#else
+constexpr int kDefaultLevel = kInfo;
+#endif  // TAOTU_DEBUG
+
+}  // namespace
+
 std::atomic<bool> Logger::is_initialized{false};
+// Set when compiling, so logs before "main()" see them too
+std::atomic<int> Logger::min_levels[kLogCategoryAmount]{
+    kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel,
+    kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel,
+    kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel,
+    kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel,
+    kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel,
+    kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel, kDefaultLevel,
+    kDefaultLevel, kDefaultLevel,
+};
+static_assert(kLogCategoryAmount == 32, "Levels have to be all given!!!");
+std::atomic<bool> Logger::is_reload_requested{false};
+
+namespace {
+
+// Retire the ring when its thread exits
+struct ThreadRing {
+  ~ThreadRing() {
+    if (ring != nullptr) {
+      ring->Retire();
+    }
+  }
+  std::shared_ptr<LogRing> ring;
+};
+
+void AppendBinaryEntry(BinaryLogEntryKind kind, uint32_t format_id,
+                       const char* bytes, size_t size, std::string* entry) {
+  auto entry_size = static_cast<uint32_t>(size);
+  entry->push_back(static_cast<char>(kind));
+  entry->append(reinterpret_cast<const char*>(&format_id), sizeof(format_id));
+  entry->append(reinterpret_cast<const char*>(&entry_size),
+                sizeof(entry_size));
+  entry->append(bytes, size);
+}
+
+// The writer thread wakes up for flushing at least so often
+constexpr auto kWriterWaitTime = std::chrono::milliseconds(100);
+
+// How often to retry reserving when waiting for room
+constexpr auto kOverloadRetryTime = std::chrono::microseconds(50);
+
+// Dropped records are reported at most once in each interval
+constexpr int64_t kDropReportMicroseconds = 1000000;
+constexpr char kDropReportFormat[] =
+    "%llu log records are dropped since the last report (overloaded)";
+
+// Records of this thread met when sampling
+thread_local uint64_t thread_sampled_amount = 0;
+
+// The level file is checked at most once in each interval
+constexpr int64_t kLevelCheckMicroseconds = 1000000;
+constexpr char kLevelReloadFormat[] = "Log levels are set to \"%s\"";
+constexpr char kLevelErrorFormat[] = "Some log levels in %s are not understood";
+
+// Names of categories, in order of "LogCategory"
+struct CategoryNames {
+  std::mutex mutex;
+  std::vector<std::string> names{"general", "poller", "connection",
+                                 "acceptor", "rpc",    "timer"};
+};
+CategoryNames& GetCategoryNames() {
+  static CategoryNames category_names;
+  return category_names;
+}
+
+// Names of levels, in order of "LogLevel"
+const char* const kLevelNames[]{
+    "emerg", "alert", "crit", "error", "warn", "notice", "info", "debug",
+};
+
+// Other names of levels taken
+const struct {
+  const char* name;
+  LogLevel log_level;
+} kLevelAliases[]{
+    {"emergency", kEmerg}, {"critical", kCrit}, {"err", kError},
+    {"warning", kWarn},
+};
+
+void TrimSpaces(std::string* text) {
+  size_t begin = 0;
+  while (begin < text->size() && ::isspace((*text)[begin])) {
+    ++begin;
+  }
+  size_t end = text->size();
+  while (end > begin && ::isspace((*text)[end - 1])) {
+    --end;
+  }
+  *text = text->substr(begin, end - begin);
+}
+
+// Take a name (or the number) of "LogLevel", false if it is not one
+bool ParseLevel(std::string text, LogLevel* log_level) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](char c) { return static_cast<char>(::tolower(c)); });
+  if (1 == text.size() && text[0] >= '0' && text[0] <= '0' + kDebug) {
+    *log_level = static_cast<LogLevel>(text[0] - '0');
+    return true;
+  }
+  for (int level = kEmerg; level <= kDebug; ++level) {
+    if (text == kLevelNames[level]) {
+      *log_level = static_cast<LogLevel>(level);
+      return true;
+    }
+  }
+  for (const auto& level_alias : kLevelAliases) {
+    if (text == level_alias.name) {
+      *log_level = level_alias.log_level;
+      return true;
+    }
+  }
+  return false;
+}
 
-Logger* Logger::GetLogger(bool should_start) {
-  // The unique actual "Logger" object
-  static Logger logger;
-  if (should_start) {
-    logger.StartLogger(kLogName);
+int64_t GetModifyTime(const std::string& file_name) {
+  struct stat file_stat;
+  if (::stat(file_name.c_str(), &file_stat) != 0) {
+    return -1;
   }
-  return &logger;
+  return static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000000 +
+         file_stat.st_mtim.tv_nsec;
 }
 
+}  // namespace
+
 void Logger::EndLogger() {
-  is_stopping_.store(true, std::memory_order_release);
-  log_cond_var_.notify_one();
+  {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    is_stopping_.store(true, std::memory_order_release);
+    log_cond_var_.notify_one();
+  }
   if (thread_.joinable()) {
     thread_.join();
   }
-  ::fclose(log_file_);
+  if (installed_reload_signal_ != 0) {
+    ::sigaction(installed_reload_signal_, &old_reload_action_, nullptr);
+    installed_reload_signal_ = 0;
+  }
+  log_file_.Close();
+  log_rotator_.Stop();
+  if (crash_file_ != nullptr) {
+    crash_file_->MarkClosed();
+  }
   is_initialized.store(false, std::memory_order_release);
 }
 
@@ -46,184 +194,463 @@ void Logger::StartLogger(std::string&& log_file_name) {
     std::lock_guard<std::mutex> lock(log_mutex_);
     if (!is_initialized.load(std::memory_order_acquire)) {
       is_stopping_.store(false, std::memory_order_release);
-      write_index_.store(0, std::memory_order_relaxed);
-      read_index_.store(0, std::memory_order_relaxed);
-      pending_.store(0, std::memory_order_relaxed);
-      for (size_t i = 0; i < kLogBufferSize; ++i) {
-        log_buffer_[i].seq.store(i, std::memory_order_relaxed);
-        log_buffer_[i].data.clear();
+      OpenCrashFile();
+      if (reload_signal_ != 0 && !level_file_name_.empty()) {
+        struct sigaction reload_action;
+        ::memset(&reload_action, 0, sizeof(reload_action));
+        reload_action.sa_handler = &Logger::HandleReloadSignal;
+        reload_action.sa_flags = SA_RESTART;
+        ::sigemptyset(&reload_action.sa_mask);
+        if (0 == ::sigaction(reload_signal_, &reload_action,
+                             &old_reload_action_)) {
+          installed_reload_signal_ = reload_signal_;
+        }
       }
       log_file_name_ = log_file_name;
       // Use the name of the log tile given by the project instead of the
       // unavailable one given by user
+      if (!log_file_name_.empty()) {
+        log_rotator_.Start(log_file_name_, rotate_options_);
+      }
       if (log_file_name_.empty() ||
-          ((log_file_ = ::fopen(log_file_name_.c_str(), "wb")) == NULL)) {
+          !log_file_.Open(log_file_name_, write_options_)) {
         log_file_name_ = kLogName;
-        log_file_ =
-            ::fopen(std::string{"n" + std::to_string(cur_log_file_seq_ & 1) +
-                                "_" + log_file_name_}
-                        .c_str(),
-                    "wb");
+        log_rotator_.Start(log_file_name_, rotate_options_);
+        log_file_.Open(log_file_name_, write_options_);
       }
-      std::string file_header{"Current file sequence: 0\n"};
-      ::fwrite(file_header.c_str(), file_header.size(), 1, log_file_);
-      ::fflush(log_file_);
+      cur_file_format_ = file_format_;
+      line_formatter_.SetStyle(kJsonFile == cur_file_format_     ? kJsonLine
+                               : kLogfmtFile == cur_file_format_ ? kLogfmtLine
+                                                                 : kPlainLine);
+      WriteFileHeader();
+      ReloadLevels(true);
+      log_file_.Flush();
       is_initialized.store(true, std::memory_order_release);
       thread_ = std::thread([this]() { this->WriteDownLogs(); });
     }
   }
-  UpdateLoggerTime();
 }
 
-void Logger::RecordLogs(LogLevel log_type, const std::string& log_info) {
-  RecordLogs(Log_level_info_prefix[log_type] + log_info);
-}
-void Logger::RecordLogs(LogLevel log_type, std::string&& log_info) {
-  RecordLogs(Log_level_info_prefix[log_type] + log_info);
+void Logger::OpenCrashFile() {
+  if (crash_file_ != nullptr) {
+    crash_file_->MarkRunning();
+  } else if (!crash_file_name_.empty()) {
+    auto crash_file = std::make_shared<LogCrashFile>();
+    if (crash_file->Open(crash_file_name_,
+                         ring_byte_.load(std::memory_order_relaxed),
+                         crash_thread_amount_)) {
+      crash_file->CatchFatalSignals();
+      crash_file_ = std::move(crash_file);
+    }
+  }
+  if (crash_file_ != nullptr) {
+    // The tail less than 4 KiB would wait in memory
+    write_options_.is_direct = false;
+  }
 }
 
-std::string Logger::UpdateLoggerTime() {
-  time_t tmp_time;
-  ::time(&tmp_time);
-  std::lock_guard<std::mutex> lock(time_mutex_);
-  if (tmp_time > time_now_sec_) {
-    time_now_sec_ = tmp_time;
-    // In consideration of time zone
-    struct tm* tmp_tm = ::localtime(&tmp_time);
-    std::string tmp_time_now_str(::asctime(tmp_tm));
-    tmp_time_now_str.resize(tmp_time_now_str.size() - 1);
-    time_now_str_ = "[ " + tmp_time_now_str + " ]";
+void Logger::RecordLogs(LogLevel log_type, const std::string& log_info) {
+  size_t args_size = GetEncodedStringSize(log_info.size());
+  LogRing* ring = nullptr;
+  char* position = BeginRecord(log_type, nullptr, 1, args_size, false, &ring);
+  if (nullptr == position) {
+    return;
   }
-  return time_now_str_;
+  EncodeString(log_info.c_str(), log_info.size(), position);
+  EndRecord(ring, kLogRecordHeaderByte + args_size);
 }
 
 void Logger::WriteDownLogs() {
+  // The writer thread keeps its own copy of the set of rings
+  std::vector<std::shared_ptr<LogRing>> rings;
+  size_t rings_version = static_cast<size_t>(-1);
   // Loop for flushing io buffer into disk
-  while (!is_stopping_.load(std::memory_order_acquire) ||
-         pending_.load(std::memory_order_acquire) != 0) {
-    // Drain available logs.
-    std::string tmp_buf;
-    while (Dequeue(&tmp_buf)) {
-      // Change the log file to new one when the old is full (Always only
-      // 2 log files in circulation)
-      if (cur_log_file_byte_ >= kStandardLogFileByte) {
-        ::fflush(log_file_);
-        ::fclose(log_file_);
-        ++cur_log_file_seq_;
-        log_file_ =
-            ::fopen(std::string{"n" + std::to_string(cur_log_file_seq_ & 1) +
-                                "_" + log_file_name_}
-                        .c_str(),
-                    "wb");
-        cur_log_file_byte_ = 0;
-        std::string file_header{"Current file sequence: " +
-                                std::to_string(cur_log_file_seq_) + "\n"};
-        ::fwrite(file_header.c_str(), file_header.size(), 1, log_file_);
-      }
-      size_t tmp_buf_len = tmp_buf.size();
-      ::fwrite(tmp_buf.c_str(), tmp_buf_len, 1, log_file_);
-      cur_log_file_byte_ += static_cast<int64_t>(tmp_buf_len);
-      tmp_buf.clear();
-    }
-    // Flush into disk (the status of ring buffer may change because of
-    // spending much time here)
-    ::fflush(log_file_);
-    // Block when the buffer is empty
-    if (pending_.load(std::memory_order_acquire) == 0) {
-      std::unique_lock<std::mutex> lock(log_mutex_);
-      if (!is_stopping_.load(std::memory_order_acquire) &&
-          pending_.load(std::memory_order_acquire) == 0) {
-        log_cond_var_.wait(lock);
+  while (true) {
+    bool is_stopping = is_stopping_.load(std::memory_order_acquire);
+    size_t amount = DrainRings(&rings, &rings_version);
+    ReportDroppedRecords(is_stopping);
+    ReloadLevels(false);
+    if (crash_file_ != nullptr) {
+      // Records drained are kept in rings until written
+      log_file_.Flush();
+      log_file_.WaitFlushed();
+      for (const auto& ring : rings) {
+        ring->ReleaseDrained();
       }
     }
+    if (amount > 0 && !is_stopping) {
+      continue;
+    }
+    // Start writing the batch once all rings are empty
+    log_file_.Flush();
+    if (is_stopping) {
+      // Records got before "EndLogger()" are all written down now
+      break;
+    }
+    // Block when all rings are empty ("EndRecord()" checks the flag after
+    // publishing, so either the records are seen here or it notifies)
+    std::unique_lock<std::mutex> lock(log_mutex_);
+    is_writer_sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool is_empty = true;
+    for (const auto& ring : rings) {
+      is_empty = is_empty && ring->IsEmpty();
+    }
+    if (is_empty &&
+        rings_version == rings_version_.load(std::memory_order_acquire) &&
+        !is_stopping_.load(std::memory_order_acquire)) {
+      log_cond_var_.wait_for(lock, kWriterWaitTime);
+    }
+    is_writer_sleeping_.store(false, std::memory_order_relaxed);
   }
 }
 
-void Logger::RecordLogs(const char* log_info) {
-  RecordLogs(std::string(log_info));
-}
-void Logger::RecordLogs(const std::string& log_info) {
-  RecordLogs(std::move(const_cast<std::string&>(log_info)));
-}
-
-void Logger::RecordLogs(std::string&& log_info) {
-  // Splice this log record
-  std::string time_now_str{UpdateLoggerTime()};
-  std::string log_data(time_now_str.size() + log_info.size() + 2, ' ');
-  ::memcpy(reinterpret_cast<void*>(const_cast<char*>(log_data.c_str())),
-           time_now_str.c_str(), time_now_str.size());
-  ::memcpy(reinterpret_cast<void*>(const_cast<char*>(log_data.c_str()) +
-                                   time_now_str.size() + 1),
-           log_info.c_str(), log_info.size());
-  log_data.back() = '\n';
-  // Put this log record into ring buffer (drop if full)
-  (void)Enqueue(std::move(log_data));
-}
-
-bool Logger::Enqueue(std::string&& log_data) {
-  size_t pos = write_index_.load(std::memory_order_relaxed);
-  for (;;) {
-    LogSlot& slot = log_buffer_[pos & kLogBufferMask];
-    size_t seq = slot.seq.load(std::memory_order_acquire);
-    intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
-    if (diff == 0) {
-      if (write_index_.compare_exchange_weak(pos, pos + 1,
-                                             std::memory_order_relaxed)) {
-        slot.data = std::move(log_data);
-        slot.seq.store(pos + 1, std::memory_order_release);
-        size_t prev = pending_.fetch_add(1, std::memory_order_release);
-        if (prev == 0) {
-          std::lock_guard<std::mutex> lock(log_mutex_);
-          log_cond_var_.notify_one();
-        }
-        return true;
-      }
-    } else if (diff < 0) {
-      return false;  // queue full, drop log
-    } else {
-      pos = write_index_.load(std::memory_order_relaxed);
+size_t Logger::DrainRings(std::vector<std::shared_ptr<LogRing>>* rings,
+                          size_t* rings_version) {
+  size_t latest_version = rings_version_.load(std::memory_order_acquire);
+  if (latest_version != *rings_version) {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    *rings = rings_;
+    *rings_version = rings_version_.load(std::memory_order_relaxed);
+  }
+  size_t amount = 0;
+  bool has_drained_retired = false;
+  for (const auto& ring : *rings) {
+    // Check before draining, so no record of a retired ring is left behind
+    bool is_retired = ring->IsRetired();
+    amount += ring->Drain([this](const char* record, size_t record_size) {
+      this->WriteDownRecord(record, record_size);
+    });
+    discarded_amount_ += ring->TakeDiscardedAmount();
+    has_drained_retired = has_drained_retired || is_retired;
+  }
+  if (has_drained_retired) {
+    // Rings of exited threads go once drained
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    auto itr = std::remove_if(rings_.begin(), rings_.end(),
+                              [](const std::shared_ptr<LogRing>& ring) {
+                                return ring->IsRetired() && ring->IsEmpty();
+                              });
+    if (itr != rings_.end()) {
+      rings_.erase(itr, rings_.end());
+      rings_version_.fetch_add(1, std::memory_order_release);
     }
   }
+  return amount;
 }
 
-bool Logger::Dequeue(std::string* out) {
-  size_t pos = read_index_.load(std::memory_order_relaxed);
-  for (;;) {
-    LogSlot& slot = log_buffer_[pos & kLogBufferMask];
-    size_t seq = slot.seq.load(std::memory_order_acquire);
-    intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
-    if (diff == 0) {
-      if (read_index_.compare_exchange_weak(pos, pos + 1,
-                                            std::memory_order_relaxed)) {
-        out->swap(slot.data);
-        slot.data.clear();
-        slot.seq.store(pos + kLogBufferSize, std::memory_order_release);
-        pending_.fetch_sub(1, std::memory_order_release);
-        return true;
+void Logger::WriteDownRecord(const char* record, size_t record_size) {
+  int64_t time_us = 0;
+  ::memcpy(&time_us, record + kLogRecordFormatByte, sizeof(time_us));
+  if (log_rotator_.ShouldRotate(cur_log_file_byte_, time_us)) {
+    log_file_.Close();
+    log_rotator_.Rotate(time_us);
+    ++cur_log_file_seq_;
+    log_file_.Open(log_file_name_, write_options_);
+    cur_log_file_byte_ = 0;
+    WriteFileHeader();
+  }
+  line_.clear();
+  if (kBinaryFile == cur_file_format_) {
+    // Keep the body as it is, with the format written once for each file
+    const char* format = nullptr;
+    ::memcpy(&format, record, sizeof(format));
+    uint32_t format_id = 0;
+    if (format != nullptr) {
+      auto itr = format_ids_.find(format);
+      if (itr == format_ids_.end()) {
+        format_id = static_cast<uint32_t>(format_ids_.size() + 1);
+        format_ids_[format] = format_id;
+        AppendBinaryEntry(kFormatEntry, format_id, format, ::strlen(format),
+                          &line_);
+      } else {
+        format_id = itr->second;
       }
-    } else if (diff < 0) {
-      return false;  // queue empty
+    }
+    AppendBinaryEntry(kRecordEntry, format_id, record + kLogRecordFormatByte,
+                      record_size - kLogRecordFormatByte, &line_);
+  } else {
+    line_formatter_.AppendLine(record, record_size, &line_);
+  }
+  log_file_.Append(line_.c_str(), line_.size());
+  cur_log_file_byte_ += static_cast<int64_t>(line_.size());
+}
+
+void Logger::WriteFileHeader() {
+  if (kBinaryFile == cur_file_format_) {
+    format_ids_.clear();
+    log_file_.Append(kBinaryLogMagic, sizeof(kBinaryLogMagic));
+    return;
+  }
+  if (cur_file_format_ != kTextFile) {
+    return;  // Every line is for machines
+  }
+  std::string file_header{"Current file sequence: " +
+                          std::to_string(cur_log_file_seq_) + "\n"};
+  log_file_.Append(file_header.c_str(), file_header.size());
+}
+
+LogRing* Logger::GetThreadRing() {
+  thread_local ThreadRing thread_ring;
+  if (nullptr == thread_ring.ring) {
+    if (crash_file_ != nullptr) {
+      thread_ring.ring = crash_file_->CreateRing();
+      LogCrashFile::SetUpSignalStack();
+    }
+    if (nullptr == thread_ring.ring) {
+      thread_ring.ring = std::make_shared<LogRing>(
+          ring_byte_.load(std::memory_order_relaxed));
+    }
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings_.push_back(thread_ring.ring);
+    rings_version_.fetch_add(1, std::memory_order_release);
+  }
+  return thread_ring.ring.get();
+}
+
+char* Logger::BeginRecord(LogLevel log_type, const char* format,
+                          uint8_t arg_amount, size_t args_size,
+                          bool is_key_value, LogRing** ring) {
+  int64_t time_us = LogClock::Now();
+  *ring = GetThreadRing();
+  if (crash_file_ != nullptr && format != nullptr) {
+    crash_file_->KeepFormat(format);
+  }
+  size_t record_size = kLogRecordHeaderByte + args_size;
+  auto policy = static_cast<LogOverloadPolicy>(
+      overload_policies_[log_type].load(std::memory_order_relaxed));
+  int64_t sample_amount =
+      kSample == policy && (*ring)->IsMostlyFull()
+          ? overload_parameters_[log_type].load(std::memory_order_relaxed)
+          : 1;
+  char* record = nullptr;
+  if (1 == sample_amount ||
+      thread_sampled_amount++ % static_cast<uint64_t>(sample_amount) == 0) {
+    record = (*ring)->Reserve(record_size);
+    if (nullptr == record && (kDropOldest == policy || kBlock == policy)) {
+      record = WaitForRoom(log_type, policy, *ring, record_size);
+    }
+  }
+  if (nullptr == record) {
+    // Reported by the writer thread
+    dropped_amount_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  auto level = static_cast<uint8_t>(log_type);
+  if (is_key_value) {
+    level |= kKeyValueRecordFlag;
+  }
+  return EncodeLogRecordHeader(format, time_us, level, arg_amount, record);
+}
+
+void Logger::EndRecord(LogRing* ring, size_t record_size) {
+  ring->Commit(record_size);
+  WakeWriter();
+}
+
+char* Logger::WaitForRoom(LogLevel log_type, LogOverloadPolicy policy,
+                          LogRing* ring, size_t record_size) {
+  if (kDropOldest == policy) {
+    ring->RequestDiscard();
+  }
+  WakeWriter();
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::microseconds(overload_parameters_[log_type].load(
+                      std::memory_order_relaxed));
+  char* record = nullptr;
+  while (nullptr == (record = ring->Reserve(record_size)) &&
+         std::chrono::steady_clock::now() < deadline &&
+         !is_stopping_.load(std::memory_order_acquire)) {
+    std::this_thread::sleep_for(kOverloadRetryTime);
+  }
+  return record;
+}
+
+void Logger::WakeWriter() {
+  // Pairs with the fence of "WriteDownLogs()" after setting the flag
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (is_writer_sleeping_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    log_cond_var_.notify_one();
+  }
+}
+
+void Logger::ReportDroppedRecords(bool is_forced) {
+  int64_t now = LogClock::Now();
+  if (!is_forced && now - last_drop_report_time_ < kDropReportMicroseconds) {
+    return;
+  }
+  last_drop_report_time_ = now;
+  uint64_t amount =
+      dropped_amount_.exchange(0, std::memory_order_relaxed) +
+      discarded_amount_;
+  discarded_amount_ = 0;
+  if (0 == amount) {
+    return;
+  }
+  // Written as a warning record
+  char record[kLogRecordHeaderByte + sizeof(uint8_t) + sizeof(uint64_t)];
+  char* position =
+      EncodeLogRecordHeader(kDropReportFormat, now,
+                            static_cast<uint8_t>(kWarn), 1, record);
+  LogArgEncoder<unsigned long long>::Encode(
+      static_cast<unsigned long long>(amount), position);
+  WriteDownRecord(record, sizeof(record));
+}
+
+void Logger::ReloadLevels(bool is_forced) {
+  if (level_file_name_.empty()) {
+    return;
+  }
+  bool is_requested = is_reload_requested.exchange(false,
+                                                   std::memory_order_relaxed);
+  int64_t now = LogClock::Now();
+  if (!is_forced && !is_requested &&
+      now - last_level_check_time_ < kLevelCheckMicroseconds) {
+    return;
+  }
+  last_level_check_time_ = now;
+  int64_t modify_time = GetModifyTime(level_file_name_);
+  if (modify_time < 0 ||
+      (!is_forced && !is_requested && modify_time == level_file_modify_time_)) {
+    return;
+  }
+  level_file_modify_time_ = modify_time;
+  std::ifstream level_file(level_file_name_);
+  if (!level_file) {
+    return;
+  }
+  std::string levels((std::istreambuf_iterator<char>(level_file)),
+                     std::istreambuf_iterator<char>());
+  if (!SetLevels(levels)) {
+    WriteDownMessage(kWarn, kLevelErrorFormat, level_file_name_.c_str());
+  }
+  WriteDownMessage(kNotice, kLevelReloadFormat, GetLevels().c_str());
+}
+
+void Logger::WriteDownMessage(LogLevel log_type, const char* format,
+                              const char* arg) {
+  size_t arg_size = LogArgEncoder<const char*>::GetSize(arg);
+  std::string record(kLogRecordHeaderByte + arg_size, '\0');
+  char* position = EncodeLogRecordHeader(
+      format, LogClock::Now(), static_cast<uint8_t>(log_type), 1, &record[0]);
+  LogArgEncoder<const char*>::Encode(arg, position);
+  WriteDownRecord(record.data(), record.size());
+}
+
+void Logger::HandleReloadSignal(int) {
+  // Only a flag, the writer thread reads the file
+  is_reload_requested.store(true, std::memory_order_relaxed);
+}
+
+void Logger::SetMinLevel(LogLevel log_level) {
+  for (auto& min_level : min_levels) {
+    min_level.store(static_cast<int>(log_level), std::memory_order_relaxed);
+  }
+}
+
+LogCategory Logger::RegisterCategory(const std::string& name) {
+  CategoryNames& category_names = GetCategoryNames();
+  std::lock_guard<std::mutex> lock(category_names.mutex);
+  auto& names = category_names.names;
+  auto itr = std::find(names.begin(), names.end(), name);
+  if (itr != names.end()) {
+    return static_cast<LogCategory>(itr - names.begin());
+  }
+  if (names.size() >= static_cast<size_t>(kLogCategoryAmount)) {
+    return kGeneralLog;
+  }
+  names.push_back(name);
+  auto log_category = static_cast<LogCategory>(names.size() - 1);
+  SetCategoryLevel(log_category, GetCategoryLevel(kGeneralLog));
+  return log_category;
+}
+
+bool Logger::SetLevels(const std::string& levels) {
+  CategoryNames& category_names = GetCategoryNames();
+  std::lock_guard<std::mutex> lock(category_names.mutex);
+  const auto& names = category_names.names;
+  bool is_understood = true;
+  size_t begin = 0;
+  while (begin < levels.size()) {
+    size_t end = levels.find_first_of(",;\n", begin);
+    end = std::string::npos == end ? levels.size() : end;
+    std::string item = levels.substr(begin, end - begin);
+    begin = end + 1;
+    item = item.substr(0, item.find('#'));
+    TrimSpaces(&item);
+    if (item.empty()) {
+      continue;
+    }
+    size_t equal = item.find('=');
+    std::string name = item.substr(0, std::min(equal, item.size()));
+    std::string level =
+        std::string::npos == equal ? "" : item.substr(equal + 1);
+    TrimSpaces(&name);
+    TrimSpaces(&level);
+    LogLevel log_level = kDebug;
+    auto itr = std::find(names.begin(), names.end(), name);
+    if (!ParseLevel(level, &log_level) ||
+        (name != "*" && itr == names.end())) {
+      is_understood = false;
+    } else if (name == "*") {
+      SetMinLevel(log_level);
     } else {
-      pos = read_index_.load(std::memory_order_relaxed);
+      SetCategoryLevel(static_cast<LogCategory>(itr - names.begin()),
+                       log_level);
     }
   }
+  return is_understood;
+}
+
+std::string Logger::GetLevels() {
+  CategoryNames& category_names = GetCategoryNames();
+  std::lock_guard<std::mutex> lock(category_names.mutex);
+  const auto& names = category_names.names;
+  std::string levels;
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (i > 0) {
+      levels += ", ";
+    }
+    levels += names[i] + "=" +
+              kLevelNames[GetCategoryLevel(static_cast<LogCategory>(i))];
+  }
+  return levels;
+}
+
+void Logger::SetOverloadPolicy(LogLevel log_level, LogOverloadPolicy policy,
+                               int64_t parameter) {
+  if (parameter <= 0) {
+    parameter = kSample == policy       ? kLogSampleAmount
+                : kDropOldest == policy ? kLogDiscardMicroseconds
+                                        : kLogBlockMicroseconds;
+  }
+  overload_parameters_[log_level].store(parameter, std::memory_order_relaxed);
+  overload_policies_[log_level].store(static_cast<int>(policy),
+                                      std::memory_order_relaxed);
 }
 
 Logger::Logger()
     : is_stopping_(false),
+      is_writer_sleeping_(false),
       cur_log_file_byte_(0),
       cur_log_file_seq_(0),
-      log_file_(NULL),
-      time_now_sec_(0),
-      write_index_(0),
-      read_index_(0),
-      pending_(0) {
-  (void)filler1_;
-  (void)filler2_;
-  (void)filler3_;
-  (void)filler4_;
-  for (size_t i = 0; i < kLogBufferSize; ++i) {
-    log_buffer_[i].seq.store(i, std::memory_order_relaxed);
+      file_format_(kTextFile),
+      cur_file_format_(kTextFile),
+      crash_thread_amount_(kLogCrashSegmentAmount),
+      rings_version_(0),
+      ring_byte_(kLogRingByte),
+      dropped_amount_(0),
+      discarded_amount_(0),
+      last_drop_report_time_(0),
+      reload_signal_(0),
+      installed_reload_signal_(0),
+      old_reload_action_(),
+      level_file_modify_time_(-1),
+      last_level_check_time_(0) {
+  for (int level = kEmerg; level <= kDebug; ++level) {
+    SetOverloadPolicy(static_cast<LogLevel>(level),
+                      level <= kError ? kBlock : kDropNewest);
   }
 }
 
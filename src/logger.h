@@ -12,19 +12,26 @@
 #ifndef TAOTU_SRC_LOGGER_H_
 #define TAOTU_SRC_LOGGER_H_
 
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
-#include <time.h>
 
-#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
-
+#include <unordered_map>
+#include <vector>
+
+#include "log_crash_file.h"
+#include "log_file_writer.h"
+#include "log_rate_limiter.h"
+#include "log_record.h"
+#include "log_ring.h"
+#include "log_rotator.h"
 #include "non_copyable_movable.h"
 
 namespace taotu {
@@ -38,26 +45,132 @@ namespace taotu {
 // End the unique logger
 #define END_LOG() logger::Logger::GetLogger(true)->EndLogger()
 
-// The unique API for recording logs
-#define LOG(...) logger::Logger::GetLogger(true)->RecordLogs(__VA_ARGS__)
-
-#ifdef TAOTU_DEBUG  // Flag for debug build, set in CMakeLists.txt
+// Skip records less severe than the level at runtime (of all categories)
+#define SET_LOG_LEVEL(log_level) logger::Logger::SetMinLevel(log_level)
+
+// Skip records of the category less severe than the level at runtime
+#define SET_LOG_CATEGORY_LEVEL(log_category, log_level) \
+  logger::Logger::SetCategoryLevel(log_category, log_level)
+
+// Put logs in the namespace where it is used (other than the global one) into
+// the category (logs are of "kGeneralLog" by default), like
+// "USE_LOG_CATEGORY(logger::kPollerLog);" in namespace "taotu"
+#define USE_LOG_CATEGORY(log_category) \
+  static const ::taotu::logger::LogCategory kTaotuLogCategory = (log_category)
+
+// The unique API for recording logs (the format has to be a string literal,
+// and arguments are checked against it when compiling). Nothing but one
+// atomic load is done if the level of the category is off at runtime.
+#define LOG(...)                                                           \
+  logger::Logger::IsLevelOn(kTaotuLogCategory,                             \
+                            TAOTU_LOG_FIRST_ARG(__VA_ARGS__))              \
+      ? ::taotu::logger::Logger::GetLogger(true)->RecordLogs(__VA_ARGS__), \
+        static_cast<void>(                                                 \
+            sizeof(::taotu::logger::CheckLogFormat(__VA_ARGS__)))          \
+      : static_cast<void>(0)
+
+// The least severe level compiled in (the number of "LogLevel", less
+// severe logs are removed when compiling), set like
+// "-DTAOTU_LOG_MIN_LEVEL=4" (only warnings and severer ones are kept). Debug
+// logs are kept by default, so they can be turned on for a category at
+// runtime even in release builds.
+#ifndef TAOTU_LOG_MIN_LEVEL
+#define TAOTU_LOG_MIN_LEVEL 7
+#endif  // !TAOTU_LOG_MIN_LEVEL
+
+#if TAOTU_LOG_MIN_LEVEL >= 7
 #define LOG_DEBUG(...) LOG(taotu::logger::kDebug, __VA_ARGS__)
-#else  // release build
-#define LOG_DEBUG(...) TrivialFunc()
-#endif  // TAOTU_DEBUG
-
+#else
+#define LOG_DEBUG(...) TAOTU_LOG_OFF(taotu::logger::kDebug, __VA_ARGS__)
+#endif
+#if TAOTU_LOG_MIN_LEVEL >= 6
 #define LOG_INFO(...) LOG(taotu::logger::kInfo, __VA_ARGS__)
+#else
+#define LOG_INFO(...) TAOTU_LOG_OFF(taotu::logger::kInfo, __VA_ARGS__)
+#endif
+#if TAOTU_LOG_MIN_LEVEL >= 5
 #define LOG_NOTICE(...) LOG(taotu::logger::kNotice, __VA_ARGS__)
+#else
+#define LOG_NOTICE(...) TAOTU_LOG_OFF(taotu::logger::kNotice, __VA_ARGS__)
+#endif
+#if TAOTU_LOG_MIN_LEVEL >= 4
 #define LOG_WARN(...) LOG(taotu::logger::kWarn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) TAOTU_LOG_OFF(taotu::logger::kWarn, __VA_ARGS__)
+#endif
+#if TAOTU_LOG_MIN_LEVEL >= 3
 #define LOG_ERROR(...) LOG(taotu::logger::kError, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) TAOTU_LOG_OFF(taotu::logger::kError, __VA_ARGS__)
+#endif
+#if TAOTU_LOG_MIN_LEVEL >= 2
 #define LOG_CRIT(...) LOG(taotu::logger::kCrit, __VA_ARGS__)
+#else
+#define LOG_CRIT(...) TAOTU_LOG_OFF(taotu::logger::kCrit, __VA_ARGS__)
+#endif
+#if TAOTU_LOG_MIN_LEVEL >= 1
 #define LOG_ALERT(...) LOG(taotu::logger::kAlert, __VA_ARGS__)
+#else
+#define LOG_ALERT(...) TAOTU_LOG_OFF(taotu::logger::kAlert, __VA_ARGS__)
+#endif
 #define LOG_EMERG(...) LOG(taotu::logger::kEmerg, __VA_ARGS__)
 
+// Record a structured log of an event followed by keys and values in turn,
+// like "LOG_KV(taotu::logger::kInfo, "conn_open", "fd", fd, "peer", ip)"
+// (the event and keys have to be string literals, and values are integers,
+// floating points, bools, strings or pointers)
+#define LOG_KV(log_level, ...)                                          \
+  logger::IsLevelCompiledIn<TAOTU_LOG_MIN_LEVEL>(log_level) &&          \
+          ::taotu::logger::Logger::IsLevelOn(kTaotuLogCategory,         \
+                                             log_level)                 \
+      ? ::taotu::logger::Logger::GetLogger(true)->RecordKeyValues(      \
+            log_level, __VA_ARGS__),                                    \
+        static_cast<void>(                                              \
+            sizeof(::taotu::logger::CheckLogKeyValues(__VA_ARGS__)))    \
+      : static_cast<void>(0)
+
+// Record only the 1st, (n+1)th, (2n+1)th... log of this call site
+#define LOG_EVERY_N(log_level, n, ...) \
+  TAOTU_LOG_LIMITED(log_level, TAOTU_LOG_LIMITER().IsEveryN(n), __VA_ARGS__)
+#define LOG_ERROR_EVERY_N(n, ...) \
+  LOG_EVERY_N(taotu::logger::kError, n, __VA_ARGS__)
+#define LOG_WARN_EVERY_N(n, ...) \
+  LOG_EVERY_N(taotu::logger::kWarn, n, __VA_ARGS__)
+
+// Record at most one log of this call site in each "interval_ms"
+// milliseconds
+#define LOG_EVERY_MS(log_level, interval_ms, ...)                          \
+  TAOTU_LOG_LIMITED(log_level, TAOTU_LOG_LIMITER().IsEveryMs(interval_ms), \
+                    __VA_ARGS__)
+
 /********************************************************************/
 
 inline void TrivialFunc() {}
+inline void TrivialFunc(size_t) {}
+
+#define TAOTU_LOG_FIRST_ARG(first, ...) first
+
+// Logs removed still have their arguments checked (but never evaluated)
+#define TAOTU_LOG_OFF(...) \
+  TrivialFunc(sizeof(::taotu::logger::CheckLogFormat(__VA_ARGS__)))
+
+// The limiter of the call site
+#define TAOTU_LOG_LIMITER()                                  \
+  []() -> ::taotu::logger::LogRateLimiter& {                 \
+    static ::taotu::logger::LogRateLimiter log_rate_limiter; \
+    return log_rate_limiter;                                 \
+  }()
+
+// Levels removed when compiling are never checked at runtime
+#define TAOTU_LOG_LIMITED(log_level, is_allowed, ...)                        \
+  logger::IsLevelCompiledIn<TAOTU_LOG_MIN_LEVEL>(log_level) &&               \
+          ::taotu::logger::Logger::IsLevelOn(kTaotuLogCategory, log_level) && \
+          (is_allowed)                                                       \
+      ? ::taotu::logger::Logger::GetLogger(true)->RecordLogs(log_level,      \
+                                                             __VA_ARGS__),   \
+        static_cast<void>(                                                   \
+            sizeof(::taotu::logger::CheckLogFormat(log_level, __VA_ARGS__))) \
+      : static_cast<void>(0)
 
 namespace logger {
 
@@ -74,8 +187,56 @@ enum LogLevel {
   kDebug,
 };
 
-constexpr int64_t kLogFileMaxByte = 1024 * 1024 * 1024;  // 2GB
-constexpr size_t kLogBufferSize = 1024 * 1024 * 16;      // Power of two.
+// Categories of logs, each with its own level at runtime (chosen for the logs
+// in a namespace by "USE_LOG_CATEGORY()")
+enum LogCategory : int {
+  kGeneralLog = 0,  // Logs of users and the rest of this library
+  kPollerLog,       // I/O multiplexing and event loops
+  kConnectionLog,   // Connections with their sockets and buffers
+  kAcceptorLog,     // Listening and accepting
+  kRpcLog,
+  kTimerLog,
+  kFirstUserLog,  // Registered by "Logger::RegisterCategory()" from here
+};
+
+// At most so many categories (including the built-in ones)
+constexpr int kLogCategoryAmount = 32;
+
+// Default size of the ring of each logging thread
+constexpr size_t kLogRingByte = 1024 * 1024;
+
+// Text lines, or binary records (decoded by "taotu-log-decode") which spare
+// the writer thread formatting, or JSON lines or logfmt lines for machines
+enum LogFileFormat {
+  kTextFile = 0,
+  kBinaryFile,
+  kJsonFile,
+  kLogfmtFile,
+};
+
+// What is done with a record when the ring of its thread is full
+enum LogOverloadPolicy {
+  // Drop the record
+  kDropNewest = 0,
+  // Have the writer thread discard the records in the ring, then wait for
+  // room until timeout
+  kDropOldest,
+  // Wait for room until timeout
+  kBlock,
+  // Drop the record, and keep only 1 in N records of the level once the
+  // ring is more than 3/4 full
+  kSample,
+};
+
+// Default timeouts and N of "LogOverloadPolicy"
+constexpr int64_t kLogBlockMicroseconds = 10000;
+constexpr int64_t kLogDiscardMicroseconds = 1000;
+constexpr int64_t kLogSampleAmount = 16;
+
+template <int kMinLevel>
+constexpr bool IsLevelCompiledIn(LogLevel log_level) {
+  return static_cast<int>(log_level) <= kMinLevel;
+}
 
 // The file name of the log
 static const std::string kLogName{"log.txt"};
@@ -86,23 +247,76 @@ static const std::string Log_level_info_prefix[]{
     "Log(Warn): ",      "Log(Notice): ", "Log(Info): ",     "Log(Debug): ",
 };
 
+// Only for checking arguments of "LOG()" (never defined)
+int CheckLogFormat(LogLevel log_type, const char* log_info, ...)
+    __attribute__((format(printf, 2, 3)));
+int CheckLogFormat(LogLevel log_type, const std::string& log_info);
+
+// Only for checking arguments of "LOG_KV()" (never defined)
+int CheckLogKeyValues(const char* event);
+template <class Value, class... Fields>
+int CheckLogKeyValues(const char* event, const char* key, const Value& value,
+                      const Fields&... fields);
+
 /**
- * @brief "Logger" uses a special ring buffer called "Disruptor": the index of
- * writable position is atomic. And it uses "Singleton" pattern, so there is
- * only one actual "Logger" object in the global environment of one process.
+ * @brief "Logger" gives each logging thread its own "LogRing" (a
+ * single-producer single-consumer ring in bytes), so records are formatted
+ * right into the ring without any lock, allocation or contended atomic
+ * operation, and only one writer thread drains all the rings into the file.
+ * And it uses "Singleton" pattern, so there is only one actual "Logger" object
+ * in the global environment of one process.
  *
  */
 class Logger : NonCopyableMovable {
  public:
-  struct LogSlot {
-    std::atomic<size_t> seq{0};
-    std::string data;
-  };
-  typedef std::array<LogSlot, kLogBufferSize> LogBuffer;
-
   // The unique method to creat the unique actual "Logger" object ("Singleton"
   // pattern)
-  static Logger* GetLogger(bool should_start);
+  static Logger* GetLogger(bool should_start) {
+    // The unique actual "Logger" object
+    static Logger logger;
+    // Only an atomic load once started
+    if (should_start && !is_initialized.load(std::memory_order_acquire)) {
+      logger.StartLogger(kLogName);
+    }
+    return &logger;
+  }
+
+  // Records less severe than the level are skipped in all categories
+  // ("kDebug" by default in debug builds, or "kInfo" in release builds)
+  static void SetMinLevel(LogLevel log_level);
+  static LogLevel GetMinLevel() { return GetCategoryLevel(kGeneralLog); }
+  static bool IsLevelOn(LogLevel log_level) {
+    return IsLevelOn(kGeneralLog, log_level);
+  }
+
+  // Records of the category less severe than the level are skipped
+  static void SetCategoryLevel(LogCategory log_category, LogLevel log_level) {
+    min_levels[log_category].store(static_cast<int>(log_level),
+                                   std::memory_order_relaxed);
+  }
+  static LogLevel GetCategoryLevel(LogCategory log_category) {
+    return static_cast<LogLevel>(
+        min_levels[log_category].load(std::memory_order_relaxed));
+  }
+  static bool IsLevelOn(LogCategory log_category, LogLevel log_level) {
+    return static_cast<int>(log_level) <=
+           min_levels[log_category].load(std::memory_order_relaxed);
+  }
+
+  // Register a category of users by its name, which starts at the level of
+  // "kGeneralLog" (the category registered before if the name is taken, or
+  // "kGeneralLog" if there is no room)
+  static LogCategory RegisterCategory(const std::string& name);
+
+  // Set levels of categories by the text like "poller=debug, rpc=warn", where
+  // "*" is for all categories, levels are names (like "warn") or numbers of
+  // "LogLevel", items can also be put in lines, and "#" starts a comment to
+  // the end of the line. False if any item is not understood (the others are
+  // still set).
+  static bool SetLevels(const std::string& levels);
+
+  // Levels of all categories in the text taken by "SetLevels()"
+  static std::string GetLevels();
 
   void EndLogger();
 
@@ -112,84 +326,218 @@ class Logger : NonCopyableMovable {
   // Initialize this logger (have to be called before recording logs)
   void StartLogger(std::string&& log_file_name);
 
-  // Record log (use variable length parameters)
+  // Set the size of the rings of threads logging for the first time after
+  // (records are dropped when the ring of its thread is full)
+  void SetRingByte(size_t ring_byte) {
+    ring_byte_.store(ring_byte, std::memory_order_relaxed);
+  }
+
+  // Set the format of the log files (effective from the next start)
+  void SetFileFormat(LogFileFormat file_format) { file_format_ = file_format; }
+
+  // Set how the log files are written (effective from the next start)
+  void SetWriteOptions(const LogWriteOptions& write_options) {
+    write_options_ = write_options;
+  }
+
+  // Set how the log files are rotated (effective from the next start)
+  void SetRotateOptions(const LogRotateOptions& rotate_options) {
+    rotate_options_ = rotate_options;
+  }
+
+  // Keep the rings of threads in the crash file given (effective from the
+  // next start, and kept once opened), so the records not written down yet
+  // can be recovered by "taotu-log-recover" after a crash. Room in rings is
+  // given back only once records are written into the page cache, and log
+  // files are not opened with "O_DIRECT" then.
+  void SetCrashFile(const std::string& crash_file_name,
+                    size_t thread_amount = kLogCrashSegmentAmount) {
+    crash_file_name_ = crash_file_name;
+    crash_thread_amount_ = thread_amount;
+  }
+
+  // Set levels of categories from the file (in the text taken by
+  // "SetLevels()") at start, and again once it is modified (checked once a
+  // second) or the signal given is caught (0 for none) while running
+  // (effective from the next start)
+  void SetLevelFile(const std::string& level_file_name, int reload_signal = 0) {
+    level_file_name_ = level_file_name;
+    reload_signal_ = reload_signal;
+  }
+
+  // Set what is done with records of the level when the ring is full, where
+  // "parameter" is the timeout in microseconds of "kDropOldest" and "kBlock",
+  // or N of "kSample" (0 for the default). Errors and severer ones block for
+  // 10 ms by default, while others are dropped.
+  void SetOverloadPolicy(LogLevel log_level, LogOverloadPolicy policy,
+                         int64_t parameter = 0);
+
+  // Record log (use variable length parameters). Only the static format and
+  // the raw arguments are kept here, while the writer thread does formatting.
   template <class... Args>
   void RecordLogs(LogLevel log_type, const char* log_info, Args... args) {
-    int msg_len =
-        ::snprintf(nullptr, static_cast<size_t>(0), log_info, args...);
-    size_t prefix_size = Log_level_info_prefix[log_type].size();
-    char* message = new char[prefix_size + static_cast<size_t>(msg_len) + 1];
-    ::memcpy(static_cast<void*>(message),
-             Log_level_info_prefix[log_type].c_str(), prefix_size);
-    ::snprintf(message + prefix_size, static_cast<size_t>(msg_len + 1),
-               log_info, args...);
-    RecordLogs(static_cast<const char*>(message));
-    delete[] message;
+    static_assert(sizeof...(Args) <= kMaxLogArgAmount,
+                  "Too many arguments for one log!!!");
+    size_t args_size = 0;
+    ((args_size += LogArgEncoder<Args>::GetSize(args)), ...);
+    LogRing* ring = nullptr;
+    char* position =
+        BeginRecord(log_type, log_info, static_cast<uint8_t>(sizeof...(Args)),
+                    args_size, false, &ring);
+    if (nullptr == position) {
+      return;
+    }
+    ((position = LogArgEncoder<Args>::Encode(args, position)), ...);
+    EndRecord(ring, kLogRecordHeaderByte + args_size);
   }
 
   // Record log
   void RecordLogs(LogLevel log_type, const std::string& log_info);
 
-  // Record log
-  void RecordLogs(LogLevel log_type, std::string&& log_info);
+  // Record a structured log (keys and values are encoded right into the ring)
+  template <class... Fields>
+  void RecordKeyValues(LogLevel log_type, const char* event,
+                       const Fields&... fields) {
+    static_assert(sizeof...(Fields) % 2 == 0,
+                  "Keys and values have to be in pairs!!!");
+    static_assert(sizeof...(Fields) <= kMaxLogArgAmount,
+                  "Too many fields for one log!!!");
+    size_t args_size = 0;
+    ((args_size += LogArgEncoder<std::decay_t<Fields>>::GetSize(fields)), ...);
+    LogRing* ring = nullptr;
+    char* position =
+        BeginRecord(log_type, event, static_cast<uint8_t>(sizeof...(Fields)),
+                    args_size, true, &ring);
+    if (nullptr == position) {
+      return;
+    }
+    ((position = LogArgEncoder<std::decay_t<Fields>>::Encode(fields, position)),
+     ...);
+    EndRecord(ring, kLogRecordHeaderByte + args_size);
+  }
 
  protected:
   Logger();
   ~Logger();
 
  private:
-  std::string UpdateLoggerTime();
-
   // Called to write down logs
   void WriteDownLogs();
 
-  bool Enqueue(std::string&& log_data);
-  bool Dequeue(std::string* out);
+  // Write down what is in the rings, return how many records are written
+  size_t DrainRings(std::vector<std::shared_ptr<LogRing>>* rings,
+                    size_t* rings_version);
 
-  void RecordLogs(const char* log_info);
-  void RecordLogs(const std::string& log_info);
+  // Write down one record (rotate the log file before it if it is time)
+  void WriteDownRecord(const char* record, size_t record_size);
 
-  // The Actual log-record method (uses "move" semantics)
-  void RecordLogs(std::string&& log_info);
+  // Write the header of the current log file
+  void WriteFileHeader();
 
-  static std::atomic<bool> is_initialized;
+  // Open the crash file if it is set (once only)
+  void OpenCrashFile();
 
-  static constexpr int64_t kStandardLogFileByte = kLogFileMaxByte / 2;
-  static constexpr size_t kLogBufferMask =
-      static_cast<size_t>(kLogBufferSize - 1);
+  // The ring of the calling thread (created and registered at its first log)
+  LogRing* GetThreadRing();
 
-  alignas(256) std::atomic<bool> is_stopping_;
-  alignas(256) char filler1_;  // Only for solving "False Sharing"
+  // Reserve a record in the ring of the calling thread with its header
+  // written, return where the arguments of "args_size" bytes go (nullptr if
+  // the ring is full, then the record is dropped)
+  char* BeginRecord(LogLevel log_type, const char* format, uint8_t arg_amount,
+                    size_t args_size, bool is_key_value, LogRing** ring);
+
+  // Publish the record begun and wake the writer thread if it sleeps
+  void EndRecord(LogRing* ring, size_t record_size);
+
+  // Wait for room of a record by the overload policy of "kDropOldest" or
+  // "kBlock", nullptr if timeout
+  char* WaitForRoom(LogLevel log_type, LogOverloadPolicy policy,
+                    LogRing* ring, size_t record_size);
+
+  void WakeWriter();
+
+  // Write how many records are dropped if there are (at most once a second
+  // unless forced)
+  void ReportDroppedRecords(bool is_forced);
+
+  // Set levels from the level file if it is modified or the reload signal is
+  // caught (checked at most once a second unless forced)
+  void ReloadLevels(bool is_forced);
+
+  // Write down a record of the message with one string argument
+  void WriteDownMessage(LogLevel log_type, const char* format,
+                        const char* arg);
+
+  static void HandleReloadSignal(int signal_number);
+
+  static std::atomic<bool> is_initialized;
+  // Levels of categories
+  static std::atomic<int> min_levels[kLogCategoryAmount];
+  static std::atomic<bool> is_reload_requested;
+
+  std::atomic<bool> is_stopping_;
 
   std::mutex log_mutex_;
   std::condition_variable log_cond_var_;
+  std::atomic<bool> is_writer_sleeping_;
 
   int64_t cur_log_file_byte_;
   int64_t cur_log_file_seq_;
   std::string log_file_name_;
 
-  FILE* log_file_;
+  LogFileWriter log_file_;
+  LogWriteOptions write_options_;
+  LogRotator log_rotator_;
+  LogRotateOptions rotate_options_;
 
   std::thread thread_;
 
-  std::mutex time_mutex_;
-  std::string time_now_str_;
-  time_t time_now_sec_;
-
-  // Queue indices
-  alignas(256) std::atomic<size_t> write_index_;
-  alignas(256) char filler2_;  // Only for solving "False Sharing"
-  alignas(256) std::atomic<size_t> read_index_;
-  alignas(256) char filler3_;  // Only for solving "False Sharing"
-  alignas(256) std::atomic<size_t> pending_;
-  alignas(256) char filler4_;  // Only for solving "False Sharing"
-
-  // A lock-free ring buffer of log-msg ("Disruptor")
-  LogBuffer log_buffer_;
+  LogFileFormat file_format_;
+  LogFileFormat cur_file_format_;
+
+  // Used by the writer thread only
+  LogLineFormatter line_formatter_;
+  std::string line_;
+  // Mapping: format -> its id in the current binary log file
+  std::unordered_map<const char*, uint32_t> format_ids_;
+
+  // Opened at most once, and never replaced (read by producers)
+  std::string crash_file_name_;
+  size_t crash_thread_amount_;
+  std::shared_ptr<LogCrashFile> crash_file_;
+
+  // Rings of all threads having logged (the version changes with the set)
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<LogRing>> rings_;
+  std::atomic<size_t> rings_version_;
+  std::atomic<size_t> ring_byte_;
+
+  // Policies of levels with their parameters
+  std::atomic<int> overload_policies_[kDebug + 1];
+  std::atomic<int64_t> overload_parameters_[kDebug + 1];
+  // Dropped by producers, and discarded by the writer thread for
+  // "kDropOldest"
+  std::atomic<uint64_t> dropped_amount_;
+  uint64_t discarded_amount_;
+  int64_t last_drop_report_time_;
+
+  std::string level_file_name_;
+  int reload_signal_;
+  // The signal whose handler is installed (0 if none), and the former action
+  // of it put back when ending
+  int installed_reload_signal_;
+  struct sigaction old_reload_action_;
+  // Used by the writer thread only
+  int64_t level_file_modify_time_;
+  int64_t last_level_check_time_;
 };
 
 }  // namespace logger
 
 }  // namespace taotu
 
+// The category of logs out of namespaces using "USE_LOG_CATEGORY()"
+static const ::taotu::logger::LogCategory kTaotuLogCategory =
+    ::taotu::logger::kGeneralLog;
+
 #endif  // !TAOTU_SRC_LOGGER_H_
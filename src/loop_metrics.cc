@@ -0,0 +1,62 @@
+/**
+ * @file loop_metrics.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LoopMetrics" which is the load of one event
+ * loop published for other threads (like the one running "Balancer").
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "loop_metrics.h"
+
+namespace taotu {
+
+LoopMetrics::LoopMetrics()
+    : active_connections_(0),
+      cqes_per_second_(0),
+      bytes_per_second_(0),
+      busy_permille_(0),
+      loop_latency_us_(0),
+      window_start_us_(0),
+      window_work_us_(0),
+      window_cqes_(0),
+      window_bytes_(0),
+      smoothed_latency_us_(0) {}
+
+void LoopMetrics::OnLoopIteration(int64_t now_us, int64_t work_us,
+                                  size_t cqe_amount) {
+  if (0 == window_start_us_) {
+    window_start_us_ = now_us;
+  }
+  window_work_us_ += work_us;
+  window_cqes_ += cqe_amount;
+  if (cqe_amount > 0) {
+    // Exponential moving average with a weight of 1/8 for the newest one
+    uint64_t latency_us = static_cast<uint64_t>(work_us);
+    smoothed_latency_us_ = smoothed_latency_us_ -
+                           (smoothed_latency_us_ >> 3) + (latency_us >> 3);
+  }
+  int64_t elapsed_us = now_us - window_start_us_;
+  if (elapsed_us < kWindowMicroseconds) {
+    return;
+  }
+  uint64_t elapsed = static_cast<uint64_t>(elapsed_us);
+  cqes_per_second_.store(window_cqes_ * 1000000 / elapsed,
+                         std::memory_order_relaxed);
+  bytes_per_second_.store(window_bytes_ * 1000000 / elapsed,
+                          std::memory_order_relaxed);
+  uint64_t busy_permille =
+      static_cast<uint64_t>(window_work_us_) * 1000 / elapsed;
+  busy_permille_.store(
+      static_cast<uint32_t>(busy_permille > 1000 ? 1000 : busy_permille),
+      std::memory_order_relaxed);
+  loop_latency_us_.store(smoothed_latency_us_, std::memory_order_relaxed);
+  window_start_us_ = now_us;
+  window_work_us_ = 0;
+  window_cqes_ = 0;
+  window_bytes_ = 0;
+}
+
+}  // namespace taotu
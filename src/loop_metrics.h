@@ -0,0 +1,88 @@
+/**
+ * @file loop_metrics.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LoopMetrics" which is the load of one event
+ * loop published for other threads (like the one running "Balancer").
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_LOOP_METRICS_H_
+#define TAOTU_SRC_LOOP_METRICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "non_copyable_movable.h"
+
+namespace taotu {
+
+/**
+ * @brief "LoopMetrics" is written by its own loop thread only and read by any
+ * thread without locking. Counters are accumulated in plain members and
+ * published as rates once per window, so the loop pays only a few additions
+ * per iteration.
+ *
+ */
+class LoopMetrics : NonCopyableMovable {
+ public:
+  // Length of each window which rates are computed over
+  static constexpr int64_t kWindowMicroseconds = 100 * 1000;
+
+  LoopMetrics();
+
+  // Called by the loop thread after each iteration ("work_us" is the time
+  // spent on handling events and tasks, "cqe_amount" is the amount of
+  // completions handled)
+  void OnLoopIteration(int64_t now_us, int64_t work_us, size_t cqe_amount);
+
+  // Called by the loop thread after bytes being read or written
+  void AddBytes(size_t bytes) { window_bytes_ += bytes; }
+
+  void OnConnectionInserted() {
+    active_connections_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void OnConnectionRemoved() {
+    active_connections_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  uint32_t GetActiveConnections() const {
+    return active_connections_.load(std::memory_order_relaxed);
+  }
+  uint64_t GetCqesPerSecond() const {
+    return cqes_per_second_.load(std::memory_order_relaxed);
+  }
+  uint64_t GetBytesPerSecond() const {
+    return bytes_per_second_.load(std::memory_order_relaxed);
+  }
+  // Share of time spent on working instead of waiting (in 1/1000)
+  uint32_t GetBusyPermille() const {
+    return busy_permille_.load(std::memory_order_relaxed);
+  }
+  // Smoothed time spent on one iteration handling something (in microseconds)
+  uint64_t GetLoopLatencyUs() const {
+    return loop_latency_us_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic_uint32_t active_connections_;
+  std::atomic_uint64_t cqes_per_second_;
+  std::atomic_uint64_t bytes_per_second_;
+  std::atomic_uint32_t busy_permille_;
+  std::atomic_uint64_t loop_latency_us_;
+
+  // Only touched by the loop thread
+  int64_t window_start_us_;
+  int64_t window_work_us_;
+  uint64_t window_cqes_;
+  uint64_t window_bytes_;
+  uint64_t smoothed_latency_us_;
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_LOOP_METRICS_H_
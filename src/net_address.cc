@@ -12,12 +12,17 @@
 #include "net_address.h"
 
 #include <arpa/inet.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "logger.h"
 
 namespace taotu {
 
+namespace {
+constexpr size_t kUnixPathOffset = offsetof(struct sockaddr_un, sun_path);
+}  // namespace
+
 NetAddress::NetAddress(uint16_t port, bool loop_back, bool use_ipv6) {
   if (use_ipv6) {
     ::memset(&socket_address6_, 0, sizeof(socket_address6_));
@@ -56,15 +61,81 @@ NetAddress::NetAddress(const std::string& ip, uint16_t port, bool use_ipv6) {
   }
 }
 
+NetAddress NetAddress::FromUnixPath(const std::string& path) {
+  NetAddress net_address;
+  ::memset(&net_address.socket_address_un_, 0,
+           sizeof(net_address.socket_address_un_));
+  net_address.socket_address_un_.sun_family = AF_UNIX;
+  size_t length = path.size();
+  if (length >= sizeof(net_address.socket_address_un_.sun_path)) {
+    LOG_ERROR("Unix domain socket path (%s) is too long!!!", path.c_str());
+    length = sizeof(net_address.socket_address_un_.sun_path) - 1;
+  }
+  ::memcpy(net_address.socket_address_un_.sun_path, path.data(), length);
+  net_address.unix_address_size_ =
+      static_cast<socklen_t>(kUnixPathOffset + length + 1);
+  return net_address;
+}
+NetAddress NetAddress::FromAbstractName(const std::string& name) {
+  NetAddress net_address;
+  ::memset(&net_address.socket_address_un_, 0,
+           sizeof(net_address.socket_address_un_));
+  net_address.socket_address_un_.sun_family = AF_UNIX;
+  size_t length = name.size();
+  if (length + 1 > sizeof(net_address.socket_address_un_.sun_path)) {
+    LOG_ERROR("Abstract socket name (%s) is too long!!!", name.c_str());
+    length = sizeof(net_address.socket_address_un_.sun_path) - 1;
+  }
+  // The leading '\0' marks the abstract namespace, whose name is not
+  // terminated but sized by the length of the address
+  ::memcpy(net_address.socket_address_un_.sun_path + 1, name.data(), length);
+  net_address.unix_address_size_ =
+      static_cast<socklen_t>(kUnixPathOffset + 1 + length);
+  return net_address;
+}
+
 std::string NetAddress::GetIp() const {
   char ip[64]{""};
   if (GetFamily() == AF_INET6) {
-    ::inet_ntop(AF_INET6, &socket_address6_, ip, sizeof(ip));
+    ::inet_ntop(AF_INET6, &socket_address6_.sin6_addr, ip, sizeof(ip));
   } else if (GetFamily() == AF_INET) {
-    ::inet_ntop(AF_INET, &socket_address_, ip, sizeof(ip));
+    ::inet_ntop(AF_INET, &socket_address_.sin_addr, ip, sizeof(ip));
   }
   return std::string{ip};
 }
-uint16_t NetAddress::GetPort() const { return htons(socket_address_.sin_port); }
+uint16_t NetAddress::GetPort() const {
+  if (IsUnix()) {
+    return 0;
+  }
+  return htons(socket_address_.sin_port);
+}
+
+std::string NetAddress::GetUnixPath() const {
+  if (!IsUnix() || unix_address_size_ <= kUnixPathOffset) {
+    return std::string{};  // Not a Unix one, or an unnamed one
+  }
+  size_t length = unix_address_size_ - kUnixPathOffset;
+  if (IsAbstract()) {
+    return "@" + std::string{socket_address_un_.sun_path + 1, length - 1};
+  }
+  return std::string{socket_address_un_.sun_path,
+                     ::strnlen(socket_address_un_.sun_path, length)};
+}
+
+void NetAddress::SetRawAddr(const struct sockaddr_storage& addr,
+                            socklen_t length) {
+  if (addr.ss_family == AF_INET) {
+    socket_address_ = *reinterpret_cast<const struct sockaddr_in*>(&addr);
+  } else if (addr.ss_family == AF_INET6) {
+    socket_address6_ = *reinterpret_cast<const struct sockaddr_in6*>(&addr);
+  } else if (addr.ss_family == AF_UNIX) {
+    if (length > sizeof(socket_address_un_)) {
+      length = static_cast<socklen_t>(sizeof(socket_address_un_));
+    }
+    ::memset(&socket_address_un_, 0, sizeof(socket_address_un_));
+    ::memcpy(&socket_address_un_, &addr, length);
+    unix_address_size_ = length;
+  }
+}
 
 }  // namespace taotu
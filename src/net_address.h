@@ -14,6 +14,8 @@
 
 #include <netinet/in.h>
 #include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include <string>
 
@@ -21,7 +23,8 @@ namespace taotu {
 
 /**
  * @brief "NetAddress" makes users ignore whether IP address specification of
- * client-end is IPv4 or IPv6.
+ * client-end is IPv4 or IPv6. It can also be a Unix domain socket address
+ * (a path or a name in the abstract namespace) for co-located peers.
  *
  */
 class NetAddress {
@@ -34,11 +37,28 @@ class NetAddress {
   explicit NetAddress(const struct sockaddr_in6& socket_address6)
       : socket_address6_(socket_address6) {}
 
+  // Unix domain socket address bound to a path in the file system
+  static NetAddress FromUnixPath(const std::string& path);
+  // Unix domain socket address in the abstract namespace (Linux only, which
+  // leaves nothing in the file system)
+  static NetAddress FromAbstractName(const std::string& name);
+
   sa_family_t GetFamily() const { return socket_address_.sin_family; }
   std::string GetIp() const;
   uint16_t GetPort() const;
 
+  bool IsUnix() const { return GetFamily() == AF_UNIX; }
+  bool IsAbstract() const {
+    return IsUnix() && unix_address_size_ > sizeof(sa_family_t) &&
+           '\0' == socket_address_un_.sun_path[0];
+  }
+  // Path of the Unix domain socket address ("@" leads the abstract one)
+  std::string GetUnixPath() const;
+
   size_t GetSize() const {
+    if (IsUnix()) {
+      return unix_address_size_;
+    }
     return (GetFamily() == AF_INET ? sizeof(struct sockaddr_in)
                                    : sizeof(struct sockaddr_in6));
   }
@@ -49,13 +69,9 @@ class NetAddress {
   void SetNetAddress(const struct sockaddr_in& socket_address) {
     socket_address_ = socket_address;
   }
-  void SetRawAddr(const struct sockaddr_storage& addr) {
-    if (addr.ss_family == AF_INET) {
-      socket_address_ = *reinterpret_cast<const struct sockaddr_in*>(&addr);
-    } else if (addr.ss_family == AF_INET6) {
-      socket_address6_ = *reinterpret_cast<const struct sockaddr_in6*>(&addr);
-    }
-  }
+  // "length" is the one given by the kernel (only needed by AF_UNIX)
+  void SetRawAddr(const struct sockaddr_storage& addr,
+                  socklen_t length = sizeof(struct sockaddr_un));
   void SetNetAddress6(const struct sockaddr_in6& socket_address6) {
     socket_address6_ = socket_address6;
   }
@@ -65,7 +81,11 @@ class NetAddress {
   union {
     struct sockaddr_in socket_address_;
     struct sockaddr_in6 socket_address6_;
+    struct sockaddr_un socket_address_un_;
   };
+
+  // Length of the Unix domain socket address in use
+  socklen_t unix_address_size_{0};
 };
 
 }  // namespace taotu
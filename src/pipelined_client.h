@@ -0,0 +1,361 @@
+/**
+ * @file pipelined_client.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration and implementation of class template "PipelinedClient"
+ * which keeps many requests outstanding on one client-end connection.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_SRC_PIPELINED_CLIENT_H_
+#define TAOTU_SRC_PIPELINED_CLIENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "client.h"
+#include "connecting.h"
+#include "event_manager.h"
+#include "io_buffer.h"
+#include "logger.h"
+#include "net_address.h"
+#include "non_copyable_movable.h"
+#include "spin_lock.h"
+
+namespace taotu {
+
+// Whether responses of the codec are matched to requests by id ("true" if
+// "CODEC::kMatchById" is "true"), or else in the order of requests
+template <typename CODEC, typename = void>
+struct IsMatchedById : std::false_type {};
+template <typename CODEC>
+struct IsMatchedById<CODEC, std::void_t<decltype(CODEC::kMatchById)>>
+    : std::bool_constant<CODEC::kMatchById> {};
+
+/**
+ * @brief "PipelinedClient" sends requests on one connection without waiting
+ * for the responses of the former ones, and matches the responses to the
+ * requests in order (or by id), each with its own deadline. Requests issued
+ * in a row are encoded together and written by one sending.
+ *
+ * The codec ("CODEC") should offer:
+ *   typedef ... Request;
+ *   typedef ... Response;
+ *   // Append the encoded request to the buffer
+ *   static void Encode(const Request& request, IoBuffer* io_buffer);
+ *   // Decode one response from the front of the buffer (and retrieve it),
+ *   // return 1 if decoded, 0 if more bytes are needed, -1 if broken
+ *   static int Decode(IoBuffer* io_buffer, Response* response);
+ * and, to match by id instead of in order,
+ *   static constexpr bool kMatchById = true;
+ *   static uint64_t GetRequestId(const Request& request);
+ *   static uint64_t GetResponseId(const Response& response);
+ *
+ */
+template <typename CODEC>
+class PipelinedClient : NonCopyableMovable {
+ public:
+  typedef typename CODEC::Request Request;
+  typedef typename CODEC::Response Response;
+
+  enum class Status {
+    kOk = 0,            // The response arrives
+    kTimedOut = 1,      // No response before the deadline
+    kDisconnected = 2,  // The connection is not there (any more)
+    kBroken = 3,        // Responses can't be decoded (so it's closed)
+    kDuplicateId = 4,   // A request with the same id is still pending
+  };
+
+  // Called in the loop thread, where "response" is only valid with "kOk"
+  typedef std::function<void(Status, Response*)> ResponseCallback;
+  typedef Connecting::NormalCallback NormalCallback;
+
+  PipelinedClient(EventManager* event_manager,
+                  const NetAddress& server_address, bool should_retry = false)
+      : event_manager_(event_manager),
+        client_(event_manager, server_address, should_retry),
+        connection_(nullptr),
+        alive_token_(std::make_shared<bool>(true)),
+        default_timeout_(kDefaultTimeoutMicroseconds),
+        max_timed_out_in_order_(kDefaultMaxTimedOutInOrder),
+        timed_out_in_order_(0),
+        is_flush_scheduled_(false),
+        next_sequence_(0),
+        pending_amount_(0) {
+    client_.SetConnectionCallback([this](Connecting& connection) {
+      this->OnConnectionCallback(connection);
+    });
+    client_.SetMessageCallback(
+        [this](Connecting& connection, IoBuffer* io_buffer, TimePoint) {
+          this->OnMessageCallback(connection, io_buffer);
+        });
+  }
+  ~PipelinedClient() { alive_token_.reset(); }
+
+  void SetConnectionCallback(const NormalCallback& cb) {
+    ConnectionCallback_ = cb;
+  }
+
+  // Deadline of requests called without their own (in microseconds, or no
+  // deadline if not positive)
+  void SetDefaultTimeout(int64_t timeout_microseconds) {
+    default_timeout_ = timeout_microseconds;
+  }
+
+  // Timed-out requests (matched in order) still waiting for their late
+  // responses, beyond which the connection is taken as stuck and closed
+  void SetMaxTimedOutInOrder(size_t max_timed_out) {
+    max_timed_out_in_order_ = max_timed_out;
+  }
+
+  void Connect() { client_.Connect(); }
+  void Disconnect() { client_.Disconnect(); }
+
+  // Issue one request (from any thread), whose callback is called once in the
+  // loop thread, with "kDisconnected" at once if it is not connected when the
+  // request is written
+  void Call(Request request, ResponseCallback cb,
+            int64_t timeout_microseconds = -1) {
+    bool should_schedule = false;
+    {
+      LockGuard lock_guard(outbox_lock_);
+      outbox_.push_back(Outgoing{std::move(request), std::move(cb),
+                                 timeout_microseconds < 0
+                                     ? default_timeout_
+                                     : timeout_microseconds});
+      should_schedule = !is_flush_scheduled_;
+      is_flush_scheduled_ = true;
+    }
+    if (should_schedule) {
+      // Requests issued before this runs go in the same writing
+      std::weak_ptr<bool> alive_token = alive_token_;
+      event_manager_->RunSoon([this, alive_token]() {
+        if (!alive_token.expired()) {
+          this->FlushOutbox();
+        }
+      });
+    }
+  }
+
+  // Requests written but not answered yet
+  size_t GetPendingAmount() const {
+    return pending_amount_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr int64_t kDefaultTimeoutMicroseconds = 5 * 1000 * 1000;
+  static constexpr size_t kDefaultMaxTimedOutInOrder = 1024;
+
+  struct Outgoing {
+    Request request;
+    ResponseCallback cb;
+    int64_t timeout_microseconds;
+  };
+  struct Pending {
+    uint64_t sequence;
+    ResponseCallback cb;  // Empty once completed by the deadline
+  };
+
+  // Write all requests issued so far by one sending (in the loop thread)
+  void FlushOutbox() {
+    std::vector<Outgoing> outgoings;
+    {
+      LockGuard lock_guard(outbox_lock_);
+      outgoings.swap(outbox_);
+      is_flush_scheduled_ = false;
+    }
+    if (nullptr == connection_ || !connection_->IsConnected()) {
+      for (auto& outgoing : outgoings) {
+        if (outgoing.cb) {
+          outgoing.cb(Status::kDisconnected, nullptr);
+        }
+      }
+      return;
+    }
+    for (auto& outgoing : outgoings) {
+      uint64_t sequence = next_sequence_;
+      uint64_t id = sequence;
+      if constexpr (IsMatchedById<CODEC>::value) {
+        id = CODEC::GetRequestId(outgoing.request);
+        if (pending_by_id_.count(id) != 0) {
+          // Its response couldn't be told from the pending one's
+          if (outgoing.cb) {
+            outgoing.cb(Status::kDuplicateId, nullptr);
+          }
+          continue;
+        }
+      }
+      CODEC::Encode(outgoing.request, &write_buffer_);
+      ++next_sequence_;
+      if constexpr (IsMatchedById<CODEC>::value) {
+        pending_by_id_.emplace(id, Pending{sequence, std::move(outgoing.cb)});
+      } else {
+        pending_in_order_.push_back(Pending{sequence, std::move(outgoing.cb)});
+      }
+      pending_amount_.fetch_add(1, std::memory_order_relaxed);
+      if (outgoing.timeout_microseconds > 0) {
+        std::weak_ptr<bool> alive_token = alive_token_;
+        event_manager_->RunAfter(
+            outgoing.timeout_microseconds, [this, alive_token, id, sequence]() {
+              if (!alive_token.expired()) {
+                this->ExpireOne(id, sequence);
+              }
+            });
+      }
+    }
+    connection_->Send(&write_buffer_);
+  }
+
+  // Complete the request with "kTimedOut" if it is still pending
+  void ExpireOne(uint64_t id, uint64_t sequence) {
+    Pending* pending = nullptr;
+    if constexpr (IsMatchedById<CODEC>::value) {
+      auto it = pending_by_id_.find(id);
+      if (it != pending_by_id_.end() && it->second.sequence == sequence) {
+        pending = &it->second;
+      }
+    } else {
+      // Sequences in the queue are consecutive
+      if (!pending_in_order_.empty() &&
+          sequence >= pending_in_order_.front().sequence) {
+        size_t index =
+            static_cast<size_t>(sequence - pending_in_order_.front().sequence);
+        if (index < pending_in_order_.size()) {
+          pending = &pending_in_order_[index];
+        }
+      }
+    }
+    if (nullptr == pending || !pending->cb) {
+      return;
+    }
+    auto cb = std::move(pending->cb);
+    pending->cb = nullptr;
+    if constexpr (IsMatchedById<CODEC>::value) {
+      pending_by_id_.erase(id);
+      pending_amount_.fetch_sub(1, std::memory_order_relaxed);
+    } else {
+      // Or it stays in the queue to take the late response
+      ++timed_out_in_order_;
+    }
+    cb(Status::kTimedOut, nullptr);
+    if (timed_out_in_order_ > max_timed_out_in_order_ &&
+        connection_ != nullptr) {
+      // The late responses may never come, so don't wait for them endlessly
+      // (the pending ones fail with "kDisconnected" once it is closed)
+      LOG_ERROR("Fd(%d) has too many requests timed out in the pipeline!!!",
+                connection_->Fd());
+      connection_->ForceClose();
+    }
+  }
+
+  void OnConnectionCallback(Connecting& connection) {
+    if (connection.IsConnected()) {
+      connection_ = &connection;
+    } else {
+      connection_ = nullptr;
+      FailAllPending(Status::kDisconnected);
+    }
+    if (ConnectionCallback_) {
+      ConnectionCallback_(connection);
+    }
+  }
+
+  void OnMessageCallback(Connecting& connection, IoBuffer* io_buffer) {
+    int result;
+    for (;;) {
+      Response response;
+      if ((result = CODEC::Decode(io_buffer, &response)) <= 0) {
+        break;
+      }
+      ResponseCallback cb;
+      if constexpr (IsMatchedById<CODEC>::value) {
+        auto it = pending_by_id_.find(CODEC::GetResponseId(response));
+        if (it == pending_by_id_.end()) {
+          continue;  // Timed out before
+        }
+        cb = std::move(it->second.cb);
+        pending_by_id_.erase(it);
+      } else {
+        if (pending_in_order_.empty()) {
+          result = -1;  // Answering nothing
+          break;
+        }
+        cb = std::move(pending_in_order_.front().cb);
+        pending_in_order_.pop_front();
+        if (!cb) {
+          --timed_out_in_order_;  // The late one
+        }
+      }
+      pending_amount_.fetch_sub(1, std::memory_order_relaxed);
+      if (cb) {
+        cb(Status::kOk, &response);
+      }
+    }
+    if (result < 0) {
+      LOG_ERROR("Fd(%d) receives a broken response in the pipeline!!!",
+                connection.Fd());
+      FailAllPending(Status::kBroken);
+      connection.ForceClose();
+    }
+  }
+
+  void FailAllPending(Status status) {
+    std::deque<Pending> pending_in_order;
+    std::unordered_map<uint64_t, Pending> pending_by_id;
+    pending_in_order.swap(pending_in_order_);
+    pending_by_id.swap(pending_by_id_);
+    pending_amount_.store(0, std::memory_order_relaxed);
+    timed_out_in_order_ = 0;
+    for (auto& pending : pending_in_order) {
+      if (pending.cb) {
+        pending.cb(status, nullptr);
+      }
+    }
+    for (auto& id_pending : pending_by_id) {
+      if (id_pending.second.cb) {
+        id_pending.second.cb(status, nullptr);
+      }
+    }
+  }
+
+  EventManager* event_manager_;
+  Client client_;
+
+  // Only touched in the loop thread
+  Connecting* connection_;
+  IoBuffer write_buffer_;
+  std::deque<Pending> pending_in_order_;
+  std::unordered_map<uint64_t, Pending> pending_by_id_;
+
+  // Expired when destroyed, so timers later find nothing to do
+  std::shared_ptr<bool> alive_token_;
+
+  int64_t default_timeout_;
+  size_t max_timed_out_in_order_;
+  size_t timed_out_in_order_;  // Placeholders left in "pending_in_order_"
+
+  // Requests issued but not written yet
+  std::vector<Outgoing> outbox_;
+  bool is_flush_scheduled_;
+  MutexLock outbox_lock_;
+
+  uint64_t next_sequence_;
+  std::atomic_size_t pending_amount_;
+
+  NormalCallback ConnectionCallback_;
+};
+
+}  // namespace taotu
+
+#endif  // !TAOTU_SRC_PIPELINED_CLIENT_H_
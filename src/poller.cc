@@ -23,6 +23,9 @@
 #include "logger.h"
 
 namespace taotu {
+
+USE_LOG_CATEGORY(logger::kPollerLog);
+
 namespace {
 constexpr uint32_t kDefaultEntries = 32768;
 constexpr uint32_t kMinEntries = 1024;
@@ -92,6 +95,10 @@ Poller::Poller() {
       use_multishot_accept_ = false;
       LOG_WARN("io_uring_accept not supported; multishot accept disabled.");
     }
+    if (!::io_uring_opcode_supported(probe, IORING_OP_SPLICE)) {
+      use_splice_ = false;
+      LOG_WARN("io_uring_splice not supported; sendfile() will be used.");
+    }
     ::io_uring_free_probe(probe);
   }
   RegisterBuffers();
@@ -274,6 +281,30 @@ uint64_t Poller::SubmitAccept(int fd, struct sockaddr* addr, socklen_t* addrlen,
   return key;
 }
 
+uint64_t Poller::SubmitSplice(Eventer* eventer, int fd_in, int64_t off_in,
+                              int fd_out, int64_t off_out, unsigned int len,
+                              CompletionFn completion, void* ctx, uint64_t key,
+                              ContextDeleter context_deleter) {
+  key = NormalizeKey(key);
+  struct io_uring_sqe* sqe = ::io_uring_get_sqe(&ring_);
+  if (!sqe) {
+    LOG_ERROR("io_uring_get_sqe failed when submit splice fd(%d)",
+              eventer->Fd());
+    return 0;
+  }
+  auto op = std::make_unique<IoUringOp>(
+      IoUringOp{OpType::kSplice, eventer, ctx, eventer->Fd(), completion, key,
+                context_deleter});
+  {
+    std::lock_guard<std::mutex> lock(ops_mutex_);
+    ops_[key] = std::move(op);
+  }
+  ::io_uring_prep_splice(sqe, fd_in, off_in, fd_out, off_out, len, 0);
+  ::io_uring_sqe_set_data64(sqe, key);
+  SubmitPending();
+  return key;
+}
+
 void Poller::CancelOp(uint64_t user_data_key) {
   if (user_data_key == 0) {
     return;
@@ -297,6 +328,19 @@ void Poller::CancelOp(uint64_t user_data_key) {
   ::io_uring_sqe_set_data64(sqe, 0);  // Cancellation CQE needs no handling.
   SubmitPending();
 }
+void Poller::InterruptOp(uint64_t user_data_key) {
+  if (user_data_key == 0) {
+    return;
+  }
+  struct io_uring_sqe* sqe = ::io_uring_get_sqe(&ring_);
+  if (!sqe) {
+    LOG_ERROR("io_uring_get_sqe failed when interrupt op");
+    return;
+  }
+  ::io_uring_prep_cancel64(sqe, user_data_key, 0);
+  ::io_uring_sqe_set_data64(sqe, 0);  // Cancellation CQE needs no handling.
+  SubmitPending();
+}
 TimePoint Poller::Poll(int timeout, EventerList* active_eventers) {
   struct __kernel_timespec ts {};
   struct __kernel_timespec* tsp = nullptr;
@@ -308,6 +352,8 @@ TimePoint Poller::Poll(int timeout, EventerList* active_eventers) {
 
   struct io_uring_cqe* cqe = nullptr;
   int ret = ::io_uring_wait_cqe_timeout(&ring_, &cqe, tsp);
+  last_wake_up_us_ = TimePoint::FNow();
+  last_cqe_amount_ = 0;
   if (ret == -ETIME) {
     SubmitPending();
     return TimePoint{};
@@ -318,7 +364,7 @@ TimePoint Poller::Poll(int timeout, EventerList* active_eventers) {
     return TimePoint{};
   }
 
-  const int64_t start_us = TimePoint::FNow();
+  const int64_t start_us = last_wake_up_us_;
   HandleCqe(cqe, active_eventers);
   ::io_uring_cqe_seen(&ring_, cqe);
 
@@ -341,6 +387,7 @@ TimePoint Poller::Poll(int timeout, EventerList* active_eventers) {
     ::io_uring_cqe_seen(&ring_, cqe);
     ++handled;
   }
+  last_cqe_amount_ = handled;
 
   SubmitPending();
   return TimePoint{};
@@ -364,7 +411,8 @@ void Poller::HandleCqe(struct io_uring_cqe* cqe, EventerList* active_eventers) {
             reinterpret_cast<void*>(op_ptr->completion));
   bool keep_op = (cqe->flags & IORING_CQE_F_MORE) != 0;
   if (op_ptr->completion) {
-    if ((op_ptr->type == OpType::kRead || op_ptr->type == OpType::kWrite) &&
+    if ((op_ptr->type == OpType::kRead || op_ptr->type == OpType::kWrite ||
+         op_ptr->type == OpType::kSplice) &&
         (op_ptr->eventer == nullptr ||
          states_.find(op_ptr->eventer) == states_.end())) {
       CleanupOpContext(op_ptr);
@@ -435,6 +483,7 @@ void Poller::HandleCqe(struct io_uring_cqe* cqe, EventerList* active_eventers) {
       }
       break;
     }
+    case OpType::kSplice:
     case OpType::kTimeout:
     case OpType::kNone:
       break;
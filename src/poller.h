@@ -37,7 +37,15 @@ class Poller : NonCopyableMovable {
  public:
   typedef std::vector<Eventer*> EventerList;
 
-  enum class OpType { kPoll, kRead, kWrite, kAccept, kTimeout, kNone };
+  enum class OpType {
+    kPoll,
+    kRead,
+    kWrite,
+    kAccept,
+    kSplice,
+    kTimeout,
+    kNone
+  };
 
   struct IoUringOp;
   typedef void (*CompletionFn)(struct io_uring_cqe* cqe, IoUringOp* op);
@@ -81,7 +89,18 @@ class Poller : NonCopyableMovable {
                         uint64_t key = 0, bool multishot = false,
                         ContextDeleter context_deleter = nullptr);
 
+  // Move "len" bytes from "fd_in" to "fd_out" (one of them must be a pipe)
+  // without copying to user space ("-1" offset means the current position)
+  uint64_t SubmitSplice(Eventer* eventer, int fd_in, int64_t off_in,
+                        int fd_out, int64_t off_out, unsigned int len,
+                        CompletionFn completion = nullptr, void* ctx = nullptr,
+                        uint64_t key = 0,
+                        ContextDeleter context_deleter = nullptr);
+
   void CancelOp(uint64_t user_data_key);
+  // Ask the kernel to cancel the operation but still handle its completion
+  // (with "-ECANCELED" or the result if it has finished anyway)
+  void InterruptOp(uint64_t user_data_key);
 
   // Limit CQE handling per poll to avoid starving timers.
   void SetCqeBatchLimit(size_t limit) { cqe_batch_limit_ = limit; }
@@ -89,8 +108,14 @@ class Poller : NonCopyableMovable {
     cqe_time_budget_us_ = budget_us;
   }
 
+  // Amount of completions handled by the last polling, and the time point (in
+  // microseconds) its waiting ended
+  size_t GetLastCqeAmount() const { return last_cqe_amount_; }
+  int64_t GetLastWakeUpTime() const { return last_wake_up_us_; }
+
   bool UseSqpoll() const { return use_sqpoll_; }
   bool UseMultishotAccept() const { return use_multishot_accept_; }
+  bool SpliceSupported() const { return use_splice_; }
   bool BuffersRegistered() const { return buffers_registered_; }
   size_t BufferCount() const { return kBufCount; }
   // The buffer pointer is only valid during the completion callback.
@@ -125,8 +150,11 @@ class Poller : NonCopyableMovable {
   mutable std::mutex ops_mutex_;
   bool use_sqpoll_{false};
   bool use_multishot_accept_{true};
+  bool use_splice_{true};
   bool buffers_registered_{false};
   std::array<char[kBufSize], kBufCount> buffers_{};
+  size_t last_cqe_amount_{0};
+  int64_t last_wake_up_us_{0};
   size_t cqe_batch_limit_{1024};
   int64_t cqe_time_budget_us_{1000};
 };
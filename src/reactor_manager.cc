@@ -14,6 +14,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <functional>
 #include <string>
@@ -21,6 +22,7 @@
 #include "balancer.h"
 #include "connecting.h"
 #include "event_manager.h"
+#include "listener_handoff.h"
 #include "logger.h"
 #include "net_address.h"
 #include "spin_lock.h"
@@ -28,25 +30,31 @@
 namespace taotu {
 
 namespace {
+constexpr int64_t kDrainCheckingIntervalMicroseconds = 10 * 1000;
+
 NetAddress GetLocalAddress(int socket_fd) {
-  struct sockaddr_in6 local_addr;
+  struct sockaddr_storage local_addr;
   ::memset(&local_addr, 0, sizeof(local_addr));
   auto addr_len = static_cast<socklen_t>(sizeof(local_addr));
   if (::getsockname(socket_fd, reinterpret_cast<struct sockaddr*>(&local_addr),
                     &addr_len) < 0) {
     LOG_ERROR("Fail to get local network info when accepting!!!");
   }
-  return NetAddress(local_addr);
+  NetAddress local_address;
+  local_address.SetRawAddr(local_addr, addr_len);
+  return local_address;
 }
 NetAddress GetPeerAddress(int socket_fd) {
-  struct sockaddr_in6 local_addr;
-  ::memset(&local_addr, 0, sizeof(local_addr));
-  auto addr_len = static_cast<socklen_t>(sizeof(local_addr));
-  if (::getpeername(socket_fd, reinterpret_cast<struct sockaddr*>(&local_addr),
+  struct sockaddr_storage peer_addr;
+  ::memset(&peer_addr, 0, sizeof(peer_addr));
+  auto addr_len = static_cast<socklen_t>(sizeof(peer_addr));
+  if (::getpeername(socket_fd, reinterpret_cast<struct sockaddr*>(&peer_addr),
                     &addr_len) < 0) {
     LOG_ERROR("Fail to get local network info when accepting!!!");
   }
-  return NetAddress(local_addr);
+  NetAddress peer_address;
+  peer_address.SetRawAddr(peer_addr, addr_len);
+  return peer_address;
 }
 }  // namespace
 
@@ -54,18 +62,12 @@ ServerReactorManager::ServerReactorManager(EventManagers* event_managers,
                                            const NetAddress& listen_address,
                                            bool should_reuse_port)
     : event_managers_(event_managers),
-      acceptor_(std::make_unique<Acceptor>((*event_managers_)[0]->GetPoller(),
-                                           listen_address, should_reuse_port)) {
-  if (acceptor_->Fd() >= 0 && !acceptor_->IsListening()) {
-    acceptor_->Listen();
-    acceptor_->RegisterNewConnectionCallback(
-        [this](int socket_fd, const NetAddress& peer_address) {
-          this->AcceptNewConnectionCallback(socket_fd, peer_address);
-        });
-  } else {
-    LOG_ERROR("Fail to init the acceptor!!!");
-    ::exit(-1);
-  }
+      handoff_drain_timeout_us_(0),
+      is_draining_(false),
+      is_drained_(false),
+      rebalancing_interval_us_(0),
+      overload_ratio_(1.5) {
+  AddListener(listen_address, should_reuse_port);
   for (size_t i = 0; i < event_managers->size(); ++i) {
     // "Initialize" "Reactor"s
     (*event_managers_)[i]->SetCreateConnectionCallback(
@@ -84,8 +86,86 @@ ServerReactorManager::ServerReactorManager(EventManagers* event_managers,
 }
 ServerReactorManager::~ServerReactorManager() {}
 
+void ServerReactorManager::AddListener(const NetAddress& listen_address,
+                                       bool should_reuse_port,
+                                       bool is_ipv6_only) {
+  // Listen on the socket handed off by the old process if there is one, so
+  // no connection is refused while restarting
+  int inherited_fd = ListenerHandoff::TakeInherited(listen_address);
+  auto acceptor =
+      inherited_fd >= 0
+          ? std::make_unique<Acceptor>((*event_managers_)[0]->GetPoller(),
+                                       listen_address, inherited_fd)
+          : std::make_unique<Acceptor>((*event_managers_)[0]->GetPoller(),
+                                       listen_address, should_reuse_port,
+                                       is_ipv6_only);
+  if (acceptor->Fd() >= 0 && !acceptor->IsListening()) {
+    acceptor->SetAdmissionController(&admission_controller_);
+    acceptor->Listen();
+    acceptor->RegisterNewConnectionCallback(
+        [this](int socket_fd, const NetAddress& peer_address) {
+          this->AcceptNewConnectionCallback(socket_fd, peer_address);
+        });
+  } else {
+    LOG_ERROR("Fail to init the acceptor!!!");
+    ::exit(-1);
+  }
+  acceptors_.push_back(std::move(acceptor));
+}
+
+void ServerReactorManager::SetBalancerStrategy(int strategy) {
+  balancer_->SetStrategy(strategy);
+}
+void ServerReactorManager::SetBalancerWeights(const std::vector<int>& weights) {
+  balancer_->SetWeights(weights);
+}
+
+void ServerReactorManager::SetAdmissionLimits(const AdmissionLimits& limits) {
+  admission_controller_.SetLimits(limits);
+}
+
+bool ServerReactorManager::MigrateConnection(Connecting& connection,
+                                             EventManager* target) {
+  if (!IsIoEventManager(target)) {
+    LOG_WARN("Fd(%d) can not be moved into a loop not of this server.",
+             connection.Fd());
+    return false;
+  }
+  return connection.StartMigrating(target);
+}
+void ServerReactorManager::EnableRebalancing(int64_t interval_microseconds,
+                                             double overload_ratio) {
+  rebalancing_interval_us_ = interval_microseconds;
+  overload_ratio_ = overload_ratio;
+}
+
+void ServerReactorManager::Drain(int64_t timeout_microseconds) {
+  (*event_managers_)[0]->RunSoon([this, timeout_microseconds]() {
+    this->DrainInLoop(timeout_microseconds);
+  });
+}
+
+void ServerReactorManager::EnableHandoff(const NetAddress& handoff_address,
+                                         int64_t drain_timeout_microseconds) {
+  handoff_drain_timeout_us_ = drain_timeout_microseconds;
+  handoff_acceptor_ = std::make_unique<Acceptor>(
+      (*event_managers_)[0]->GetPoller(), handoff_address, false);
+  handoff_acceptor_->RegisterNewConnectionCallback(
+      [this](int socket_fd, const NetAddress&) {
+        this->HandOffListeners(socket_fd);
+      });
+  // Nobody can connect before listening, so there is no window for others
+  ListenerHandoff::RestrictToOwner(handoff_address);
+  handoff_acceptor_->Listen();
+}
+
 void ServerReactorManager::Loop() {
   size_t io_thread_amount = (*event_managers_).size();
+  if (rebalancing_interval_us_ > 0 && io_thread_amount > 2) {
+    // The main thread only accepts, so it has time to watch I/O threads
+    (*event_managers_)[0]->RunEveryUntil(
+        rebalancing_interval_us_, [this]() { this->Rebalance(); });
+  }
   for (size_t i = 1; i < io_thread_amount; ++i) {
     // Start each event loop in the corresponding I/O thread
     (*event_managers_)[i]->Loop();
@@ -97,9 +177,33 @@ void ServerReactorManager::Loop() {
   // Let user do it by themselves
 }
 
+void ServerReactorManager::DeleteOneConnectingFromObjectPool(
+    Connecting* connecting_ptr) {
+  if (connecting_ptr->IsAdmitted() &&
+      admission_controller_.Release(connecting_ptr->GetPeerNetAddress()) &&
+      AdmissionPolicy::kPauseAccepting ==
+          admission_controller_.GetLimits().policy) {
+    // There is room again
+    (*event_managers_)[0]->RunSoon([this]() {
+      for (auto& acceptor : this->acceptors_) {
+        acceptor->ResumeAccepting();
+      }
+    });
+  }
+  LockGuard lock_guard(object_pool_lock_);
+  object_pool_.Delete(connecting_ptr);
+}
+
 void ServerReactorManager::AcceptNewConnectionCallback(
     int socket_fd, const NetAddress& peer_address) {
-  auto* event_manager = balancer_->PickOneEventManager();
+  auto* event_manager = PickOneEventManager();
+  if (nullptr == event_manager) {
+    LOG_DEBUG("Reject fd(%d) since all I/O threads are full.", socket_fd);
+    admission_controller_.Release(peer_address);
+    admission_controller_.AddRejected();
+    Acceptor::RejectConnection(socket_fd);
+    return;
+  }
   NetAddress local_address = GetLocalAddress(socket_fd);
   event_manager->RunSoon(
       [this, event_manager, socket_fd, local_address, peer_address]() {
@@ -110,11 +214,157 @@ void ServerReactorManager::AcceptNewConnectionCallback(
         new_connection->RegisterOnMessageCallback(MessageCallback_);
         new_connection->RegisterWriteCallback(WriteCompleteCallback_);
         new_connection->RegisterCloseCallback(CloseCallback_);
+        new_connection->SetMigratable(true);
+        new_connection->SetAdmitted(true);
         new_connection
             ->OnEstablishing();  // Set the status flag on and start reading
       });
 }
 
+EventManager* ServerReactorManager::PickOneEventManager() {
+  auto* event_manager = balancer_->PickOneEventManager();
+  size_t max_connections_per_loop =
+      admission_controller_.GetLimits().max_connections_per_loop;
+  if (0 == max_connections_per_loop ||
+      event_manager->GetLoopMetrics().GetActiveConnections() <
+          max_connections_per_loop) {
+    return event_manager;
+  }
+  // Counts are published by I/O threads, so a burst may go a little beyond
+  size_t io_thread_amount = (*event_managers_).size();
+  for (size_t i = io_thread_amount > 1 ? 1 : 0; i < io_thread_amount; ++i) {
+    if ((*event_managers_)[i]->GetLoopMetrics().GetActiveConnections() <
+        max_connections_per_loop) {
+      return (*event_managers_)[i];
+    }
+  }
+  return nullptr;
+}
+
+void ServerReactorManager::Rebalance() {
+  size_t io_thread_amount = (*event_managers_).size();
+  EventManager* hottest = nullptr;
+  EventManager* coolest = nullptr;
+  uint64_t max_bytes = 0;
+  uint64_t min_bytes = UINT64_MAX;
+  uint64_t total_bytes = 0;
+  for (size_t i = 1; i < io_thread_amount; ++i) {
+    auto* event_manager = (*event_managers_)[i];
+    uint64_t bytes = event_manager->GetLoopMetrics().GetBytesPerSecond();
+    total_bytes += bytes;
+    if (nullptr == hottest || bytes > max_bytes) {
+      max_bytes = bytes;
+      hottest = event_manager;
+    }
+    if (nullptr == coolest || bytes < min_bytes) {
+      min_bytes = bytes;
+      coolest = event_manager;
+    }
+  }
+  double mean = static_cast<double>(total_bytes) /
+                static_cast<double>(io_thread_amount - 1);
+  if (hottest == coolest || 0 == max_bytes ||
+      static_cast<double>(max_bytes) <= overload_ratio_ * mean ||
+      hottest->GetLoopMetrics().GetActiveConnections() < 2) {
+    return;
+  }
+  LOG_DEBUG("Rebalance: %lu bytes/s in the hottest loop, %lf on average.",
+            static_cast<unsigned long>(max_bytes), mean);
+  hottest->RunSoon(
+      [hottest, coolest]() { hottest->MigrateHeaviestConnection(coolest); });
+}
+void ServerReactorManager::DrainInLoop(int64_t timeout_microseconds) {
+  if (is_draining_.exchange(true)) {
+    return;
+  }
+  for (auto& acceptor : acceptors_) {
+    acceptor->StopAccepting();
+  }
+  if (handoff_acceptor_) {
+    handoff_acceptor_->StopAccepting();
+  }
+  LOG_NOTICE("The server starts draining within %ld us.",
+             static_cast<long>(timeout_microseconds));
+  if (DrainCallback_) {
+    size_t io_thread_amount = (*event_managers_).size();
+    for (size_t i = io_thread_amount > 1 ? 1 : 0; i < io_thread_amount; ++i) {
+      auto* event_manager = (*event_managers_)[i];
+      event_manager->RunSoon([event_manager, this]() {
+        event_manager->ForEachConnection(this->DrainCallback_);
+      });
+    }
+  }
+  int64_t deadline = TimePoint::FNow() + timeout_microseconds;
+  (*event_managers_)[0]->RunEveryUntil(
+      kDrainCheckingIntervalMicroseconds,
+      [this, deadline]() { this->CheckDrained(deadline); },
+      TimePoint(TimePoint::FNow()), [this]() { return !this->is_drained_; });
+}
+
+void ServerReactorManager::CheckDrained(int64_t deadline_microseconds) {
+  if (is_drained_) {
+    return;
+  }
+  size_t io_thread_amount = (*event_managers_).size();
+  size_t remaining = 0;
+  for (size_t i = io_thread_amount > 1 ? 1 : 0; i < io_thread_amount; ++i) {
+    remaining += (*event_managers_)[i]->GetLoopMetrics().GetActiveConnections();
+  }
+  if (remaining > 0 && TimePoint::FNow() < deadline_microseconds) {
+    return;
+  }
+  is_drained_ = true;
+  if (remaining > 0) {
+    LOG_WARN("Draining times out, %zu connection(s) left are closed.",
+             remaining);
+  } else {
+    LOG_NOTICE("The server is drained.");
+  }
+  // Each I/O loop closes what is left when leaving, which must be done before
+  // "Loop()" returns and the server goes away
+  for (size_t i = 1; i < io_thread_amount; ++i) {
+    (*event_managers_)[i]->Quit();
+    (*event_managers_)[i]->Join();
+  }
+  (*event_managers_)[0]->Quit();
+}
+
+void ServerReactorManager::HandOffListeners(int socket_fd) {
+  if (is_draining_.load()) {
+    ::close(socket_fd);
+    return;
+  }
+  std::vector<int> listening_fds;
+  listening_fds.reserve(acceptors_.size());
+  for (auto& acceptor : acceptors_) {
+    listening_fds.push_back(acceptor->Fd());
+  }
+  bool is_handed_off = ListenerHandoff::SendListeners(socket_fd, listening_fds);
+  ::close(socket_fd);
+  if (!is_handed_off) {
+    // Keep serving, the new process has to bind by itself
+    return;
+  }
+  for (auto& acceptor : acceptors_) {
+    acceptor->HandOver();
+  }
+  handoff_acceptor_->HandOver();  // The new process serves the next handoff
+  LOG_NOTICE("Hand off %zu listening socket(s) to the new process.",
+             listening_fds.size());
+  DrainInLoop(handoff_drain_timeout_us_);
+}
+
+bool ServerReactorManager::IsIoEventManager(
+    const EventManager* event_manager) const {
+  size_t io_thread_amount = (*event_managers_).size();
+  for (size_t i = io_thread_amount > 1 ? 1 : 0; i < io_thread_amount; ++i) {
+    if ((*event_managers_)[i] == event_manager) {
+      return true;
+    }
+  }
+  return false;
+}
+
 ClientReactorManager::ClientReactorManager(EventManager* event_manager,
                                            const NetAddress& server_address)
     : event_manager_(event_manager),
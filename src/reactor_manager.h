@@ -15,11 +15,13 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "acceptor.h"
+#include "admission_controller.h"
 #include "connecting.h"
 #include "connector.h"
 #include "net_address.h"
@@ -50,6 +52,11 @@ class ServerReactorManager : NonCopyableMovable {
                        bool should_reuse_port = false);
   ~ServerReactorManager();
 
+  // Listen to one more address (of any family, before starting), whose
+  // connections share the same callbacks and I/O threads
+  void AddListener(const NetAddress& listen_address,
+                   bool should_reuse_port = false, bool is_ipv6_only = false);
+
   void SetConnectionCallback(const NormalCallback& cb) {
     ConnectionCallback_ = cb;
   }
@@ -59,6 +66,43 @@ class ServerReactorManager : NonCopyableMovable {
   }
   void SetCloseCallback(const NormalCallback& cb) { CloseCallback_ = cb; }
 
+  // Choose how new connections are dispatched (see "BalancerStrategy") and the
+  // weights of I/O threads for the weighted strategy (before starting)
+  void SetBalancerStrategy(int strategy);
+  void SetBalancerWeights(const std::vector<int>& weights);
+
+  // Limit the connections served and how fast they come (before starting)
+  void SetAdmissionLimits(const AdmissionLimits& limits);
+  const AdmissionController& GetAdmissionController() const {
+    return admission_controller_;
+  }
+
+  // Move the connection into another I/O thread of this server (called in the
+  // thread of the connection), return false if it can not be moved now
+  bool MigrateConnection(Connecting& connection, EventManager* target);
+
+  // Check the load of I/O threads at certain intervals (before starting), and
+  // when the bytes per second of the hottest one exceeds "overload_ratio"
+  // times the mean, move its heaviest connection into the coolest one
+  void EnableRebalancing(int64_t interval_microseconds,
+                         double overload_ratio = 1.5);
+
+  // Stop accepting, give the existing connections up to the timeout to finish
+  // (then close the ones left), and quit all event loops so "Loop()" returns
+  // (called in any thread)
+  void Drain(int64_t timeout_microseconds);
+  bool IsDraining() const { return is_draining_.load(); }
+
+  // Be called in the thread of each connection when draining starts, like to
+  // tell the peer to go away once the current request is answered
+  void SetDrainCallback(const NormalCallback& cb) { DrainCallback_ = cb; }
+
+  // Serve a handoff socket (a Unix domain one, before starting) from which a
+  // new process takes the listening sockets (see "ListenerHandoff"), then
+  // drain within the timeout
+  void EnableHandoff(const NetAddress& handoff_address,
+                     int64_t drain_timeout_microseconds);
+
   // Drive the engine (push everything starting -- start all event loops)
   void Loop();
 
@@ -70,10 +114,7 @@ class ServerReactorManager : NonCopyableMovable {
   }
 
   // Delete a connection from the object pool
-  void DeleteOneConnectingFromObjectPool(Connecting* connecting_ptr) {
-    LockGuard lock_guard(object_pool_lock_);
-    object_pool_.Delete(connecting_ptr);
-  }
+  void DeleteOneConnectingFromObjectPool(Connecting* connecting_ptr);
 
  private:
   typedef std::unique_ptr<Acceptor> AcceptorPtr;
@@ -83,16 +124,49 @@ class ServerReactorManager : NonCopyableMovable {
   void AcceptNewConnectionCallback(int socket_fd,
                                    const NetAddress& peer_address);
 
+  // Pick the I/O thread for the new connection (nullptr if all are full)
+  EventManager* PickOneEventManager();
+
+  // Move one heavy connection off the hottest I/O thread if it is overloaded
+  void Rebalance();
+
+  bool IsIoEventManager(const EventManager* event_manager) const;
+
+  void DrainInLoop(int64_t timeout_microseconds);
+
+  // Quit all event loops once no connection is left or the deadline passes
+  void CheckDrained(int64_t deadline_microseconds);
+
+  // Send the listening sockets to the new process connected, then drain
+  void HandOffListeners(int socket_fd);
+
   // Event managers which are the "Reactor"s that manages events in their own
   // I/O threads
   EventManagers* event_managers_;
 
-  // Acceptor for accepting new connections in the main thread
-  AcceptorPtr acceptor_;
+  // Acceptors (one per listening address) for accepting new connections in
+  // the main thread
+  std::vector<AcceptorPtr> acceptors_;
+
+  // Admission control shared by all acceptors
+  AdmissionController admission_controller_;
+
+  // Acceptor of the handoff socket (nullptr if hot restarts are not enabled)
+  AcceptorPtr handoff_acceptor_;
+  int64_t handoff_drain_timeout_us_;
+
+  // Set once draining starts (by the main thread), and "is_drained_" once
+  // all event loops are told to quit
+  std::atomic_bool is_draining_;
+  bool is_drained_;
 
   // Load balancer for dispatching new connections into I/O threads
   BalancerPtr balancer_;
 
+  // Interval of rebalancing (0 means never) and the overload threshold
+  int64_t rebalancing_interval_us_;
+  double overload_ratio_;
+
   // Callback function which will be called after this TCP connection creating
   // and before this TCP connection destroying
   NormalCallback ConnectionCallback_;
@@ -107,6 +181,10 @@ class ServerReactorManager : NonCopyableMovable {
   // closed
   NormalCallback CloseCallback_;
 
+  // Callback function which will be called for each connection when draining
+  // starts
+  NormalCallback DrainCallback_;
+
   // Object pool for connections
   ObjectPool<Connecting> object_pool_;
 
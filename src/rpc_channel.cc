@@ -11,6 +11,7 @@
 
 #include "rpc_channel.h"
 
+#include <errno.h>
 #include <google/protobuf/descriptor.h>
 
 #include "logger.h"
@@ -20,6 +21,8 @@
 
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kRpcLog);
+
 const char kRpcTag[] = "RPC0";
 
 RpcAsyncChannel::RpcAsyncChannel()
@@ -30,7 +33,8 @@ RpcAsyncChannel::RpcAsyncChannel()
       }),
       connection_(nullptr),
       services_(nullptr) {
-  LOG_INFO("RpcAsyncChannel::RpcAsyncChannel - %p", this);
+  LOG_KV(logger::kDebug, "rpc_async_channel_create", "channel",
+         static_cast<const void*>(this));
 }
 RpcAsyncChannel::RpcAsyncChannel(Connecting& connection)
     : codec_([this](Connecting& connection,
@@ -40,10 +44,12 @@ RpcAsyncChannel::RpcAsyncChannel(Connecting& connection)
       }),
       connection_(const_cast<Connecting*>(&connection)),
       services_(nullptr) {
-  LOG_INFO("RpcAsyncChannel::RpcAsyncChannel - %p", this);
+  LOG_KV(logger::kDebug, "rpc_async_channel_create", "channel",
+         static_cast<const void*>(this));
 }
 RpcAsyncChannel::~RpcAsyncChannel() {
-  LOG_INFO("RpcAsyncChannel::~RpcAsyncChannel - %p", this);
+  LOG_KV(logger::kDebug, "rpc_async_channel_destroy", "channel",
+         static_cast<const void*>(this));
   for (auto itr = outstanding_calls_.begin(); itr != outstanding_calls_.end();
        ++itr) {
     auto outstanding_call = itr->second;
@@ -172,7 +178,8 @@ RpcSyncChannel::RpcSyncChannel(const NetAddress& server_address)
       }),
       socket_fd_(::socket(server_address.GetFamily(),
                           SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP)) {
-  LOG_INFO("RpcSyncChannel::RpcSyncChannel - %p", this);
+  LOG_KV(logger::kInfo, "rpc_sync_channel_create", "channel",
+         static_cast<const void*>(this));
   if (socket_fd_ < 0) {
     LOG_ERROR("Fail to initialize for the socket fd of new RpcSyncChannel!!!");
     ::exit(-1);
@@ -184,15 +191,16 @@ RpcSyncChannel::RpcSyncChannel(const NetAddress& server_address)
 #endif
   if (::connect(socket_fd_, server_address_.GetNetAddress(),
                 server_address_.GetSize()) == -1) {
-    LOG_ERROR("RpcSyncChannel cannot connect to [ IP(%s), Port(%s) ]!!!",
-              server_address_.GetIp().c_str(),
-              std::to_string(server_address_.GetPort()).c_str());
+    LOG_KV(logger::kError, "rpc_connect_error", "server_ip",
+           server_address_.GetIp(), "server_port", server_address_.GetPort(),
+           "err", errno);
     ::close(socket_fd_);
     socket_fd_ = -100;
   }
 }
 RpcSyncChannel::~RpcSyncChannel() {
-  LOG_INFO("RpcSyncChannel::~RpcSyncChannel - %p", this);
+  LOG_KV(logger::kInfo, "rpc_sync_channel_destroy", "channel",
+         static_cast<const void*>(this));
   if (socket_fd_ >= 0) {
     ::close(socket_fd_);
   }
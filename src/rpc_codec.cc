@@ -10,6 +10,7 @@
 
 #include "rpc_codec.h"
 
+#include <errno.h>
 #include <google/protobuf/message_lite.h>
 #include <google/protobuf/stubs/common.h>
 #include <stddef.h>
@@ -33,6 +34,9 @@
 #include "rpc.pb.h"
 
 namespace taotu {
+
+USE_LOG_CATEGORY(logger::kRpcLog);
+
 namespace {
 
 int ProtobufVersionCheck() {
@@ -48,11 +52,11 @@ static bool CheckSocketStatusValid(int sock_fd) {
   int error;
   socklen_t len = sizeof(error);
   if (::getsockopt(sock_fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
-    LOG_ERROR("Fd(%d) - getsockopt() failed!", sock_fd);
+    LOG_KV(logger::kError, "rpc_socket_error", "fd", sock_fd, "err", errno);
     return false;
   }
   if (error != 0) {
-    LOG_ERROR("Fd(%d) - errno(%d)!", sock_fd, error);
+    LOG_KV(logger::kError, "rpc_socket_error", "fd", sock_fd, "err", error);
     return false;
   }
   return true;
@@ -125,8 +129,8 @@ void RpcCodec::OnMessage(int sock_fd, IoBuffer* io_buffer,
     io_buffer->ReadFromFd(
         sock_fd, min_header_len - io_buffer->GetReadableBytes(), &saved_errno);
     if (saved_errno != 0) {
-      LOG_ERROR("RpcCodec::OnMessage() - Fd(%d) with errno(%d)", sock_fd,
-                saved_errno);
+      LOG_KV(logger::kError, "rpc_read_error", "fd", sock_fd, "err",
+             saved_errno);
     }
   }
   const int32_t len = io_buffer->GetReadableInt32();
@@ -267,8 +271,8 @@ void RpcCodec::AsyncDefaultErrorCallback(Connecting& connection,
                                          IoBuffer* io_buffer,
                                          TimePoint time_point,
                                          ErrorCode error_code) {
-  LOG_ERROR("RpcCodec::DefaultErrorCallback - %s",
-            ErrorCode2String(error_code).c_str());
+  LOG_KV(logger::kError, "rpc_codec_error", "fd", connection.Fd(), "error",
+         ErrorCode2String(error_code));
   if (connection.IsConnected()) {
     const_cast<Connecting&>(connection).ShutDownWrite();
   }
@@ -276,12 +280,10 @@ void RpcCodec::AsyncDefaultErrorCallback(Connecting& connection,
 void RpcCodec::SyncDefaultErrorCallback(int sock_fd, IoBuffer* io_buffer,
                                         TimePoint time_point,
                                         ErrorCode error_code) {
-  LOG_ERROR("RpcCodec::DefaultErrorCallback - %s",
-            ErrorCode2String(error_code).c_str());
+  LOG_KV(logger::kError, "rpc_codec_error", "fd", sock_fd, "error",
+         ErrorCode2String(error_code));
   if (!CheckSocketStatusValid(sock_fd)) {
-    LOG_ERROR(
-        "RpcCodec::SyncDefaultErrorCallback() - Fd(%d) - socket invalid!!!",
-        sock_fd);
+    LOG_KV(logger::kError, "rpc_socket_invalid", "fd", sock_fd);
   }
 }
 
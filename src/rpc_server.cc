@@ -20,6 +20,8 @@
 
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kRpcLog);
+
 RpcServer::RpcServer(EventManagers* event_managers,
                      const NetAddress& listen_address)
     : server_(event_managers, listen_address) {
@@ -35,12 +37,12 @@ void RpcServer::RegisterService(::google::protobuf::Service* service) {
 void RpcServer::Start() { server_.Start(); }
 
 void RpcServer::OnConnectionCallback(Connecting& connection) {
-  LOG_NOTICE("RpcServer - [ IP(%s), Port(%s) ] -> [ IP(%s), Port(%s) ] %s",
-             connection.GetLocalNetAddress().GetIp().c_str(),
-             std::to_string(connection.GetLocalNetAddress().GetPort()).c_str(),
-             connection.GetPeerNetAddress().GetIp().c_str(),
-             std::to_string(connection.GetPeerNetAddress().GetPort()).c_str(),
-             (connection.IsConnected() ? "UP" : "DOWN"));
+  LOG_KV(logger::kNotice, "rpc_conn", "fd", connection.Fd(), "local_ip",
+         connection.GetLocalNetAddress().GetIp(), "local_port",
+         connection.GetLocalNetAddress().GetPort(), "peer_ip",
+         connection.GetPeerNetAddress().GetIp(), "peer_port",
+         connection.GetPeerNetAddress().GetPort(), "state",
+         connection.IsConnected() ? "up" : "down");
   if (connection.IsConnected()) {
     std::shared_ptr<RpcAsyncChannel> rpc_channel =
         std::make_shared<RpcAsyncChannel>(connection);
@@ -52,8 +54,7 @@ void RpcServer::OnConnectionCallback(Connecting& connection) {
     });
     connection.SetContext<std::shared_ptr<RpcAsyncChannel>>(rpc_channel);
   } else {
-    connection.SetContext<std::shared_ptr<RpcAsyncChannel>>(
-        std::shared_ptr<RpcAsyncChannel>());
+    connection.ResetContext();
   }
 }
 
@@ -18,6 +18,8 @@
 
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kConnectionLog);
+
 Server::Server(EventManagers* event_managers, const NetAddress& listen_address,
                bool should_reuse_port)
     : reactor_manager_(event_managers, listen_address, should_reuse_port),
@@ -34,6 +36,12 @@ Server::Server(EventManagers* event_managers, const NetAddress& listen_address,
       [this](Connecting& connection) { this->RemoveConnection(connection); });
 }
 
+void Server::AddListener(const NetAddress& listen_address,
+                         bool should_reuse_port, bool is_ipv6_only) {
+  reactor_manager_.AddListener(listen_address, should_reuse_port,
+                               is_ipv6_only);
+}
+
 void Server::SetConnectionCallback(const std::function<void(Connecting&)>& cb) {
   reactor_manager_.SetConnectionCallback(cb);
 }
@@ -49,6 +57,40 @@ void Server::SetCloseCallback(const std::function<void(Connecting&)>& cb) {
   reactor_manager_.SetCloseCallback(cb);
 }
 
+void Server::SetBalancerStrategy(int strategy) {
+  reactor_manager_.SetBalancerStrategy(strategy);
+}
+void Server::SetBalancerWeights(const std::vector<int>& weights) {
+  reactor_manager_.SetBalancerWeights(weights);
+}
+
+void Server::SetAdmissionLimits(const AdmissionLimits& limits) {
+  reactor_manager_.SetAdmissionLimits(limits);
+}
+const AdmissionController& Server::GetAdmissionController() const {
+  return reactor_manager_.GetAdmissionController();
+}
+
+bool Server::MigrateConnection(Connecting& connection, EventManager* target) {
+  return reactor_manager_.MigrateConnection(connection, target);
+}
+void Server::EnableRebalancing(int64_t interval_microseconds,
+                               double overload_ratio) {
+  reactor_manager_.EnableRebalancing(interval_microseconds, overload_ratio);
+}
+
+void Server::Drain(int64_t timeout_microseconds) {
+  reactor_manager_.Drain(timeout_microseconds);
+}
+bool Server::IsDraining() const { return reactor_manager_.IsDraining(); }
+void Server::SetDrainCallback(const std::function<void(Connecting&)>& cb) {
+  reactor_manager_.SetDrainCallback(cb);
+}
+void Server::EnableHandoff(const NetAddress& handoff_address,
+                           int64_t drain_timeout_microseconds) {
+  reactor_manager_.EnableHandoff(handoff_address, drain_timeout_microseconds);
+}
+
 void Server::Start() {
   if (!is_started_.load()) {
     is_started_.store(true);
@@ -57,19 +99,17 @@ void Server::Start() {
 }
 
 void Server::RemoveConnection(Connecting& connection) {
-  LOG_DEBUG("The connection with fd(%d) is being removed.", connection.Fd());
+  LOG_KV(logger::kDebug, "conn_remove", "fd", connection.Fd());
   connection.ForceClose();
 }
 
 void Server::DefaultOnConnectionCallback(Connecting& connection) {
-  LOG_DEBUG(
-      "A new connection with fd(%d) on local [ IP(%s) Port(%u) ] and peer [ "
-      "IP(%s) Port(%u) ] is %s now.",
-      connection.Fd(), connection.GetLocalNetAddress().GetIp().c_str(),
-      connection.GetLocalNetAddress().GetPort(),
-      connection.GetPeerNetAddress().GetIp().c_str(),
-      connection.GetPeerNetAddress().GetPort(),
-      (connection.IsConnected() ? "created" : "closed"));
+  LOG_KV(logger::kDebug, "conn_state", "fd", connection.Fd(), "local_ip",
+         connection.GetLocalNetAddress().GetIp(), "local_port",
+         connection.GetLocalNetAddress().GetPort(), "peer_ip",
+         connection.GetPeerNetAddress().GetIp(), "peer_port",
+         connection.GetPeerNetAddress().GetPort(), "state",
+         connection.IsConnected() ? "up" : "down");
 }
 void Server::DefaultOnMessageCallback(Connecting& connection,
                                       IoBuffer* io_buffer,
@@ -15,6 +15,7 @@
 #include <atomic>
 #include <functional>
 
+#include "admission_controller.h"
 #include "connecting.h"
 #include "io_buffer.h"
 #include "net_address.h"
@@ -38,12 +39,51 @@ class Server : NonCopyableMovable {
                   const NetAddress& listen_address,
                   bool should_reuse_port = false);
 
+  // Listen to one more address before starting, like another port, an IPv6
+  // one or a Unix domain socket ("NetAddress::FromUnixPath()")
+  void AddListener(const NetAddress& listen_address,
+                   bool should_reuse_port = false, bool is_ipv6_only = false);
+
   void SetConnectionCallback(const std::function<void(Connecting&)>& cb);
   void SetMessageCallback(
       const std::function<void(Connecting&, IoBuffer*, TimePoint)>& cb);
   void SetWriteCompleteCallback(const std::function<void(Connecting&)>& cb);
   void SetCloseCallback(const std::function<void(Connecting&)>& cb);
 
+  // Choose how new connections are dispatched into I/O threads (see
+  // "BalancerStrategy", round robin by default) before starting
+  void SetBalancerStrategy(int strategy);
+  void SetBalancerWeights(const std::vector<int>& weights);
+
+  // Limit the connections served and how fast they come before starting (see
+  // "AdmissionLimits"), the ones beyond are reset at once
+  void SetAdmissionLimits(const AdmissionLimits& limits);
+  const AdmissionController& GetAdmissionController() const;
+
+  // Move the connection into another I/O thread (see
+  // "ServerReactorManager::MigrateConnection()")
+  bool MigrateConnection(Connecting& connection, EventManager* target);
+
+  // Move heavy connections off overloaded I/O threads automatically (see
+  // "ServerReactorManager::EnableRebalancing()") before starting
+  void EnableRebalancing(int64_t interval_microseconds,
+                         double overload_ratio = 1.5);
+
+  // Stop accepting and let the existing connections finish within the timeout
+  // (the ones left are closed then), after which "Start()" returns (called in
+  // any thread)
+  void Drain(int64_t timeout_microseconds);
+  bool IsDraining() const;
+
+  // Be called in the thread of each connection when draining starts
+  void SetDrainCallback(const std::function<void(Connecting&)>& cb);
+
+  // Serve the Unix domain socket (before starting) from which a new process
+  // takes the listening sockets by "ListenerHandoff::Inherit()" for a hot
+  // restart, after which this server drains within the timeout
+  void EnableHandoff(const NetAddress& handoff_address,
+                     int64_t drain_timeout_microseconds);
+
   // Start all "Reactors" (make all event loops run)
   void Start();
 
@@ -23,6 +23,8 @@
 
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kConnectionLog);
+
 namespace {
 bool IsAccept4Unavailable(int err) {
   return err == ENOSYS || err == EINVAL || err == EPERM;
@@ -146,6 +148,15 @@ void Socketer::SetKeepAlive(bool on) const {
   }
 }
 
+void Socketer::SetIpv6Only(bool on) const {
+  int opt = on ? 1 : 0;
+  if (::setsockopt(socket_fd_, IPPROTO_IPV6, IPV6_V6ONLY, &opt,
+                   static_cast<socklen_t>(sizeof(opt))) < 0) {
+    LOG_ERROR("SocketFd(%d) failed to set IPv6 only %s!!!", socket_fd_,
+              (on ? "on" : "off"));
+  }
+}
+
 bool Socketer::SetNonBlockAndCloexec(int fd) {
   int flags = ::fcntl(fd, F_GETFL, 0);
   if (flags < 0) {
@@ -170,14 +181,15 @@ bool Socketer::SetNonBlockAndCloexec(int fd) {
 
 int Socketer::CreateNonblockingTcpSocket(const NetAddress& address) {
   int fd = ::socket(address.GetFamily(),
-                    SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+                    SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    GetStreamProtocol(address));
   if (fd >= 0) {
     return fd;
   }
   int saved_errno = errno;
   LOG_WARN("socket with flags failed (errno %d: %s), fallback to fcntl path.",
            saved_errno, ::strerror(saved_errno));
-  fd = ::socket(address.GetFamily(), SOCK_STREAM, IPPROTO_TCP);
+  fd = ::socket(address.GetFamily(), SOCK_STREAM, GetStreamProtocol(address));
   if (fd < 0) {
     return fd;
   }
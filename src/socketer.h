@@ -58,10 +58,17 @@ class Socketer : NonCopyableMovable {
   void SetReuseAddress(bool on) const;
   void SetReusePort(bool on) const;
   void SetKeepAlive(bool on) const;
+  // Accept only IPv6 (or IPv4-mapped ones too, the dual stack) on AF_INET6
+  void SetIpv6Only(bool on) const;
 
   // Helpers
   static bool SetNonBlockAndCloexec(int fd);
+  // Create a TCP socket (or a Unix domain stream one for AF_UNIX addresses)
   static int CreateNonblockingTcpSocket(const NetAddress& address);
+  // Protocol of stream sockets of the address family
+  static int GetStreamProtocol(const NetAddress& address) {
+    return address.IsUnix() ? 0 : IPPROTO_TCP;
+  }
 
  private:
   void Close() const;
@@ -13,11 +13,21 @@
 
 #include <utility>
 
+#include "logger.h"
+
 namespace taotu {
 
+USE_LOG_CATEGORY(logger::kTimerLog);
+
 void Timer::AddTimeTask(const TimePoint& time_point, TimeCallback TimeTask) {
-  LockGuard lock_guard(mutex_lock_);
-  time_points_.insert({time_point, std::move(TimeTask)});
+  size_t task_amount = 0;
+  {
+    LockGuard lock_guard(mutex_lock_);
+    time_points_.insert({time_point, std::move(TimeTask)});
+    task_amount = time_points_.size();
+  }
+  LOG_DEBUG("Timer adds a task at %lld ms, %zu tasks are waiting.",
+            static_cast<long long>(time_point.GetMillisecond()), task_amount);
 }
 
 int Timer::GetMinTimeDuration() const {
@@ -43,6 +53,9 @@ Timer::ExpiredTimeTasks Timer::GetExpiredTimeTasks() {
     }
     time_points_.erase(time_points_.begin(), itr);
   }
+  if (!expired_time_tasks.empty()) {
+    LOG_DEBUG("Timer takes %zu expired tasks.", expired_time_tasks.size());
+  }
   return expired_time_tasks;
 }
 
@@ -0,0 +1,81 @@
+#include "../src/admission_controller.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../src/net_address.h"
+
+namespace {
+
+taotu::NetAddress MakePeer(const std::string& ip, bool use_ipv6 = false) {
+  return taotu::NetAddress{ip, 4567, use_ipv6};
+}
+
+}  // namespace
+
+TEST(AdmissionControllerTest, ConnectionLimit) {
+  taotu::AdmissionController admission_controller;
+  taotu::AdmissionLimits limits;
+  limits.max_connections = 2;
+  admission_controller.SetLimits(limits);
+  auto peer = MakePeer("10.0.0.1");
+  ASSERT_EQ(admission_controller.Admit(peer, 1),
+            taotu::AdmissionController::Verdict::kAdmitted);
+  ASSERT_EQ(admission_controller.Admit(peer, 1),
+            taotu::AdmissionController::Verdict::kAdmitted);
+  ASSERT_TRUE(admission_controller.IsFull());
+  ASSERT_EQ(admission_controller.Admit(peer, 1),
+            taotu::AdmissionController::Verdict::kTooManyConnections);
+  ASSERT_TRUE(admission_controller.Release(peer));  // Was full
+  ASSERT_FALSE(admission_controller.Release(peer));
+  ASSERT_EQ(admission_controller.GetConnectionAmount(), static_cast<size_t>(0));
+}
+
+TEST(AdmissionControllerTest, PerIpLimits) {
+  taotu::AdmissionController admission_controller;
+  taotu::AdmissionLimits limits;
+  limits.max_connections_per_ip = 2;
+  limits.max_accepts_per_ip_per_second = 3;
+  admission_controller.SetLimits(limits);
+  auto peer = MakePeer("10.0.0.1");
+  auto other_peer = MakePeer("::ffff:10.0.0.2", true);
+  ASSERT_EQ(admission_controller.Admit(peer, 1),
+            taotu::AdmissionController::Verdict::kAdmitted);
+  ASSERT_EQ(admission_controller.Admit(peer, 1),
+            taotu::AdmissionController::Verdict::kAdmitted);
+  ASSERT_EQ(admission_controller.Admit(peer, 1),
+            taotu::AdmissionController::Verdict::kTooManyConnectionsFromIp);
+  ASSERT_EQ(admission_controller.Admit(other_peer, 1),
+            taotu::AdmissionController::Verdict::kAdmitted);
+
+  // The 4th attempt in the same second is too frequent even after releasing
+  admission_controller.Release(peer);
+  ASSERT_EQ(admission_controller.Admit(peer, 1),
+            taotu::AdmissionController::Verdict::kTooFrequentFromIp);
+  ASSERT_EQ(admission_controller.Admit(peer, 2),
+            taotu::AdmissionController::Verdict::kAdmitted);
+}
+
+TEST(AdmissionControllerTest, TrackedIpsArePurged) {
+  taotu::AdmissionController admission_controller;
+  taotu::AdmissionLimits limits;
+  limits.max_connections_per_ip = 1;
+  limits.max_tracked_ips = 4;
+  admission_controller.SetLimits(limits);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(admission_controller.Admit(
+                  MakePeer("10.0.1." + std::to_string(i)), 1),
+              taotu::AdmissionController::Verdict::kAdmitted);
+  }
+  ASSERT_EQ(admission_controller.Admit(MakePeer("10.0.2.1"), 2),
+            taotu::AdmissionController::Verdict::kTooManyIps);
+
+  // Idle IPs are dropped to make room
+  admission_controller.Release(MakePeer("10.0.1.0"));
+  admission_controller.Release(MakePeer("10.0.1.1"));
+  ASSERT_EQ(admission_controller.Admit(MakePeer("10.0.2.1"), 2),
+            taotu::AdmissionController::Verdict::kAdmitted);
+  ASSERT_EQ(admission_controller.Admit(MakePeer("10.0.1.2"), 2),
+            taotu::AdmissionController::Verdict::kTooManyConnectionsFromIp);
+}
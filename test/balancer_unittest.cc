@@ -0,0 +1,104 @@
+#include "../src/balancer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "../src/event_manager.h"
+#include "../src/logger.h"
+#include "../src/loop_metrics.h"
+
+namespace {
+
+constexpr size_t kIoThreadAmount = 3;
+
+}  // namespace
+
+class BalancerTest : public ::testing::Test {
+ protected:
+  static void TearDownTestSuite() { taotu::END_LOG(); }
+
+  void SetUp() override {
+    // The first one only accepts and is never picked
+    for (size_t i = 0; i <= kIoThreadAmount; ++i) {
+      event_managers_.push_back(new taotu::EventManager);
+    }
+  }
+  void TearDown() override {
+    for (auto* event_manager : event_managers_) {
+      delete event_manager;
+    }
+  }
+
+  // Publish one window of load for the I/O thread
+  void Publish(size_t index, int64_t work_us, size_t bytes) {
+    auto* loop_metrics = event_managers_[index]->GetMutableLoopMetrics();
+    if (0 == clocks_[index]) {  // Open the first window
+      clocks_[index] = 1;
+      loop_metrics->OnLoopIteration(clocks_[index], 0, 0);
+    }
+    clocks_[index] += taotu::LoopMetrics::kWindowMicroseconds;
+    loop_metrics->AddBytes(bytes);
+    loop_metrics->OnLoopIteration(clocks_[index], work_us, 1);
+  }
+
+  std::vector<taotu::EventManager*> event_managers_;
+  std::vector<int64_t> clocks_ = std::vector<int64_t>(kIoThreadAmount + 1, 0);
+};
+
+TEST_F(BalancerTest, LeastBytesPerSecond) {
+  Publish(1, 0, 300 * 1024);
+  Publish(2, 0, 100 * 1024);
+  Publish(3, 0, 200 * 1024);
+  ASSERT_EQ(event_managers_[2]->GetLoopMetrics().GetBytesPerSecond(),
+            static_cast<uint64_t>(1000 * 1024));
+  taotu::Balancer balancer(&event_managers_,
+                           taotu::BalancerStrategy::kLeastBytesPerSecond);
+  ASSERT_EQ(balancer.PickOneEventManager(), event_managers_[2]);
+  // Equal load is broken by the amount of connections
+  Publish(1, 0, 100 * 1024);
+  event_managers_[2]->GetMutableLoopMetrics()->OnConnectionInserted();
+  ASSERT_EQ(balancer.PickOneEventManager(), event_managers_[1]);
+}
+
+TEST_F(BalancerTest, PowerOfTwoChoices) {
+  Publish(1, 10 * 1000, 0);
+  Publish(2, 50 * 1000, 0);
+  Publish(3, 90 * 1000, 0);
+  ASSERT_EQ(event_managers_[3]->GetLoopMetrics().GetBusyPermille(),
+            static_cast<uint32_t>(900));
+  taotu::Balancer balancer(&event_managers_,
+                           taotu::BalancerStrategy::kPowerOfTwoChoices);
+  std::vector<size_t> pick_counts(kIoThreadAmount + 1, 0);
+  for (int i = 0; i < 3000; ++i) {
+    auto* event_manager = balancer.PickOneEventManager();
+    for (size_t j = 0; j <= kIoThreadAmount; ++j) {
+      if (event_managers_[j] == event_manager) {
+        ++pick_counts[j];
+      }
+    }
+  }
+  // The busiest one always loses its comparison
+  ASSERT_EQ(pick_counts[0], static_cast<size_t>(0));
+  ASSERT_EQ(pick_counts[3], static_cast<size_t>(0));
+  ASSERT_GT(pick_counts[1], pick_counts[2]);
+  ASSERT_GT(pick_counts[2], static_cast<size_t>(0));
+}
+
+TEST_F(BalancerTest, Weighted) {
+  taotu::Balancer balancer(&event_managers_,
+                           taotu::BalancerStrategy::kWeighted);
+  balancer.SetWeights({0, 1, 2, 3});
+  std::vector<taotu::EventManager*> picks;
+  for (int i = 0; i < 60; ++i) {
+    picks.push_back(balancer.PickOneEventManager());
+  }
+  for (size_t j = 1; j <= kIoThreadAmount; ++j) {
+    ASSERT_EQ(std::count(picks.begin(), picks.end(), event_managers_[j]),
+              static_cast<std::ptrdiff_t>(10 * j));
+  }
+  // Picks are interleaved instead of bursting
+  ASSERT_NE(picks[0], picks[1]);
+}
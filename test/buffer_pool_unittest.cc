@@ -0,0 +1,195 @@
+#include "../src/buffer_pool.h"
+
+#include <gtest/gtest.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <deque>
+#include <string>
+
+#include "../src/io_buffer.h"
+#include "../src/logger.h"
+
+namespace {
+
+constexpr size_t kBuffersPerConnection = 3;
+
+// Resident set size of this process in bytes
+int64_t GetRss() {
+  size_t total_pages = 0;
+  size_t resident_pages = 0;
+  FILE* statm = ::fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+  if (::fscanf(statm, "%zu %zu", &total_pages, &resident_pages) != 2) {
+    resident_pages = 0;
+  }
+  ::fclose(statm);
+  return static_cast<int64_t>(resident_pages) * ::sysconf(_SC_PAGESIZE);
+}
+
+// 100k by default, or set by "TAOTU_IDLE_CONNECTION_AMOUNT"
+size_t GetIdleConnectionAmount() {
+  const char* amount = ::getenv("TAOTU_IDLE_CONNECTION_AMOUNT");
+  if (amount != nullptr && ::strtoull(amount, nullptr, 10) > 0) {
+    return static_cast<size_t>(::strtoull(amount, nullptr, 10));
+  }
+  return 100000;
+}
+
+// RSS grown by each connection (in bytes)
+struct ConnectionRss {
+  int64_t busy;  // All connections hold data at the same time
+  int64_t idle;  // All of them are drained then
+};
+
+// Let all connections (3 buffers each) carry one small message together and
+// then go idle, where buffers take storage from the pool if it is given, or
+// keep their own storage on the heap as before
+ConnectionRss MeasureConnections(size_t connection_amount,
+                                 taotu::BufferPool* buffer_pool) {
+  const std::string message(64, 'x');
+  int64_t rss_before = GetRss();
+  std::deque<taotu::IoBuffer> io_buffers;
+  for (size_t i = 0; i < connection_amount * kBuffersPerConnection; ++i) {
+    if (buffer_pool != nullptr) {
+      io_buffers.emplace_back(buffer_pool);
+    } else {
+      io_buffers.emplace_back();
+    }
+  }
+  for (auto& io_buffer : io_buffers) {
+    io_buffer.Append(message.data(), message.size());
+  }
+  int64_t rss_busy = GetRss();
+  for (auto& io_buffer : io_buffers) {
+    io_buffer.Refresh(message.size());
+    if (buffer_pool != nullptr) {
+      io_buffer.ReleaseIfEmpty();
+    }
+  }
+  ::malloc_trim(0);  // Give freed pages back to the system
+  int64_t rss_idle = GetRss();
+  if (buffer_pool != nullptr) {
+    // Blocks cached for reuse are bounded by the pool, not paid by each
+    // connection
+    rss_idle -= static_cast<int64_t>(buffer_pool->GetBytesCached());
+  }
+  auto amount = static_cast<int64_t>(connection_amount);
+  return ConnectionRss{(rss_busy - rss_before) / amount,
+                       (rss_idle - rss_before) / amount};
+}
+
+}  // namespace
+
+TEST(BufferPoolTest, ReuseBlocks) {
+  taotu::BufferPool buffer_pool;
+  size_t block_size = 0;
+  char* block = buffer_pool.Allocate(1500, &block_size);
+  ASSERT_EQ(block_size, static_cast<size_t>(2048));
+  ASSERT_EQ(buffer_pool.GetBytesInUse(), static_cast<size_t>(2048));
+  buffer_pool.Deallocate(block, block_size);
+  ASSERT_EQ(buffer_pool.GetBytesInUse(), static_cast<size_t>(0));
+  ASSERT_EQ(buffer_pool.GetBytesCached(), static_cast<size_t>(2048));
+  size_t another_block_size = 0;
+  ASSERT_EQ(buffer_pool.Allocate(2048, &another_block_size), block);
+  ASSERT_EQ(another_block_size, block_size);
+  buffer_pool.Deallocate(block, another_block_size);
+  // Blocks beyond the largest size class are not cached
+  char* large_block =
+      buffer_pool.Allocate(taotu::BufferPool::kMaxBlockSize + 1, &block_size);
+  ASSERT_GT(block_size, taotu::BufferPool::kMaxBlockSize);
+  buffer_pool.Deallocate(large_block, block_size);
+  ASSERT_EQ(buffer_pool.GetBytesCached(), static_cast<size_t>(2048));
+}
+
+TEST(BufferPoolTest, IoBufferReleaseAndTrim) {
+  taotu::BufferPool buffer_pool;
+  {
+    taotu::IoBuffer io_buffer(&buffer_pool);
+    ASSERT_EQ(io_buffer.GetBufferCapacity(), static_cast<size_t>(0));
+    io_buffer.AppendInt32(711);
+    ASSERT_GT(buffer_pool.GetBytesInUse(), static_cast<size_t>(0));
+    ASSERT_EQ(io_buffer.RetrieveInt32(), 711);
+    io_buffer.ReleaseIfEmpty();
+    ASSERT_EQ(io_buffer.GetBufferCapacity(), static_cast<size_t>(0));
+    ASSERT_EQ(buffer_pool.GetBytesInUse(), static_cast<size_t>(0));
+
+    const std::string large(100 * 1024, 'y');
+    io_buffer.Append(large.data(), large.size());
+    io_buffer.Refresh(large.size() - 10);
+    io_buffer.Trim(taotu::BufferPool::kDefaultMaxRetainedCapacity);
+    ASSERT_LE(io_buffer.GetBufferCapacity(),
+              taotu::BufferPool::kDefaultMaxRetainedCapacity);
+    ASSERT_EQ(io_buffer.RetrieveAllAsString(), std::string(10, 'y'));
+    io_buffer.Append("z", 1);
+  }
+  ASSERT_EQ(buffer_pool.GetBytesInUse(), static_cast<size_t>(0));
+}
+
+TEST(BufferPoolTest, IoBufferRebind) {
+  taotu::BufferPool source_pool;
+  taotu::BufferPool target_pool;
+  taotu::IoBuffer io_buffer(&source_pool);
+  io_buffer.Append("hello, world", 12);
+  io_buffer.Refresh(7);
+  // Moving between loops goes through the heap
+  io_buffer.Rebind(nullptr);
+  ASSERT_EQ(source_pool.GetBytesInUse(), static_cast<size_t>(0));
+  io_buffer.Rebind(&target_pool);
+  ASSERT_GT(target_pool.GetBytesInUse(), static_cast<size_t>(0));
+  ASSERT_EQ(io_buffer.RetrieveAllAsString(), std::string("world"));
+  io_buffer.ReleaseIfEmpty();
+  ASSERT_EQ(target_pool.GetBytesInUse(), static_cast<size_t>(0));
+}
+
+TEST(BufferPoolTest, BudgetCallback) {
+  taotu::BufferPool buffer_pool;
+  int exceeded_times = 0;
+  taotu::BufferPool::SetMemoryBudget(
+      taotu::BufferPool::GetGlobalBytesInUse() + 4096,
+      [&exceeded_times](size_t, size_t) { ++exceeded_times; });
+  size_t first_size = 0;
+  size_t second_size = 0;
+  size_t third_size = 0;
+  char* first = buffer_pool.Allocate(4096, &first_size);
+  ASSERT_EQ(exceeded_times, 0);
+  char* second = buffer_pool.Allocate(1024, &second_size);
+  char* third = buffer_pool.Allocate(1024, &third_size);
+  ASSERT_EQ(exceeded_times, 1);  // Only reported once each time
+  buffer_pool.Deallocate(second, second_size);
+  buffer_pool.Deallocate(third, third_size);
+  second = buffer_pool.Allocate(1024, &second_size);
+  ASSERT_EQ(exceeded_times, 2);
+  buffer_pool.Deallocate(first, first_size);
+  buffer_pool.Deallocate(second, second_size);
+  taotu::BufferPool::SetMemoryBudget(0, nullptr);
+  taotu::END_LOG();
+}
+
+TEST(BufferPoolTest, IdleConnectionsRss) {
+  size_t connection_amount = GetIdleConnectionAmount();
+  taotu::BufferPool buffer_pool;
+  ConnectionRss pooled = MeasureConnections(connection_amount, &buffer_pool);
+  ASSERT_EQ(buffer_pool.GetBytesInUse(), static_cast<size_t>(0));
+  ConnectionRss heap = MeasureConnections(connection_amount, nullptr);
+  ::printf(
+      "RSS of each of %zu connections: %ld B busy, %ld B idle (heap) -> %ld B "
+      "busy, %ld B idle (pool)\n",
+      connection_amount, heap.busy, heap.idle, pooled.busy, pooled.idle);
+
+  // Busy connections hold a block for each buffer either way
+  constexpr auto kBuffersByte = static_cast<int64_t>(
+      kBuffersPerConnection * taotu::IoBuffer::kInitialCapacity);
+  ASSERT_GE(pooled.busy, kBuffersByte / 2);
+  ASSERT_GE(heap.busy, kBuffersByte / 2);
+  // Idle ones keep all of them on the heap, but less than one with the pool
+  ASSERT_GE(heap.idle, kBuffersByte / 2);
+  ASSERT_LT(pooled.idle,
+            static_cast<int64_t>(taotu::IoBuffer::kInitialCapacity));
+  ASSERT_LT(pooled.idle * 4, heap.idle);
+}
@@ -0,0 +1,94 @@
+#include "../src/byte_scanner.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <random>
+#include <string>
+
+#include "../src/io_buffer.h"
+
+namespace {
+
+const char* NaiveFind(const std::string& text, size_t start,
+                      const std::string& pattern) {
+  size_t index = text.find(pattern, start);
+  return index == std::string::npos ? nullptr : text.data() + index;
+}
+
+const char* NaiveFindAnyOf(const std::string& text, size_t start,
+                           const std::string& bytes) {
+  size_t index = text.find_first_of(bytes, start);
+  return index == std::string::npos ? nullptr : text.data() + index;
+}
+
+// Random text made of few kinds of bytes, so delimiters (and near-misses like
+// "\r\r\n") appear at every alignment
+std::string MakeText(std::mt19937* engine, size_t len) {
+  static const char kAlphabet[] = {'\r', '\n', 'a', ':', '\x80', '\xff'};
+  std::uniform_int_distribution<size_t> distribution(0, 5);
+  std::string text(len, 'a');
+  for (auto& c : text) {
+    c = kAlphabet[distribution(*engine)];
+  }
+  return text;
+}
+
+}  // namespace
+
+TEST(ByteScannerTest, AllLevelsMatchNaiveSearch) {
+  const std::string bytes_list[] = {":", "\r\n", std::string("\x80\xff", 2),
+                                    "abcdefghijklmnopqrstuvwxyz:"};
+  std::mt19937 engine(711);
+  for (auto scan_level :
+       {taotu::ScanLevel::kScalar, taotu::ScanLevel::kSse42,
+        taotu::ScanLevel::kAvx2}) {
+    taotu::byte_scanner::SetScanLevel(scan_level);
+    for (size_t len = 0; len < 200; ++len) {
+      std::string text = MakeText(&engine, len);
+      const char* end = text.data() + text.size();
+      for (size_t start = 0; start <= len; ++start) {
+        const char* begin = text.data() + start;
+        ASSERT_EQ(taotu::byte_scanner::FindCrlf(begin, end),
+                  NaiveFind(text, start, "\r\n"));
+        ASSERT_EQ(taotu::byte_scanner::FindDoubleCrlf(begin, end),
+                  NaiveFind(text, start, "\r\n\r\n"));
+        for (const auto& bytes : bytes_list) {
+          taotu::ByteSet byte_set(bytes.data(), bytes.size());
+          ASSERT_EQ(taotu::byte_scanner::FindAnyOf(begin, end, byte_set),
+                    NaiveFindAnyOf(text, start, bytes));
+        }
+      }
+    }
+  }
+  taotu::byte_scanner::SetScanLevel(taotu::ScanLevel::kAvx2);
+}
+
+TEST(ByteScannerTest, ResumableFinding) {
+  const std::string request =
+      "GET / HTTP/1.1\r\nHost: localhost\r\nAccept: */*\r\n\r\n";
+  taotu::IoBuffer io_buffer;
+  size_t scanned_bytes = 0;
+  const char* position = nullptr;
+  // Feed the request byte by byte, the delimiter must be found right after
+  // its last byte arrives
+  for (size_t i = 0; i < request.size(); ++i) {
+    io_buffer.Append(request.data() + i, 1);
+    position = io_buffer.FindDoubleCrlfFrom(&scanned_bytes);
+    if (i + 1 < request.size()) {
+      ASSERT_EQ(position, nullptr);
+      ASSERT_LE(scanned_bytes, i + 1);
+    }
+  }
+  ASSERT_NE(position, nullptr);
+  ASSERT_EQ(position - io_buffer.GetReadablePosition(),
+            static_cast<ptrdiff_t>(request.size() - 4));
+  ASSERT_EQ(scanned_bytes, static_cast<size_t>(0));
+
+  const char* line_end = io_buffer.FindCrlfFrom(&scanned_bytes);
+  ASSERT_EQ(std::string(io_buffer.GetReadablePosition(), line_end),
+            "GET / HTTP/1.1");
+  io_buffer.Refresh(line_end + 2 - io_buffer.GetReadablePosition());
+  taotu::ByteSet colon(":");
+  ASSERT_EQ(*io_buffer.FindAnyOf(colon), ':');
+}
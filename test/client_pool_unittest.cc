@@ -0,0 +1,173 @@
+#include "../src/client_pool.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../src/event_manager.h"
+#include "../src/logger.h"
+
+namespace {
+
+constexpr size_t kConnectionAmount = 4;
+
+// A server on a free port of the loopback which accepts and keeps connections
+class LoopbackServer {
+ public:
+  LoopbackServer() : listen_fd_(::socket(AF_INET, SOCK_STREAM, 0)) {
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address));
+    ::listen(listen_fd_, SOMAXCONN);
+    socklen_t length = sizeof(address);
+    ::getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&address),
+                  &length);
+    address_.SetNetAddress(address);
+    thread_ = std::thread([this]() {
+      int fd = -1;
+      while ((fd = ::accept(listen_fd_, nullptr, nullptr)) >= 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accepted_fds_.push_back(fd);
+      }
+    });
+  }
+  ~LoopbackServer() {
+    ::shutdown(listen_fd_, SHUT_RDWR);  // Wake up "accept()"
+    thread_.join();
+    ::close(listen_fd_);
+    for (int fd : accepted_fds_) {
+      ::close(fd);
+    }
+  }
+
+  const taotu::NetAddress& GetAddress() const { return address_; }
+
+  // Connections accepted and closed by the peer since
+  size_t CountClosedByPeer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t closed_amount = 0;
+    char buffer[256];
+    for (int fd : accepted_fds_) {
+      // Skip the requests received
+      ssize_t size = 0;
+      while ((size = ::recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+      }
+      closed_amount += 0 == size ? 1 : 0;
+    }
+    return closed_amount;
+  }
+
+ private:
+  int listen_fd_;
+  taotu::NetAddress address_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::vector<int> accepted_fds_;
+};
+
+bool WaitUntil(const std::function<bool()>& is_done) {
+  for (int i = 0; i < 500; ++i) {
+    if (is_done()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return is_done();
+}
+
+class ClientPoolTest : public ::testing::Test {
+ protected:
+  static void TearDownTestSuite() { taotu::END_LOG(); }
+
+  void SetUp() override {
+    for (auto& event_manager : event_managers_) {
+      event_manager.Loop();
+    }
+    pool_ = std::make_unique<taotu::ClientPool>(
+        taotu::ClientPool::EventManagers{&event_managers_[0],
+                                         &event_managers_[1]},
+        std::vector<taotu::NetAddress>{server_.GetAddress()},
+        kConnectionAmount);
+    pool_->SetCloseCallback(
+        [this](taotu::Connecting&) { closed_amount_.fetch_add(1); });
+  }
+  void TearDown() override {
+    pool_.reset();
+    // Members torn down in their loops leave nothing behind
+    ASSERT_TRUE(WaitUntil([this]() {
+      return server_.CountClosedByPeer() == kConnectionAmount;
+    }));
+  }
+
+  void StartAndWait() {
+    pool_->Start();
+    ASSERT_TRUE(WaitUntil([this]() {
+      return pool_->GetConnectedAmount() == kConnectionAmount;
+    }));
+  }
+
+  LoopbackServer server_;
+  std::atomic_size_t closed_amount_{0};
+  taotu::EventManager event_managers_[2];
+  std::unique_ptr<taotu::ClientPool> pool_;
+};
+
+}  // namespace
+
+TEST_F(ClientPoolTest, StartAndStop) {
+  StartAndWait();
+  pool_->Stop();
+  ASSERT_TRUE(
+      WaitUntil([this]() { return 0 == pool_->GetConnectedAmount(); }));
+  ASSERT_EQ(closed_amount_.load(), kConnectionAmount);
+  // Not connected again once stopped
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(pool_->GetConnectedAmount(), 0u);
+  ASSERT_EQ(pool_->Pick(), nullptr);
+}
+
+TEST_F(ClientPoolTest, DestroyWhileConnected) {
+  StartAndWait();
+  // Closed by "TearDown()" without stopping first
+}
+
+TEST_F(ClientPoolTest, PickInTurn) {
+  StartAndWait();
+  std::vector<size_t> picked_times(kConnectionAmount, 0);
+  for (size_t i = 0; i < kConnectionAmount * 3; ++i) {
+    taotu::ClientPool::Member* member = pool_->Pick();
+    ASSERT_NE(member, nullptr);
+    ++picked_times[member->GetIndex()];
+  }
+  for (size_t times : picked_times) {
+    ASSERT_EQ(times, 3u);
+  }
+}
+
+TEST_F(ClientPoolTest, PickLeastPending) {
+  pool_->SetPickStrategy(taotu::ClientPool::kLeastPending);
+  StartAndWait();
+  // Each request in flight moves the next pick to another member
+  std::vector<size_t> picked_times(kConnectionAmount, 0);
+  for (size_t i = 0; i < kConnectionAmount; ++i) {
+    taotu::ClientPool::Member* member = pool_->Pick();
+    ASSERT_NE(member, nullptr);
+    ++picked_times[member->GetIndex()];
+    ASSERT_TRUE(member->Send("request"));
+  }
+  for (size_t times : picked_times) {
+    ASSERT_EQ(times, 1u);
+  }
+}
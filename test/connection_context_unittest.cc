@@ -0,0 +1,66 @@
+#include "../src/connection_context.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+namespace {
+
+struct Counter {
+  explicit Counter(int* destroyed_count) : destroyed_count(destroyed_count) {}
+  ~Counter() { ++*destroyed_count; }
+  int* destroyed_count;
+};
+
+struct LargeState {
+  char bytes[taotu::ConnectionContext::kInlineSize + 1];
+  std::string name;
+};
+
+}  // namespace
+
+TEST(ConnectionContextTest, TypedGetting) {
+  taotu::ConnectionContext context;
+  ASSERT_FALSE(context.HasValue());
+  ASSERT_EQ(context.Get<int>(), nullptr);
+  context.Emplace<int>(711);
+  ASSERT_TRUE(context.HasValue());
+  ASSERT_EQ(*context.Get<int>(), 711);
+  ASSERT_EQ(context.Get<long>(), nullptr);
+  ASSERT_EQ(context.Get<std::string>(), nullptr);
+  auto& text = context.Emplace<std::string>("taotu");
+  ASSERT_EQ(context.Get<int>(), nullptr);
+  ASSERT_EQ(context.Get<std::string>(), &text);
+  const auto& const_context = context;
+  ASSERT_EQ(*const_context.Get<std::string>(), "taotu");
+}
+
+TEST(ConnectionContextTest, Storage) {
+  static_assert(
+      taotu::ConnectionContext::IsStoredInline<std::shared_ptr<int>>());
+  static_assert(!taotu::ConnectionContext::IsStoredInline<LargeState>());
+  taotu::ConnectionContext context;
+  auto& pointer = context.Emplace<std::shared_ptr<int>>(new int(1));
+  ASSERT_LE(static_cast<void*>(&context), static_cast<void*>(&pointer));
+  ASSERT_LT(static_cast<void*>(&pointer), static_cast<void*>(&context + 1));
+  auto& large_state = context.Emplace<LargeState>();
+  large_state.name = "large";
+  ASSERT_EQ(context.Get<LargeState>()->name, "large");
+}
+
+TEST(ConnectionContextTest, Destroying) {
+  int destroyed_count = 0;
+  {
+    taotu::ConnectionContext context;
+    context.Emplace<Counter>(&destroyed_count);
+    context.Emplace<Counter>(&destroyed_count);
+    ASSERT_EQ(destroyed_count, 1);
+    context.Reset();
+    ASSERT_EQ(destroyed_count, 2);
+    ASSERT_FALSE(context.HasValue());
+    auto shared_counter = std::make_shared<Counter>(&destroyed_count);
+    context.Emplace<std::shared_ptr<Counter>>(std::move(shared_counter));
+  }
+  ASSERT_EQ(destroyed_count, 3);
+}
@@ -0,0 +1,50 @@
+#include "../src/hdr_histogram.h"
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+TEST(HdrHistogramTest, Percentiles) {
+  taotu::HdrHistogram histogram{3600LL * 1000 * 1000, 3};
+  for (int64_t i = 1; i <= 100000; ++i) {
+    histogram.Record(i);
+  }
+  ASSERT_EQ(histogram.GetTotalCount(), 100000);
+  ASSERT_EQ(histogram.GetMin(), 1);
+  ASSERT_EQ(histogram.GetMax(), 100000);
+  ASSERT_EQ(histogram.GetValueAtPercentile(100), 100000);
+
+  // 3 significant figures keep the error within 0.1%
+  ASSERT_NEAR(histogram.GetValueAtPercentile(50), 50000, 50);
+  ASSERT_NEAR(histogram.GetValueAtPercentile(99), 99000, 99);
+  ASSERT_NEAR(histogram.GetValueAtPercentile(99.9), 99900, 100);
+  ASSERT_NEAR(histogram.GetMean(), 50000.5, 50);
+
+  // Small values are exact
+  taotu::HdrHistogram small;
+  small.Record(0);
+  small.Record(7);
+  small.Record(7);
+  ASSERT_EQ(small.GetValueAtPercentile(30), 0);
+  ASSERT_EQ(small.GetValueAtPercentile(50), 7);
+}
+
+TEST(HdrHistogramTest, MergeAndReset) {
+  taotu::HdrHistogram histogram;
+  taotu::HdrHistogram other;
+  histogram.Record(1000);
+  other.RecordN(2000000, 3);
+  histogram.Merge(other);
+  ASSERT_EQ(histogram.GetTotalCount(), 4);
+  ASSERT_EQ(histogram.GetMin(), 1000);
+  ASSERT_EQ(histogram.GetMax(), 2000000);
+  ASSERT_NEAR(histogram.GetValueAtPercentile(50), 2000000, 2000);
+
+  // Out of range values are clamped
+  histogram.Record(INT64_MAX);
+  ASSERT_EQ(histogram.GetMax(), 3600LL * 1000 * 1000 * 1000);
+
+  histogram.Reset();
+  ASSERT_EQ(histogram.GetTotalCount(), 0);
+  ASSERT_EQ(histogram.GetMax(), 0);
+  ASSERT_EQ(histogram.GetValueAtPercentile(99), 0);
+}
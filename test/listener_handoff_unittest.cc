@@ -0,0 +1,100 @@
+#include "../src/listener_handoff.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "../src/logger.h"
+
+namespace {
+
+// Listen on a free port of the loopback
+int ListenOnLoopback(taotu::NetAddress* listen_address) {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_in address {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+  ::listen(fd, SOMAXCONN);
+  socklen_t length = sizeof(address);
+  ::getsockname(fd, reinterpret_cast<struct sockaddr*>(&address), &length);
+  listen_address->SetNetAddress(address);
+  return fd;
+}
+
+}  // namespace
+
+TEST(ListenerHandoffTest, PassListeningSockets) {
+  taotu::NetAddress listen_address;
+  int listening_fd = ListenOnLoopback(&listen_address);
+  ASSERT_GE(listening_fd, 0);
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+  ASSERT_TRUE(taotu::ListenerHandoff::SendListeners(
+      fds[0], std::vector<int>{listening_fd}));
+  ASSERT_EQ(taotu::ListenerHandoff::ReceiveListeners(fds[1]), 1u);
+  ::close(fds[0]);
+  ::close(fds[1]);
+
+  // A connection coming once the old one is closed waits in the shared
+  // backlog for the inherited one
+  ::close(listening_fd);
+  taotu::NetAddress other_address{"127.0.0.1", 1};
+  ASSERT_LT(taotu::ListenerHandoff::TakeInherited(other_address), 0);
+  int inherited_fd = taotu::ListenerHandoff::TakeInherited(listen_address);
+  ASSERT_GE(inherited_fd, 0);
+  ASSERT_LT(taotu::ListenerHandoff::TakeInherited(listen_address), 0);
+  int client_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(::connect(client_fd, listen_address.GetNetAddress(),
+                      static_cast<socklen_t>(listen_address.GetSize())),
+            0);
+  int accepted_fd = ::accept(inherited_fd, nullptr, nullptr);
+  ASSERT_GE(accepted_fd, 0);
+  ::close(accepted_fd);
+  ::close(client_fd);
+  ::close(inherited_fd);
+}
+
+TEST(ListenerHandoffTest, NothingToInherit) {
+  auto handoff_address =
+      taotu::NetAddress::FromUnixPath("/tmp/taotu_handoff_unittest.sock");
+  ::unlink(handoff_address.GetUnixPath().c_str());
+  ASSERT_EQ(taotu::ListenerHandoff::Inherit(handoff_address, 100), 0u);
+}
+
+TEST(ListenerHandoffTest, TrustPeerOfSameUser) {
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+  ASSERT_TRUE(taotu::ListenerHandoff::IsPeerTrusted(fds[0]));
+  ASSERT_TRUE(taotu::ListenerHandoff::IsPeerTrusted(fds[1]));
+  ::close(fds[0]);
+  ::close(fds[1]);
+  // Not a Unix domain one
+  taotu::NetAddress listen_address;
+  int listening_fd = ListenOnLoopback(&listen_address);
+  ASSERT_FALSE(taotu::ListenerHandoff::IsPeerTrusted(listening_fd));
+  ::close(listening_fd);
+  taotu::END_LOG();
+}
+
+TEST(ListenerHandoffTest, RestrictToOwner) {
+  auto handoff_address =
+      taotu::NetAddress::FromUnixPath("/tmp/taotu_handoff_unittest.sock");
+  ::unlink(handoff_address.GetUnixPath().c_str());
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(::bind(fd, handoff_address.GetNetAddress(),
+                   static_cast<socklen_t>(handoff_address.GetSize())),
+            0);
+  ASSERT_TRUE(taotu::ListenerHandoff::RestrictToOwner(handoff_address));
+  struct stat status {};
+  ASSERT_EQ(::stat(handoff_address.GetUnixPath().c_str(), &status), 0);
+  ASSERT_EQ(status.st_mode & 0777, 0600u);
+  ::close(fd);
+  ::unlink(handoff_address.GetUnixPath().c_str());
+}
@@ -0,0 +1,66 @@
+#include "../src/log_clock.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// What "strftime()" gives for the timestamp
+std::string ExpectedTimestamp(int64_t time_us) {
+  auto second = static_cast<time_t>(time_us / 1000000);
+  struct tm tmp_tm;
+  ::localtime_r(&second, &tmp_tm);
+  char date_time[32];
+  ::strftime(date_time, sizeof(date_time), "%Y-%m-%dT%H:%M:%S", &tmp_tm);
+  char offset[8];
+  ::strftime(offset, sizeof(offset), "%z", &tmp_tm);  // Like "+0800"
+  char microsecond[16];
+  ::snprintf(microsecond, sizeof(microsecond), ".%06d",
+             static_cast<int>(time_us % 1000000));
+  return std::string(date_time) + microsecond +
+         std::string(offset, 3) + ":" + std::string(offset + 3, 2);
+}
+
+std::string Format(int64_t time_us) {
+  char buffer[taotu::logger::LogClock::kTimestampByte];
+  size_t size = taotu::logger::LogClock::FormatTimestamp(time_us, buffer);
+  return std::string(buffer, size);
+}
+
+}  // namespace
+
+TEST(LogClockTest, FormatIso8601) {
+  int64_t now = taotu::logger::LogClock::Now();
+  for (int64_t time_us : {now, now + 7, now + 1000000, now - 86400000000,
+                          static_cast<int64_t>(1791979200000001)}) {
+    ASSERT_EQ(Format(time_us), ExpectedTimestamp(time_us));
+  }
+}
+
+TEST(LogClockTest, FormatFromThreads) {
+  int64_t base = taotu::logger::LogClock::Now();
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(8, 0);
+  for (size_t t = 0; t < mismatches.size(); ++t) {
+    threads.emplace_back([base, t, &mismatches]() {
+      for (int64_t i = 0; i < 2000; ++i) {
+        // Seconds go back and forth, so the published one keeps changing
+        int64_t time_us = base + (i % 5) * 1000000 + i;
+        if (Format(time_us) != ExpectedTimestamp(time_us)) {
+          ++mismatches[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int mismatch : mismatches) {
+    ASSERT_EQ(mismatch, 0);
+  }
+}
@@ -0,0 +1,231 @@
+#include "../src/log_crash_file.h"
+
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/log_record.h"
+
+namespace {
+
+const char kFormat[] = "record %d of %s";
+
+size_t CountSubstring(const std::string& text, const std::string& sub) {
+  size_t count = 0;
+  for (size_t pos = text.find(sub); pos != std::string::npos;
+       pos = text.find(sub, pos + sub.size())) {
+    ++count;
+  }
+  return count;
+}
+
+std::string ReadFile(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+// Put a record into the ring like "Logger" does
+void PutRecord(taotu::logger::LogCrashFile* crash_file,
+               taotu::logger::LogRing* ring, int i,
+               const char* format = kFormat) {
+  const char* name = "the test";
+  size_t args_size = taotu::logger::LogArgEncoder<int>::GetSize(i) +
+                     taotu::logger::LogArgEncoder<const char*>::GetSize(name);
+  crash_file->KeepFormat(format);
+  char* position = ring->Reserve(taotu::logger::kLogRecordHeaderByte +
+                                 args_size);
+  ASSERT_NE(position, nullptr);
+  position = taotu::logger::EncodeLogRecordHeader(format, i, 6, 2, position);
+  position = taotu::logger::LogArgEncoder<int>::Encode(i, position);
+  taotu::logger::LogArgEncoder<const char*>::Encode(name, position);
+  ring->Commit(taotu::logger::kLogRecordHeaderByte + args_size);
+}
+
+// Lines of the records left in the crash file
+std::vector<std::string> RecoverLines(const std::string& file_name,
+                                      taotu::logger::LogCrashState* state) {
+  std::string data = ReadFile(file_name);
+  std::vector<std::string> lines;
+  taotu::logger::LogLineFormatter line_formatter;
+  EXPECT_TRUE(taotu::logger::LogCrashFile::ReadRecords(
+      data.data(), data.size(), state,
+      [&](const char* format, const char* body, size_t body_size) {
+        std::string line;
+        line_formatter.AppendLine(format, body, body_size, &line);
+        lines.push_back(line.substr(line.find("Log(Info): ") + 11));
+      }));
+  return lines;
+}
+
+class LogCrashFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    file_name_ = "log_crash_file_test_" + std::to_string(::getpid()) + ".crash";
+  }
+  void TearDown() override {
+    ::unlink(file_name_.c_str());
+    ::unlink((file_name_ + ".last").c_str());
+  }
+
+  std::string file_name_;
+};
+
+}  // namespace
+
+TEST_F(LogCrashFileTest, KeepRecordsNotReleased) {
+  auto crash_file = std::make_shared<taotu::logger::LogCrashFile>();
+  ASSERT_TRUE(crash_file->Open(file_name_, 4096, 2));
+  auto ring = crash_file->CreateRing();
+  ASSERT_NE(ring, nullptr);
+  auto other_ring = crash_file->CreateRing();
+  ASSERT_NE(other_ring, nullptr);
+  ASSERT_EQ(crash_file->CreateRing(), nullptr);  // All segments are taken
+  // Wrap around the ring a few times
+  int released = 0;
+  for (int i = 0; i < 200; ++i) {
+    PutRecord(crash_file.get(), ring.get(), i);
+    if (i % 10 == 9 && i < 190) {
+      ring->Drain([](const char*, size_t) {});
+      ring->ReleaseDrained();
+      released = i + 1;
+    }
+  }
+  // Drained but not released, so still left
+  ring->Drain([](const char*, size_t) {});
+
+  taotu::logger::LogCrashState state;
+  std::vector<std::string> lines = RecoverLines(file_name_, &state);
+  EXPECT_FALSE(state.is_closed);
+  EXPECT_EQ(state.signal_number, 0);
+  EXPECT_EQ(state.pid, static_cast<int64_t>(::getpid()));
+  ASSERT_EQ(lines.size(), static_cast<size_t>(200 - released));
+  for (size_t i = 0; i < lines.size(); ++i) {
+    EXPECT_EQ(lines[i], "record " + std::to_string(released + i) +
+                            " of the test\n");
+  }
+
+  // A file closed normally is not kept by the next open
+  crash_file->MarkClosed();
+  ring.reset();
+  other_ring.reset();
+  crash_file.reset();
+  auto next_crash_file = std::make_shared<taotu::logger::LogCrashFile>();
+  ASSERT_TRUE(next_crash_file->Open(file_name_, 4096, 2));
+  EXPECT_NE(::access((file_name_ + ".last").c_str(), F_OK), 0);
+}
+
+TEST_F(LogCrashFileTest, RecoverAfterCrash) {
+  pid_t pid = ::fork();
+  ASSERT_GE(pid, 0);
+  if (0 == pid) {
+    auto crash_file = std::make_shared<taotu::logger::LogCrashFile>();
+    if (!crash_file->Open(file_name_, 4096, 1)) {
+      ::_exit(1);
+    }
+    crash_file->CatchFatalSignals();
+    auto ring = crash_file->CreateRing();
+    for (int i = 0; i < 3; ++i) {
+      PutRecord(crash_file.get(), ring.get(), i);
+    }
+    ::abort();
+  }
+  int status = 0;
+  ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFSIGNALED(status));
+  EXPECT_EQ(WTERMSIG(status), SIGABRT);
+
+  taotu::logger::LogCrashState state;
+  std::vector<std::string> lines = RecoverLines(file_name_, &state);
+  EXPECT_FALSE(state.is_closed);
+  EXPECT_EQ(state.signal_number, SIGABRT);
+  EXPECT_GT(state.crash_time_us, 0);
+  EXPECT_EQ(state.pid, static_cast<int64_t>(pid));
+  ASSERT_EQ(lines.size(), 3u);
+  EXPECT_EQ(lines[2], "record 2 of the test\n");
+
+  // Kept for recovering by the next open
+  auto crash_file = std::make_shared<taotu::logger::LogCrashFile>();
+  ASSERT_TRUE(crash_file->Open(file_name_, 4096, 1));
+  EXPECT_EQ(::access((file_name_ + ".last").c_str(), F_OK), 0);
+}
+
+TEST_F(LogCrashFileTest, KeepEachFormatOnce) {
+  constexpr size_t kThreadAmount = 8;
+  constexpr size_t kFormatAmount = 300;  // Beyond the cache of a thread
+  std::vector<std::string> formats;
+  for (size_t i = 0; i < kFormatAmount; ++i) {
+    formats.push_back("call site " + std::to_string(i) + ": %d of %s");
+  }
+  auto crash_file = std::make_shared<taotu::logger::LogCrashFile>();
+  ASSERT_TRUE(crash_file->Open(file_name_, 64 * 1024, kThreadAmount));
+  std::vector<std::shared_ptr<taotu::logger::LogRing>> rings;
+  for (size_t i = 0; i < kThreadAmount; ++i) {
+    rings.push_back(crash_file->CreateRing());
+    ASSERT_NE(rings.back(), nullptr);
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadAmount; ++i) {
+    threads.emplace_back([&crash_file, &formats, ring = rings[i].get()]() {
+      for (int round = 0; round < 2; ++round) {
+        for (size_t j = 0; j < formats.size(); ++j) {
+          PutRecord(crash_file.get(), ring, round, formats[j].c_str());
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  taotu::logger::LogCrashState state;
+  std::vector<std::string> lines = RecoverLines(file_name_, &state);
+  ASSERT_EQ(lines.size(), kThreadAmount * kFormatAmount * 2);
+  std::map<std::string, size_t> line_amounts;
+  for (const auto& line : lines) {
+    ++line_amounts[line];
+  }
+  for (size_t i = 0; i < kFormatAmount; ++i) {
+    for (int round = 0; round < 2; ++round) {
+      EXPECT_EQ(line_amounts["call site " + std::to_string(i) + ": " +
+                             std::to_string(round) + " of the test\n"],
+                kThreadAmount);
+    }
+  }
+  // Copied into the file once by all threads
+  std::string data = ReadFile(file_name_);
+  for (const auto& format : formats) {
+    EXPECT_EQ(CountSubstring(data, format), 1u);
+  }
+}
+
+TEST_F(LogCrashFileTest, ReportFullFormatArea) {
+  auto crash_file = std::make_shared<taotu::logger::LogCrashFile>();
+  ASSERT_TRUE(crash_file->Open(file_name_, 4096, 1));
+  // More than the area of 1 MiB takes
+  std::vector<std::string> formats;
+  for (size_t i = 0; i < 20000; ++i) {
+    formats.push_back("a format long enough to fill up the area " +
+                      std::to_string(i));
+  }
+  ::testing::internal::CaptureStderr();
+  for (const auto& format : formats) {
+    crash_file->KeepFormat(format.c_str());
+  }
+  std::string error = ::testing::internal::GetCapturedStderr();
+  EXPECT_EQ(CountSubstring(error, "is full"), 1u);
+  // The ones kept before are still there
+  std::string data = ReadFile(file_name_);
+  EXPECT_EQ(CountSubstring(data, formats[0]), 1u);
+  EXPECT_EQ(CountSubstring(data, formats.back()), 0u);
+}
@@ -0,0 +1,69 @@
+#include "../src/log_file_writer.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+
+std::string ReadFile(const std::string& file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+// Lines of different lengths, so batches are cut anywhere
+std::string WriteLines(taotu::logger::LogFileWriter* writer, int amount) {
+  std::string expected;
+  for (int i = 0; i < amount; ++i) {
+    std::string line = "line " + std::to_string(i) + " " +
+                       std::string(static_cast<size_t>(i % 97), 'x') + "\n";
+    writer->Append(line.c_str(), line.size());
+    expected += line;
+    if (i % 1000 == 0) {
+      writer->Flush();
+    }
+  }
+  return expected;
+}
+
+void ExpectWritten(const taotu::logger::LogWriteOptions& options) {
+  const std::string file_name =
+      "log_file_writer_test_" + std::to_string(::getpid()) + ".log";
+  taotu::logger::LogFileWriter writer;
+  ASSERT_TRUE(writer.Open(file_name, options));
+  std::string expected = WriteLines(&writer, 20000);
+  EXPECT_EQ(static_cast<int64_t>(expected.size()), writer.GetFileByte());
+  writer.Close();
+  EXPECT_EQ(expected, ReadFile(file_name));
+
+  // Reopened files start over
+  ASSERT_TRUE(writer.Open(file_name, options));
+  expected = WriteLines(&writer, 3);
+  writer.Close();
+  EXPECT_EQ(expected, ReadFile(file_name));
+  ::remove(file_name.c_str());
+}
+
+}  // namespace
+
+TEST(LogFileWriterTest, WriteInBatches) {
+  taotu::logger::LogWriteOptions options;
+  options.batch_byte = 8192;
+  ExpectWritten(options);
+  options.sync_interval_microseconds = 0;
+  ExpectWritten(options);
+}
+
+TEST(LogFileWriterTest, WriteDirectly) {
+  // Falls back to the page cache where "O_DIRECT" is not supported
+  taotu::logger::LogWriteOptions options;
+  options.batch_byte = 10000;  // Rounded up to 12 KiB
+  options.is_direct = true;
+  options.sync_interval_microseconds = 1000;
+  ExpectWritten(options);
+}
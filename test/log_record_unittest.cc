@@ -0,0 +1,129 @@
+#include "../src/log_record.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Encode the arguments into a record like "Logger" does, then format it
+template <typename... Args>
+std::string FormatRecord(const char* format, Args... args) {
+  size_t args_size = 0;
+  ((args_size += taotu::logger::LogArgEncoder<Args>::GetSize(args)), ...);
+  std::vector<char> record(taotu::logger::kLogRecordHeaderByte + args_size);
+  char* position = taotu::logger::EncodeLogRecordHeader(
+      format, 0, 6, static_cast<uint8_t>(sizeof...(Args)), record.data());
+  ((position = taotu::logger::LogArgEncoder<Args>::Encode(args, position)),
+   ...);
+  static_cast<void>(position);  // Unused without arguments
+  taotu::logger::LogLineFormatter line_formatter;
+  std::string line;
+  line_formatter.AppendLine(record.data(), record.size(), &line);
+  // Only the message is compared
+  return line.substr(line.find("Log(Info): ") + 11);
+}
+
+template <typename... Args>
+std::string Snprintf(const char* format, Args... args) {
+  char buffer[512];
+  ::snprintf(buffer, sizeof(buffer), format, args...);
+  return std::string(buffer) + "\n";
+}
+
+}  // namespace
+
+TEST(LogRecordTest, FormatLikeSnprintf) {
+#define EXPECT_FORMAT(...) \
+  EXPECT_EQ(FormatRecord(__VA_ARGS__), Snprintf(__VA_ARGS__))
+  EXPECT_FORMAT("no arguments, 100%%");
+  EXPECT_FORMAT("%d %i %5d %-5d| %05d %+d", -42, 7, 3, 4, 5, 6);
+  EXPECT_FORMAT("%u %x %X %#o %lu %zu", 4000000000U, 255, 255, 8,
+                18446744073709551615UL, sizeof(int));
+  EXPECT_FORMAT("%hhd %hd %lld %llu", 300, 70000, -1LL, 2ULL);
+  EXPECT_FORMAT("%f %.3f %e %g %10.2f", 3.5, 3.14159, 1e10, 0.0001, -2.5F);
+  EXPECT_FORMAT("%s|%10s|%-10s|%.2s", "abc", "right", "left", "cut");
+  EXPECT_FORMAT("%*d|%-*d|%.*s|%.*f", 6, 1, 6, 2, 3, "abcdef", 1, 2.25);
+  EXPECT_FORMAT("%c%c %p", 'o', 'k', reinterpret_cast<void*>(0x1234));
+  const char* null_string = nullptr;
+  EXPECT_EQ(FormatRecord("%s", null_string), "(null)\n");
+  EXPECT_EQ(FormatRecord("%d %s"), "(?) (?)\n");  // Arguments are missing
+  // Not the address of the copy, nor the bytes at a pointer
+  EXPECT_EQ(FormatRecord("%p|%s", "text", reinterpret_cast<void*>(0x1234)),
+            "(?)|(?)\n");
+  EXPECT_EQ(FormatRecord("%p", 42), "(?)\n");
+#undef EXPECT_FORMAT
+}
+
+TEST(LogRecordTest, PlainMessage) {
+  std::string message{"a plain message with %d"};
+  size_t args_size = taotu::logger::GetEncodedStringSize(message.size());
+  std::vector<char> record(taotu::logger::kLogRecordHeaderByte + args_size);
+  char* position = taotu::logger::EncodeLogRecordHeader(
+      nullptr, 1000000, 3, 1,
+      record.data());
+  taotu::logger::EncodeString(message.c_str(), message.size(), position);
+  taotu::logger::LogLineFormatter line_formatter;
+  std::string line;
+  line_formatter.AppendLine(record.data(), record.size(), &line);
+  ASSERT_EQ(line.substr(line.find("] ") + 2),
+            "Log(Error): a plain message with %d\n");
+}
+
+TEST(LogRecordTest, KeyValues) {
+  std::string ip{"10.0.0.1"};
+  std::vector<char> record(taotu::logger::kLogRecordHeaderByte + 256);
+  char* position = taotu::logger::EncodeLogRecordHeader(
+      "conn_open", 0, 6 | taotu::logger::kKeyValueRecordFlag, 8,
+      record.data());
+  position = taotu::logger::LogArgEncoder<const char*>::Encode("fd", position);
+  position = taotu::logger::LogArgEncoder<int>::Encode(7, position);
+  position = taotu::logger::LogArgEncoder<const char*>::Encode("ip", position);
+  position = taotu::logger::LogArgEncoder<std::string>::Encode(ip, position);
+  position =
+      taotu::logger::LogArgEncoder<const char*>::Encode("reason", position);
+  position = taotu::logger::LogArgEncoder<const char*>::Encode(
+      "say \"bye\"\n", position);
+  position = taotu::logger::LogArgEncoder<const char*>::Encode("ok", position);
+  position = taotu::logger::LogArgEncoder<bool>::Encode(true, position);
+  size_t record_size = static_cast<size_t>(position - record.data());
+  std::string line;
+  taotu::logger::LogLineFormatter plain_formatter;
+  plain_formatter.AppendLine(record.data(), record_size, &line);
+  EXPECT_EQ(line.substr(line.find("] ") + 2),
+            "Log(Info): conn_open fd=7 ip=10.0.0.1 "
+            "reason=\"say \\\"bye\\\"\\n\" ok=true\n");
+  line.clear();
+  taotu::logger::LogLineFormatter json_formatter{taotu::logger::kJsonLine};
+  json_formatter.AppendLine(record.data(), record_size, &line);
+  EXPECT_EQ(line.substr(0, 9), "{\"time\":\"");
+  EXPECT_EQ(line.substr(line.find("\",\"level\"")),
+            "\",\"level\":\"info\",\"event\":\"conn_open\",\"fd\":7,"
+            "\"ip\":\"10.0.0.1\",\"reason\":\"say \\\"bye\\\"\\n\","
+            "\"ok\":true}\n");
+  line.clear();
+  taotu::logger::LogLineFormatter logfmt_formatter{taotu::logger::kLogfmtLine};
+  logfmt_formatter.AppendLine(record.data(), record_size, &line);
+  EXPECT_EQ(line.substr(0, 5), "time=");
+  EXPECT_EQ(line.substr(line.find(" level=")),
+            " level=info event=conn_open fd=7 ip=10.0.0.1 "
+            "reason=\"say \\\"bye\\\"\\n\" ok=true\n");
+}
+
+TEST(LogRecordTest, MessageInJsonLine) {
+  std::vector<char> record(taotu::logger::kLogRecordHeaderByte + 64);
+  char* position = taotu::logger::EncodeLogRecordHeader("%s \"%d\"", 0, 4, 2,
+                                                         record.data());
+  position =
+      taotu::logger::LogArgEncoder<const char*>::Encode("a\tb", position);
+  position = taotu::logger::LogArgEncoder<int>::Encode(1, position);
+  std::string line;
+  taotu::logger::LogLineFormatter json_formatter{taotu::logger::kJsonLine};
+  json_formatter.AppendLine(record.data(),
+                            static_cast<size_t>(position - record.data()),
+                            &line);
+  EXPECT_EQ(line.substr(line.find("\",\"level\"")),
+            "\",\"level\":\"warn\",\"message\":\"a\\tb \\\"1\\\"\"}\n");
+}
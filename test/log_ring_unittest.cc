@@ -0,0 +1,91 @@
+#include "../src/log_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+namespace {
+
+void Put(taotu::logger::LogRing* ring, const std::string& record) {
+  char* position = ring->Reserve(record.size());
+  ASSERT_NE(position, nullptr);
+  ::memcpy(position, record.data(), record.size());
+  ring->Commit(record.size());
+}
+
+}  // namespace
+
+TEST(LogRingTest, WrapAroundAndFull) {
+  taotu::logger::LogRing ring(64);
+  ASSERT_EQ(ring.GetCapacity(), 64u);
+  ASSERT_EQ(ring.Reserve(64), nullptr);  // Never fits with its header
+
+  std::string drained;
+  auto drain = [&drained](const char* record, size_t record_size) {
+    drained.append(record, record_size);
+  };
+  for (int i = 0; i < 100; ++i) {
+    // 24 bytes each, so the end of the buffer is skipped now and then
+    Put(&ring, "record" + std::to_string(i % 10) + std::string(13, '.'));
+    Put(&ring, "r" + std::to_string(i % 10));
+    ASSERT_EQ(ring.Drain(drain), 2u);
+    ASSERT_EQ(drained,
+              "record" + std::to_string(i % 10) + std::string(13, '.') + "r" +
+                  std::to_string(i % 10));
+    drained.clear();
+  }
+
+  Put(&ring, std::string(28, 'a'));
+  Put(&ring, std::string(28, 'b'));
+  ASSERT_EQ(ring.Reserve(1), nullptr);  // Full
+  ASSERT_EQ(ring.Drain(drain), 2u);
+  ASSERT_TRUE(ring.IsEmpty());
+  ASSERT_EQ(drained, std::string(28, 'a') + std::string(28, 'b'));
+}
+
+TEST(LogRingTest, ProducerAndConsumerThreads) {
+  constexpr int kAmount = 100000;
+  taotu::logger::LogRing ring(1024);
+  std::thread producer([&ring]() {
+    for (int i = 0; i < kAmount; ++i) {
+      auto record = std::to_string(i);
+      char* position = nullptr;
+      while ((position = ring.Reserve(record.size())) == nullptr) {
+      }
+      ::memcpy(position, record.data(), record.size());
+      ring.Commit(record.size());
+    }
+  });
+  int expected = 0;
+  while (expected < kAmount) {
+    ring.Drain([&expected](const char* record, size_t record_size) {
+      ASSERT_EQ(std::string(record, record_size), std::to_string(expected));
+      ++expected;
+    });
+  }
+  producer.join();
+  ASSERT_TRUE(ring.IsEmpty());
+}
+
+TEST(LogRingTest, DiscardOnRequest) {
+  taotu::logger::LogRing ring(256);
+  std::string drained;
+  auto drain = [&drained](const char* record, size_t record_size) {
+    drained.append(record, record_size);
+  };
+  ASSERT_FALSE(ring.IsMostlyFull());
+  for (int i = 0; i < 7; ++i) {
+    Put(&ring, std::string(28, static_cast<char>('a' + i)));  // 32 each
+  }
+  ASSERT_TRUE(ring.IsMostlyFull());
+
+  // Records published after the request are kept
+  ring.RequestDiscard();
+  Put(&ring, "new");
+  ASSERT_EQ(ring.Drain(drain), 1u);
+  ASSERT_EQ(ring.TakeDiscardedAmount(), 7u);
+  ASSERT_EQ(ring.TakeDiscardedAmount(), 0u);
+  ASSERT_EQ(drained, "new");
+  ASSERT_FALSE(ring.IsMostlyFull());
+}
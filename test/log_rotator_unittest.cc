@@ -0,0 +1,130 @@
+#include "../src/log_rotator.h"
+
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 2026-10-18 (UTC), with a second between rotations
+constexpr int64_t kBaseTime = 1792281600000000;
+constexpr int64_t kSecond = 1000000;
+
+class LogRotatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_name_ = "log_rotator_test_" + std::to_string(::getpid());
+    ::mkdir(dir_name_.c_str(), 0755);
+    file_name_ = dir_name_ + "/test.log";
+  }
+  void TearDown() override {
+    for (const auto& name : ListFiles()) {
+      ::unlink((dir_name_ + "/" + name).c_str());
+    }
+    ::rmdir(dir_name_.c_str());
+  }
+
+  std::vector<std::string> ListFiles() const {
+    std::vector<std::string> names;
+    DIR* dir = ::opendir(dir_name_.c_str());
+    while (struct dirent* entry = ::readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        names.emplace_back(entry->d_name);
+      }
+    }
+    ::closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+  void WriteActiveFile(const std::string& content) const {
+    std::ofstream file(file_name_, std::ios::binary | std::ios::trunc);
+    file << content;
+  }
+
+  std::string dir_name_;
+  std::string file_name_;
+};
+
+std::string ReadCompressed(const std::string& file_name) {
+  gzFile gz_file = ::gzopen(file_name.c_str(), "rb");
+  std::string content;
+  char chunk[256];
+  int n = 0;
+  while ((n = ::gzread(gz_file, chunk, sizeof(chunk))) > 0) {
+    content.append(chunk, static_cast<size_t>(n));
+  }
+  ::gzclose(gz_file);
+  return content;
+}
+
+}  // namespace
+
+TEST_F(LogRotatorTest, KeepCompressedFiles) {
+  taotu::logger::LogRotateOptions options;
+  options.retained_file_amount = 3;
+  taotu::logger::LogRotator rotator;
+  rotator.Start(file_name_, options);
+  for (int i = 0; i < 5; ++i) {
+    WriteActiveFile("content " + std::to_string(i) + "\n");
+    rotator.Rotate(kBaseTime + i * kSecond);
+  }
+  // Rotated twice in one second
+  WriteActiveFile("content 5\n");
+  rotator.Rotate(kBaseTime + 4 * kSecond);
+  rotator.Stop();
+  std::vector<std::string> names = ListFiles();
+  ASSERT_EQ(3U, names.size());
+  for (const auto& name : names) {
+    EXPECT_EQ(0U, name.find("test.log.2026"));
+    EXPECT_EQ(name.size() - 3, name.rfind(".gz"));
+  }
+  EXPECT_EQ("content 3\n", ReadCompressed(dir_name_ + "/" + names[0]));
+  EXPECT_EQ("content 4\n", ReadCompressed(dir_name_ + "/" + names[2]));
+  EXPECT_EQ("content 5\n", ReadCompressed(dir_name_ + "/" + names[1]));
+
+  // Files kept before count, and the active file left is rotated
+  WriteActiveFile("content 6\n");
+  options.retained_file_amount = 2;
+  rotator.Start(file_name_, options);
+  rotator.Stop();
+  names = ListFiles();
+  ASSERT_EQ(2U, names.size());
+  EXPECT_EQ("content 6\n", ReadCompressed(dir_name_ + "/" + names[1]));
+}
+
+TEST_F(LogRotatorTest, CapTotalByte) {
+  taotu::logger::LogRotateOptions options;
+  options.max_total_byte = 25;
+  options.should_compress = false;
+  taotu::logger::LogRotator rotator;
+  rotator.Start(file_name_, options);
+  for (int i = 0; i < 5; ++i) {
+    WriteActiveFile("content " + std::to_string(i) + "\n");  // 10 bytes
+    rotator.Rotate(kBaseTime + i * kSecond);
+  }
+  rotator.Stop();
+  EXPECT_EQ(2U, ListFiles().size());
+}
+
+TEST_F(LogRotatorTest, RotateBySizeAndTime) {
+  taotu::logger::LogRotateOptions options;
+  options.max_file_byte = 100;
+  options.interval_seconds = 3600;
+  taotu::logger::LogRotator rotator;
+  rotator.Start(file_name_, options);
+  WriteActiveFile("content\n");
+  rotator.Rotate(kBaseTime);
+  EXPECT_FALSE(rotator.ShouldRotate(99, kBaseTime + kSecond));
+  EXPECT_TRUE(rotator.ShouldRotate(100, kBaseTime + kSecond));
+  // On the hour
+  EXPECT_TRUE(rotator.ShouldRotate(0, kBaseTime + 3600 * kSecond));
+  rotator.Stop();
+}
@@ -1,8 +1,10 @@
 #include "../src/logger.h"
 
 #include <gtest/gtest.h>
+#include <signal.h>
 
 #include <atomic>
+#include <chrono>
 #include <fstream>
 #include <string>
 #include <thread>
@@ -18,6 +20,11 @@ std::string ReadFile(const std::string& path) {
                      std::istreambuf_iterator<char>());
 }
 
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::trunc);
+  out << content;
+}
+
 size_t CountSubstring(const std::string& text, const std::string& sub) {
   size_t count = 0;
   size_t pos = 0;
@@ -32,6 +39,21 @@ size_t CountSubstring(const std::string& text, const std::string& sub) {
   return count;
 }
 
+// Handler of the user, put back once the logger ends
+std::atomic<int> user_signal_amount{0};
+void CountUserSignal(int) { user_signal_amount.fetch_add(1); }
+
+// Logs of a category of users
+namespace cache {
+
+const taotu::logger::LogCategory kCacheLog =
+    taotu::logger::Logger::RegisterCategory("cache");
+USE_LOG_CATEGORY(kCacheLog);
+
+void LogCacheMiss(int key) { taotu::LOG_DEBUG("cache miss %d", key); }
+
+}  // namespace cache
+
 }  // namespace
 
 TEST(LoggerUnit, WritesExpectedPrefix) {
@@ -46,6 +68,182 @@ TEST(LoggerUnit, WritesExpectedPrefix) {
   std::remove(log_path.c_str());
 }
 
+TEST(LoggerUnit, SkipsLogsOfLevelsOff) {
+  const std::string log_path = "logger_level_test.log";
+  taotu::START_LOG(log_path.c_str());
+  int evaluated = 0;
+  auto evaluate = [&evaluated]() { return ++evaluated; };
+  taotu::SET_LOG_LEVEL(taotu::logger::kWarn);
+  taotu::LOG_INFO("level test %d", evaluate());
+  taotu::LOG_WARN("level test %d", evaluate());
+  taotu::SET_LOG_LEVEL(taotu::logger::kDebug);
+  taotu::END_LOG();
+
+  // Arguments of the log skipped are not evaluated
+  ASSERT_EQ(evaluated, 1);
+  const std::string content = ReadFile(log_path);
+  ASSERT_EQ(content.find("Log(Info): level test"), std::string::npos);
+  ASSERT_NE(content.find("Log(Warn): level test 1"), std::string::npos);
+
+  std::remove(log_path.c_str());
+}
+
+TEST(LoggerUnit, SetsLevelsOfCategories) {
+  using taotu::logger::Logger;
+  const std::string log_path = "logger_category_test.log";
+  taotu::START_LOG(log_path.c_str());
+  ASSERT_TRUE(Logger::SetLevels(
+      "*=warn, cache = debug  # Trace the cache only\npoller=3"));
+  ASSERT_EQ(Logger::GetCategoryLevel(taotu::logger::kPollerLog),
+            taotu::logger::kError);
+  ASSERT_NE(Logger::GetLevels().find("timer=warn, cache=debug"),
+            std::string::npos);
+  taotu::LOG_DEBUG("general %d", 1);
+  cache::LogCacheMiss(1);
+  taotu::SET_LOG_CATEGORY_LEVEL(cache::kCacheLog, taotu::logger::kInfo);
+  cache::LogCacheMiss(2);
+  // Items not understood are skipped
+  ASSERT_FALSE(Logger::SetLevels("nothing=debug, rpc=loud, timer=info"));
+  ASSERT_EQ(Logger::GetCategoryLevel(taotu::logger::kRpcLog),
+            taotu::logger::kWarn);
+  ASSERT_EQ(Logger::GetCategoryLevel(taotu::logger::kTimerLog),
+            taotu::logger::kInfo);
+  taotu::SET_LOG_LEVEL(taotu::logger::kDebug);
+  taotu::END_LOG();
+
+  const std::string content = ReadFile(log_path);
+  ASSERT_EQ(content.find("general 1"), std::string::npos);
+  ASSERT_NE(content.find("Log(Debug): cache miss 1"), std::string::npos);
+  ASSERT_EQ(content.find("cache miss 2"), std::string::npos);
+
+  std::remove(log_path.c_str());
+}
+
+TEST(LoggerUnit, ReloadsLevelsFromFile) {
+  using taotu::logger::Logger;
+  const std::string log_path = "logger_reload_test.log";
+  const std::string level_path = "logger_reload_test.levels";
+  WriteFile(level_path, "rpc=error\n");
+  ::signal(SIGUSR2, &CountUserSignal);
+  Logger* logger = Logger::GetLogger(false);
+  logger->SetLevelFile(level_path, SIGUSR2);
+  taotu::START_LOG(log_path.c_str());
+  // Loaded at start
+  ASSERT_EQ(Logger::GetCategoryLevel(taotu::logger::kRpcLog),
+            taotu::logger::kError);
+  WriteFile(level_path, "rpc=debug\n");
+  ::raise(SIGUSR2);
+  // Set by the writer thread soon
+  for (int i = 0; i < 200; ++i) {
+    if (Logger::GetCategoryLevel(taotu::logger::kRpcLog) ==
+        taotu::logger::kDebug) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(Logger::GetCategoryLevel(taotu::logger::kRpcLog),
+            taotu::logger::kDebug);
+  ASSERT_EQ(user_signal_amount.load(), 0);
+  taotu::END_LOG();
+  logger->SetLevelFile("", 0);
+  taotu::SET_LOG_LEVEL(taotu::logger::kDebug);
+  ::raise(SIGUSR2);
+  ASSERT_EQ(user_signal_amount.load(), 1);
+  ::signal(SIGUSR2, SIG_DFL);
+
+  const std::string content = ReadFile(log_path);
+  ASSERT_GE(CountSubstring(content, "Log(Notice): Log levels are set to "),
+            2u);
+  ASSERT_NE(content.find("rpc=debug"), std::string::npos);
+
+  std::remove(log_path.c_str());
+  std::remove(level_path.c_str());
+}
+
+TEST(LoggerUnit, LimitsLogsOfCallSites) {
+  const std::string log_path = "logger_limit_test.log";
+  taotu::START_LOG(log_path.c_str());
+  for (int i = 0; i < 100; ++i) {
+    taotu::LOG_ERROR_EVERY_N(10, "every n %d", i);
+  }
+  for (int i = 0; i < 3; ++i) {
+    taotu::LOG_EVERY_MS(taotu::logger::kInfo, 60000, "every ms %d", i);
+  }
+  taotu::END_LOG();
+
+  const std::string content = ReadFile(log_path);
+  ASSERT_EQ(CountSubstring(content, "every n "), 10u);
+  ASSERT_NE(content.find("Log(Error): every n 90\n"), std::string::npos);
+  ASSERT_EQ(CountSubstring(content, "every ms "), 1u);
+  ASSERT_NE(content.find("Log(Info): every ms 0\n"), std::string::npos);
+
+  std::remove(log_path.c_str());
+}
+
+TEST(LoggerUnit, WritesKeyValuesInJsonLines) {
+  const std::string log_path = "logger_kv_test.log";
+  taotu::logger::Logger* logger = taotu::logger::Logger::GetLogger(false);
+  logger->SetFileFormat(taotu::logger::kJsonFile);
+  taotu::START_LOG(log_path.c_str());
+  std::string peer_ip{"127.0.0.1"};
+  taotu::LOG_KV(taotu::logger::kNotice, "conn_state", "fd", 5, "peer_ip",
+                peer_ip, "state", "up");
+  taotu::LOG_NOTICE("plain %d", 1);
+  taotu::END_LOG();
+  logger->SetFileFormat(taotu::logger::kTextFile);
+
+  // No text header, every line is an object
+  const std::string content = ReadFile(log_path);
+  ASSERT_EQ(content.compare(0, 9, "{\"time\":\""), 0);
+  ASSERT_NE(content.find("\"level\":\"notice\",\"event\":\"conn_state\","
+                         "\"fd\":5,\"peer_ip\":\"127.0.0.1\","
+                         "\"state\":\"up\"}\n"),
+            std::string::npos);
+  ASSERT_NE(content.find("\"level\":\"notice\",\"message\":\"plain 1\"}\n"),
+            std::string::npos);
+
+  std::remove(log_path.c_str());
+}
+
+TEST(LoggerUnit, CountsRecordsDroppedInOverload) {
+  const std::string log_path = "logger_overload_test.log";
+  constexpr int kAmount = 20000;
+  taotu::logger::Logger* logger = taotu::logger::Logger::GetLogger(false);
+  // Rings of threads logging for the first time are tiny
+  logger->SetRingByte(4096);
+  taotu::START_LOG(log_path.c_str());
+  std::thread([]() {
+    for (int i = 0; i < kAmount; ++i) {
+      taotu::LOG_INFO("dropped %d", i);
+    }
+  }).join();
+  logger->SetOverloadPolicy(taotu::logger::kInfo, taotu::logger::kBlock,
+                            10000000);
+  std::thread([]() {
+    for (int i = 0; i < kAmount; ++i) {
+      taotu::LOG_INFO("blocked %d", i);
+    }
+  }).join();
+  logger->SetOverloadPolicy(taotu::logger::kInfo, taotu::logger::kDropNewest);
+  logger->SetRingByte(taotu::logger::kLogRingByte);
+  taotu::END_LOG();
+
+  // Records written and dropped add up
+  const std::string content = ReadFile(log_path);
+  const std::string report = "Log(Warn): ";
+  size_t dropped = 0;
+  for (size_t pos = content.find(report); pos != std::string::npos;
+       pos = content.find(report, pos + 1)) {
+    dropped += std::stoul(content.substr(pos + report.size()));
+  }
+  ASSERT_EQ(CountSubstring(content, "Log(Info): dropped ") + dropped,
+            static_cast<size_t>(kAmount));
+  ASSERT_EQ(CountSubstring(content, "Log(Info): blocked "),
+            static_cast<size_t>(kAmount));
+
+  std::remove(log_path.c_str());
+}
+
 TEST(LoggerRegression, MultiThreadedLoggingDoesNotLoseLogs) {
   const std::string log_path = "logger_regression_test.log";
   taotu::START_LOG(log_path.c_str());
@@ -0,0 +1,44 @@
+#include "../src/net_address.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <sys/un.h>
+
+#include <string>
+
+TEST(NetAddressTest, IpAndPort) {
+  taotu::NetAddress ipv4{"127.0.0.1", 4567};
+  ASSERT_EQ(ipv4.GetFamily(), AF_INET);
+  ASSERT_EQ(ipv4.GetIp(), std::string("127.0.0.1"));
+  ASSERT_EQ(ipv4.GetPort(), 4567);
+  taotu::NetAddress ipv6{"::1", 4567};
+  ASSERT_EQ(ipv6.GetFamily(), AF_INET6);
+  ASSERT_EQ(ipv6.GetIp(), std::string("::1"));
+  ASSERT_FALSE(ipv6.IsUnix());
+}
+
+TEST(NetAddressTest, UnixDomainSocket) {
+  auto path = taotu::NetAddress::FromUnixPath("/tmp/taotu.sock");
+  ASSERT_TRUE(path.IsUnix());
+  ASSERT_FALSE(path.IsAbstract());
+  ASSERT_EQ(path.GetUnixPath(), std::string("/tmp/taotu.sock"));
+  ASSERT_EQ(path.GetPort(), 0);
+  size_t path_offset = offsetof(struct sockaddr_un, sun_path);
+  ASSERT_EQ(path.GetSize(), path_offset + ::strlen("/tmp/taotu.sock") + 1);
+
+  auto abstract = taotu::NetAddress::FromAbstractName("taotu");
+  ASSERT_TRUE(abstract.IsAbstract());
+  ASSERT_EQ(abstract.GetUnixPath(), std::string("@taotu"));
+  ASSERT_EQ(abstract.GetSize(), path_offset + 6);
+
+  // Addresses given by the kernel keep their length
+  struct sockaddr_storage raw {};
+  ::memcpy(&raw, abstract.GetNetAddress(), abstract.GetSize());
+  taotu::NetAddress copied;
+  copied.SetRawAddr(raw, static_cast<socklen_t>(abstract.GetSize()));
+  ASSERT_EQ(copied.GetUnixPath(), std::string("@taotu"));
+  taotu::NetAddress unnamed;
+  unnamed.SetRawAddr(raw, static_cast<socklen_t>(sizeof(sa_family_t)));
+  ASSERT_TRUE(unnamed.IsUnix());
+  ASSERT_EQ(unnamed.GetUnixPath(), std::string());
+}
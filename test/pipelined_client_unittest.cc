@@ -0,0 +1,371 @@
+#include "../src/pipelined_client.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/event_manager.h"
+#include "../src/io_buffer.h"
+#include "../src/logger.h"
+
+namespace {
+
+constexpr int64_t kShortTimeout = 50 * 1000;
+
+// Take one line (without '\n') from the front of the buffer
+int DecodeLine(taotu::IoBuffer* io_buffer, std::string* line) {
+  const char* begin = io_buffer->GetReadablePosition();
+  const char* end = static_cast<const char*>(
+      ::memchr(begin, '\n', io_buffer->GetReadableBytes()));
+  if (nullptr == end) {
+    return 0;
+  }
+  *line = io_buffer->RetrieveAString(static_cast<size_t>(end - begin));
+  io_buffer->Refresh(1);
+  return 1;
+}
+
+// Lines answered in order
+struct LineCodec {
+  typedef std::string Request;
+  typedef std::string Response;
+
+  static void Encode(const Request& request, taotu::IoBuffer* io_buffer) {
+    io_buffer->Append(request.data(), request.size());
+    io_buffer->Append("\n", 1);
+  }
+  static int Decode(taotu::IoBuffer* io_buffer, Response* response) {
+    return DecodeLine(io_buffer, response);
+  }
+};
+
+// Lines of "<id> <body>" answered in any order
+struct IdLineCodec {
+  struct Message {
+    uint64_t id;
+    std::string body;
+  };
+  typedef Message Request;
+  typedef Message Response;
+
+  static constexpr bool kMatchById = true;
+
+  static void Encode(const Request& request, taotu::IoBuffer* io_buffer) {
+    std::string line = std::to_string(request.id) + ' ' + request.body + '\n';
+    io_buffer->Append(line.data(), line.size());
+  }
+  static int Decode(taotu::IoBuffer* io_buffer, Response* response) {
+    std::string line;
+    if (0 == DecodeLine(io_buffer, &line)) {
+      return 0;
+    }
+    size_t space = line.find(' ');
+    if (std::string::npos == space) {
+      return -1;
+    }
+    response->id = std::stoull(line.substr(0, space));
+    response->body = line.substr(space + 1);
+    return 1;
+  }
+  static uint64_t GetRequestId(const Request& request) { return request.id; }
+  static uint64_t GetResponseId(const Response& response) {
+    return response.id;
+  }
+};
+
+// A server on a free port of the loopback which echoes each line, except for
+// lines with "silent" (never answered), "later" (held until a line with
+// "flush", then answered in reverse) and "close" (the connection is closed)
+class LineServer {
+ public:
+  LineServer() : listen_fd_(::socket(AF_INET, SOCK_STREAM, 0)) {
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address));
+    ::listen(listen_fd_, SOMAXCONN);
+    socklen_t length = sizeof(address);
+    ::getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&address),
+                  &length);
+    address_.SetNetAddress(address);
+    thread_ = std::thread([this]() {
+      int fd = -1;
+      while ((fd = ::accept(listen_fd_, nullptr, nullptr)) >= 0) {
+        Serve(fd);
+      }
+    });
+  }
+  ~LineServer() {
+    ::shutdown(listen_fd_, SHUT_RDWR);  // Wake up "accept()"
+    thread_.join();
+    ::close(listen_fd_);
+  }
+
+  const taotu::NetAddress& GetAddress() const { return address_; }
+
+ private:
+  static void Serve(int fd) {
+    std::string received;
+    std::vector<std::string> held;
+    char buffer[256];
+    ssize_t size = 0;
+    while ((size = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+      received.append(buffer, static_cast<size_t>(size));
+      size_t end = 0;
+      while ((end = received.find('\n')) != std::string::npos) {
+        std::string line = received.substr(0, end + 1);
+        received.erase(0, end + 1);
+        if (line.find("close") != std::string::npos) {
+          ::close(fd);
+          return;
+        }
+        if (line.find("silent") != std::string::npos) {
+          continue;
+        }
+        if (line.find("later") != std::string::npos) {
+          held.push_back(std::move(line));
+          continue;
+        }
+        std::string answer;
+        if (line.find("flush") != std::string::npos) {
+          std::reverse(held.begin(), held.end());
+          for (const auto& held_line : held) {
+            answer += held_line;
+          }
+          held.clear();
+        }
+        answer += line;
+        ::send(fd, answer.data(), answer.size(), MSG_NOSIGNAL);
+      }
+    }
+    ::close(fd);
+  }
+
+  int listen_fd_;
+  taotu::NetAddress address_;
+  std::thread thread_;
+};
+
+bool WaitUntil(const std::function<bool()>& is_done) {
+  for (int i = 0; i < 500; ++i) {
+    if (is_done()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return is_done();
+}
+
+// A connected pipelined client which records how its requests complete
+template <typename CODEC>
+class Harness {
+ public:
+  typedef taotu::PipelinedClient<CODEC> Client;
+  typedef typename Client::Status Status;
+
+  struct Completion {
+    Status status;
+    typename CODEC::Response response;
+  };
+
+  Harness() {
+    event_manager_.Loop();
+    client_ = std::make_unique<Client>(&event_manager_, server_.GetAddress());
+    client_->SetConnectionCallback([this](taotu::Connecting& connection) {
+      is_connected_.store(connection.IsConnected());
+    });
+  }
+  ~Harness() {
+    // Close it in the loop and quit, then nothing runs into the client
+    client_->Disconnect();
+    event_manager_.Join();
+  }
+
+  bool Connect() {
+    client_->Connect();
+    return WaitUntil([this]() { return is_connected_.load(); });
+  }
+
+  void Call(typename CODEC::Request request, int64_t timeout_microseconds) {
+    client_->Call(
+        std::move(request),
+        [this](Status status, typename CODEC::Response* response) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          completions_.push_back(Completion{
+              status, nullptr == response ? typename CODEC::Response{}
+                                          : std::move(*response)});
+        },
+        timeout_microseconds);
+  }
+
+  bool WaitForCompletions(size_t amount) {
+    return WaitUntil([this, amount]() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return completions_.size() >= amount;
+    });
+  }
+  std::vector<Completion> GetCompletions() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completions_;
+  }
+
+  Client* GetClient() { return client_.get(); }
+  bool IsConnected() const { return is_connected_.load(); }
+
+ private:
+  LineServer server_;
+  taotu::EventManager event_manager_;
+  std::unique_ptr<Client> client_;
+  std::atomic_bool is_connected_{false};
+  std::mutex mutex_;
+  std::vector<Completion> completions_;
+};
+
+typedef Harness<LineCodec> LineHarness;
+typedef Harness<IdLineCodec> IdLineHarness;
+
+class PipelinedClientTest : public ::testing::Test {
+ protected:
+  static void TearDownTestSuite() { taotu::END_LOG(); }
+};
+
+}  // namespace
+
+TEST_F(PipelinedClientTest, CompletesInOrder) {
+  LineHarness harness;
+  ASSERT_TRUE(harness.Connect());
+  harness.Call("first", 0);
+  harness.Call("second", 0);
+  harness.Call("third", 0);
+  ASSERT_TRUE(harness.WaitForCompletions(3));
+  auto completions = harness.GetCompletions();
+  ASSERT_EQ(completions.size(), 3u);
+  const char* expected[] = {"first", "second", "third"};
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(completions[i].status, LineHarness::Status::kOk);
+    ASSERT_EQ(completions[i].response, expected[i]);
+  }
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 0u);
+}
+
+TEST_F(PipelinedClientTest, TimesOutInOrder) {
+  LineHarness harness;
+  ASSERT_TRUE(harness.Connect());
+  harness.Call("silent", kShortTimeout);
+  ASSERT_TRUE(harness.WaitForCompletions(1));
+  ASSERT_EQ(harness.GetCompletions()[0].status,
+            LineHarness::Status::kTimedOut);
+  // Kept to take the late response
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 1u);
+  ASSERT_TRUE(harness.IsConnected());
+}
+
+TEST_F(PipelinedClientTest, ClosesWhenTooManyTimedOut) {
+  LineHarness harness;
+  harness.GetClient()->SetMaxTimedOutInOrder(2);
+  ASSERT_TRUE(harness.Connect());
+  harness.Call("silent", 0);
+  for (int i = 0; i < 3; ++i) {
+    harness.Call("silent", kShortTimeout);
+  }
+  ASSERT_TRUE(harness.WaitForCompletions(4));
+  auto completions = harness.GetCompletions();
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(completions[i].status, LineHarness::Status::kTimedOut);
+  }
+  ASSERT_EQ(completions[3].status, LineHarness::Status::kDisconnected);
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 0u);
+  ASSERT_TRUE(WaitUntil([&harness]() { return !harness.IsConnected(); }));
+}
+
+TEST_F(PipelinedClientTest, FailsPendingInOrderOnDisconnect) {
+  LineHarness harness;
+  ASSERT_TRUE(harness.Connect());
+  harness.Call("silent", 0);
+  harness.Call("close", 0);
+  ASSERT_TRUE(harness.WaitForCompletions(2));
+  for (const auto& completion : harness.GetCompletions()) {
+    ASSERT_EQ(completion.status, LineHarness::Status::kDisconnected);
+  }
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 0u);
+  // Not written at all
+  harness.Call("next", 0);
+  ASSERT_TRUE(harness.WaitForCompletions(3));
+  ASSERT_EQ(harness.GetCompletions()[2].status,
+            LineHarness::Status::kDisconnected);
+}
+
+TEST_F(PipelinedClientTest, MatchesById) {
+  IdLineHarness harness;
+  ASSERT_TRUE(harness.Connect());
+  harness.Call({1, "later one"}, 0);
+  harness.Call({2, "later two"}, 0);
+  harness.Call({3, "flush three"}, 0);
+  ASSERT_TRUE(harness.WaitForCompletions(3));
+  auto completions = harness.GetCompletions();
+  ASSERT_EQ(completions.size(), 3u);
+  // Answered in reverse
+  const uint64_t expected_ids[] = {2, 1, 3};
+  const char* expected_bodies[] = {"later two", "later one", "flush three"};
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(completions[i].status, IdLineHarness::Status::kOk);
+    ASSERT_EQ(completions[i].response.id, expected_ids[i]);
+    ASSERT_EQ(completions[i].response.body, expected_bodies[i]);
+  }
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 0u);
+}
+
+TEST_F(PipelinedClientTest, TimesOutById) {
+  IdLineHarness harness;
+  ASSERT_TRUE(harness.Connect());
+  harness.Call({7, "silent"}, kShortTimeout);
+  ASSERT_TRUE(harness.WaitForCompletions(1));
+  ASSERT_EQ(harness.GetCompletions()[0].status,
+            IdLineHarness::Status::kTimedOut);
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 0u);
+  // The id is free again
+  harness.Call({7, "again"}, 0);
+  ASSERT_TRUE(harness.WaitForCompletions(2));
+  ASSERT_EQ(harness.GetCompletions()[1].status, IdLineHarness::Status::kOk);
+  ASSERT_EQ(harness.GetCompletions()[1].response.body, "again");
+}
+
+TEST_F(PipelinedClientTest, RejectsDuplicateId) {
+  IdLineHarness harness;
+  ASSERT_TRUE(harness.Connect());
+  harness.Call({5, "silent"}, 0);
+  harness.Call({5, "duplicate"}, 0);
+  ASSERT_TRUE(harness.WaitForCompletions(1));
+  ASSERT_EQ(harness.GetCompletions()[0].status,
+            IdLineHarness::Status::kDuplicateId);
+  // The pending one is kept
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 1u);
+}
+
+TEST_F(PipelinedClientTest, FailsPendingByIdOnDisconnect) {
+  IdLineHarness harness;
+  ASSERT_TRUE(harness.Connect());
+  harness.Call({1, "silent"}, 0);
+  harness.Call({2, "later"}, 0);
+  harness.Call({3, "close"}, 0);
+  ASSERT_TRUE(harness.WaitForCompletions(3));
+  for (const auto& completion : harness.GetCompletions()) {
+    ASSERT_EQ(completion.status, IdLineHarness::Status::kDisconnected);
+  }
+  ASSERT_EQ(harness.GetClient()->GetPendingAmount(), 0u);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file main.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief The entrance of "taotu-log-decode" which turns binary log files into
+ * text lines.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/log_record.h"
+
+namespace {
+
+void PrintUsage() {
+  ::fprintf(stderr,
+            "Usage: taotu-log-decode [--json|--logfmt] [FILE...]\n"
+            "  Print the lines of binary log files (written by the logger\n"
+            "  set to \"kBinaryFile\") in order, or of the standard input if\n"
+            "  no file is given. Lines are JSON or logfmt ones if asked.\n");
+}
+
+bool ReadExactly(FILE* file, void* buffer, size_t size) {
+  return size == 0 || ::fread(buffer, size, 1, file) == 1;
+}
+
+// Decode one binary log file into the standard output, false if it is broken
+bool DecodeFile(FILE* file, const char* name,
+                taotu::logger::LogLineStyle style) {
+  char magic[sizeof(taotu::logger::kBinaryLogMagic)];
+  if (!ReadExactly(file, magic, sizeof(magic)) ||
+      ::memcmp(magic, taotu::logger::kBinaryLogMagic, sizeof(magic)) != 0) {
+    ::fprintf(stderr, "%s is not a binary log file.\n", name);
+    return false;
+  }
+  taotu::logger::LogLineFormatter line_formatter{style};
+  // Mapping: format id -> format
+  std::unordered_map<uint32_t, std::string> formats;
+  std::vector<char> bytes;
+  std::string line;
+  while (true) {
+    uint8_t kind = 0;
+    if (::fread(&kind, sizeof(kind), 1, file) != 1) {
+      return true;  // The end
+    }
+    uint32_t format_id = 0;
+    uint32_t size = 0;
+    if (!ReadExactly(file, &format_id, sizeof(format_id)) ||
+        !ReadExactly(file, &size, sizeof(size))) {
+      break;
+    }
+    bytes.resize(size);
+    if (!ReadExactly(file, bytes.data(), size)) {
+      break;
+    }
+    if (taotu::logger::kFormatEntry == kind) {
+      formats[format_id].assign(bytes.data(), size);
+    } else if (taotu::logger::kRecordEntry == kind) {
+      const char* format = nullptr;
+      if (format_id != 0) {
+        auto itr = formats.find(format_id);
+        if (itr == formats.end()) {
+          ::fprintf(stderr, "%s has a record of unknown format(%u).\n", name,
+                    format_id);
+          continue;
+        }
+        format = itr->second.c_str();
+      }
+      line.clear();
+      line_formatter.AppendLine(format, bytes.data(), size, &line);
+      ::fwrite(line.c_str(), line.size(), 1, stdout);
+    } else {
+      break;
+    }
+  }
+  // A record cut off (by a crash) ends the file
+  ::fprintf(stderr, "%s ends with a broken entry.\n", name);
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && (::strcmp(argv[1], "-h") == 0 ||
+                   ::strcmp(argv[1], "--help") == 0)) {
+    PrintUsage();
+    return 0;
+  }
+  int first_file = 1;
+  auto style = taotu::logger::kPlainLine;
+  if (argc > 1 && ::strcmp(argv[1], "--json") == 0) {
+    style = taotu::logger::kJsonLine;
+    ++first_file;
+  } else if (argc > 1 && ::strcmp(argv[1], "--logfmt") == 0) {
+    style = taotu::logger::kLogfmtLine;
+    ++first_file;
+  }
+  if (argc <= first_file) {
+    return DecodeFile(stdin, "stdin", style) ? 0 : 1;
+  }
+  int ret = 0;
+  for (int i = first_file; i < argc; ++i) {
+    FILE* file = ::fopen(argv[i], "rb");
+    if (nullptr == file) {
+      ::fprintf(stderr, "Can not open %s.\n", argv[i]);
+      ret = 1;
+      continue;
+    }
+    if (!DecodeFile(file, argv[i], style)) {
+      ret = 1;
+    }
+    ::fclose(file);
+  }
+  return ret;
+}
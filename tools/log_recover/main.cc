@@ -0,0 +1,127 @@
+/**
+ * @file main.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief The entrance of "taotu-log-recover" which prints the log records left
+ * in a crash file after the process crashed.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../../src/log_clock.h"
+#include "../../src/log_crash_file.h"
+#include "../../src/log_record.h"
+
+namespace {
+
+void PrintUsage() {
+  ::fprintf(stderr,
+            "Usage: taotu-log-recover [--json|--logfmt] CRASH_FILE\n"
+            "  Print the log records which were not written down yet when\n"
+            "  the process crashed, kept in the crash file set by\n"
+            "  \"SetCrashFile()\" (renamed with \".last\" by the next run),\n"
+            "  in order of time. Lines are JSON or logfmt ones if asked.\n");
+}
+
+struct Record {
+  int64_t time_us;
+  // Of a plain message if there is none
+  bool has_format;
+  std::string format;
+  std::string body;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int first_arg = 1;
+  auto style = taotu::logger::kPlainLine;
+  if (argc > 1 && ::strcmp(argv[1], "--json") == 0) {
+    style = taotu::logger::kJsonLine;
+    ++first_arg;
+  } else if (argc > 1 && ::strcmp(argv[1], "--logfmt") == 0) {
+    style = taotu::logger::kLogfmtLine;
+    ++first_arg;
+  }
+  if (argc != first_arg + 1 || ::strcmp(argv[first_arg], "-h") == 0 ||
+      ::strcmp(argv[first_arg], "--help") == 0) {
+    PrintUsage();
+    return argc == first_arg + 1 ? 0 : 1;
+  }
+  const char* name = argv[first_arg];
+  int fd = ::open(name, O_RDONLY | O_CLOEXEC);
+  struct stat file_stat;
+  if (fd < 0 || ::fstat(fd, &file_stat) != 0) {
+    ::fprintf(stderr, "Can not open %s.\n", name);
+    return 1;
+  }
+  auto size = static_cast<size_t>(file_stat.st_size);
+  void* data = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                        : MAP_FAILED;
+  ::close(fd);
+  if (MAP_FAILED == data) {
+    ::fprintf(stderr, "%s is not a crash file.\n", name);
+    return 1;
+  }
+  taotu::logger::LogCrashState state;
+  std::vector<Record> records;
+  bool is_read = taotu::logger::LogCrashFile::ReadRecords(
+      static_cast<const char*>(data), size, &state,
+      [&records](const char* format, const char* body, size_t body_size) {
+        Record record{0, format != nullptr,
+                      format != nullptr ? format : "",
+                      std::string(body, body_size)};
+        ::memcpy(&record.time_us, body, sizeof(record.time_us));
+        records.push_back(std::move(record));
+      });
+  if (!is_read) {
+    ::fprintf(stderr, "%s is not a crash file.\n", name);
+    ::munmap(data, size);
+    return 1;
+  }
+  // Rings of threads are merged by time
+  std::stable_sort(records.begin(), records.end(),
+                   [](const Record& lhs, const Record& rhs) {
+                     return lhs.time_us < rhs.time_us;
+                   });
+  taotu::logger::LogLineFormatter line_formatter{style};
+  std::string line;
+  for (const auto& record : records) {
+    line.clear();
+    line_formatter.AppendLine(
+        record.has_format ? record.format.c_str() : nullptr,
+        record.body.data(), record.body.size(), &line);
+    ::fwrite(line.c_str(), line.size(), 1, stdout);
+  }
+  if (state.signal_number != 0) {
+    char crash_time[taotu::logger::LogClock::kTimestampByte + 1];
+    crash_time[taotu::logger::LogClock::FormatTimestamp(state.crash_time_us,
+                                                        crash_time)] = '\0';
+    ::fprintf(stderr,
+              "Process(%lld) got signal(%d) (%s) at %s, %zu records are "
+              "left.\n",
+              static_cast<long long>(state.pid), state.signal_number,
+              ::strsignal(state.signal_number), crash_time, records.size());
+  } else {
+    ::fprintf(stderr, "Process(%lld) %s, %zu records are left.\n",
+              static_cast<long long>(state.pid),
+              state.is_closed ? "closed the logger"
+                              : "died without a fatal signal caught",
+              records.size());
+  }
+  ::munmap(data, size);
+  return 0;
+}
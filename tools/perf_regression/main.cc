@@ -0,0 +1,198 @@
+/**
+ * @file main.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief The entrance of the performance regression driver "taotu-perf".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "perf_runner.h"
+
+namespace {
+
+void PrintUsage() {
+  ::fprintf(
+      stderr,
+      "Usage: taotu-perf [options]\n"
+      "  -b, --bin-dir=DIR             Where the servers and taotu-bench are\n"
+      "                                (the directory of taotu-perf)\n"
+      "  -S, --servers=A,B,...         Servers run (all of simple_echo,\n"
+      "                                pingpong, http_server, chat_room,\n"
+      "                                rpc_demo)\n"
+      "  -c, --connections=N,...       Connections (16,256)\n"
+      "  -s, --sizes=BYTES,...         Sizes of messages (64,4096)\n"
+      "  -t, --io-threads=N,...        I/O threads of the servers (1,4)\n"
+      "  -T, --client-threads=N        I/O threads of taotu-bench (4)\n"
+      "  -d, --duration=SECONDS        Duration of each run (5)\n"
+      "  -P, --port=PORT               First port taken (45670)\n"
+      "  -o, --output=FILE             Save the results in JSON lines\n"
+      "  -B, --baseline=FILE           Compare with the baseline, which is\n"
+      "                                saved from this run if missing\n"
+      "      --tolerance=RATIO         Of throughput, p99 and CPU (0.1)\n"
+      "      --rss-tolerance=RATIO     Of peak RSS (0.2)\n");
+}
+
+std::vector<std::string> Split(const std::string& text) {
+  std::vector<std::string> parts;
+  size_t begin = 0;
+  while (begin <= text.size()) {
+    size_t end = text.find(',', begin);
+    if (std::string::npos == end) {
+      end = text.size();
+    }
+    if (end > begin) {
+      parts.push_back(text.substr(begin, end - begin));
+    }
+    begin = end + 1;
+  }
+  return parts;
+}
+
+std::vector<size_t> SplitAmounts(const std::string& text) {
+  std::vector<size_t> amounts;
+  for (const auto& part : Split(text)) {
+    auto amount = static_cast<size_t>(::atol(part.c_str()));
+    if (amount > 0) {
+      amounts.push_back(amount);
+    }
+  }
+  return amounts;
+}
+
+std::string GetOwnDirectory() {
+  char path[4096];
+  ssize_t length = ::readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length <= 0) {
+    return ".";
+  }
+  std::string own_path(path, static_cast<size_t>(length));
+  auto position = own_path.rfind('/');
+  return std::string::npos == position ? "." : own_path.substr(0, position);
+}
+
+}  // namespace
+
+// Call it like:
+// './taotu-perf -S simple_echo,http_server -d 10 -B baseline.jsonl'
+int main(int argc, char* argv[]) {
+  enum { kToleranceOption = 256, kRssToleranceOption };
+  static const struct option kLongOptions[] = {
+      {"bin-dir", required_argument, nullptr, 'b'},
+      {"servers", required_argument, nullptr, 'S'},
+      {"connections", required_argument, nullptr, 'c'},
+      {"sizes", required_argument, nullptr, 's'},
+      {"io-threads", required_argument, nullptr, 't'},
+      {"client-threads", required_argument, nullptr, 'T'},
+      {"duration", required_argument, nullptr, 'd'},
+      {"port", required_argument, nullptr, 'P'},
+      {"output", required_argument, nullptr, 'o'},
+      {"baseline", required_argument, nullptr, 'B'},
+      {"tolerance", required_argument, nullptr, kToleranceOption},
+      {"rss-tolerance", required_argument, nullptr, kRssToleranceOption},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+  PerfOptions options;
+  options.bin_dir = GetOwnDirectory();
+  std::string output_path;
+  std::string baseline_path;
+  int option;
+  while ((option = ::getopt_long(argc, argv, "b:S:c:s:t:T:d:P:o:B:h",
+                                 kLongOptions, nullptr)) != -1) {
+    switch (option) {
+      case 'b':
+        options.bin_dir = optarg;
+        break;
+      case 'S':
+        options.servers = Split(optarg);
+        break;
+      case 'c':
+        options.connection_amounts = SplitAmounts(optarg);
+        break;
+      case 's':
+        options.message_sizes = SplitAmounts(optarg);
+        break;
+      case 't':
+        options.io_thread_amounts = SplitAmounts(optarg);
+        break;
+      case 'T':
+        options.client_thread_amount = static_cast<size_t>(::atol(optarg));
+        break;
+      case 'd':
+        options.duration_seconds = ::atol(optarg);
+        break;
+      case 'P':
+        options.port = static_cast<uint16_t>(::atoi(optarg));
+        break;
+      case 'o':
+        output_path = optarg;
+        break;
+      case 'B':
+        baseline_path = optarg;
+        break;
+      case kToleranceOption:
+        options.throughput_tolerance = ::atof(optarg);
+        options.latency_tolerance = options.throughput_tolerance;
+        options.cpu_tolerance = options.throughput_tolerance;
+        break;
+      case kRssToleranceOption:
+        options.rss_tolerance = ::atof(optarg);
+        break;
+      default:
+        PrintUsage();
+        return 'h' == option ? 0 : 1;
+    }
+  }
+  if (options.connection_amounts.empty() || options.message_sizes.empty() ||
+      options.io_thread_amounts.empty() || 0 == options.client_thread_amount ||
+      options.duration_seconds <= 0) {
+    PrintUsage();
+    return 1;
+  }
+
+  PerfRunner perf_runner{options};
+  std::vector<PerfResult> results;
+  bool is_successful = perf_runner.Run(&results);
+  if (!output_path.empty() &&
+      !PerfRunner::SaveResults(output_path, results)) {
+    ::fprintf(stderr, "Failed to save the results in %s!\n",
+              output_path.c_str());
+    is_successful = false;
+  }
+  if (baseline_path.empty()) {
+    for (const auto& result : results) {
+      ::printf("%s\n", result.ToJson().c_str());
+    }
+    return is_successful ? 0 : 1;
+  }
+  std::vector<PerfResult> baseline;
+  if (0 != ::access(baseline_path.c_str(), F_OK)) {
+    // The first run on this machine sets the baseline
+    if (!PerfRunner::SaveResults(baseline_path, results)) {
+      ::fprintf(stderr, "Failed to save the baseline in %s!\n",
+                baseline_path.c_str());
+      return 1;
+    }
+    ::printf("The baseline is saved in %s\n", baseline_path.c_str());
+    return is_successful ? 0 : 1;
+  }
+  if (!PerfRunner::LoadResults(baseline_path, &baseline)) {
+    ::fprintf(stderr, "Failed to load the baseline from %s!\n",
+              baseline_path.c_str());
+    return 1;
+  }
+  if (!perf_runner.Compare(baseline, results)) {
+    is_successful = false;
+  }
+  return is_successful ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+/**
+ * @file perf_runner.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "PerfRunner" which runs the example servers
+ * under a matrix of workloads and compares the results with a baseline.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "perf_runner.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+constexpr int kProbingTimes = 100;
+constexpr int64_t kProbingIntervalMilliseconds = 50;
+
+// Only the flat objects written by "PerfResult::ToJson()" and by
+// "taotu-bench --json" are read, so a full JSON parser is not needed
+bool FindJsonValue(const std::string& line, const std::string& name,
+                   std::string* value) {
+  auto position = line.find("\"" + name + "\":");
+  if (std::string::npos == position) {
+    return false;
+  }
+  position = line.find_first_not_of(' ', position + name.size() + 3);
+  if (std::string::npos == position) {
+    return false;
+  }
+  if ('"' == line[position]) {
+    auto end = line.find('"', position + 1);
+    if (std::string::npos == end) {
+      return false;
+    }
+    *value = line.substr(position + 1, end - position - 1);
+  } else {
+    auto end = line.find_first_of(",}", position);
+    if (std::string::npos == end) {
+      return false;
+    }
+    *value = line.substr(position, end - position);
+  }
+  return true;
+}
+
+bool FindJsonNumber(const std::string& line, const std::string& name,
+                    double* value) {
+  std::string text;
+  if (!FindJsonValue(line, name, &text) || text.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  *value = ::strtod(text.c_str(), &end);
+  return end != text.c_str();
+}
+
+double GetChange(double old_value, double new_value) {
+  return old_value > 0 ? (new_value - old_value) / old_value : 0.0;
+}
+
+}  // namespace
+
+std::string Workload::GetKey() const {
+  std::string key{server};
+  key += "/c" + std::to_string(connection_amount);
+  if (message_size > 0) {
+    key += "/s" + std::to_string(message_size);
+  }
+  key += "/t" + std::to_string(io_thread_amount);
+  return key;
+}
+
+std::string PerfResult::ToJson() const {
+  char buf[512];
+  ::snprintf(buf, sizeof(buf),
+             "{\"key\": \"%s\", \"server\": \"%s\", \"connections\": %zu, "
+             "\"size\": %zu, \"io_threads\": %zu, \"completed\": %ld, "
+             "\"errors\": %ld, \"throughput\": %.1lf, \"p99_us\": %.1lf, "
+             "\"cpu_us_per_request\": %.3lf, \"rss_kb\": %ld}",
+             workload.GetKey().c_str(), workload.server.c_str(),
+             workload.connection_amount, workload.message_size,
+             workload.io_thread_amount, completed, errors, throughput, p99_us,
+             cpu_us_per_request, rss_kb);
+  return buf;
+}
+
+bool PerfResult::FromJson(const std::string& line, PerfResult* result) {
+  double connection_amount = 0, message_size = 0, io_thread_amount = 0;
+  double completed = 0, errors = 0, rss_kb = 0;
+  if (!FindJsonValue(line, "server", &result->workload.server) ||
+      !FindJsonNumber(line, "connections", &connection_amount) ||
+      !FindJsonNumber(line, "size", &message_size) ||
+      !FindJsonNumber(line, "io_threads", &io_thread_amount) ||
+      !FindJsonNumber(line, "completed", &completed) ||
+      !FindJsonNumber(line, "errors", &errors) ||
+      !FindJsonNumber(line, "throughput", &result->throughput) ||
+      !FindJsonNumber(line, "p99_us", &result->p99_us) ||
+      !FindJsonNumber(line, "cpu_us_per_request",
+                      &result->cpu_us_per_request) ||
+      !FindJsonNumber(line, "rss_kb", &rss_kb)) {
+    return false;
+  }
+  result->workload.connection_amount = static_cast<size_t>(connection_amount);
+  result->workload.message_size = static_cast<size_t>(message_size);
+  result->workload.io_thread_amount = static_cast<size_t>(io_thread_amount);
+  result->completed = static_cast<int64_t>(completed);
+  result->errors = static_cast<int64_t>(errors);
+  result->rss_kb = static_cast<int64_t>(rss_kb);
+  return true;
+}
+
+PerfRunner::PerfRunner(const PerfOptions& options) : options_(options) {}
+
+const std::vector<ServerSpec>& PerfRunner::GetServerSpecs() {
+  static const std::vector<ServerSpec> kServerSpecs{
+      {"simple_echo", "simple_echo", "echo", true},
+      {"pingpong", "pingpong_server", "echo", true},
+      {"http_server", "http_server", "http", false},
+      {"chat_room", "chat_server", "chat", true},
+      {"rpc_demo", "time_service_server", "rpc", false},
+  };
+  return kServerSpecs;
+}
+
+bool PerfRunner::Run(std::vector<PerfResult>* results) {
+  std::vector<std::pair<const ServerSpec*, Workload>> runs;
+  for (const auto& server_spec : GetServerSpecs()) {
+    if (!options_.servers.empty()) {
+      bool is_chosen = false;
+      for (const auto& server : options_.servers) {
+        is_chosen = is_chosen || server == server_spec.name;
+      }
+      if (!is_chosen) {
+        continue;
+      }
+    }
+    std::vector<size_t> message_sizes{0};
+    if (server_spec.is_sized) {
+      message_sizes = options_.message_sizes;
+    }
+    for (auto connection_amount : options_.connection_amounts) {
+      for (auto message_size : message_sizes) {
+        for (auto io_thread_amount : options_.io_thread_amounts) {
+          Workload workload;
+          workload.server = server_spec.name;
+          workload.connection_amount = connection_amount;
+          workload.message_size = message_size;
+          workload.io_thread_amount = io_thread_amount;
+          runs.emplace_back(&server_spec, workload);
+        }
+      }
+    }
+  }
+
+  bool is_successful = true;
+  uint16_t port = options_.port;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    const auto& workload = runs[i].second;
+    ::fprintf(stderr, "[%zu/%zu] %s ... ", i + 1, runs.size(),
+              workload.GetKey().c_str());
+    ::fflush(stderr);
+    PerfResult result;
+    result.workload = workload;
+    // Never reuse a port, so lingering connections of the last server can't
+    // get in the way
+    if (RunOne(*runs[i].first, workload, port++, &result)) {
+      ::fprintf(stderr,
+                "%.1lf requests/s, p99 %.1lf us, %.3lf CPU us/request, "
+                "%ld KiB\n",
+                result.throughput, result.p99_us, result.cpu_us_per_request,
+                result.rss_kb);
+      results->push_back(result);
+    } else {
+      ::fprintf(stderr, "failed\n");
+      is_successful = false;
+    }
+  }
+  return is_successful;
+}
+
+bool PerfRunner::Compare(const std::vector<PerfResult>& baseline,
+                         const std::vector<PerfResult>& results) const {
+  std::unordered_map<std::string, const PerfResult*> baseline_map;
+  for (const auto& result : baseline) {
+    baseline_map[result.workload.GetKey()] = &result;
+  }
+  ::printf("%-28s %12s %10s %10s %10s  %s\n", "workload", "throughput",
+           "p99", "cpu/req", "rss", "verdict");
+  bool is_regressed = false;
+  for (const auto& result : results) {
+    auto key = result.workload.GetKey();
+    auto itr = baseline_map.find(key);
+    if (itr == baseline_map.end()) {
+      ::printf("%-28s %12s %10s %10s %10s  %s\n", key.c_str(), "-", "-", "-",
+               "-", "new");
+      continue;
+    }
+    const auto& old_result = *(itr->second);
+    double throughput_change =
+        GetChange(old_result.throughput, result.throughput);
+    double latency_change = GetChange(old_result.p99_us, result.p99_us);
+    double cpu_change =
+        GetChange(old_result.cpu_us_per_request, result.cpu_us_per_request);
+    double rss_change =
+        GetChange(static_cast<double>(old_result.rss_kb),
+                  static_cast<double>(result.rss_kb));
+    std::string verdict;
+    if (throughput_change < -options_.throughput_tolerance) {
+      verdict += " throughput";
+    }
+    if (latency_change > options_.latency_tolerance) {
+      verdict += " p99";
+    }
+    if (cpu_change > options_.cpu_tolerance) {
+      verdict += " cpu";
+    }
+    if (rss_change > options_.rss_tolerance) {
+      verdict += " rss";
+    }
+    if (verdict.empty()) {
+      verdict = "ok";
+    } else {
+      verdict = "REGRESSED:" + verdict;
+      is_regressed = true;
+    }
+    ::printf("%-28s %+11.1lf%% %+9.1lf%% %+9.1lf%% %+9.1lf%%  %s\n",
+             key.c_str(), throughput_change * 100, latency_change * 100,
+             cpu_change * 100, rss_change * 100, verdict.c_str());
+  }
+  ::fflush(stdout);
+  return !is_regressed;
+}
+
+bool PerfRunner::LoadResults(const std::string& path,
+                             std::vector<PerfResult>* results) {
+  std::ifstream file{path};
+  if (!file.is_open()) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    PerfResult result;
+    if (!PerfResult::FromJson(line, &result)) {
+      ::fprintf(stderr, "Broken result in %s: %s\n", path.c_str(),
+                line.c_str());
+      return false;
+    }
+    results->push_back(result);
+  }
+  return true;
+}
+
+bool PerfRunner::SaveResults(const std::string& path,
+                             const std::vector<PerfResult>& results) {
+  std::ofstream file{path, std::ios::trunc};
+  if (!file.is_open()) {
+    return false;
+  }
+  for (const auto& result : results) {
+    file << result.ToJson() << '\n';
+  }
+  return static_cast<bool>(file);
+}
+
+bool PerfRunner::RunOne(const ServerSpec& server_spec,
+                        const Workload& workload, uint16_t port,
+                        PerfResult* result) {
+  pid_t pid = LaunchServer(server_spec, workload, port);
+  if (pid < 0) {
+    return false;
+  }
+  bool is_successful = WaitForServer(pid, port) &&
+                       RunBench(server_spec, workload, port, result);
+  ::kill(pid, SIGTERM);
+  int status = 0;
+  struct rusage usage;
+  ::memset(&usage, 0, sizeof(usage));
+  if (::wait4(pid, &status, 0, &usage) != pid) {
+    return false;
+  }
+  // Taken from the whole life of the server, the start of which costs little
+  int64_t cpu_us =
+      (static_cast<int64_t>(usage.ru_utime.tv_sec) +
+       static_cast<int64_t>(usage.ru_stime.tv_sec)) *
+          1000000 +
+      static_cast<int64_t>(usage.ru_utime.tv_usec) +
+      static_cast<int64_t>(usage.ru_stime.tv_usec);
+  result->cpu_us_per_request =
+      result->completed > 0 ? static_cast<double>(cpu_us) /
+                                  static_cast<double>(result->completed)
+                            : 0.0;
+  result->rss_kb = static_cast<int64_t>(usage.ru_maxrss);  // In KiB on Linux
+  return is_successful && result->completed > 0;
+}
+
+pid_t PerfRunner::LaunchServer(const ServerSpec& server_spec,
+                               const Workload& workload, uint16_t port) {
+  std::string path = options_.bin_dir + "/" + server_spec.binary;
+  std::string port_arg = std::to_string(port);
+  std::string thread_arg = std::to_string(workload.io_thread_amount);
+  pid_t pid = ::fork();
+  if (pid < 0) {
+    ::fprintf(stderr, "fork() failed: %s\n", ::strerror(errno));
+    return -1;
+  }
+  if (0 == pid) {
+    // Keep the report clean of what the servers print
+    int null_fd = ::open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+      ::dup2(null_fd, STDOUT_FILENO);
+      ::dup2(null_fd, STDERR_FILENO);
+      ::close(null_fd);
+    }
+    ::execl(path.c_str(), server_spec.binary, port_arg.c_str(),
+            thread_arg.c_str(), static_cast<char*>(nullptr));
+    ::_exit(127);
+  }
+  return pid;
+}
+
+bool PerfRunner::WaitForServer(pid_t pid, uint16_t port) {
+  struct sockaddr_in address;
+  ::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  for (int i = 0; i < kProbingTimes; ++i) {
+    int status = 0;
+    if (::waitpid(pid, &status, WNOHANG) != 0) {
+      ::fprintf(stderr, "(the server exits early) ");
+      return false;
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return false;
+    }
+    int ret = ::connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                        sizeof(address));
+    ::close(fd);
+    if (0 == ret) {
+      return true;
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(kProbingIntervalMilliseconds));
+  }
+  ::fprintf(stderr, "(the server never listens) ");
+  return false;
+}
+
+bool PerfRunner::RunBench(const ServerSpec& server_spec,
+                          const Workload& workload, uint16_t port,
+                          PerfResult* result) {
+  std::string command{"'" + options_.bin_dir + "/taotu-bench'"};
+  command += " -p " + std::string{server_spec.protocol};
+  command += " -H 127.0.0.1 -P " + std::to_string(port);
+  command += " -c " + std::to_string(workload.connection_amount);
+  command += " -t " + std::to_string(options_.client_thread_amount);
+  command += " -d " + std::to_string(options_.duration_seconds);
+  command += " -i " + std::to_string(options_.duration_seconds);
+  if (workload.message_size > 0) {
+    command += " -s " + std::to_string(workload.message_size);
+  }
+  command += " --json 2>/dev/null";
+  FILE* pipe = ::popen(command.c_str(), "r");
+  if (nullptr == pipe) {
+    return false;
+  }
+  std::string summary;
+  char buf[1024];
+  while (::fgets(buf, sizeof(buf), pipe) != nullptr) {
+    if ('{' == buf[0]) {
+      summary = buf;
+    }
+  }
+  if (::pclose(pipe) != 0 || summary.empty()) {
+    return false;
+  }
+  double completed = 0, errors = 0, connected = 0;
+  if (!FindJsonNumber(summary, "completed", &completed) ||
+      !FindJsonNumber(summary, "errors", &errors) ||
+      !FindJsonNumber(summary, "connected", &connected) ||
+      !FindJsonNumber(summary, "throughput", &result->throughput) ||
+      !FindJsonNumber(summary, "p99_us", &result->p99_us)) {
+    return false;
+  }
+  if (static_cast<size_t>(connected) < workload.connection_amount) {
+    ::fprintf(stderr, "(only %zu connected) ", static_cast<size_t>(connected));
+  }
+  result->completed = static_cast<int64_t>(completed);
+  result->errors = static_cast<int64_t>(errors);
+  return true;
+}
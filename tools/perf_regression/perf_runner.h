@@ -0,0 +1,117 @@
+/**
+ * @file perf_runner.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "PerfRunner" which runs the example servers
+ * under a matrix of workloads and compares the results with a baseline.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_TOOLS_PERF_REGRESSION_PERF_RUNNER_H_
+#define TAOTU_TOOLS_PERF_REGRESSION_PERF_RUNNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "../../src/non_copyable_movable.h"
+
+// How to start an example server and how to talk to it
+struct ServerSpec {
+  const char* name;
+  const char* binary;    // Called like "<binary> <port> <I/O threads>"
+  const char* protocol;  // Of "taotu-bench"
+  bool is_sized;         // Whether the size of messages matters
+};
+
+struct Workload {
+  std::string server;
+  size_t connection_amount = 0;
+  size_t message_size = 0;  // 0 if not sized
+  size_t io_thread_amount = 0;
+
+  // Like "simple_echo/c16/s64/t1", the same across runs
+  std::string GetKey() const;
+};
+
+struct PerfResult {
+  Workload workload;
+  int64_t completed = 0;
+  int64_t errors = 0;
+  double throughput = 0.0;  // Requests per second
+  double p99_us = 0.0;
+  double cpu_us_per_request = 0.0;  // Of the server (user + system)
+  int64_t rss_kb = 0;               // Peak RSS of the server
+
+  // One line of JSON
+  std::string ToJson() const;
+  static bool FromJson(const std::string& line, PerfResult* result);
+};
+
+struct PerfOptions {
+  std::string bin_dir;               // Where the servers and "taotu-bench" are
+  std::vector<std::string> servers;  // Empty for all
+  std::vector<size_t> connection_amounts{16, 256};
+  std::vector<size_t> message_sizes{64, 4096};
+  std::vector<size_t> io_thread_amounts{1, 4};
+  int64_t duration_seconds = 5;
+  size_t client_thread_amount = 4;
+  uint16_t port = 45670;  // Each run takes the next one
+
+  // Relative changes allowed before a result counts as a regression
+  double throughput_tolerance = 0.1;
+  double latency_tolerance = 0.1;
+  double cpu_tolerance = 0.1;
+  double rss_tolerance = 0.2;
+};
+
+/**
+ * @brief "PerfRunner" starts each example server on loopback as a child
+ * process, drives it with "taotu-bench" for every workload, then takes the
+ * CPU time and peak RSS of the server from its resource usage once it is
+ * terminated.
+ *
+ */
+class PerfRunner : taotu::NonCopyableMovable {
+ public:
+  explicit PerfRunner(const PerfOptions& options);
+
+  static const std::vector<ServerSpec>& GetServerSpecs();
+
+  // Run the whole matrix, return false if any run fails (the others are
+  // still run and kept)
+  bool Run(std::vector<PerfResult>* results);
+
+  // Print the changes against the baseline, return false on regressions
+  bool Compare(const std::vector<PerfResult>& baseline,
+               const std::vector<PerfResult>& results) const;
+
+  // In JSON lines
+  static bool LoadResults(const std::string& path,
+                          std::vector<PerfResult>* results);
+  static bool SaveResults(const std::string& path,
+                          const std::vector<PerfResult>& results);
+
+ private:
+  bool RunOne(const ServerSpec& server_spec, const Workload& workload,
+              uint16_t port, PerfResult* result);
+
+  pid_t LaunchServer(const ServerSpec& server_spec, const Workload& workload,
+                     uint16_t port);
+
+  // Wait until the server accepts connections, return false if it exits or
+  // stays silent
+  bool WaitForServer(pid_t pid, uint16_t port);
+
+  bool RunBench(const ServerSpec& server_spec, const Workload& workload,
+                uint16_t port, PerfResult* result);
+
+  PerfOptions options_;
+};
+
+#endif  // !TAOTU_TOOLS_PERF_REGRESSION_PERF_RUNNER_H_
@@ -0,0 +1,528 @@
+/**
+ * @file load_generator.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Implementation of class "LoadGenerator" which drives open-loop or
+ * closed-loop load against a server and reports latency percentiles.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include "load_generator.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "../../src/logger.h"
+#include "../../src/rpc.pb.h"
+#include "../../src/rpc_channel.h"
+#include "../../src/rpc_codec.h"
+
+namespace {
+
+constexpr int64_t kPacingIntervalMicroseconds = 1000;
+constexpr int64_t kConnectingTimeoutMilliseconds = 5000;
+constexpr int64_t kClosingTimeoutMilliseconds = 5000;
+constexpr size_t kChatHeaderLength = sizeof(int32_t);
+constexpr size_t kMaxChatMessageSize = 65536;
+
+// Bound to each connection
+struct Session {
+  std::deque<int64_t> sending_times;  // Of requests not answered yet
+  size_t received_bytes = 0;          // Of the echo block not complete yet
+};
+
+int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Length of the body by "Content-Length" (0 if absent), or -1 if the body is
+// chunked (which is not supported)
+int64_t GetContentLength(std::string_view header) {
+  const std::string_view kContentLength{"\r\ncontent-length:"};
+  const std::string_view kTransferEncoding{"\r\ntransfer-encoding:"};
+  int64_t content_length = 0;
+  size_t line_start = header.find("\r\n");
+  while (line_start != std::string_view::npos &&
+         line_start + 2 < header.size()) {
+    std::string_view line = header.substr(line_start);
+    if (line.size() > kContentLength.size() &&
+        0 == ::strncasecmp(line.data(), kContentLength.data(),
+                           kContentLength.size())) {
+      content_length = ::strtoll(line.data() + kContentLength.size(), nullptr,
+                                 10);
+    } else if (line.size() > kTransferEncoding.size() &&
+               0 == ::strncasecmp(line.data(), kTransferEncoding.data(),
+                                  kTransferEncoding.size())) {
+      return -1;
+    }
+    line_start = header.find("\r\n", line_start + 2);
+  }
+  return content_length;
+}
+
+}  // namespace
+
+LoadGenerator::LoadGenerator(const BenchOptions& options)
+    : options_(options), is_running_(false), open_amount_(0) {
+  options_.thread_amount = std::max<size_t>(options_.thread_amount, 1);
+  options_.message_size = std::max<size_t>(options_.message_size, 1);
+  options_.pipeline_depth = std::max<size_t>(options_.pipeline_depth, 1);
+  options_.report_interval_seconds =
+      std::max<int64_t>(options_.report_interval_seconds, 1);
+  switch (options_.protocol) {
+    case BenchProtocol::kHttpProtocol: {
+      const auto& server_address = options_.server_address;
+      request_ = "GET " + options_.http_path + " HTTP/1.1\r\nHost: " +
+                 (server_address.IsUnix() ? std::string{"localhost"}
+                                          : server_address.GetIp()) +
+                 "\r\nConnection: keep-alive\r\n\r\n";
+      break;
+    }
+    case BenchProtocol::kRpcProtocol: {
+      taotu::RpcMessage message;
+      message.set_type(taotu::REQUEST);
+      message.set_id(0);  // Answered in order on each connection
+      message.set_service(options_.rpc_service);
+      message.set_method(options_.rpc_method);
+      message.set_request(std::string{});
+      taotu::RpcCodec codec{&taotu::RpcMessage::default_instance(),
+                            taotu::kRpcTag,
+                            taotu::RpcCodec::AsyncProtobufMessageCallback{}};
+      taotu::IoBuffer io_buffer;
+      codec.FillEmptyBuffer(&io_buffer, message);
+      request_ = io_buffer.RetrieveAllAsString();
+      break;
+    }
+    case BenchProtocol::kChatProtocol: {
+      // The body starts with the sender (filled when sent)
+      options_.message_size =
+          std::min(std::max(options_.message_size, sizeof(int64_t)),
+                   kMaxChatMessageSize);
+      taotu::IoBuffer io_buffer;
+      io_buffer.AppendInt32(static_cast<int32_t>(options_.message_size));
+      request_ = io_buffer.RetrieveAllAsString();
+      request_.append(options_.message_size, 'x');
+      break;
+    }
+    default:
+      request_.assign(options_.message_size, 'x');
+      break;
+  }
+  for (size_t i = 0; i < options_.thread_amount; ++i) {
+    event_managers_.push_back(new taotu::EventManager);
+    loop_states_.emplace_back(std::make_unique<LoopState>());
+    loop_states_.back()->event_manager = event_managers_.back();
+  }
+  client_pool_ = std::make_unique<taotu::ClientPool>(
+      event_managers_,
+      std::vector<taotu::NetAddress>{options_.server_address},
+      options_.connection_amount);
+  client_pool_->SetConnectionCallback([this](taotu::Connecting& connection) {
+    this->OnConnectionCallback(connection);
+  });
+  client_pool_->SetMessageCallback([this](taotu::Connecting& connection,
+                                          taotu::IoBuffer* io_buffer,
+                                          taotu::TimePoint) {
+    this->OnMessageCallback(connection, io_buffer);
+  });
+  client_pool_->SetCloseCallback([this](taotu::Connecting& connection) {
+    this->OnCloseCallback(connection);
+  });
+}
+LoadGenerator::~LoadGenerator() {
+  is_running_ = false;
+  client_pool_->Stop();
+  {
+    // Each connection is closed in its own loop
+    std::unique_lock<std::mutex> lock(open_mutex_);
+    all_closed_cond_.wait_for(
+        lock, std::chrono::milliseconds(kClosingTimeoutMilliseconds),
+        [this]() { return 0 == open_amount_; });
+  }
+  for (auto* event_manager : event_managers_) {
+    event_manager->Quit();
+  }
+  for (auto* event_manager : event_managers_) {
+    event_manager->Join();
+  }
+  client_pool_.reset();
+  for (auto* event_manager : event_managers_) {
+    delete event_manager;
+  }
+}
+
+bool LoadGenerator::Run() {
+  for (auto* event_manager : event_managers_) {
+    event_manager->Loop();
+  }
+  client_pool_->Start();
+  auto connecting_deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(kConnectingTimeoutMilliseconds);
+  while (client_pool_->GetConnectedAmount() < options_.connection_amount &&
+         std::chrono::steady_clock::now() < connecting_deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  size_t connected_amount = client_pool_->GetConnectedAmount();
+  if (0 == connected_amount) {
+    ::fprintf(stderr, "Nothing is connected to the server!\n");
+    return false;
+  }
+  if (!options_.should_print_json) {
+    ::printf("%zu of %zu connections over %zu threads, %s loop",
+             connected_amount, options_.connection_amount,
+             options_.thread_amount,
+             options_.request_rate > 0 ? "open" : "closed");
+    if (options_.request_rate > 0) {
+      ::printf(" at %ld requests/s", options_.request_rate);
+    }
+    ::printf("\n%8s %12s %10s %10s %10s %10s %8s\n", "time(s)", "requests/s",
+             "p50(us)", "p99(us)", "p99.9(us)", "max(us)", "errors");
+    ::fflush(stdout);
+  }
+
+  is_running_ = true;
+  auto loop_amount = static_cast<int64_t>(loop_states_.size());
+  for (auto& loop_state_ptr : loop_states_) {
+    LoopState* loop_state = loop_state_ptr.get();
+    loop_state->event_manager->RunSoon([this, loop_state, loop_amount]() {
+      if (options_.request_rate > 0) {
+        loop_state->sending_period = std::max<int64_t>(
+            1000LL * 1000 * 1000 * loop_amount / options_.request_rate, 1);
+        loop_state->next_sending_time = Now();
+        loop_state->event_manager->RunEveryUntil(
+            kPacingIntervalMicroseconds,
+            [this, loop_state]() { this->Pace(loop_state); },
+            taotu::TimePoint(taotu::TimePoint::FNow()),
+            [this]() { return is_running_.load(); });
+        return;
+      }
+      // Connections of the closed loop send as soon as they are connected
+      // after this
+      for (auto* connection : loop_state->connections) {
+        auto* session = connection->GetContext<Session>();
+        for (size_t i = session->sending_times.size();
+             i < options_.pipeline_depth; ++i) {
+          this->SendOne(*connection, Now());
+        }
+      }
+    });
+  }
+
+  auto start_time = std::chrono::steady_clock::now();
+  for (int64_t elapsed_seconds = options_.report_interval_seconds;
+       elapsed_seconds <= options_.duration_seconds;
+       elapsed_seconds += options_.report_interval_seconds) {
+    std::this_thread::sleep_until(start_time +
+                                  std::chrono::seconds(elapsed_seconds));
+    Summary summary = Collect(true);
+    if (options_.should_print_json) {
+      continue;
+    }
+    const auto& latencies = summary.latencies;
+    ::printf("%8ld %12.1lf %10.1lf %10.1lf %10.1lf %10.1lf %8ld\n",
+             elapsed_seconds,
+             static_cast<double>(summary.completed) /
+                 static_cast<double>(options_.report_interval_seconds),
+             static_cast<double>(latencies.GetValueAtPercentile(50)) / 1000,
+             static_cast<double>(latencies.GetValueAtPercentile(99)) / 1000,
+             static_cast<double>(latencies.GetValueAtPercentile(99.9)) / 1000,
+             static_cast<double>(latencies.GetMax()) / 1000, summary.errors);
+    ::fflush(stdout);
+  }
+  is_running_ = false;
+
+  Summary summary = Collect(false);
+  const auto& latencies = summary.latencies;
+  double throughput = options_.duration_seconds > 0
+                          ? static_cast<double>(summary.completed) /
+                                static_cast<double>(options_.duration_seconds)
+                          : 0.0;
+  if (options_.should_print_json) {
+    ::printf(
+        "{\"completed\": %ld, \"errors\": %ld, \"connected\": %zu, "
+        "\"duration_seconds\": %ld, \"throughput\": %.1lf, \"mean_us\": "
+        "%.1lf, \"p50_us\": %.1lf, \"p99_us\": %.1lf, \"p999_us\": %.1lf, "
+        "\"max_us\": %.1lf}\n",
+        summary.completed, summary.errors, connected_amount,
+        options_.duration_seconds, throughput, latencies.GetMean() / 1000,
+        static_cast<double>(latencies.GetValueAtPercentile(50)) / 1000,
+        static_cast<double>(latencies.GetValueAtPercentile(99)) / 1000,
+        static_cast<double>(latencies.GetValueAtPercentile(99.9)) / 1000,
+        static_cast<double>(latencies.GetMax()) / 1000);
+    ::fflush(stdout);
+    return true;
+  }
+  ::printf(
+      "Totally,\n%ld requests completed and %ld failed in %ld seconds,\nthe "
+      "throughput is %.1lf requests/s,\nand the latency (in microseconds) is "
+      "%.1lf in mean, %.1lf in p50, %.1lf in p99, %.1lf in p99.9, %.1lf in "
+      "max.\n",
+      summary.completed, summary.errors, options_.duration_seconds,
+      throughput, latencies.GetMean() / 1000,
+      static_cast<double>(latencies.GetValueAtPercentile(50)) / 1000,
+      static_cast<double>(latencies.GetValueAtPercentile(99)) / 1000,
+      static_cast<double>(latencies.GetValueAtPercentile(99.9)) / 1000,
+      static_cast<double>(latencies.GetMax()) / 1000);
+  ::fflush(stdout);
+  return true;
+}
+
+void LoadGenerator::OnConnectionCallback(taotu::Connecting& connection) {
+  LoopState* loop_state = FindLoopState(connection);
+  if (connection.IsConnected()) {
+    connection.SetTcpNoDelay(true);
+    connection.SetContext<Session>();
+    loop_state->connections.push_back(&connection);
+    {
+      std::lock_guard<std::mutex> lock(open_mutex_);
+      ++open_amount_;
+    }
+    if (is_running_ && 0 == options_.request_rate) {
+      for (size_t i = 0; i < options_.pipeline_depth; ++i) {
+        SendOne(connection, Now());
+      }
+    }
+  } else {
+    auto* session = connection.GetContext<Session>();
+    if (session != nullptr) {
+      auto lost_amount = static_cast<int64_t>(session->sending_times.size());
+      loop_state->interval_errors += lost_amount;
+      loop_state->total_errors += lost_amount;
+      session->sending_times.clear();
+    }
+    auto& connections = loop_state->connections;
+    connections.erase(
+        std::remove(connections.begin(), connections.end(), &connection),
+        connections.end());
+  }
+}
+
+void LoadGenerator::OnCloseCallback(taotu::Connecting&) {
+  std::lock_guard<std::mutex> lock(open_mutex_);
+  if (0 == --open_amount_) {
+    all_closed_cond_.notify_all();
+  }
+}
+
+void LoadGenerator::OnMessageCallback(taotu::Connecting& connection,
+                                      taotu::IoBuffer* io_buffer) {
+  if (!ParseResponses(connection, io_buffer, FindLoopState(connection))) {
+    taotu::LOG_ERROR("Fd(%d) receives a broken response!!!", connection.Fd());
+    connection.ForceClose();
+  }
+}
+
+bool LoadGenerator::ParseResponses(taotu::Connecting& connection,
+                                   taotu::IoBuffer* io_buffer,
+                                   LoopState* loop_state) {
+  auto* session = connection.GetContext<Session>();
+  if (nullptr == session) {
+    return false;
+  }
+  switch (options_.protocol) {
+    case BenchProtocol::kHttpProtocol:
+      for (;;) {
+        const char* header_end = io_buffer->FindDoubleCrlf();
+        if (nullptr == header_end) {
+          break;
+        }
+        std::string_view header(
+            io_buffer->GetReadablePosition(),
+            header_end + 4 - io_buffer->GetReadablePosition());
+        int64_t content_length = GetContentLength(header);
+        if (content_length < 0 || header.size() < 12 ||
+            header.compare(0, 5, "HTTP/") != 0 ||
+            session->sending_times.empty()) {
+          return false;
+        }
+        size_t response_length =
+            header.size() + static_cast<size_t>(content_length);
+        if (io_buffer->GetReadableBytes() < response_length) {
+          break;
+        }
+        bool is_successful = '2' == header[9];
+        io_buffer->Refresh(response_length);
+        CompleteOne(connection, loop_state, is_successful);
+      }
+      return true;
+    case BenchProtocol::kRpcProtocol: {
+      const auto kTagLength =
+          static_cast<int32_t>(std::string_view{taotu::kRpcTag}.size());
+      const int32_t kMinMessageLength =
+          kTagLength + taotu::RpcCodec::kChecksumLength;
+      while (io_buffer->GetReadableBytes() >=
+             static_cast<size_t>(taotu::RpcCodec::kHeaderLength)) {
+        int32_t length = io_buffer->GetReadableInt32();
+        if (length < kMinMessageLength ||
+            length > taotu::RpcCodec::kMaxMessageLength ||
+            session->sending_times.empty()) {
+          return false;
+        }
+        size_t message_length =
+            static_cast<size_t>(taotu::RpcCodec::kHeaderLength + length);
+        if (io_buffer->GetReadableBytes() < message_length) {
+          break;
+        }
+        taotu::RpcMessage response;
+        bool is_successful =
+            response.ParseFromArray(io_buffer->GetReadablePosition() +
+                                        taotu::RpcCodec::kHeaderLength +
+                                        kTagLength,
+                                    length - kMinMessageLength) &&
+            taotu::RESPONSE == response.type();
+        io_buffer->Refresh(message_length);
+        CompleteOne(connection, loop_state, is_successful);
+      }
+      return true;
+    }
+    case BenchProtocol::kChatProtocol:
+      while (io_buffer->GetReadableBytes() >= kChatHeaderLength) {
+        int32_t length = io_buffer->GetReadableInt32();
+        if (length < static_cast<int32_t>(sizeof(int64_t)) ||
+            length > static_cast<int32_t>(kMaxChatMessageSize)) {
+          return false;
+        }
+        size_t message_length = kChatHeaderLength + length;
+        if (io_buffer->GetReadableBytes() < message_length) {
+          break;
+        }
+        int64_t sender;
+        ::memcpy(&sender, io_buffer->GetReadablePosition() + kChatHeaderLength,
+                 sizeof(sender));
+        io_buffer->Refresh(message_length);
+        // Messages of the others are only delivered
+        if (sender == connection.Fd()) {
+          if (session->sending_times.empty()) {
+            return false;
+          }
+          CompleteOne(connection, loop_state, true);
+        }
+      }
+      return true;
+    default:
+      session->received_bytes += io_buffer->GetReadableBytes();
+      io_buffer->RefreshRW();
+      while (session->received_bytes >= options_.message_size) {
+        if (session->sending_times.empty()) {
+          return false;
+        }
+        session->received_bytes -= options_.message_size;
+        CompleteOne(connection, loop_state, true);
+      }
+      return true;
+  }
+}
+
+void LoadGenerator::SendOne(taotu::Connecting& connection,
+                            int64_t intended_time) {
+  connection.GetContext<Session>()->sending_times.push_back(intended_time);
+  if (BenchProtocol::kChatProtocol == options_.protocol) {
+    // Every member receives it, so tell whose it is
+    std::string message{request_};
+    auto sender = static_cast<int64_t>(connection.Fd());
+    ::memcpy(&message[kChatHeaderLength], &sender, sizeof(sender));
+    connection.Send(message);
+    return;
+  }
+  connection.Send(request_);
+}
+
+void LoadGenerator::CompleteOne(taotu::Connecting& connection,
+                                LoopState* loop_state, bool is_successful) {
+  auto* session = connection.GetContext<Session>();
+  int64_t now = Now();
+  int64_t latency = now - session->sending_times.front();
+  session->sending_times.pop_front();
+  if (is_successful) {
+    loop_state->interval_latencies.Record(latency);
+    loop_state->total_latencies.Record(latency);
+    ++loop_state->interval_completed;
+    ++loop_state->total_completed;
+  } else {
+    ++loop_state->interval_errors;
+    ++loop_state->total_errors;
+  }
+  if (is_running_ && 0 == options_.request_rate) {
+    SendOne(connection, now);
+  }
+}
+
+void LoadGenerator::Pace(LoopState* loop_state) {
+  int64_t now = Now();
+  auto& connections = loop_state->connections;
+  while (loop_state->next_sending_time <= now) {
+    // Measured from when it should be sent, however late it's sent
+    int64_t intended_time = loop_state->next_sending_time;
+    loop_state->next_sending_time += loop_state->sending_period;
+    if (connections.empty()) {
+      ++loop_state->interval_errors;
+      ++loop_state->total_errors;
+      continue;
+    }
+    auto* connection =
+        connections[loop_state->next_connection++ % connections.size()];
+    SendOne(*connection, intended_time);
+  }
+}
+
+LoadGenerator::Summary LoadGenerator::Collect(bool is_interval) {
+  {
+    taotu::LockGuard lock_guard(summary_lock_);
+    summary_.latencies.Reset();
+    summary_.completed = 0;
+    summary_.errors = 0;
+    summary_.loop_amount = 0;
+  }
+  for (auto& loop_state_ptr : loop_states_) {
+    LoopState* loop_state = loop_state_ptr.get();
+    loop_state->event_manager->RunSoon([this, loop_state, is_interval]() {
+      taotu::LockGuard lock_guard(summary_lock_);
+      if (is_interval) {
+        summary_.latencies.Merge(loop_state->interval_latencies);
+        summary_.completed += loop_state->interval_completed;
+        summary_.errors += loop_state->interval_errors;
+      } else {
+        summary_.latencies.Merge(loop_state->total_latencies);
+        summary_.completed += loop_state->total_completed;
+        summary_.errors += loop_state->total_errors;
+      }
+      loop_state->interval_latencies.Reset();
+      loop_state->interval_completed = 0;
+      loop_state->interval_errors = 0;
+      ++summary_.loop_amount;
+    });
+  }
+  for (;;) {
+    {
+      taotu::LockGuard lock_guard(summary_lock_);
+      if (summary_.loop_amount == loop_states_.size()) {
+        return summary_;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+LoadGenerator::LoopState* LoadGenerator::FindLoopState(
+    taotu::Connecting& connection) {
+  auto* event_manager = &connection.GetEventManager();
+  for (auto& loop_state : loop_states_) {
+    if (loop_state->event_manager == event_manager) {
+      return loop_state.get();
+    }
+  }
+  return loop_states_.front().get();
+}
@@ -0,0 +1,143 @@
+/**
+ * @file load_generator.h
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief Declaration of class "LoadGenerator" which drives open-loop or
+ * closed-loop load against a server and reports latency percentiles.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#ifndef TAOTU_TOOLS_TAOTU_BENCH_LOAD_GENERATOR_H_
+#define TAOTU_TOOLS_TAOTU_BENCH_LOAD_GENERATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../../src/client_pool.h"
+#include "../../src/hdr_histogram.h"
+#include "../../src/net_address.h"
+#include "../../src/non_copyable_movable.h"
+#include "../../src/spin_lock.h"
+
+enum BenchProtocol {
+  kEchoProtocol = 0,  // Blocks echoed back as they are
+  kHttpProtocol = 1,  // HTTP/1.1 keep-alive "GET"s
+  kRpcProtocol = 2,   // taotu RPC requests
+  kChatProtocol = 3,  // Length-prefixed messages of the chat room (answered
+                      // when one's own message is broadcast back)
+};
+
+struct BenchOptions {
+  taotu::NetAddress server_address{4567, true};
+  int protocol = BenchProtocol::kEchoProtocol;
+  size_t connection_amount = 64;
+  size_t thread_amount = 4;
+  int64_t duration_seconds = 10;
+  int64_t report_interval_seconds = 1;
+
+  // Requests per second of all connections (open loop), or 0 for each
+  // connection to send again once answered (closed loop)
+  int64_t request_rate = 0;
+
+  // Requests outstanding on each connection in the closed loop
+  size_t pipeline_depth = 1;
+
+  size_t message_size = 64;     // Of echo blocks and chat messages
+  std::string http_path = "/";  // Of HTTP requests
+  std::string rpc_service = "timeservice.TimeService";
+  std::string rpc_method = "GetTime";
+
+  // Print only the summary of the whole run in one line of JSON
+  bool should_print_json = false;
+};
+
+/**
+ * @brief "LoadGenerator" keeps its connections in a "ClientPool" spread over
+ * its own I/O threads. In the open loop, requests are scheduled at a fixed
+ * rate and each latency is measured from the time the request should have
+ * been sent, so a stalled server can't hide its stalls by slowing down the
+ * load (coordinated omission).
+ *
+ */
+class LoadGenerator : taotu::NonCopyableMovable {
+ public:
+  explicit LoadGenerator(const BenchOptions& options);
+  ~LoadGenerator();
+
+  // Run the load for the duration and print reports, return false if
+  // nothing is connected
+  bool Run();
+
+ private:
+  typedef std::vector<taotu::EventManager*> EventManagers;
+
+  // Everything of one I/O thread, only touched in that thread
+  struct alignas(64) LoopState {
+    taotu::EventManager* event_manager = nullptr;
+    std::vector<taotu::Connecting*> connections;
+    size_t next_connection = 0;
+    int64_t next_sending_time = 0;  // Of the open loop (in nanoseconds)
+    int64_t sending_period = 0;
+    taotu::HdrHistogram interval_latencies;
+    taotu::HdrHistogram total_latencies;
+    int64_t interval_completed = 0;
+    int64_t total_completed = 0;
+    int64_t interval_errors = 0;
+    int64_t total_errors = 0;
+  };
+
+  // Sums of all loops
+  struct Summary {
+    taotu::HdrHistogram latencies;
+    int64_t completed = 0;
+    int64_t errors = 0;
+    size_t loop_amount = 0;  // Loops added
+  };
+
+  void OnConnectionCallback(taotu::Connecting& connection);
+  void OnCloseCallback(taotu::Connecting& connection);
+  void OnMessageCallback(taotu::Connecting& connection,
+                         taotu::IoBuffer* io_buffer);
+
+  // Take complete responses from the buffer, return false if broken
+  bool ParseResponses(taotu::Connecting& connection, taotu::IoBuffer* io_buffer,
+                      LoopState* loop_state);
+
+  void SendOne(taotu::Connecting& connection, int64_t intended_time);
+  void CompleteOne(taotu::Connecting& connection, LoopState* loop_state,
+                   bool is_successful);
+
+  // Send the requests due in the open loop
+  void Pace(LoopState* loop_state);
+
+  // Sum up all loops (of the last interval or of the whole run)
+  Summary Collect(bool is_interval);
+
+  LoopState* FindLoopState(taotu::Connecting& connection);
+
+  BenchOptions options_;
+  std::string request_;  // Encoded once, the same every time
+  EventManagers event_managers_;
+  std::vector<std::unique_ptr<LoopState>> loop_states_;
+  std::unique_ptr<taotu::ClientPool> client_pool_;
+  std::atomic_bool is_running_;
+
+  // Connections not closed yet, waited for when destroyed
+  size_t open_amount_;
+  std::mutex open_mutex_;
+  std::condition_variable all_closed_cond_;
+
+  Summary summary_;
+  taotu::MutexLock summary_lock_;
+};
+
+#endif  // !TAOTU_TOOLS_TAOTU_BENCH_LOAD_GENERATOR_H_
@@ -0,0 +1,156 @@
+/**
+ * @file main.cc
+ * @author Sigma711 (sigma711 at foxmail dot com)
+ * @brief The entrance of the load generator "taotu-bench".
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026 Sigma711
+ *
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "../../src/logger.h"
+#include "load_generator.h"
+
+namespace {
+
+void PrintUsage() {
+  ::fprintf(
+      stderr,
+      "Usage: taotu-bench [options]\n"
+      "  -p, --protocol=echo|http|rpc|chat\n"
+      "                                Protocol spoken (echo)\n"
+      "  -H, --host=IP|unix:PATH       Server host (127.0.0.1)\n"
+      "  -P, --port=PORT               Server port (4567)\n"
+      "  -c, --connections=N           Connections (64)\n"
+      "  -t, --threads=N               I/O threads (4)\n"
+      "  -d, --duration=SECONDS        Duration of the load (10)\n"
+      "  -i, --interval=SECONDS        Interval of reports (1)\n"
+      "  -r, --rate=N                  Requests per second of the open loop,\n"
+      "                                or 0 for the closed loop (0)\n"
+      "  -D, --depth=N                 Outstanding requests per connection\n"
+      "                                of the closed loop (1)\n"
+      "  -s, --size=BYTES              Size of echo blocks and chat\n"
+      "                                messages (64)\n"
+      "      --path=PATH               Path of HTTP requests (/)\n"
+      "      --service=NAME            Service of RPC requests\n"
+      "                                (timeservice.TimeService)\n"
+      "      --method=NAME             Method of RPC requests (GetTime)\n"
+      "      --json                    Print only the summary in JSON\n");
+}
+
+}  // namespace
+
+// Call it like:
+// './taotu-bench -p http -H 127.0.0.1 -P 8080 -c 256 -t 4 -d 30 -r 50000'
+int main(int argc, char* argv[]) {
+  enum { kPathOption = 256, kServiceOption, kMethodOption, kJsonOption };
+  static const struct option kLongOptions[] = {
+      {"protocol", required_argument, nullptr, 'p'},
+      {"host", required_argument, nullptr, 'H'},
+      {"port", required_argument, nullptr, 'P'},
+      {"connections", required_argument, nullptr, 'c'},
+      {"threads", required_argument, nullptr, 't'},
+      {"duration", required_argument, nullptr, 'd'},
+      {"interval", required_argument, nullptr, 'i'},
+      {"rate", required_argument, nullptr, 'r'},
+      {"depth", required_argument, nullptr, 'D'},
+      {"size", required_argument, nullptr, 's'},
+      {"path", required_argument, nullptr, kPathOption},
+      {"service", required_argument, nullptr, kServiceOption},
+      {"method", required_argument, nullptr, kMethodOption},
+      {"json", no_argument, nullptr, kJsonOption},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+  BenchOptions options;
+  std::string host{"127.0.0.1"};
+  uint16_t port = 4567;
+  int option;
+  while ((option = ::getopt_long(argc, argv, "p:H:P:c:t:d:i:r:D:s:h",
+                                 kLongOptions, nullptr)) != -1) {
+    switch (option) {
+      case 'p': {
+        std::string protocol{optarg};
+        if ("echo" == protocol) {
+          options.protocol = BenchProtocol::kEchoProtocol;
+        } else if ("http" == protocol) {
+          options.protocol = BenchProtocol::kHttpProtocol;
+        } else if ("rpc" == protocol) {
+          options.protocol = BenchProtocol::kRpcProtocol;
+        } else if ("chat" == protocol) {
+          options.protocol = BenchProtocol::kChatProtocol;
+        } else {
+          PrintUsage();
+          return 1;
+        }
+        break;
+      }
+      case 'H':
+        host = optarg;
+        break;
+      case 'P':
+        port = static_cast<uint16_t>(::atoi(optarg));
+        break;
+      case 'c':
+        options.connection_amount = static_cast<size_t>(::atol(optarg));
+        break;
+      case 't':
+        options.thread_amount = static_cast<size_t>(::atol(optarg));
+        break;
+      case 'd':
+        options.duration_seconds = ::atol(optarg);
+        break;
+      case 'i':
+        options.report_interval_seconds = ::atol(optarg);
+        break;
+      case 'r':
+        options.request_rate = ::atol(optarg);
+        break;
+      case 'D':
+        options.pipeline_depth = static_cast<size_t>(::atol(optarg));
+        break;
+      case 's':
+        options.message_size = static_cast<size_t>(::atol(optarg));
+        break;
+      case kPathOption:
+        options.http_path = optarg;
+        break;
+      case kServiceOption:
+        options.rpc_service = optarg;
+        break;
+      case kMethodOption:
+        options.rpc_method = optarg;
+        break;
+      case kJsonOption:
+        options.should_print_json = true;
+        break;
+      default:
+        PrintUsage();
+        return 'h' == option ? 0 : 1;
+    }
+  }
+  if (0 == options.connection_amount || options.duration_seconds <= 0) {
+    PrintUsage();
+    return 1;
+  }
+  const std::string unix_prefix{"unix:"};
+  options.server_address =
+      host.compare(0, unix_prefix.size(), unix_prefix) == 0
+          ? taotu::NetAddress::FromUnixPath(host.substr(unix_prefix.size()))
+          : taotu::NetAddress{host, port};
+
+  taotu::START_LOG("taotu_bench_log.txt");
+  bool is_successful = false;
+  {
+    LoadGenerator load_generator{options};
+    is_successful = load_generator.Run();
+  }
+  taotu::END_LOG();
+  return is_successful ? 0 : 1;
+}